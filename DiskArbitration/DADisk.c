@@ -29,6 +29,7 @@
 #include "DiskArbitrationPrivate.h"
 
 #include <paths.h>
+#include <libkern/OSAtomic.h>
 #include <mach/mach.h>
 #include <CoreFoundation/CoreFoundation.h>
 #include <CoreFoundation/CFRuntime.h>
@@ -41,6 +42,7 @@ struct __DADisk
     CFDictionaryRef _description;
     char *          _device;
     char *          _id;
+    CFDataRef       _serialization;
     DASessionRef    _session;
 };
 
@@ -69,7 +71,13 @@ static CFTypeID __kDADiskTypeID = _kCFRuntimeNotATypeID;
 
 __private_extern__ void _DAInitialize( void );
 
-__private_extern__ mach_port_t _DASessionGetID( DASessionRef session );
+__private_extern__ CFDictionaryRef _DASessionCopyCachedDescription( DASessionRef session, CFDataRef id );
+__private_extern__ CFDictionaryRef _DASessionCopyDescription( DASessionRef session, CFDataRef id, SInt64 * generation );
+__private_extern__ CFDictionaryRef _DASessionCopyDescriptionWithSerialization( DASessionRef session, CFDataRef serialization );
+__private_extern__ mach_port_t     _DASessionGetID( DASessionRef session );
+__private_extern__ Boolean         _DASessionIsDescriptionCacheCurrent( DASessionRef session );
+__private_extern__ void            _DASessionPrepareDescriptionCache( DASessionRef session );
+__private_extern__ void            _DASessionSetDescription( DASessionRef session, CFDataRef id, CFTypeRef description, SInt64 generation, Boolean current );
 
 extern CFHashCode CFHashBytes( UInt8 * bytes, CFIndex length );
 
@@ -100,6 +108,7 @@ static DADiskRef __DADiskCreate( CFAllocatorRef allocator, DASessionRef session,
         disk->_description   = NULL;
         disk->_device        = NULL;
         disk->_id            = strdup( id );
+        disk->_serialization = NULL;
         disk->_session       = session;
     }
 
@@ -113,6 +122,7 @@ static void __DADiskDeallocate( CFTypeRef object )
     if ( disk->_description   )  CFRelease( disk->_description );
     if ( disk->_device        )  free( disk->_device );
     if ( disk->_id            )  free( disk->_id );
+    if ( disk->_serialization )  CFRelease( disk->_serialization );
     if ( disk->_session       )  CFRelease( disk->_session );
 }
 
@@ -131,6 +141,139 @@ static CFHashCode __DADiskHash( CFTypeRef object )
     return CFHashBytes( ( void * ) disk->_id, MIN( strlen( disk->_id ), 16 ) );
 }
 
+static void __DADiskCacheDescription( DASessionRef session, CFDataRef id, CFMutableDictionaryRef description, Boolean current )
+{
+    CFNumberRef generation;
+
+    /*
+     * Strip the keys internal to the serialization and remember the description in the session.
+     */
+
+    CFDictionaryRemoveValue( description, _kDADiskIDKey );
+
+    generation = CFDictionaryGetValue( description, _kDADiskGenerationKey );
+
+    if ( generation )
+    {
+        SInt64 value;
+
+        CFNumberGetValue( generation, kCFNumberSInt64Type, &value );
+
+        CFDictionaryRemoveValue( description, _kDADiskGenerationKey );
+
+        _DASessionSetDescription( session, id, description, value, current );
+    }
+}
+
+static CFMutableDictionaryRef __DADiskCopyDescriptionWithDelta( DASessionRef session, CFDataRef id, CFDictionaryRef delta )
+{
+    CFDictionaryRef        base;
+    CFMutableDictionaryRef description = NULL;
+    SInt64                 generation;
+
+    /*
+     * The delta carries the current value of every key changed since the base generation, so it
+     * applies to any description we hold from the base generation up to the delta's generation.
+     */
+
+    base = _DASessionCopyDescription( session, id, &generation );
+
+    if ( base )
+    {
+        SInt64 generation0;
+        SInt64 generation1;
+
+        generation0 = ___CFDictionaryGetIntegerValue( delta, _kDADiskBaseGenerationKey );
+        generation1 = ___CFDictionaryGetIntegerValue( delta, _kDADiskGenerationKey );
+
+        if ( generation0 <= generation && generation <= generation1 )
+        {
+            description = CFDictionaryCreateMutableCopy( CFGetAllocator( session ), 0, base );
+
+            if ( description )
+            {
+                CFArrayRef   removed;
+                CFIndex      count;
+                CFIndex      index;
+                const void * keys[CFDictionaryGetCount( delta )];
+                const void * values[CFDictionaryGetCount( delta )];
+
+                count = CFDictionaryGetCount( delta );
+
+                CFDictionaryGetKeysAndValues( delta, keys, values );
+
+                for ( index = 0; index < count; index++ )
+                {
+                    CFDictionarySetValue( description, keys[index], values[index] );
+                }
+
+                removed = CFDictionaryGetValue( delta, _kDADiskRemovedKeysKey );
+
+                if ( removed )
+                {
+                    count = CFArrayGetCount( removed );
+
+                    for ( index = 0; index < count; index++ )
+                    {
+                        CFDictionaryRemoveValue( description, CFArrayGetValueAtIndex( removed, index ) );
+                    }
+                }
+
+                CFDictionaryRemoveValue( description, _kDADiskBaseGenerationKey );
+                CFDictionaryRemoveValue( description, _kDADiskRemovedKeysKey );
+
+                __DADiskCacheDescription( session, id, description, FALSE );
+            }
+        }
+
+        CFRelease( base );
+    }
+
+    return description;
+}
+
+static CFMutableDictionaryRef __DADiskCopyServerDescription( DADiskRef disk )
+{
+    Boolean                current;
+    vm_address_t           _description;
+    mach_msg_type_number_t _descriptionSize;
+    CFMutableDictionaryRef description = NULL;
+    kern_return_t          status;
+
+    /*
+     * The description is current if we were registered for its changes before we asked for it.
+     */
+
+    current = _DASessionIsDescriptionCacheCurrent( disk->_session );
+
+    status = _DAServerDiskCopyDescription( _DASessionGetID( disk->_session ), disk->_id, &_description, &_descriptionSize );
+
+    if ( status == KERN_SUCCESS )
+    {
+        description = _DAUnserializeDiskDescriptionWithBytes( CFGetAllocator( disk ), _description, _descriptionSize );
+
+        if ( description )
+        {
+            CFDataRef id;
+
+            id = CFDictionaryGetValue( description, _kDADiskIDKey );
+
+            if ( id )
+            {
+                CFRetain( id );
+
+                __DADiskCacheDescription( disk->_session, id, description, current );
+
+                CFRelease( id );
+            }
+        }
+
+        vm_deallocate( mach_task_self( ), _description, _descriptionSize );
+    }
+
+    return description;
+}
+
 __private_extern__ DADiskRef _DADiskCreate( CFAllocatorRef allocator, DASessionRef session, const char * id )
 {
     DADiskRef disk = NULL;
@@ -151,11 +294,72 @@ __private_extern__ DADiskRef _DADiskCreate( CFAllocatorRef allocator, DASessionR
     return disk;
 }
 
+static DADiskRef __DADiskCreateFromCompactSerialization( DASessionRef session, CFDataRef serialization )
+{
+    DADiskRef      disk = NULL;
+    CFIndex        length;
+    _DACompactType type;
+    const UInt8 *  value;
+
+    /*
+     * A full description in the compact encoding names its disk without being decoded, so that we
+     * can leave the decoding to the first DADiskCopyDescription.  Deltas are not left undecoded, as
+     * they resolve against the description we hold at the time.
+     */
+
+    if ( _DAUnserializeDiskDescriptionGetField( serialization, _kDADiskBaseGenerationKey, &type, &value, &length ) == FALSE )
+    {
+        if ( _DAUnserializeDiskDescriptionGetField( serialization, _kDADiskIDKey, &type, &value, &length ) )
+        {
+            if ( type == _kDACompactTypeData && length && value[ length - 1 ] == 0 )
+            {
+                disk = _DADiskCreate( CFGetAllocator( session ), session, ( const char * ) value );
+
+                if ( disk )
+                {
+                    CFNumberRef generation;
+
+                    disk->_serialization = CFRetain( serialization );
+
+                    generation = _DAUnserializeDiskDescriptionCopyValue( kCFAllocatorDefault, serialization, _kDADiskGenerationKey );
+
+                    if ( generation )
+                    {
+                        CFDataRef id;
+
+                        id = CFDataCreate( kCFAllocatorDefault, value, length );
+
+                        if ( id )
+                        {
+                            SInt64 number;
+
+                            CFNumberGetValue( generation, kCFNumberSInt64Type, &number );
+
+                            _DASessionSetDescription( session, id, serialization, number, FALSE );
+
+                            CFRelease( id );
+                        }
+
+                        CFRelease( generation );
+                    }
+                }
+            }
+        }
+    }
+
+    return disk;
+}
+
 DADiskRef _DADiskCreateFromSerialization( CFAllocatorRef allocator, DASessionRef session, CFDataRef serialization )
 {
     DADiskRef disk = NULL;
 
     if ( serialization )
+    {
+        disk = __DADiskCreateFromCompactSerialization( session, serialization );
+    }
+
+    if ( serialization && disk == NULL )
     {
         CFMutableDictionaryRef description;
 
@@ -171,6 +375,8 @@ DADiskRef _DADiskCreateFromSerialization( CFAllocatorRef allocator, DASessionRef
             {
                 const char * id;
 
+                CFRetain( data );
+
                 id = ( void * ) CFDataGetBytePtr( data );
 
                 if ( id )
@@ -179,20 +385,81 @@ DADiskRef _DADiskCreateFromSerialization( CFAllocatorRef allocator, DASessionRef
 
                     if ( disk )
                     {
-                        CFDictionaryRemoveValue( description, _kDADiskIDKey );
-
-                        disk->_description = CFRetain( description );
+                        if ( CFDictionaryContainsKey( description, _kDADiskBaseGenerationKey ) )
+                        {
+                            CFMutableDictionaryRef copy;
+
+                            /*
+                             * Resolve the delta against the description we hold.  Should we not hold
+                             * a suitable one, leave the description to DADiskCopyDescription, so that
+                             * we go to the server only for the disks the client asks about.
+                             */
+
+                            copy = __DADiskCopyDescriptionWithDelta( session, data, description );
+
+                            CFRelease( description );
+
+                            description = copy;
+                        }
+                        else
+                        {
+                            __DADiskCacheDescription( session, data, description, FALSE );
+                        }
+
+                        if ( description )
+                        {
+                            disk->_description = CFRetain( description );
+                        }
                     }
                 }
+
+                CFRelease( data );
             }
 
-            CFRelease( description );
+            if ( description )  CFRelease( description );
         }
     }
 
     return disk;
 }
 
+CFDataRef _DADiskCopySerialization( DADiskRef disk, UInt32 encoding )
+{
+    CFDataRef       data = NULL;
+    CFDictionaryRef description;
+
+    description = DADiskCopyDescription( disk );
+
+    if ( description )
+    {
+        CFMutableDictionaryRef copy;
+
+        copy = CFDictionaryCreateMutableCopy( CFGetAllocator( disk ), 0, description );
+
+        if ( copy )
+        {
+            CFDataRef id;
+
+            id = CFDataCreate( CFGetAllocator( disk ), ( void * ) disk->_id, strlen( disk->_id ) + 1 );
+
+            if ( id )
+            {
+                CFDictionarySetValue( copy, _kDADiskIDKey, id );
+
+                data = _DASerializeDiskDescriptionWithEncoding( CFGetAllocator( disk ), copy, encoding );
+
+                CFRelease( id );
+            }
+
+            CFRelease( copy );
+        }
+
+        CFRelease( description );
+    }
+
+    return data;
+}
+
 __private_extern__ char * _DADiskGetID( DADiskRef disk )
 {
     return disk->_id;
@@ -213,8 +480,29 @@ __private_extern__ void _DADiskInitialize( void )
     __kDADiskTypeID = _CFRuntimeRegisterClass( &__DADiskClass );
 }
 
+__private_extern__ void _DADiskRemoveDescriptionFromSession( DADiskRef disk )
+{
+    CFDataRef id;
+
+    id = CFDataCreate( CFGetAllocator( disk ), ( void * ) disk->_id, strlen( disk->_id ) + 1 );
+
+    if ( id )
+    {
+        _DASessionSetDescription( disk->_session, id, NULL, 0, FALSE );
+
+        CFRelease( id );
+    }
+}
+
 __private_extern__ void _DADiskSetDescription( DADiskRef disk, CFDictionaryRef description )
 {
+    if ( disk->_serialization )
+    {
+        CFRelease( disk->_serialization );
+
+        disk->_serialization = NULL;
+    }
+
     if ( disk->_description )
     {
         CFRelease( disk->_description );
@@ -238,6 +526,21 @@ CFDictionaryRef DADiskCopyDescription( DADiskRef disk )
 
     if ( disk )
     {
+        if ( disk->_description == NULL && disk->_serialization )
+        {
+            description = _DASessionCopyDescriptionWithSerialization( disk->_session, disk->_serialization );
+
+            if ( description )
+            {
+                if ( OSAtomicCompareAndSwapPtrBarrier( NULL, ( void * ) description, ( void * volatile * ) &disk->_description ) == FALSE )
+                {
+                    CFRelease( description );
+                }
+
+                description = NULL;
+            }
+        }
+
         if ( disk->_description )
         {
             CFRetain( disk->_description );
@@ -246,19 +549,22 @@ CFDictionaryRef DADiskCopyDescription( DADiskRef disk )
         }
         else
         {
-            vm_address_t           _description;
-            mach_msg_type_number_t _descriptionSize;
-            kern_return_t          status;
+            CFDataRef id;
 
-            status = _DAServerDiskCopyDescription( _DADiskGetSessionID( disk ), _DADiskGetID( disk ), &_description, &_descriptionSize );
+            id = CFDataCreate( CFGetAllocator( disk ), ( void * ) disk->_id, strlen( disk->_id ) + 1 );
 
-            if ( status == KERN_SUCCESS )
+            if ( id )
             {
-                description = _DAUnserializeDiskDescriptionWithBytes( CFGetAllocator( disk ), _description, _descriptionSize );
+                description = _DASessionCopyCachedDescription( disk->_session, id );
+
+                CFRelease( id );
+            }
 
-                CFDictionaryRemoveValue( ( void * ) description, _kDADiskIDKey );
+            if ( description == NULL )
+            {
+                _DASessionPrepareDescriptionCache( disk->_session );
 
-                vm_deallocate( mach_task_self( ), _description, _descriptionSize );
+                description = __DADiskCopyServerDescription( disk );
             }
         }
     }
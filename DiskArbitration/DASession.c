@@ -32,9 +32,11 @@
 #include <crt_externs.h>
 #include <libgen.h>
 #include <pthread.h>
+#include <sched.h>
 #include <unistd.h>
 #include <dispatch/dispatch.h>
 #include <mach/mach.h>
+#include <mach/mach_vm.h>
 #include <mach-o/dyld.h>
 #include <servers/bootstrap.h>
 #include <CoreFoundation/CoreFoundation.h>
@@ -46,6 +48,41 @@
 #include <libkern/OSAtomic.h>
 #include <notify.h>
 
+struct __DASessionCallbackSlot
+{
+    CFMutableDictionaryRef callback;
+    mach_vm_offset_t       address;
+    mach_vm_offset_t       context;
+    volatile SInt32        handle;
+    SInt32                 next;
+    UInt64                 sequence;
+    SInt32                 tag;
+};
+
+typedef struct __DASessionCallbackSlot __DASessionCallbackSlot;
+
+struct __DASessionDeliveryQueue
+{
+    dispatch_queue_t queue;
+    volatile int32_t pending;
+    Boolean          retired;
+};
+
+typedef struct __DASessionDeliveryQueue __DASessionDeliveryQueue;
+
+struct __DASessionDelivery
+{
+    DASessionRef       session;
+    void *             address;
+    void *             context;
+    _DACallbackKind    kind;
+    CFTypeRef          argument0;
+    CFTypeRef          argument1;
+    volatile int32_t * pending;
+};
+
+typedef struct __DASessionDelivery __DASessionDelivery;
+
 struct __DASession
 {
     CFRuntimeBase           _base;
@@ -53,14 +90,33 @@ struct __DASession
     AuthorizationRef        _authorization;
 #endif
     CFMachPortRef           _client;
+    dispatch_group_t        _deliveryGroup;
+    dispatch_queue_t        _deliveryQueue;
+    CFMutableDictionaryRef  _deliveryQueues;
+    CFMutableArrayRef       _deliveryRetired;
+    CFMutableDictionaryRef  _descriptions;
+    Boolean                 _descriptionCache;
+    volatile int32_t        _descriptionCacheState;
+    pthread_mutex_t         _descriptionLock;
+    CFMutableDictionaryRef  _descriptionMemo;
+    _DAEncoding             _encoding;
+    UInt32                  _interval;
     char *                  _name;
     pid_t                    _pid;
+    UInt32                  _queueLimit;
     mach_port_t             _server;
     CFRunLoopSourceRef      _source;
     dispatch_source_t       _source2;
     UInt32                  _sourceCount;
-    CFMutableDictionaryRef  _register;
-    SInt32                  _registerIndex;
+    __DASessionCallbackSlot * volatile * _registerChunks;
+    SInt32                  _registerFree;
+    SInt32 *                _registerHash;
+    SInt32                  _registerLimit;
+    CFMutableArrayRef       _registerPending;
+    volatile int32_t        _registerReaders;
+    UInt64                  _registerSequence;
+    _DACallbackRing *       _ring;
+    uint32_t                _ringSize;
     pthread_mutex_t         _registerLock;
     bool                    _keepAlive;
     int                     _token;
@@ -99,6 +155,28 @@ const CFStringRef kDAApprovalRunLoopMode = CFSTR( "kDAApprovalRunLoopMode" );
 
 static uint32_t           sessionCount = 0;
 
+static const CFIndex      __kDASessionDescriptionCountMaximum = 1024;
+
+static const int          __kDASessionDeliveryKey = 0;
+
+/*
+ * The callback register is a table of slots, allocated in chunks that stay put for the life of the
+ * session.  A callback handle carries its slot in the low 16 bits and the slot's reuse tag above,
+ * which is never zero, so that a stale handle does not find the slot's next callback.
+ */
+
+static const SInt32       __kDASessionRegisterChunkCount = 1024;
+static const SInt32       __kDASessionRegisterChunkSize  = 64;
+static const SInt32       __kDASessionRegisterHashSize   = 256;
+static const SInt32       __kDASessionRegisterTagMaximum = 0x7FFF;
+
+enum
+{
+    __kDASessionDescriptionCacheStateNone        = 0,
+    __kDASessionDescriptionCacheStateRegistering = 1,
+    __kDASessionDescriptionCacheStateRegistered  = 2
+};
+
 __private_extern__ void _DADispatchCallback( DASessionRef    session,
                                              void *          address,
                                              void *          context,
@@ -106,8 +184,21 @@ __private_extern__ void _DADispatchCallback( DASessionRef    session,
                                              CFTypeRef       argument0,
                                              CFTypeRef       argument1 );
 
+__private_extern__ char * _DADiskGetID( DADiskRef disk );
+
 __private_extern__ void _DAInitialize( void );
 
+__private_extern__ void _DARegisterCallback( DASessionRef    session,
+                                             void *          address,
+                                             void *          context,
+                                             _DACallbackKind kind,
+                                             CFIndex         order,
+                                             CFDictionaryRef match,
+                                             CFArrayRef      watch,
+                                             bool            block );
+
+__private_extern__ void _DAUnregisterCallback( DASessionRef session, void * address, void * context );
+
 static CFStringRef __DASessionCopyDescription( CFTypeRef object )
 {
     DASessionRef session = ( DASessionRef ) object;
@@ -146,19 +237,37 @@ static DASessionRef __DASessionCreate( CFAllocatorRef allocator )
         session->_authorization = NULL;
 #endif
         session->_client        = NULL;
+        session->_deliveryGroup  = NULL;
+        session->_deliveryQueue  = NULL;
+        session->_deliveryQueues = NULL;
+        session->_deliveryRetired = NULL;
+        session->_descriptions  = CFDictionaryCreateMutable( kCFAllocatorDefault, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks );
+        session->_descriptionCache      = FALSE;
+        session->_descriptionCacheState = __kDASessionDescriptionCacheStateNone;
+        session->_descriptionMemo       = NULL;
+        session->_encoding      = _kDAEncodingPropertyList;
+        session->_interval      = 0;
         session->_name          = NULL;
         session->_pid           = 0;
+        session->_queueLimit    = 0;
         session->_server        = MACH_PORT_NULL;
         session->_source        = NULL;
         session->_source2       = NULL;
         session->_sourceCount   = 0;
-        session->_register      = CFDictionaryCreateMutable( kCFAllocatorDefault, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks );
-        session->_registerIndex = 0;
+        session->_registerChunks   = NULL;
+        session->_registerFree     = 0;
+        session->_registerHash     = NULL;
+        session->_registerLimit    = 0;
+        session->_registerPending  = NULL;
+        session->_registerSequence = 0;
+        session->_ring          = NULL;
+        session->_ringSize      = 0;
         session->_keepAlive     = false;
         session->_token         = -1;
         pthread_mutex_init( &session->_registerLock, NULL );
+        pthread_mutex_init( &session->_descriptionLock, NULL );
 
-        assert( session->_register );
+        assert( session->_descriptions );
         
         uint32_t newSessionCount = OSAtomicIncrement32( &sessionCount );
         if ( 0 == ( newSessionCount % 1000 ) )
@@ -171,833 +280,2408 @@ static DASessionRef __DASessionCreate( CFAllocatorRef allocator )
     return session;
 }
 
-static void __DASessionReleaseCallbackBlocks( DASessionRef session )
+static __DASessionCallbackSlot * __DASessionGetCallbackSlot( DASessionRef session, SInt32 slot )
 {
-    CFIndex count = CFDictionaryGetCount( session->_register );
-    const void** keys = ( const void** ) malloc( sizeof(void*)*count );
-    const void** values = ( const void** ) malloc( sizeof(void*)*count );
-    SInt32 queueIndex;
+    __DASessionCallbackSlot * volatile * chunks;
+    __DASessionCallbackSlot *            chunk = NULL;
 
-    CFDictionaryGetKeysAndValues( session->_register, keys, values );
-    for ( queueIndex = 0; queueIndex < count; queueIndex++ )
+    chunks = session->_registerChunks;
+
+    if ( chunks )
     {
-        CFMutableDictionaryRef callback = ( CFMutableDictionaryRef )( values[queueIndex] );
-        void *currentaddress = ( void * ) ( uintptr_t ) ___CFDictionaryGetIntegerValue( callback, _kDACallbackAddressKey );
-        int block = ( uintptr_t ) ___CFDictionaryGetIntegerValue( callback, _kDACallbackBlockKey );
-        if ( block )
-        {
-            Block_release ( currentaddress );
-        }
+        chunk = chunks[ slot / __kDASessionRegisterChunkSize ];
     }
-    free ( keys );
-    free ( values );
+
+    return chunk ? &chunk[ slot % __kDASessionRegisterChunkSize ] : NULL;
 }
 
-static void __DASessionDeallocate( CFTypeRef object )
+static CFMutableDictionaryRef __DASessionGetCallback( DASessionRef session, SInt32 handle )
 {
-    DASessionRef session = ( DASessionRef ) object;
+    CFMutableDictionaryRef    callback = NULL;
+    __DASessionCallbackSlot * entry;
 
-    assert( session->_client  == NULL );
-    assert( session->_source  == NULL );
-    assert( session->_source2 == NULL );
+    /*
+     * Look the callback up without the register lock.  The handle is checked again once the
+     * callback is read, should the slot have been reused in between.
+     */
 
-#if TARGET_OS_OSX || TARGET_OS_MACCATALYST
-    if ( session->_authorization )  AuthorizationFree( session->_authorization, kAuthorizationFlagDefaults );
-#endif
-    if ( session->_name          )  free( session->_name );
-    if ( session->_token  != -1  )  notify_cancel( session->_token );
-    if ( session->_server        )  mach_port_deallocate( mach_task_self( ), session->_server );
-   
-    if ( session->_register )
+    if ( handle > 0 )
     {
-        __DASessionReleaseCallbackBlocks( session );
-        CFRelease( session->_register );
+        entry = __DASessionGetCallbackSlot( session, handle & 0xFFFF );
+
+        if ( entry && entry->handle == handle )
+        {
+            callback = entry->callback;
+
+            OSMemoryBarrier( );
+
+            if ( entry->handle != handle )
+            {
+                callback = NULL;
+            }
+        }
     }
-    OSAtomicDecrement32( &sessionCount );
-    pthread_mutex_destroy( &session->_registerLock );
+
+    return callback;
 }
 
-static Boolean __DASessionEqual( CFTypeRef object1, CFTypeRef object2 )
+static SInt32 __DASessionGetCallbackHash( mach_vm_offset_t address, mach_vm_offset_t context )
 {
-    DASessionRef session1 = ( DASessionRef ) object1;
-    DASessionRef session2 = ( DASessionRef ) object2;
+    return ( SInt32 ) ( ( ( address >> 4 ) ^ ( context >> 4 ) ^ context ) % __kDASessionRegisterHashSize );
+}
 
-    return ( session1->_server == session2->_server ) ? TRUE : FALSE;
+static int __DASessionCompareCallbackSlots( const void * slot1, const void * slot2 )
+{
+    UInt64 sequence1 = ( ( const __DASessionCallbackSlot * ) slot1 )->sequence;
+    UInt64 sequence2 = ( ( const __DASessionCallbackSlot * ) slot2 )->sequence;
+
+    return ( sequence1 > sequence2 ) - ( sequence1 < sequence2 );
 }
 
-static CFHashCode __DASessionHash( CFTypeRef object )
+static void __DASessionRemoveCallbackSlot( DASessionRef session, SInt32 slot )
 {
-    DASessionRef session = ( DASessionRef ) object;
+    __DASessionCallbackSlot * entry;
+    SInt32 *                  link;
 
-    return ( CFHashCode ) session->_server;
+    /*
+     * Unlink the slot from its hash chain and put it on the free list.  The register lock is held.
+     */
+
+    entry = __DASessionGetCallbackSlot( session, slot );
+
+    link = &session->_registerHash[ __DASessionGetCallbackHash( entry->address, entry->context ) ];
+
+    while ( *link )
+    {
+        if ( *link == slot + 1 )
+        {
+            *link = entry->next;
+
+            break;
+        }
+
+        link = &__DASessionGetCallbackSlot( session, *link - 1 )->next;
+    }
+
+    entry->handle = 0;
+
+    OSMemoryBarrier( );
+
+    /*
+     * A delivery may have found the slot before its handle was cleared and be about to retain the
+     * callback, so let it finish before the slot lets go of the callback.
+     */
+
+    while ( session->_registerReaders )
+    {
+        sched_yield( );
+    }
+
+    if ( ___CFDictionaryGetIntegerValue( entry->callback, _kDACallbackBlockKey ) )
+    {
+        Block_release( ( void * ) ( uintptr_t ) entry->address );
+    }
+
+    CFRelease( entry->callback );
+
+    entry->callback = NULL;
+    entry->next     = session->_registerFree;
+
+    session->_registerFree = slot + 1;
 }
 
-__private_extern__ void _DASessionCallback( CFMachPortRef port, void * message, CFIndex messageSize, void * info )
+static DAReturn __DASessionRegisterCallbacks( DASessionRef session, CFArrayRef keys )
 {
-    vm_address_t           _queue;
-    mach_msg_type_number_t _queueSize;
-    DASessionRef           session = info;
-    kern_return_t          status;
+    CFMutableArrayRef callbacks;
+    DAReturn          status;
 
-    status = _DAServerSessionCopyCallbackQueue( session->_server, &_queue, &_queueSize );
+    /*
+     * Register the callbacks under the given register keys with the server in one message.
+     */
 
-    if ( status == KERN_SUCCESS )
+    status = kDAReturnNoResources;
+
+    callbacks = CFArrayCreateMutable( kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks );
+
+    if ( callbacks )
     {
-        CFArrayRef queue;
+        CFDataRef data;
+        CFIndex   count;
+        CFIndex   index;
 
-        queue = _DAUnserializeWithBytes( CFGetAllocator( session ), _queue, _queueSize );
+        count = CFArrayGetCount( keys );
 
-        if ( queue )
+        for ( index = 0; index < count; index++ )
         {
-            CFIndex count;
-            CFIndex index;
+            CFDictionaryRef        callback;
+            CFMutableDictionaryRef entry;
+            CFNumberRef            key;
+            SInt32                 value;
 
-            count = CFArrayGetCount( queue );
+            key = CFArrayGetValueAtIndex( keys, index );
 
-            for ( index = 0; index < count; index++ )
+            CFNumberGetValue( key, kCFNumberSInt32Type, &value );
+
+            entry = CFDictionaryCreateMutable( kCFAllocatorDefault, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks );
+
+            if ( entry )
             {
-                CFDictionaryRef callback;
-                
-                callback = CFArrayGetValueAtIndex( queue, index );
+                pthread_mutex_lock( &session->_registerLock );
+
+                callback = __DASessionGetCallback( session, value );
 
                 if ( callback )
                 {
-                    void * address;
-                    void * context;
+                    CFDataRef match;
+                    CFDataRef watch;
 
-                    CFTypeRef argument0;
-                    CFTypeRef argument1;
+                    match = CFDictionaryGetValue( callback, _kDACallbackMatchKey );
+                    watch = CFDictionaryGetValue( callback, _kDACallbackWatchKey );
 
-                    address = ( void * ) ( uintptr_t ) ___CFDictionaryGetIntegerValue( callback, _kDACallbackAddressKey );
-                    context = ( void * ) ( uintptr_t ) ___CFDictionaryGetIntegerValue( callback, _kDACallbackContextKey );
+                    ___CFDictionarySetIntegerValue( entry, _kDACallbackAddressKey, value );
+                    ___CFDictionarySetIntegerValue( entry, _kDACallbackContextKey, value );
+                    ___CFDictionarySetIntegerValue( entry, _kDACallbackKindKey,    ___CFDictionaryGetIntegerValue( callback, _kDACallbackKindKey  ) );
+                    ___CFDictionarySetIntegerValue( entry, _kDACallbackOrderKey,   ___CFDictionaryGetIntegerValue( callback, _kDACallbackOrderKey ) );
 
-                    argument0 = CFDictionaryGetValue( callback, _kDACallbackArgument0Key );
-                    argument1 = CFDictionaryGetValue( callback, _kDACallbackArgument1Key );
-                    
-                    _DADispatchCallback( session, address, context, ___CFDictionaryGetIntegerValue( callback, _kDACallbackKindKey ), argument0, argument1 );
+                    if ( match )  CFDictionarySetValue( entry, _kDACallbackMatchKey, match );
+                    if ( watch )  CFDictionarySetValue( entry, _kDACallbackWatchKey, watch );
+
+                    CFArrayAppendValue( callbacks, entry );
                 }
+
+                pthread_mutex_unlock( &session->_registerLock );
+
+                CFRelease( entry );
             }
+        }
 
-            CFRelease( queue );
+        status = kDAReturnSuccess;
+
+        if ( CFArrayGetCount( callbacks ) )
+        {
+            status = kDAReturnNoResources;
+
+            data = _DASerialize( kCFAllocatorDefault, callbacks );
+
+            if ( data )
+            {
+                status = _DAServerSessionRegisterCallbacks( session->_server,
+                                                            ( vm_address_t           ) CFDataGetBytePtr( data ),
+                                                            ( mach_msg_type_number_t ) CFDataGetLength(  data ) );
+
+                CFRelease( data );
+            }
         }
 
-        vm_deallocate( mach_task_self( ), _queue, _queueSize );
+        CFRelease( callbacks );
     }
-}
-#if TARGET_OS_OSX || TARGET_OS_MACCATALYST
-__private_extern__ AuthorizationRef _DASessionGetAuthorization( DASessionRef session )
-{
-    AuthorizationRef authorization;
-
-    pthread_mutex_lock( &__gDASessionSetAuthorizationLock );
 
-    authorization = session->_authorization;
+    return status;
+}
 
-    if ( authorization == NULL )
+static void __DASessionReleaseDeliveryQueues( DASessionRef session )
+{
+    if ( session->_deliveryQueues )
     {
-        kern_return_t status;
+        CFIndex       count;
+        CFIndex       index;
+        const void ** queues;
 
-        /*
-         * Create the session's authorization reference.
-         */
+        count = CFDictionaryGetCount( session->_deliveryQueues );
 
-        status = AuthorizationCreate( NULL, NULL, kAuthorizationFlagDefaults, &authorization );
+        queues = malloc( sizeof( void * ) * MAX( count, 1 ) );
 
-        if ( status == errAuthorizationSuccess )
+        if ( queues )
         {
-            AuthorizationExternalForm _authorization;
-
-            /*
-             * Create the session's authorization reference representation.
-             */
-
-            status = AuthorizationMakeExternalForm( authorization, &_authorization );
+            CFDictionaryGetKeysAndValues( session->_deliveryQueues, NULL, queues );
 
-            if ( status == errAuthorizationSuccess )
+            for ( index = 0; index < count; index++ )
             {
-                _DAServerSessionSetAuthorization( session->_server, _authorization );
+                dispatch_release( ( ( __DASessionDeliveryQueue * ) queues[index] )->queue );
 
-                session->_authorization = authorization;
+                free( ( void * ) queues[index] );
             }
-            else
-            {
-                AuthorizationFree( authorization, kAuthorizationFlagDefaults );
 
-                authorization = NULL;
-            }
+            free( queues );
         }
+
+        CFRelease( session->_deliveryQueues );
+
+        session->_deliveryQueues = NULL;
     }
 
-    pthread_mutex_unlock( &__gDASessionSetAuthorizationLock );
+    if ( session->_deliveryRetired )
+    {
+        CFRelease( session->_deliveryRetired );
 
-    return authorization;
+        session->_deliveryRetired = NULL;
+    }
+
+    if ( session->_deliveryQueue )
+    {
+        dispatch_release( session->_deliveryQueue );
+
+        session->_deliveryQueue = NULL;
+    }
 }
-#endif
-#ifndef __LP64__
 
-__private_extern__ mach_port_t _DASessionGetClientPort( DASessionRef session )
+static void __DASessionReleaseCallbacks( DASessionRef session )
 {
-    mach_port_t client;
+    SInt32 index;
 
-    client = MACH_PORT_NULL;
+    for ( index = 0; index < session->_registerLimit; index++ )
+    {
+        __DASessionCallbackSlot * entry;
 
-    if ( session->_client )
+        entry = __DASessionGetCallbackSlot( session, index );
+
+        if ( entry->handle )
+        {
+            if ( ___CFDictionaryGetIntegerValue( entry->callback, _kDACallbackBlockKey ) )
+            {
+                Block_release( ( void * ) ( uintptr_t ) entry->address );
+            }
+
+            CFRelease( entry->callback );
+        }
+    }
+
+    for ( index = 0; index < __kDASessionRegisterChunkCount; index++ )
     {
-        client = CFMachPortGetPort( session->_client );
+        if ( session->_registerChunks[ index ] )
+        {
+            free( session->_registerChunks[ index ] );
+        }
     }
 
-    return client;
+    free( ( void * ) session->_registerChunks );
+    free( session->_registerHash );
 }
 
-#endif /* !__LP64__ */
-
-__private_extern__ mach_port_t _DASessionGetID( DASessionRef session )
+static void __DASessionDeallocate( CFTypeRef object )
 {
-    return session->_server;
+    DASessionRef session = ( DASessionRef ) object;
+
+    assert( session->_client  == NULL );
+    assert( session->_source  == NULL );
+    assert( session->_source2 == NULL );
+
+#if TARGET_OS_OSX || TARGET_OS_MACCATALYST
+    if ( session->_authorization )  AuthorizationFree( session->_authorization, kAuthorizationFlagDefaults );
+#endif
+    if ( session->_descriptions  )  CFRelease( session->_descriptions );
+    if ( session->_descriptionMemo )  CFRelease( session->_descriptionMemo );
+
+    __DASessionReleaseDeliveryQueues( session );
+
+    if ( session->_deliveryGroup )  dispatch_release( session->_deliveryGroup );
+    if ( session->_name          )  free( session->_name );
+    if ( session->_token  != -1  )  notify_cancel( session->_token );
+    if ( session->_server        )  mach_port_deallocate( mach_task_self( ), session->_server );
+    if ( session->_ring          )  mach_vm_deallocate( mach_task_self( ), ( mach_vm_address_t ) session->_ring, sizeof( _DACallbackRing ) + session->_ringSize );
+   
+    if ( session->_registerPending )  CFRelease( session->_registerPending );
+
+    if ( session->_registerChunks )
+    {
+        __DASessionReleaseCallbacks( session );
+    }
+    OSAtomicDecrement32( &sessionCount );
+    pthread_mutex_destroy( &session->_registerLock );
+    pthread_mutex_destroy( &session->_descriptionLock );
 }
 
-__private_extern__ bool _DASessionIsKeepAlive( DASessionRef session )
+static Boolean __DASessionEqual( CFTypeRef object1, CFTypeRef object2 )
 {
-    return ( session->_keepAlive == true );
+    DASessionRef session1 = ( DASessionRef ) object1;
+    DASessionRef session2 = ( DASessionRef ) object2;
+
+    return ( session1->_server == session2->_server ) ? TRUE : FALSE;
 }
 
-__private_extern__ void _DASessionInitialize( void )
+static CFHashCode __DASessionHash( CFTypeRef object )
 {
-    __kDASessionTypeID = _CFRuntimeRegisterClass( &__DASessionClass );
+    DASessionRef session = ( DASessionRef ) object;
+
+    return ( CFHashCode ) session->_server;
 }
 
-__private_extern__ void _DASessionScheduleWithRunLoop( DASessionRef session )
+static DAReturn __DASessionCreateCallbackRing( DASessionRef session )
 {
-    session->_sourceCount++;
+    mach_port_t   ring;
+    uint32_t      ringSize;
+    kern_return_t status;
 
-    if ( session->_sourceCount == 1 )
+    /*
+     * Map the memory the server shares with us for callback delivery.
+     */
+
+    status = _DAServerSessionCreateCallbackRing( session->_server, session->_ringSize, &ring, &ringSize );
+
+    if ( status == KERN_SUCCESS )
     {
-        mach_port_t   clientPort;
-        kern_return_t status;
+        mach_vm_address_t address;
 
-        /*
-         * Create the session's client port.
-         */
+        address = 0;
 
-        status = mach_port_allocate( mach_task_self( ), MACH_PORT_RIGHT_RECEIVE, &clientPort );
+        status = mach_vm_map( mach_task_self( ),
+                              &address,
+                              sizeof( _DACallbackRing ) + ringSize,
+                              0,
+                              VM_FLAGS_ANYWHERE,
+                              ring,
+                              0,
+                              FALSE,
+                              VM_PROT_READ | VM_PROT_WRITE,
+                              VM_PROT_READ | VM_PROT_WRITE,
+                              VM_INHERIT_NONE );
+
+        mach_port_deallocate( mach_task_self( ), ring );
 
         if ( status == KERN_SUCCESS )
         {
-            mach_port_limits_t limits = { 0 };
+            session->_ring     = ( void * ) address;
+            session->_ringSize = ringSize;
+        }
+        else
+        {
+            status = kDAReturnNoResources;
+        }
+    }
 
-            limits.mpl_qlimit = 1;
+    return status;
+}
 
-            /*
-             * Set up the session's client port.  It requires no more than one queue element.
-             */
+static CFMutableArrayRef __DASessionCreateDescriptionsWithBytes( DASessionRef session, vm_address_t bytes, mach_msg_type_number_t length )
+{
+    CFMutableArrayRef descriptions = NULL;
+    CFArrayRef        serializations;
 
-            status = mach_port_set_attributes( mach_task_self( ),
-                                               clientPort,
-                                               MACH_PORT_LIMITS_INFO,
-                                               ( mach_port_info_t ) &limits,
-                                               MACH_PORT_LIMITS_INFO_COUNT );
+    serializations = _DAUnserializeWithBytes( CFGetAllocator( session ), bytes, length );
 
-            if ( status == KERN_SUCCESS )
+    if ( serializations )
+    {
+        descriptions = CFArrayCreateMutable( CFGetAllocator( session ), 0, &kCFTypeArrayCallBacks );
+
+        if ( descriptions )
+        {
+            CFIndex count;
+            CFIndex index;
+
+            count = CFArrayGetCount( serializations );
+
+            for ( index = 0; index < count; index++ )
             {
-                CFMachPortRef     client;
-                CFMachPortContext clientContext;
+                CFDictionaryRef description = NULL;
+                CFDataRef       serialization;
 
-                clientContext.version         = 0;
-                clientContext.info            = session;
-                clientContext.retain          = CFRetain;
-                clientContext.release         = CFRelease;
-                clientContext.copyDescription = NULL;
+                serialization = CFArrayGetValueAtIndex( serializations, index );
 
                 /*
-                 * Create the session's client port run loop source.
+                 * Decode each description as we would for a callback, which also lets the
+                 * session remember it.  Empty data stands for a disk without description.
                  */
 
-                client = CFMachPortCreateWithPort( CFGetAllocator( session ), clientPort, _DASessionCallback, &clientContext, NULL );
-
-                if ( client )
+                if ( CFDataGetLength( serialization ) )
                 {
-                    CFRunLoopSourceRef source;
+                    DADiskRef disk;
 
-                    source = CFMachPortCreateRunLoopSource( CFGetAllocator( session ), client, 0 );
+                    disk = _DADiskCreateFromSerialization( CFGetAllocator( session ), session, serialization );
 
-                    if ( source )
+                    if ( disk )
                     {
-                        session->_client = client;
-                        session->_source = source;
-
-                        _DAServerSessionSetClientPort( session->_server, CFMachPortGetPort( client ) );
+                        description = DADiskCopyDescription( disk );
 
-                        return;
+                        CFRelease( disk );
                     }
+                }
 
-                    CFMachPortInvalidate( client );
+                CFArrayAppendValue( descriptions, description ? ( CFTypeRef ) description : kCFNull );
 
-                    CFRelease( client );
-                }
+                if ( description )  CFRelease( description );
             }
-
-            mach_port_mod_refs( mach_task_self( ), clientPort, MACH_PORT_RIGHT_RECEIVE, -1 );
         }
+
+        CFRelease( serializations );
     }
+
+    return descriptions;
 }
 
-__private_extern__ void _DASessionUnscheduleFromRunLoop( DASessionRef session )
+static CFDictionaryRef __DASessionCopyDescriptionWithSerialization( DASessionRef session, CFDataRef serialization )
 {
-    if ( session->_sourceCount == 1 )
+    CFMutableDictionaryRef description = NULL;
+
+    /*
+     * Decode a description left undecoded on arrival.  Within a queue drain, identical descriptions
+     * share the one dictionary.  The description lock is held.
+     */
+
+    if ( session->_descriptionMemo )
     {
-        if ( session->_source )
+        description = ( void * ) CFDictionaryGetValue( session->_descriptionMemo, serialization );
+
+        if ( description )
         {
-            CFRunLoopSourceInvalidate( session->_source );
+            return CFRetain( description );
+        }
+    }
 
-            CFRelease( session->_source );
+    description = _DAUnserializeDiskDescription( CFGetAllocator( session ), serialization );
 
-            session->_source = NULL;
+    if ( description )
+    {
+        CFDictionaryRemoveValue( description, _kDADiskIDKey );
+        CFDictionaryRemoveValue( description, _kDADiskGenerationKey );
+
+        if ( session->_descriptionMemo )
+        {
+            CFDictionarySetValue( session->_descriptionMemo, serialization, description );
         }
+    }
 
-        if ( session->_client )
+    return description;
+}
+
+static CFDictionaryRef __DASessionGetEntryDescription( DASessionRef session, CFDataRef id, CFArrayRef entry )
+{
+    CFTypeRef description;
+
+    /*
+     * Decode the description of an entry on first use, and keep the result in its place.  The
+     * description lock is held.
+     */
+
+    description = CFArrayGetValueAtIndex( entry, 1 );
+
+    if ( CFGetTypeID( description ) == CFDataGetTypeID( ) )
+    {
+        CFDictionaryRef decoded;
+
+        description = NULL;
+
+        decoded = __DASessionCopyDescriptionWithSerialization( session, CFArrayGetValueAtIndex( entry, 1 ) );
+
+        if ( decoded )
         {
-            mach_port_t clientPort;
+            CFTypeRef values[3] = { CFArrayGetValueAtIndex( entry, 0 ), decoded, CFArrayGetValueAtIndex( entry, 2 ) };
 
-            clientPort = CFMachPortGetPort( session->_client );
+            entry = CFArrayCreate( kCFAllocatorDefault, values, 3, &kCFTypeArrayCallBacks );
 
-            CFMachPortInvalidate( session->_client );
+            if ( entry )
+            {
+                CFDictionarySetValue( session->_descriptions, id, entry );
 
-            CFRelease( session->_client );
+                CFRelease( entry );
 
-            mach_port_mod_refs( mach_task_self( ), clientPort, MACH_PORT_RIGHT_RECEIVE, -1 );
+                description = decoded;
+            }
 
-            session->_client = NULL;
+            CFRelease( decoded );
         }
-    }
 
-    if ( session->_sourceCount )
-    {
-        session->_sourceCount--;
+        if ( description == NULL )
+        {
+            CFDictionaryRemoveValue( session->_descriptions, id );
+        }
     }
+
+    return description;
 }
 
-#if TARGET_OS_OSX || TARGET_OS_MACCATALYST
-DAApprovalSessionRef DAApprovalSessionCreate( CFAllocatorRef allocator )
+static void __DASessionSetDescriptionMemo( DASessionRef session, Boolean enable )
 {
-    return DASessionCreate( allocator );
+    pthread_mutex_lock( &session->_descriptionLock );
+
+    if ( session->_descriptionMemo )
+    {
+        CFRelease( session->_descriptionMemo );
+
+        session->_descriptionMemo = NULL;
+    }
+
+    if ( enable )
+    {
+        session->_descriptionMemo = CFDictionaryCreateMutable( kCFAllocatorDefault, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks );
+    }
+
+    pthread_mutex_unlock( &session->_descriptionLock );
 }
-#endif
 
-CFTypeID DAApprovalSessionGetTypeID( void )
+static void __DASessionDeliverCallback( void * context )
 {
-    return DASessionGetTypeID( );
+    __DASessionDelivery * delivery = context;
+
+    _DADispatchCallback( delivery->session, delivery->address, delivery->context, delivery->kind, delivery->argument0, delivery->argument1 );
+
+    if ( delivery->argument0 )  CFRelease( delivery->argument0 );
+    if ( delivery->argument1 )  CFRelease( delivery->argument1 );
+
+    CFRelease( delivery->session );
+
+    /*
+     * This is our last touch of the disk's queue, which may be released once it drains.
+     */
+
+    OSAtomicDecrement32Barrier( delivery->pending );
+
+    free( delivery );
 }
 
-#if TARGET_OS_OSX || TARGET_OS_MACCATALYST
-void DAApprovalSessionScheduleWithRunLoop( DAApprovalSessionRef session, CFRunLoopRef runLoop, CFStringRef runLoopMode )
+static void __DASessionRetireDeliveryQueues( DASessionRef session )
 {
-    DASessionScheduleWithRunLoop( session, runLoop, kDAApprovalRunLoopMode );
+    CFIndex count;
+    CFIndex index;
 
-    DASessionScheduleWithRunLoop( session, runLoop, runLoopMode );
-}
+    /*
+     * Release the queues of the disks that disappeared, once their callbacks have been delivered.
+     * A queue whose disk has since reappeared stays in use, which keeps its callbacks in order.
+     */
 
+    count = CFArrayGetCount( session->_deliveryRetired );
 
-void DAApprovalSessionUnscheduleFromRunLoop( DAApprovalSessionRef session, CFRunLoopRef runLoop, CFStringRef runLoopMode )
-{
-    DASessionUnscheduleFromRunLoop( session, runLoop, kDAApprovalRunLoopMode );
+    for ( index = count - 1; index > -1; index-- )
+    {
+        __DASessionDeliveryQueue * entry;
+        CFDataRef                  id;
 
-    DASessionUnscheduleFromRunLoop( session, runLoop, runLoopMode );
-}
-#endif
+        id = CFArrayGetValueAtIndex( session->_deliveryRetired, index );
 
+        entry = ( void * ) CFDictionaryGetValue( session->_deliveryQueues, id );
 
-static bool DASessionEstablish(DASessionRef session  )
+        if ( entry && entry->retired )
+        {
+            if ( entry->pending )
+            {
+                continue;
+            }
+
+            dispatch_release( entry->queue );
+
+            free( entry );
+
+            CFDictionaryRemoveValue( session->_deliveryQueues, id );
+        }
+
+        CFArrayRemoveValueAtIndex( session->_deliveryRetired, index );
+    }
+}
+
+static void __DASessionDispatchCallback( DASessionRef    session,
+                                         void *          address,
+                                         void *          context,
+                                         _DACallbackKind kind,
+                                         CFTypeRef       argument0,
+                                         CFTypeRef       argument1 )
 {
-    if ( session )
+    __DASessionDeliveryQueue * queue = NULL;
+
+    if ( session->_deliveryQueue )
     {
-        mach_port_t   bootstrapPort;
-        kern_return_t status;
+        __DASessionRetireDeliveryQueues( session );
 
         /*
-         * Obtain the bootstrap port.
+         * Deliver the callbacks for a disk in order on a serial queue of its own, which targets the
+         * concurrent delivery queue.  Other callbacks wait for those delivered before them.
          */
 
-        status = task_get_bootstrap_port( mach_task_self( ), &bootstrapPort );
-
-        if ( status == KERN_SUCCESS )
+        if ( argument0 && CFGetTypeID( argument0 ) == CFDataGetTypeID( ) )
         {
-            mach_port_t masterPort;
+            CFDataRef id;
 
-            /*
-             * Obtain the Disk Arbitration master port.
-             */
+            id = _DAUnserializeDiskDescriptionCopyValue( kCFAllocatorDefault, argument0, _kDADiskIDKey );
 
-            status = bootstrap_look_up2( bootstrapPort, _kDADaemonName, &masterPort, 0, BOOTSTRAP_PRIVILEGED_SERVER );
+            if ( id )
+            {
+                queue = ( void * ) CFDictionaryGetValue( session->_deliveryQueues, id );
 
-            mach_port_deallocate( mach_task_self( ), bootstrapPort );
+                if ( queue == NULL )
+                {
+                    queue = malloc( sizeof( __DASessionDeliveryQueue ) );
 
-            if ( status == KERN_SUCCESS )
-            {
-                mach_port_t server;
+                    if ( queue )
+                    {
+                        queue->queue   = dispatch_queue_create_with_target( "com.apple.DiskArbitration.delivery", DISPATCH_QUEUE_SERIAL, session->_deliveryQueue );
+                        queue->pending = 0;
+                        queue->retired = FALSE;
 
-                /*
-                 * Create the session at the server.
-                 */
+                        if ( queue->queue )
+                        {
+                            dispatch_queue_set_specific( queue->queue, &__kDASessionDeliveryKey, session, NULL );
 
-                status = _DAServerSessionCreate( masterPort,
-                                                 basename( ( char * ) _dyld_get_image_name( 0 ) ),
-                                                 &server );
+                            CFDictionarySetValue( session->_deliveryQueues, id, queue );
+                        }
+                        else
+                        {
+                            free( queue );
 
-                mach_port_deallocate( mach_task_self( ), masterPort );
+                            queue = NULL;
+                        }
+                    }
+                }
 
-                if ( status == KERN_SUCCESS )
+                if ( queue )
                 {
-                    session->_name   = strdup( basename( ( char * ) _dyld_get_image_name( 0 ) ) );
-                    session->_pid    = getpid( );
-                    session->_server = server;
-#if TARGET_OS_OSX || TARGET_OS_MACCATALYST
-///w:start
-if ( strcmp( session->_name, "SystemUIServer" ) == 0 )
-{
-    _DASessionGetAuthorization( session );
-}
-///w:stop
-#endif
-                    return true;
+                    /*
+                     * Retire the queue with the disk's disappearance, unless the disk reappears first.
+                     */
+
+                    if ( kind == _kDADiskDisappearedCallback )
+                    {
+                        if ( queue->retired == FALSE )
+                        {
+                            queue->retired = TRUE;
+
+                            CFArrayAppendValue( session->_deliveryRetired, id );
+                        }
+                    }
+                    else
+                    {
+                        queue->retired = FALSE;
+                    }
                 }
+
+                CFRelease( id );
+            }
+        }
+
+        if ( queue )
+        {
+            __DASessionDelivery * delivery;
+
+            delivery = malloc( sizeof( __DASessionDelivery ) );
+
+            if ( delivery )
+            {
+                delivery->session   = ( void * ) CFRetain( session );
+                delivery->address   = address;
+                delivery->context   = context;
+                delivery->kind      = kind;
+                delivery->argument0 = argument0 ? CFRetain( argument0 ) : NULL;
+                delivery->argument1 = argument1 ? CFRetain( argument1 ) : NULL;
+                delivery->pending   = &queue->pending;
+
+                OSAtomicIncrement32Barrier( &queue->pending );
+
+                dispatch_group_async_f( session->_deliveryGroup, queue->queue, delivery, __DASessionDeliverCallback );
+
+                return;
             }
         }
+
+        dispatch_group_wait( session->_deliveryGroup, DISPATCH_TIME_FOREVER );
     }
-    return false;
+
+    _DADispatchCallback( session, address, context, kind, argument0, argument1 );
 }
 
-DASessionRef DASessionCreate( CFAllocatorRef allocator )
+static void __DASessionDrainCallbackRing( DASessionRef session )
 {
-    DASessionRef session;
+    _DACallbackRing * ring = session->_ring;
 
-    /*
-     * Initialize the Disk Arbitration framework.
-     */
+    for ( ; ; )
+    {
+        _DACallbackKind  kind;
+        mach_vm_offset_t address;
+        mach_vm_offset_t context;
+        CFDataRef        argument0;
+        CFTypeRef        argument1;
 
-    _DAInitialize( );
+        while ( _DACallbackRingDequeue( ring, session->_ringSize, CFGetAllocator( session ), &kind, &address, &context, &argument0, &argument1 ) )
+        {
+            __DASessionDispatchCallback( session, ( void * ) ( uintptr_t ) address, ( void * ) ( uintptr_t ) context, kind, argument0, argument1 );
+
+            if ( argument0 )  CFRelease( argument0 );
+            if ( argument1 )  CFRelease( argument1 );
+        }
+
+        /*
+         * Re-arm the server's notification, then look again in case a record was written before
+         * the server could observe it.  If the server consumed the arm, a notification is on its way.
+         */
+
+        atomic_store( &ring->armed, 1 );
+
+        if ( atomic_load( &ring->head ) == atomic_load( &ring->tail ) )
+        {
+            break;
+        }
+
+        if ( atomic_exchange( &ring->armed, 0 ) == 0 )
+        {
+            break;
+        }
+    }
+}
+
+__private_extern__ void _DASessionCallback( CFMachPortRef port, void * message, CFIndex messageSize, void * info )
+{
+    vm_address_t           _queue;
+    mach_msg_type_number_t _queueSize;
+    DASessionRef           session = info;
+    kern_return_t          status;
 
     /*
-     * Create the session.
+     * Identical descriptions delivered in this drain share one decoded dictionary.
      */
 
-    session = __DASessionCreate( allocator );
+    __DASessionSetDescriptionMemo( session, TRUE );
 
-    if ( session )
+    if ( session->_ring )
     {
-        mach_port_t   bootstrapPort;
-        kern_return_t status;
+        __DASessionDrainCallbackRing( session );
 
         /*
-         * Obtain the bootstrap port.
+         * Callbacks that did not fit in the ring are waiting in the regular queue.
          */
 
-        status = task_get_bootstrap_port( mach_task_self( ), &bootstrapPort );
-
-        if ( status == KERN_SUCCESS )
+        if ( atomic_exchange( &session->_ring->overflow, 0 ) == 0 )
         {
-            mach_port_t masterPort;
-
-            /*
-             * Obtain the Disk Arbitration master port.
-             */
+            __DASessionSetDescriptionMemo( session, FALSE );
 
-            status = bootstrap_look_up2( bootstrapPort, _kDADaemonName, &masterPort, 0, BOOTSTRAP_PRIVILEGED_SERVER );
+            return;
+        }
+    }
 
-            mach_port_deallocate( mach_task_self( ), bootstrapPort );
+    status = _DAServerSessionCopyCallbackQueue( session->_server, &_queue, &_queueSize );
 
-            if ( status == KERN_SUCCESS )
-            {
-                mach_port_t server;
+    if ( status == KERN_SUCCESS )
+    {
+        CFArrayRef queue;
 
-                /*
-                 * Create the session at the server.
-                 */
+        queue = _DAUnserializeWithBytes( CFGetAllocator( session ), _queue, _queueSize );
 
-                status = _DAServerSessionCreate( masterPort,
-                                                 basename( ( char * ) _dyld_get_image_name( 0 ) ),
-                                                 &server );
+        if ( queue )
+        {
+            CFIndex count;
+            CFIndex index;
 
-                mach_port_deallocate( mach_task_self( ), masterPort );
+            count = CFArrayGetCount( queue );
 
-                if ( status == KERN_SUCCESS )
+            for ( index = 0; index < count; index++ )
+            {
+                CFDictionaryRef callback;
+                
+                callback = CFArrayGetValueAtIndex( queue, index );
+
+                if ( callback )
                 {
-                    session->_name   = strdup( basename( ( char * ) _dyld_get_image_name( 0 ) ) );
-                    session->_pid    = getpid( );
-                    session->_server = server;
+                    void * address;
+                    void * context;
+
+                    CFTypeRef argument0;
+                    CFTypeRef argument1;
+
+                    address = ( void * ) ( uintptr_t ) ___CFDictionaryGetIntegerValue( callback, _kDACallbackAddressKey );
+                    context = ( void * ) ( uintptr_t ) ___CFDictionaryGetIntegerValue( callback, _kDACallbackContextKey );
+
+                    argument0 = CFDictionaryGetValue( callback, _kDACallbackArgument0Key );
+                    argument1 = CFDictionaryGetValue( callback, _kDACallbackArgument1Key );
+                    
+                    __DASessionDispatchCallback( session, address, context, ___CFDictionaryGetIntegerValue( callback, _kDACallbackKindKey ), argument0, argument1 );
+                }
+            }
+
+            CFRelease( queue );
+        }
+
+        vm_deallocate( mach_task_self( ), _queue, _queueSize );
+    }
+
+    __DASessionSetDescriptionMemo( session, FALSE );
+}
 #if TARGET_OS_OSX || TARGET_OS_MACCATALYST
-///w:start
-if ( strcmp( session->_name, "SystemUIServer" ) == 0 )
+__private_extern__ AuthorizationRef _DASessionGetAuthorization( DASessionRef session )
 {
-    _DASessionGetAuthorization( session );
+    AuthorizationRef authorization;
+
+    pthread_mutex_lock( &__gDASessionSetAuthorizationLock );
+
+    authorization = session->_authorization;
+
+    if ( authorization == NULL )
+    {
+        kern_return_t status;
+
+        /*
+         * Create the session's authorization reference.
+         */
+
+        status = AuthorizationCreate( NULL, NULL, kAuthorizationFlagDefaults, &authorization );
+
+        if ( status == errAuthorizationSuccess )
+        {
+            AuthorizationExternalForm _authorization;
+
+            /*
+             * Create the session's authorization reference representation.
+             */
+
+            status = AuthorizationMakeExternalForm( authorization, &_authorization );
+
+            if ( status == errAuthorizationSuccess )
+            {
+                _DAServerSessionSetAuthorization( session->_server, _authorization );
+
+                session->_authorization = authorization;
+            }
+            else
+            {
+                AuthorizationFree( authorization, kAuthorizationFlagDefaults );
+
+                authorization = NULL;
+            }
+        }
+    }
+
+    pthread_mutex_unlock( &__gDASessionSetAuthorizationLock );
+
+    return authorization;
 }
-///w:stop
 #endif
-                    return session;
+#ifndef __LP64__
+
+__private_extern__ mach_port_t _DASessionGetClientPort( DASessionRef session )
+{
+    mach_port_t client;
+
+    client = MACH_PORT_NULL;
+
+    if ( session->_client )
+    {
+        client = CFMachPortGetPort( session->_client );
+    }
+
+    return client;
+}
+
+#endif /* !__LP64__ */
+
+__private_extern__ CFDictionaryRef _DASessionCopyCachedDescription( DASessionRef session, CFDataRef id )
+{
+    CFDictionaryRef description = NULL;
+
+    /*
+     * A description is current for as long as we receive the disk's description changes, which
+     * requires our registration with the server and a scheduled session to process them.
+     */
+
+    if ( session->_descriptionCache && session->_descriptionCacheState == __kDASessionDescriptionCacheStateRegistered )
+    {
+        if ( session->_source || session->_source2 )
+        {
+            CFArrayRef entry;
+
+            pthread_mutex_lock( &session->_descriptionLock );
+
+            entry = CFDictionaryGetValue( session->_descriptions, id );
+
+            if ( entry )
+            {
+                if ( CFArrayGetValueAtIndex( entry, 2 ) == kCFBooleanTrue )
+                {
+                    description = __DASessionGetEntryDescription( session, id, entry );
+
+                    if ( description )  CFRetain( description );
+                }
+            }
+
+            pthread_mutex_unlock( &session->_descriptionLock );
+        }
+    }
+
+    return description;
+}
+
+__private_extern__ CFDictionaryRef _DASessionCopyDescription( DASessionRef session, CFDataRef id, SInt64 * generation )
+{
+    CFArrayRef      entry;
+    CFDictionaryRef description = NULL;
+
+    pthread_mutex_lock( &session->_descriptionLock );
+
+    entry = CFDictionaryGetValue( session->_descriptions, id );
+
+    if ( entry )
+    {
+        CFNumberGetValue( CFArrayGetValueAtIndex( entry, 0 ), kCFNumberSInt64Type, generation );
+
+        description = __DASessionGetEntryDescription( session, id, entry );
+
+        if ( description )  CFRetain( description );
+    }
+
+    pthread_mutex_unlock( &session->_descriptionLock );
+
+    return description;
+}
+
+__private_extern__ CFDictionaryRef _DASessionCopyDescriptionWithSerialization( DASessionRef session, CFDataRef serialization )
+{
+    CFDictionaryRef description;
+
+    pthread_mutex_lock( &session->_descriptionLock );
+
+    description = __DASessionCopyDescriptionWithSerialization( session, serialization );
+
+    pthread_mutex_unlock( &session->_descriptionLock );
+
+    return description;
+}
+
+__private_extern__ Boolean _DASessionDeferCallbackRegistration( DASessionRef session, SInt32 index )
+{
+    Boolean defer = FALSE;
+
+    /*
+     * Hold the registration back for DASessionCommitCallbackRegistration, should it be pending.
+     */
+
+    pthread_mutex_lock( &session->_registerLock );
+
+    if ( session->_registerPending )
+    {
+        CFNumberRef key;
+
+        key = CFNumberCreate( kCFAllocatorDefault, kCFNumberSInt32Type, &index );
+
+        if ( key )
+        {
+            if ( CFArrayContainsValue( session->_registerPending, CFRangeMake( 0, CFArrayGetCount( session->_registerPending ) ), key ) == FALSE )
+            {
+                CFArrayAppendValue( session->_registerPending, key );
+            }
+
+            CFRelease( key );
+
+            defer = TRUE;
+        }
+    }
+
+    pthread_mutex_unlock( &session->_registerLock );
+
+    return defer;
+}
+
+__private_extern__ mach_port_t _DASessionGetID( DASessionRef session )
+{
+    return session->_server;
+}
+
+__private_extern__ Boolean _DASessionIsDescriptionCacheCurrent( DASessionRef session )
+{
+    return ( session->_descriptionCacheState == __kDASessionDescriptionCacheStateRegistered );
+}
+
+__private_extern__ bool _DASessionIsKeepAlive( DASessionRef session )
+{
+    return ( session->_keepAlive == true );
+}
+
+__private_extern__ void _DASessionPrepareDescriptionCache( DASessionRef session )
+{
+    /*
+     * Register for the description changes and disappearances of all disks on first use of the
+     * cache, which keeps it current without a round trip to the server for each description.
+     */
+
+    if ( session->_descriptionCache && ( session->_encoding & _kDAEncodingDelta ) )
+    {
+        /*
+         * Wait out a pending batch of registrations, which would hold ours back from the server.
+         */
+
+        if ( ( session->_source || session->_source2 ) && session->_registerPending == NULL )
+        {
+            if ( OSAtomicCompareAndSwap32Barrier( __kDASessionDescriptionCacheStateNone, __kDASessionDescriptionCacheStateRegistering, &session->_descriptionCacheState ) )
+            {
+                _DARegisterCallback( session, NULL, session, _kDADiskDescriptionChangedCallback, 0, NULL, NULL, false );
+                _DARegisterCallback( session, NULL, session, _kDADiskDisappearedCallback,        0, NULL, NULL, false );
+
+                /*
+                 * The descriptions we hold may predate the registration, and thus miss changes.
+                 */
+
+                pthread_mutex_lock( &session->_descriptionLock );
+                CFDictionaryRemoveAllValues( session->_descriptions );
+                pthread_mutex_unlock( &session->_descriptionLock );
+
+                OSAtomicCompareAndSwap32Barrier( __kDASessionDescriptionCacheStateRegistering, __kDASessionDescriptionCacheStateRegistered, &session->_descriptionCacheState );
+            }
+        }
+    }
+}
+
+__private_extern__ void _DASessionResync( DASessionRef session )
+{
+    /*
+     * The server dropped callbacks for us.  Forget what we know about the disks and have the
+     * server replay its disk list; the server still delivers every disappearance we are owed.
+     */
+
+    pthread_mutex_lock( &session->_descriptionLock );
+    CFDictionaryRemoveAllValues( session->_descriptions );
+    pthread_mutex_unlock( &session->_descriptionLock );
+
+    os_log( OS_LOG_DEFAULT, "session fell behind diskarbitrationd, resynchronizing" );
+
+    _DAServerSessionResync( session->_server );
+}
+
+__private_extern__ void _DASessionSetDescription( DASessionRef session, CFDataRef id, CFTypeRef description, SInt64 generation, Boolean current )
+{
+    /*
+     * Remember the last description seen for each disk, so that description changes can be
+     * delivered as deltas against it.  Descriptions are only needed for sessions receiving deltas.
+     * The description may be its serialization still, to be decoded should it be needed.
+     */
+
+    if ( ( session->_encoding & _kDAEncodingDelta ) == 0 )
+    {
+        return;
+    }
+
+    pthread_mutex_lock( &session->_descriptionLock );
+
+    if ( description )
+    {
+        CFArrayRef  entry;
+        CFNumberRef number;
+
+        entry = CFDictionaryGetValue( session->_descriptions, id );
+
+        if ( entry )
+        {
+            if ( CFArrayGetValueAtIndex( entry, 2 ) == kCFBooleanTrue )
+            {
+                SInt64 value;
+
+                /*
+                 * A current description stays current through the changes that follow it, so long
+                 * as we do not go back to an older generation of it.
+                 */
+
+                CFNumberGetValue( CFArrayGetValueAtIndex( entry, 0 ), kCFNumberSInt64Type, &value );
+
+                if ( generation < value )
+                {
+                    pthread_mutex_unlock( &session->_descriptionLock );
+
+                    return;
                 }
+
+                current = TRUE;
+            }
+        }
+
+        if ( CFDictionaryGetCount( session->_descriptions ) >= __kDASessionDescriptionCountMaximum )
+        {
+            CFDictionaryRemoveAllValues( session->_descriptions );
+        }
+
+        number = CFNumberCreate( kCFAllocatorDefault, kCFNumberSInt64Type, &generation );
+
+        if ( number )
+        {
+            CFTypeRef  values[3] = { number, description, current ? kCFBooleanTrue : kCFBooleanFalse };
+
+            entry = CFArrayCreate( kCFAllocatorDefault, values, 3, &kCFTypeArrayCallBacks );
+
+            if ( entry )
+            {
+                CFDictionarySetValue( session->_descriptions, id, entry );
+
+                CFRelease( entry );
+            }
+
+            CFRelease( number );
+        }
+    }
+    else
+    {
+        CFDictionaryRemoveValue( session->_descriptions, id );
+    }
+
+    pthread_mutex_unlock( &session->_descriptionLock );
+}
+
+__private_extern__ void _DASessionInitialize( void )
+{
+    __kDASessionTypeID = _CFRuntimeRegisterClass( &__DASessionClass );
+}
+
+__private_extern__ void _DASessionScheduleWithRunLoop( DASessionRef session )
+{
+    session->_sourceCount++;
+
+    if ( session->_sourceCount == 1 )
+    {
+        mach_port_t   clientPort;
+        kern_return_t status;
+
+        /*
+         * Create the session's client port.
+         */
+
+        status = mach_port_allocate( mach_task_self( ), MACH_PORT_RIGHT_RECEIVE, &clientPort );
+
+        if ( status == KERN_SUCCESS )
+        {
+            mach_port_limits_t limits = { 0 };
+
+            limits.mpl_qlimit = 1;
+
+            /*
+             * Set up the session's client port.  It requires no more than one queue element.
+             */
+
+            status = mach_port_set_attributes( mach_task_self( ),
+                                               clientPort,
+                                               MACH_PORT_LIMITS_INFO,
+                                               ( mach_port_info_t ) &limits,
+                                               MACH_PORT_LIMITS_INFO_COUNT );
+
+            if ( status == KERN_SUCCESS )
+            {
+                CFMachPortRef     client;
+                CFMachPortContext clientContext;
+
+                clientContext.version         = 0;
+                clientContext.info            = session;
+                clientContext.retain          = CFRetain;
+                clientContext.release         = CFRelease;
+                clientContext.copyDescription = NULL;
+
+                /*
+                 * Create the session's client port run loop source.
+                 */
+
+                client = CFMachPortCreateWithPort( CFGetAllocator( session ), clientPort, _DASessionCallback, &clientContext, NULL );
+
+                if ( client )
+                {
+                    CFRunLoopSourceRef source;
+
+                    source = CFMachPortCreateRunLoopSource( CFGetAllocator( session ), client, 0 );
+
+                    if ( source )
+                    {
+                        session->_client = client;
+                        session->_source = source;
+
+                        _DAServerSessionSetClientPort( session->_server, CFMachPortGetPort( client ) );
+
+                        return;
+                    }
+
+                    CFMachPortInvalidate( client );
+
+                    CFRelease( client );
+                }
+            }
+
+            mach_port_mod_refs( mach_task_self( ), clientPort, MACH_PORT_RIGHT_RECEIVE, -1 );
+        }
+    }
+}
+
+__private_extern__ void _DASessionUnscheduleFromRunLoop( DASessionRef session )
+{
+    if ( session->_sourceCount == 1 )
+    {
+        if ( session->_source )
+        {
+            CFRunLoopSourceInvalidate( session->_source );
+
+            CFRelease( session->_source );
+
+            session->_source = NULL;
+        }
+
+        if ( session->_client )
+        {
+            mach_port_t clientPort;
+
+            clientPort = CFMachPortGetPort( session->_client );
+
+            CFMachPortInvalidate( session->_client );
+
+            CFRelease( session->_client );
+
+            mach_port_mod_refs( mach_task_self( ), clientPort, MACH_PORT_RIGHT_RECEIVE, -1 );
+
+            session->_client = NULL;
+        }
+    }
+
+    if ( session->_sourceCount )
+    {
+        session->_sourceCount--;
+    }
+}
+
+#if TARGET_OS_OSX || TARGET_OS_MACCATALYST
+DAApprovalSessionRef DAApprovalSessionCreate( CFAllocatorRef allocator )
+{
+    return DASessionCreate( allocator );
+}
+#endif
+
+CFTypeID DAApprovalSessionGetTypeID( void )
+{
+    return DASessionGetTypeID( );
+}
+
+#if TARGET_OS_OSX || TARGET_OS_MACCATALYST
+void DAApprovalSessionScheduleWithRunLoop( DAApprovalSessionRef session, CFRunLoopRef runLoop, CFStringRef runLoopMode )
+{
+    DASessionScheduleWithRunLoop( session, runLoop, kDAApprovalRunLoopMode );
+
+    DASessionScheduleWithRunLoop( session, runLoop, runLoopMode );
+}
+
+
+void DAApprovalSessionUnscheduleFromRunLoop( DAApprovalSessionRef session, CFRunLoopRef runLoop, CFStringRef runLoopMode )
+{
+    DASessionUnscheduleFromRunLoop( session, runLoop, kDAApprovalRunLoopMode );
+
+    DASessionUnscheduleFromRunLoop( session, runLoop, runLoopMode );
+}
+#endif
+
+
+static bool DASessionEstablish(DASessionRef session  )
+{
+    if ( session )
+    {
+        mach_port_t   bootstrapPort;
+        kern_return_t status;
+
+        /*
+         * Obtain the bootstrap port.
+         */
+
+        status = task_get_bootstrap_port( mach_task_self( ), &bootstrapPort );
+
+        if ( status == KERN_SUCCESS )
+        {
+            mach_port_t masterPort;
+
+            /*
+             * Obtain the Disk Arbitration master port.
+             */
+
+            status = bootstrap_look_up2( bootstrapPort, _kDADaemonName, &masterPort, 0, BOOTSTRAP_PRIVILEGED_SERVER );
+
+            mach_port_deallocate( mach_task_self( ), bootstrapPort );
+
+            if ( status == KERN_SUCCESS )
+            {
+                mach_port_t server;
+                uint32_t    encoding;
+
+                /*
+                 * Create the session at the server.
+                 */
+
+                status = _DAServerSessionCreate( masterPort,
+                                                 basename( ( char * ) _dyld_get_image_name( 0 ) ),
+                                                 _kDAEncodingPropertyList | _kDAEncodingCompact | _kDAEncodingDelta,
+                                                 &server,
+                                                 &encoding );
+
+                mach_port_deallocate( mach_task_self( ), masterPort );
+
+                if ( status == KERN_SUCCESS )
+                {
+                    session->_encoding = encoding;
+                    session->_name     = strdup( basename( ( char * ) _dyld_get_image_name( 0 ) ) );
+                    session->_pid      = getpid( );
+                    session->_server   = server;
+#if TARGET_OS_OSX || TARGET_OS_MACCATALYST
+///w:start
+if ( strcmp( session->_name, "SystemUIServer" ) == 0 )
+{
+    _DASessionGetAuthorization( session );
+}
+///w:stop
+#endif
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+DASessionRef DASessionCreate( CFAllocatorRef allocator )
+{
+    DASessionRef session;
+
+    /*
+     * Initialize the Disk Arbitration framework.
+     */
+
+    _DAInitialize( );
+
+    /*
+     * Create the session.
+     */
+
+    session = __DASessionCreate( allocator );
+
+    if ( session )
+    {
+        mach_port_t   bootstrapPort;
+        kern_return_t status;
+
+        /*
+         * Obtain the bootstrap port.
+         */
+
+        status = task_get_bootstrap_port( mach_task_self( ), &bootstrapPort );
+
+        if ( status == KERN_SUCCESS )
+        {
+            mach_port_t masterPort;
+
+            /*
+             * Obtain the Disk Arbitration master port.
+             */
+
+            status = bootstrap_look_up2( bootstrapPort, _kDADaemonName, &masterPort, 0, BOOTSTRAP_PRIVILEGED_SERVER );
+
+            mach_port_deallocate( mach_task_self( ), bootstrapPort );
+
+            if ( status == KERN_SUCCESS )
+            {
+                mach_port_t server;
+                uint32_t    encoding;
+
+                /*
+                 * Create the session at the server.
+                 */
+
+                status = _DAServerSessionCreate( masterPort,
+                                                 basename( ( char * ) _dyld_get_image_name( 0 ) ),
+                                                 _kDAEncodingPropertyList | _kDAEncodingCompact | _kDAEncodingDelta,
+                                                 &server,
+                                                 &encoding );
+
+                mach_port_deallocate( mach_task_self( ), masterPort );
+
+                if ( status == KERN_SUCCESS )
+                {
+                    session->_encoding = encoding;
+                    session->_name     = strdup( basename( ( char * ) _dyld_get_image_name( 0 ) ) );
+                    session->_pid      = getpid( );
+                    session->_server   = server;
+#if TARGET_OS_OSX || TARGET_OS_MACCATALYST
+///w:start
+if ( strcmp( session->_name, "SystemUIServer" ) == 0 )
+{
+    _DASessionGetAuthorization( session );
+}
+///w:stop
+#endif
+                    return session;
+                }
+            }
+        }
+
+        CFRelease( session );
+    }
+
+    return NULL;
+}
+
+CFTypeID DASessionGetTypeID( void )
+{
+    _DAInitialize( );
+
+    return __kDASessionTypeID;
+}
+
+void DASessionScheduleWithRunLoop( DASessionRef session, CFRunLoopRef runLoop, CFStringRef runLoopMode )
+{
+    if ( session )
+    {
+        _DASessionScheduleWithRunLoop( session );
+
+        if ( session->_source )
+        {
+            CFRunLoopAddSource( runLoop, session->_source, runLoopMode );
+        }
+    }
+}
+
+void DASessionSetDispatchQueue( DASessionRef session, dispatch_queue_t queue )
+{
+    if ( session )
+    {
+        if ( session->_source2 )
+        {
+            dispatch_source_cancel( session->_source2 );
+
+            dispatch_release( session->_source2 );
+
+            session->_source2 = NULL;
+        }
+
+        if ( queue )
+        {
+            mach_port_t   client;
+            kern_return_t status;
+
+            /*
+             * Create the session's client port.
+             */
+
+            status = mach_port_allocate( mach_task_self( ), MACH_PORT_RIGHT_RECEIVE, &client );
+
+            if ( status == KERN_SUCCESS )
+            {
+                mach_port_limits_t limits = { 0 };
+
+                limits.mpl_qlimit = 1;
+
+                /*
+                 * Set up the session's client port.  It requires no more than one queue element.
+                 */
+
+                status = mach_port_set_attributes( mach_task_self( ),
+                                                   client,
+                                                   MACH_PORT_LIMITS_INFO,
+                                                   ( mach_port_info_t ) &limits,
+                                                   MACH_PORT_LIMITS_INFO_COUNT );
+
+                if ( status == KERN_SUCCESS )
+                {
+                    dispatch_source_t source;
+
+                    /*
+                     * Create the session's client port dispatch source.
+                     */
+
+                    source = dispatch_source_create( DISPATCH_SOURCE_TYPE_MACH_RECV, client, 0, queue );
+
+                    if ( source )
+                    {
+                        session->_source2 = source;
+
+                        CFRetain( session );
+                        mach_port_t port;
+                        
+                        status = mach_port_request_notification( mach_task_self( ),
+                                                                client,
+                                                                 MACH_NOTIFY_NO_SENDERS,
+                                                                 1,
+                                                                client,
+                                                                 MACH_MSG_TYPE_MAKE_SEND_ONCE,
+                                                                 &port );
+                        if ( status == KERN_SUCCESS )
+                        {
+
+                            dispatch_source_set_cancel_handler( session->_source2, ^
+                                                               {
+                                mach_port_mod_refs( mach_task_self( ), client, MACH_PORT_RIGHT_RECEIVE, -1 );
+
+                                CFRelease( session );
+                            } );
+
+                            dispatch_source_set_event_handler( session->_source2, ^
+                                                              {
+                                mach_msg_empty_rcv_t message;
+                                mach_msg( ( void * ) &message, MACH_RCV_MSG | MACH_RCV_TIMEOUT, 0, sizeof( message ), client, 0, MACH_PORT_NULL );
+                                if (MACH_NOTIFY_NO_SENDERS == message.header.msgh_id)
+                                {
+                                    os_log(OS_LOG_DEFAULT, "diskarbitrationd exited.");
+                                    if ( session->_name )  free( session->_name );
+                                    session->_name = NULL;
+                                    if ( session->_server )  mach_port_deallocate( mach_task_self( ), session->_server );
+                                    session->_server        = MACH_PORT_NULL;
+#if TARGET_OS_OSX || TARGET_OS_MACCATALYST
+                                    if ( session->_authorization )  AuthorizationFree( session->_authorization, kAuthorizationFlagDefaults );
+                                    session->_authorization = NULL;
+#endif
+                                }
+                                else
+                                {
+                                    _DASessionCallback( NULL, NULL, 0, session );
+                                }
+                                
+                            } );
+
+                            dispatch_resume( session->_source2 );
+
+                            _DAServerSessionSetClientPort( session->_server, client );
+
+                            return;
+                        }
+                    }
+                }
+
+                mach_port_mod_refs( mach_task_self( ), client, MACH_PORT_RIGHT_RECEIVE, -1 );
+            }
+        }
+    }
+}
+
+void DASessionUnscheduleFromRunLoop( DASessionRef session, CFRunLoopRef runLoop, CFStringRef runLoopMode )
+{
+    if ( session )
+    {
+        if ( session->_source )
+        {
+            CFRunLoopRemoveSource( runLoop, session->_source, runLoopMode );
+        }
+
+        _DASessionUnscheduleFromRunLoop( session );
+    }
+}
+
+__private_extern__ CFMutableDictionaryRef DACallbackCreate( CFAllocatorRef   allocator,
+                                mach_vm_offset_t address,
+                                mach_vm_offset_t context,
+                                _DACallbackKind kind,
+                                CFIndex         order,
+                                CFDataRef match,
+                                CFDataRef      watch,
+                                bool block )
+{
+    CFMutableDictionaryRef callback;
+
+    callback = CFDictionaryCreateMutable( allocator, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks );
+
+    if ( callback )
+    {
+        ___CFDictionarySetIntegerValue( callback, _kDACallbackAddressKey, address );
+        ___CFDictionarySetIntegerValue( callback, _kDACallbackContextKey, context );
+        ___CFDictionarySetIntegerValue( callback, _kDACallbackKindKey,    kind    );
+        ___CFDictionarySetIntegerValue( callback, _kDACallbackOrderKey,   order   );
+        ___CFDictionarySetIntegerValue( callback, _kDACallbackBlockKey,   block   );
+
+        if ( match )  CFDictionarySetValue( callback, _kDACallbackMatchKey, match );
+        if ( watch )  CFDictionarySetValue( callback, _kDACallbackWatchKey, watch );
+    }
+
+    return  callback;
+}
+
+__private_extern__ SInt32 DAAddCallbackToSession(DASessionRef session, CFMutableDictionaryRef callback)
+{
+    SInt32 handle = 0;
+
+    /*
+     * Add the callback dict object to the session's register
+     */
+
+    if ( session )
+    {
+        __DASessionCallbackSlot * entry = NULL;
+        SInt32                    slot  = 0;
+
+        pthread_mutex_lock( &session->_registerLock );
+
+        if ( session->_registerChunks == NULL )
+        {
+            session->_registerHash = calloc( __kDASessionRegisterHashSize, sizeof( SInt32 ) );
+
+            if ( session->_registerHash )
+            {
+                session->_registerChunks = calloc( __kDASessionRegisterChunkCount, sizeof( __DASessionCallbackSlot * ) );
+            }
+        }
+
+        if ( session->_registerChunks )
+        {
+            if ( session->_registerFree )
+            {
+                slot = session->_registerFree - 1;
+
+                entry = __DASessionGetCallbackSlot( session, slot );
+
+                session->_registerFree = entry->next;
+            }
+            else if ( session->_registerLimit < __kDASessionRegisterChunkCount * __kDASessionRegisterChunkSize )
+            {
+                slot = session->_registerLimit;
+
+                if ( ( slot % __kDASessionRegisterChunkSize ) == 0 )
+                {
+                    __DASessionCallbackSlot * chunk;
+
+                    chunk = calloc( __kDASessionRegisterChunkSize, sizeof( __DASessionCallbackSlot ) );
+
+                    if ( chunk )
+                    {
+                        OSMemoryBarrier( );
+
+                        session->_registerChunks[ slot / __kDASessionRegisterChunkSize ] = chunk;
+                    }
+                }
+
+                entry = __DASessionGetCallbackSlot( session, slot );
+
+                if ( entry )
+                {
+                    session->_registerLimit++;
+                }
+            }
+        }
+
+        if ( entry )
+        {
+            SInt32 * bucket;
+
+            CFRetain( callback );
+
+            entry->callback = callback;
+            entry->address  = ( mach_vm_offset_t ) ___CFDictionaryGetIntegerValue( callback, _kDACallbackAddressKey );
+            entry->context  = ( mach_vm_offset_t ) ___CFDictionaryGetIntegerValue( callback, _kDACallbackContextKey );
+            entry->sequence = ++session->_registerSequence;
+            entry->tag      = ( entry->tag % __kDASessionRegisterTagMaximum ) + 1;
+
+            bucket = &session->_registerHash[ __DASessionGetCallbackHash( entry->address, entry->context ) ];
+
+            entry->next = *bucket;
+
+            *bucket = slot + 1;
+
+            handle = ( entry->tag << 16 ) | slot;
+
+            OSMemoryBarrier( );
+
+            entry->handle = handle;
+        }
+        else
+        {
+            os_log_fault( OS_LOG_DEFAULT, "unable to add callback to session %p", session );
+        }
+
+        pthread_mutex_unlock( &session->_registerLock );
+    }
+
+    return handle;
+}
+
+__private_extern__ void DARemoveCallbackFromSessionWithKey(DASessionRef session, SInt32 index)
+{
+    /*
+     * Remove the callback dict object from the session's register
+     */
+
+    if ( session && index > 0 )
+    {
+        __DASessionCallbackSlot * entry;
+
+        pthread_mutex_lock( &session->_registerLock );
+
+        entry = __DASessionGetCallbackSlot( session, index & 0xFFFF );
+
+        if ( entry && entry->handle == index )
+        {
+            __DASessionRemoveCallbackSlot( session, index & 0xFFFF );
+        }
+
+        pthread_mutex_unlock( &session->_registerLock );
+    }
+}
+
+__private_extern__ SInt32 DARemoveCallbackFromSession(DASessionRef session, mach_vm_offset_t address,
+                                mach_vm_offset_t context)
+{
+    SInt32 matchingKey = 0;
+
+    /*
+     * Remove the callback dict object from the session's register
+     * by matching the address and context
+     */
+
+    if ( session )
+    {
+        pthread_mutex_lock( &session->_registerLock );
+
+        if ( session->_registerHash )
+        {
+            SInt32 next;
+
+            next = session->_registerHash[ __DASessionGetCallbackHash( address, context ) ];
+
+            while ( next )
+            {
+                __DASessionCallbackSlot * entry;
+
+                entry = __DASessionGetCallbackSlot( session, next - 1 );
+
+                if ( entry->address == address && entry->context == context )
+                {
+                    matchingKey = entry->handle;
+
+                    __DASessionRemoveCallbackSlot( session, next - 1 );
+
+                    break;
+                }
+
+                next = entry->next;
+            }
+        }
+
+        pthread_mutex_unlock( &session->_registerLock );
+    }
+    return matchingKey;
+}
+
+__private_extern__ CFMutableDictionaryRef DACopyCallbackFromSession(DASessionRef session, SInt32 index)
+{
+    CFMutableDictionaryRef callback = 0;
+
+    /*
+     * Retain the callback object, and its block, without the register lock, so that neither is
+     * freed by an unregistration while the callback is being delivered.  The reader count holds
+     * off the release of the slot until the retain is done, and the handle is checked again once
+     * it is, should the slot have been released or reused in between.
+     */
+
+    if ( session && index > 0 )
+    {
+        __DASessionCallbackSlot * entry;
+
+        OSAtomicIncrement32Barrier( &session->_registerReaders );
+
+        entry = __DASessionGetCallbackSlot( session, index & 0xFFFF );
+
+        if ( entry && entry->handle == index )
+        {
+            mach_vm_offset_t address;
+            Boolean          block;
+
+            callback = ( void * ) CFRetain( entry->callback );
+            address  = entry->address;
+            block    = ___CFDictionaryGetIntegerValue( callback, _kDACallbackBlockKey ) ? TRUE : FALSE;
+
+            if ( block )
+            {
+                ( void ) Block_copy( ( void * ) ( uintptr_t ) address );
+            }
+
+            OSMemoryBarrier( );
+
+            if ( entry->handle != index )
+            {
+                if ( block )
+                {
+                    Block_release( ( void * ) ( uintptr_t ) address );
+                }
+
+                CFRelease( callback );
+
+                callback = NULL;
+            }
+        }
+
+        OSAtomicDecrement32Barrier( &session->_registerReaders );
+    }
+
+    return callback;
+}
+
+__private_extern__ void _DASessionWaitForDelivery( DASessionRef session )
+{
+    /*
+     * Let the callbacks in flight on the concurrent delivery queue finish, so that none runs after
+     * its unregistration returns.  A callback cannot wait for the callbacks of its own session, so
+     * an unregistration from one relies on the lookup at delivery to find the slot gone instead.
+     * One made from a callback of another session waits as any other would.
+     */
+
+    if ( session->_deliveryGroup )
+    {
+        if ( dispatch_get_specific( &__kDASessionDeliveryKey ) != session )
+        {
+            dispatch_group_wait( session->_deliveryGroup, DISPATCH_TIME_FOREVER );
+        }
+    }
+}
+
+__private_extern__ DAReturn _DASessionRecreate( DASessionRef session )
+{
+    Boolean  current;
+    DAReturn status = kDAReturnSuccess;
+    CFIndex  index;
+    
+    if ( false == DASessionEstablish(session) )
+    {
+        os_log(OS_LOG_DEFAULT, "failed to establish session with diskarbitrationd");
+        return kDAReturnBadArgument;
+    }
+
+    /*
+     * Generations restart with the server, so the descriptions we hold are no base for deltas.
+     * Nor are they current until we have registered with the server again.
+     */
+
+    current = OSAtomicCompareAndSwap32Barrier( __kDASessionDescriptionCacheStateRegistered, __kDASessionDescriptionCacheStateRegistering, &session->_descriptionCacheState );
+
+    pthread_mutex_lock( &session->_descriptionLock );
+    CFDictionaryRemoveAllValues( session->_descriptions );
+    pthread_mutex_unlock( &session->_descriptionLock );
+    
+    if ( session->_ring )
+    {
+        mach_vm_deallocate( mach_task_self( ), ( mach_vm_address_t ) session->_ring, sizeof( _DACallbackRing ) + session->_ringSize );
+
+        session->_ring = NULL;
+
+        __DASessionCreateCallbackRing( session );
+    }
+
+    if ( session->_interval )
+    {
+        _DAServerSessionSetCoalescingInterval( session->_server, session->_interval );
+    }
+
+    if ( session->_queueLimit )
+    {
+        _DAServerSessionSetQueueLimit( session->_server, session->_queueLimit );
+    }
+
+    DASessionSetDispatchQueue( session, session->_queue);
+    
+    /*
+     * Register every callback again in one message, in the order they were first registered.  The
+     * callbacks held back by an open batch are left to DASessionCommitCallbackRegistration, which
+     * would otherwise register them a second time.
+     */
+
+    pthread_mutex_lock( &session->_registerLock );
+
+    CFIndex count = 0;
+    __DASessionCallbackSlot * slots = malloc( sizeof( __DASessionCallbackSlot ) * MAX( session->_registerLimit, 1 ) );
+
+    if ( slots )
+    {
+        for ( index = 0; index < session->_registerLimit; index++ )
+        {
+            __DASessionCallbackSlot * entry;
+
+            entry = __DASessionGetCallbackSlot( session, ( SInt32 ) index );
+
+            if ( entry->handle )
+            {
+                if ( session->_registerPending )
+                {
+                    SInt32      handle = entry->handle;
+                    CFNumberRef key;
+                    Boolean     pending;
+
+                    key = CFNumberCreate( kCFAllocatorDefault, kCFNumberSInt32Type, &handle );
+
+                    pending = key ? CFArrayContainsValue( session->_registerPending, CFRangeMake( 0, CFArrayGetCount( session->_registerPending ) ), key ) : FALSE;
+
+                    if ( key )  CFRelease( key );
+
+                    if ( pending )
+                    {
+                        continue;
+                    }
+                }
+
+                slots[ count++ ] = *entry;
+            }
+        }
+    }
+
+    pthread_mutex_unlock( &session->_registerLock );
+
+    if ( slots )
+    {
+        CFMutableArrayRef callbacks;
+
+        qsort( slots, count, sizeof( __DASessionCallbackSlot ), __DASessionCompareCallbackSlots );
+
+        callbacks = CFArrayCreateMutable( kCFAllocatorDefault, count, &kCFTypeArrayCallBacks );
+
+        if ( callbacks )
+        {
+            for ( index = 0; index < count; index++ )
+            {
+                CFNumberRef key;
+
+                key = CFNumberCreate( kCFAllocatorDefault, kCFNumberSInt32Type, ( void * ) &slots[ index ].handle );
+
+                if ( key )
+                {
+                    CFArrayAppendValue( callbacks, key );
+
+                    CFRelease( key );
+                }
+            }
+
+            __DASessionRegisterCallbacks( session, callbacks );
+
+            CFRelease( callbacks );
+        }
+
+        free( slots );
+    }
+
+    status = _DAServerSessionSetKeepAlive(session->_server);
+
+    if ( current )
+    {
+        OSAtomicCompareAndSwap32Barrier( __kDASessionDescriptionCacheStateRegistering, __kDASessionDescriptionCacheStateRegistered, &session->_descriptionCacheState );
+    }
+    
+    return status;
+}
+
+void DASessionBeginCallbackRegistration( DASessionRef session )
+{
+    if ( session )
+    {
+        pthread_mutex_lock( &session->_registerLock );
+
+        if ( session->_registerPending == NULL )
+        {
+            session->_registerPending = CFArrayCreateMutable( kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks );
+        }
+
+        pthread_mutex_unlock( &session->_registerLock );
+    }
+}
+
+DAReturn DASessionCancelRequest( DASessionRef session, void * callback, void * context )
+{
+    DAReturn status = kDAReturnBadArgument;
+
+    if ( session && callback )
+    {
+        CFMutableArrayRef handles;
+
+        handles = CFArrayCreateMutable( kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks );
+
+        if ( handles )
+        {
+            CFIndex count;
+            CFIndex index;
+
+            /*
+             * A request is known to the server by the handle of its callback.  Gather the handles of
+             * the outstanding requests that were submitted with this callback and context.
+             */
+
+            pthread_mutex_lock( &session->_registerLock );
+
+            if ( session->_registerHash )
+            {
+                SInt32 next;
+
+                next = session->_registerHash[ __DASessionGetCallbackHash( ( uintptr_t ) callback, ( uintptr_t ) context ) ];
+
+                while ( next )
+                {
+                    __DASessionCallbackSlot * entry;
+
+                    entry = __DASessionGetCallbackSlot( session, next - 1 );
+
+                    if ( entry->address == ( uintptr_t ) callback && entry->context == ( uintptr_t ) context )
+                    {
+                        if ( ___CFDictionaryGetIntegerValue( entry->callback, _kDACallbackKindKey ) == UINT32_MAX )
+                        {
+                            CFNumberRef handle;
+
+                            handle = ___CFNumberCreateWithIntegerValue( kCFAllocatorDefault, entry->handle );
+
+                            if ( handle )
+                            {
+                                CFArrayAppendValue( handles, handle );
+
+                                CFRelease( handle );
+                            }
+                        }
+                    }
+
+                    next = entry->next;
+                }
+            }
+
+            pthread_mutex_unlock( &session->_registerLock );
+
+            status = kDAReturnNotFound;
+
+            count = CFArrayGetCount( handles );
+
+            for ( index = 0; index < count; index++ )
+            {
+                SInt32 handle;
+
+                handle = ___CFNumberGetIntegerValue( CFArrayGetValueAtIndex( handles, index ) );
+
+                if ( _DAServerSessionCancelRequest( session->_server, handle, handle ) == kDAReturnSuccess )
+                {
+                    status = kDAReturnSuccess;
+                }
+            }
+
+            CFRelease( handles );
+        }
+    }
+
+    return status;
+}
+
+DAReturn DASessionCommitCallbackRegistration( DASessionRef session )
+{
+    DAReturn status = kDAReturnBadArgument;
+
+    if ( session )
+    {
+        CFMutableArrayRef pending;
+
+        pthread_mutex_lock( &session->_registerLock );
+
+        pending = session->_registerPending;
+
+        session->_registerPending = NULL;
+
+        pthread_mutex_unlock( &session->_registerLock );
+
+        status = kDAReturnSuccess;
+
+        if ( pending )
+        {
+            if ( session->_server == MACH_PORT_NULL && session->_keepAlive )
+            {
+                /*
+                 * Recreating the session registers every callback, pending or not.
+                 */
+
+                status = _DASessionRecreate( session );
+            }
+            else
+            {
+                status = __DASessionRegisterCallbacks( session, pending );
+            }
+
+            CFRelease( pending );
+        }
+    }
+
+    return status;
+}
+
+void DASessionSetConcurrentDeliveryQueue( DASessionRef session, dispatch_queue_t queue )
+{
+    if ( session )
+    {
+        /*
+         * Let the callbacks delivered so far finish before we change how callbacks are delivered.
+         */
+
+        if ( session->_deliveryGroup )
+        {
+            dispatch_group_wait( session->_deliveryGroup, DISPATCH_TIME_FOREVER );
+        }
+
+        __DASessionReleaseDeliveryQueues( session );
+
+        if ( queue )
+        {
+            if ( session->_deliveryGroup == NULL )
+            {
+                session->_deliveryGroup = dispatch_group_create( );
+            }
+
+            session->_deliveryQueues  = CFDictionaryCreateMutable( kCFAllocatorDefault, 0, &kCFTypeDictionaryKeyCallBacks, NULL );
+            session->_deliveryRetired = CFArrayCreateMutable( kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks );
+
+            if ( session->_deliveryGroup && session->_deliveryQueues && session->_deliveryRetired )
+            {
+                dispatch_retain( queue );
+
+                session->_deliveryQueue = queue;
             }
         }
-
-        CFRelease( session );
     }
-
-    return NULL;
 }
 
-CFTypeID DASessionGetTypeID( void )
+DAReturn DASessionEnableCallbackRing( DASessionRef session, CFIndex size )
 {
-    _DAInitialize( );
-
-    return __kDASessionTypeID;
-}
+    DAReturn status = kDAReturnBadArgument;
 
-void DASessionScheduleWithRunLoop( DASessionRef session, CFRunLoopRef runLoop, CFStringRef runLoopMode )
-{
-    if ( session )
+    if ( session && size >= 0 )
     {
-        _DASessionScheduleWithRunLoop( session );
+        status = kDAReturnSuccess;
 
-        if ( session->_source )
+        if ( session->_ring == NULL )
         {
-            CFRunLoopAddSource( runLoop, session->_source, runLoopMode );
+            session->_ringSize = ( uint32_t ) MIN( size, _kDACallbackRingSizeMaximum );
+
+            status = __DASessionCreateCallbackRing( session );
         }
     }
+
+    return status;
 }
 
-void DASessionSetDispatchQueue( DASessionRef session, dispatch_queue_t queue )
+CFArrayRef DASessionCopyDescriptions( DASessionRef session, CFArrayRef disks, CFDictionaryRef match )
 {
+    CFMutableArrayRef descriptions = NULL;
+
     if ( session )
     {
-        if ( session->_source2 )
-        {
-            dispatch_source_cancel( session->_source2 );
-
-            dispatch_release( session->_source2 );
+        CFDataRef              _disks = NULL;
+        vm_address_t           _descriptions;
+        mach_msg_type_number_t _descriptionsSize;
+        CFDataRef              _match = NULL;
+        kern_return_t          status;
 
-            session->_source2 = NULL;
-        }
-
-        if ( queue )
+        if ( disks )
         {
-            mach_port_t   client;
-            kern_return_t status;
+            CFMutableArrayRef ids;
 
             /*
-             * Create the session's client port.
+             * The descriptions line up with the disks, so a disk that cannot be named fails the
+             * request as a whole rather than shift the rest.
              */
 
-            status = mach_port_allocate( mach_task_self( ), MACH_PORT_RIGHT_RECEIVE, &client );
+            ids = CFArrayCreateMutable( kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks );
 
-            if ( status == KERN_SUCCESS )
+            if ( ids )
             {
-                mach_port_limits_t limits = { 0 };
+                CFIndex count;
+                CFIndex index;
 
-                limits.mpl_qlimit = 1;
+                count = CFArrayGetCount( disks );
 
-                /*
-                 * Set up the session's client port.  It requires no more than one queue element.
-                 */
+                for ( index = 0; index < count; index++ )
+                {
+                    CFTypeRef disk;
+                    CFDataRef id;
+                    char *    name;
 
-                status = mach_port_set_attributes( mach_task_self( ),
-                                                   client,
-                                                   MACH_PORT_LIMITS_INFO,
-                                                   ( mach_port_info_t ) &limits,
-                                                   MACH_PORT_LIMITS_INFO_COUNT );
+                    disk = CFArrayGetValueAtIndex( disks, index );
 
-                if ( status == KERN_SUCCESS )
-                {
-                    dispatch_source_t source;
+                    if ( disk == NULL || CFGetTypeID( disk ) != DADiskGetTypeID( ) )
+                    {
+                        break;
+                    }
 
-                    /*
-                     * Create the session's client port dispatch source.
-                     */
+                    name = _DADiskGetID( ( void * ) disk );
 
-                    source = dispatch_source_create( DISPATCH_SOURCE_TYPE_MACH_RECV, client, 0, queue );
+                    id = CFDataCreate( kCFAllocatorDefault, ( void * ) name, strlen( name ) + 1 );
 
-                    if ( source )
+                    if ( id == NULL )
                     {
-                        session->_source2 = source;
+                        break;
+                    }
 
-                        CFRetain( session );
-                        mach_port_t port;
-                        
-                        status = mach_port_request_notification( mach_task_self( ),
-                                                                client,
-                                                                 MACH_NOTIFY_NO_SENDERS,
-                                                                 1,
-                                                                client,
-                                                                 MACH_MSG_TYPE_MAKE_SEND_ONCE,
-                                                                 &port );
-                        if ( status == KERN_SUCCESS )
-                        {
+                    CFArrayAppendValue( ids, id );
 
-                            dispatch_source_set_cancel_handler( session->_source2, ^
-                                                               {
-                                mach_port_mod_refs( mach_task_self( ), client, MACH_PORT_RIGHT_RECEIVE, -1 );
+                    CFRelease( id );
+                }
 
-                                CFRelease( session );
-                            } );
+                if ( index == count )
+                {
+                    _disks = _DASerialize( kCFAllocatorDefault, ids );
+                }
 
-                            dispatch_source_set_event_handler( session->_source2, ^
-                                                              {
-                                mach_msg_empty_rcv_t message;
-                                mach_msg( ( void * ) &message, MACH_RCV_MSG | MACH_RCV_TIMEOUT, 0, sizeof( message ), client, 0, MACH_PORT_NULL );
-                                if (MACH_NOTIFY_NO_SENDERS == message.header.msgh_id)
-                                {
-                                    os_log(OS_LOG_DEFAULT, "diskarbitrationd exited.");
-                                    if ( session->_name )  free( session->_name );
-                                    session->_name = NULL;
-                                    if ( session->_server )  mach_port_deallocate( mach_task_self( ), session->_server );
-                                    session->_server        = MACH_PORT_NULL;
-#if TARGET_OS_OSX || TARGET_OS_MACCATALYST
-                                    if ( session->_authorization )  AuthorizationFree( session->_authorization, kAuthorizationFlagDefaults );
-                                    session->_authorization = NULL;
-#endif
-                                }
-                                else
-                                {
-                                    _DASessionCallback( NULL, NULL, 0, session );
-                                }
-                                
-                            } );
+                CFRelease( ids );
+            }
 
-                            dispatch_resume( session->_source2 );
+            if ( _disks == NULL )
+            {
+                return NULL;
+            }
+        }
 
-                            _DAServerSessionSetClientPort( session->_server, client );
+        if ( match )
+        {
+            _match = _DASerializeDiskDescription( kCFAllocatorDefault, match );
 
-                            return;
-                        }
-                    }
-                }
+            /*
+             * A match that cannot be sent must not be taken for no match at all.
+             */
 
-                mach_port_mod_refs( mach_task_self( ), client, MACH_PORT_RIGHT_RECEIVE, -1 );
+            if ( _match == NULL )
+            {
+                if ( _disks )  CFRelease( _disks );
+
+                return NULL;
             }
         }
+
+        status = _DAServerSessionCopyDescriptions( session->_server,
+                                                   ( vm_address_t           ) ( _disks ? CFDataGetBytePtr( _disks ) : 0 ),
+                                                   ( mach_msg_type_number_t ) ( _disks ? CFDataGetLength(  _disks ) : 0 ),
+                                                   ( vm_address_t           ) ( _match ? CFDataGetBytePtr( _match ) : 0 ),
+                                                   ( mach_msg_type_number_t ) ( _match ? CFDataGetLength(  _match ) : 0 ),
+                                                   &_descriptions,
+                                                   &_descriptionsSize );
+
+        if ( status == KERN_SUCCESS )
+        {
+            descriptions = __DASessionCreateDescriptionsWithBytes( session, _descriptions, _descriptionsSize );
+
+            vm_deallocate( mach_task_self( ), _descriptions, _descriptionsSize );
+        }
+
+        if ( _disks )  CFRelease( _disks );
+        if ( _match )  CFRelease( _match );
     }
+
+    return descriptions;
 }
 
-void DASessionUnscheduleFromRunLoop( DASessionRef session, CFRunLoopRef runLoop, CFStringRef runLoopMode )
+CFArrayRef DASessionCopyDiskList( DASessionRef session, CFDictionaryRef match, UInt64 * generation )
 {
+    CFMutableArrayRef descriptions = NULL;
+
     if ( session )
     {
-        if ( session->_source )
+        vm_address_t           _descriptions;
+        mach_msg_type_number_t _descriptionsSize;
+        uint64_t               _generation;
+        CFDataRef              _match = NULL;
+        kern_return_t          status;
+
+        if ( match )
         {
-            CFRunLoopRemoveSource( runLoop, session->_source, runLoopMode );
+            _match = _DASerializeDiskDescription( kCFAllocatorDefault, match );
+
+            /*
+             * A match that cannot be sent must not be taken for no match at all.
+             */
+
+            if ( _match == NULL )
+            {
+                return NULL;
+            }
         }
 
-        _DASessionUnscheduleFromRunLoop( session );
-    }
-}
+        status = _DAServerSessionCopyDiskList( session->_server,
+                                               ( vm_address_t           ) ( _match ? CFDataGetBytePtr( _match ) : 0 ),
+                                               ( mach_msg_type_number_t ) ( _match ? CFDataGetLength(  _match ) : 0 ),
+                                               &_generation,
+                                               &_descriptions,
+                                               &_descriptionsSize );
 
-__private_extern__ CFMutableDictionaryRef DACallbackCreate( CFAllocatorRef   allocator,
-                                mach_vm_offset_t address,
-                                mach_vm_offset_t context,
-                                _DACallbackKind kind,
-                                CFIndex         order,
-                                CFDataRef match,
-                                CFDataRef      watch,
-                                bool block )
-{
-    CFMutableDictionaryRef callback;
+        if ( status == KERN_SUCCESS )
+        {
+            descriptions = __DASessionCreateDescriptionsWithBytes( session, _descriptions, _descriptionsSize );
 
-    callback = CFDictionaryCreateMutable( allocator, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks );
+            if ( descriptions )
+            {
+                if ( generation )
+                {
+                    *generation = _generation;
+                }
+            }
 
-    if ( callback )
-    {
-        ___CFDictionarySetIntegerValue( callback, _kDACallbackAddressKey, address );
-        ___CFDictionarySetIntegerValue( callback, _kDACallbackContextKey, context );
-        ___CFDictionarySetIntegerValue( callback, _kDACallbackKindKey,    kind    );
-        ___CFDictionarySetIntegerValue( callback, _kDACallbackOrderKey,   order   );
-        ___CFDictionarySetIntegerValue( callback, _kDACallbackBlockKey,   block   );
+            vm_deallocate( mach_task_self( ), _descriptions, _descriptionsSize );
+        }
 
-        if ( match )  CFDictionarySetValue( callback, _kDACallbackMatchKey, match );
-        if ( watch )  CFDictionarySetValue( callback, _kDACallbackWatchKey, watch );
+        if ( _match )  CFRelease( _match );
     }
 
-    return  callback;
+    return descriptions;
 }
 
-__private_extern__ SInt32 DAAddCallbackToSession(DASessionRef session, CFMutableDictionaryRef callback)
+CFDictionaryRef DASessionCopyStatistics( DASessionRef session )
 {
-    SInt32 currentIndex = 0;
+    CFDictionaryRef statistics = NULL;
 
-    /*
-     * Add the callback dict object to the session's register queue
-     */
-    
     if ( session )
-    { 
-        pthread_mutex_lock( &session->_registerLock );
-        currentIndex = ++session->_registerIndex;
-        CFNumberRef cfnumber = CFNumberCreate( NULL, kCFNumberSInt32Type, &currentIndex );
+    {
+        vm_address_t           _statistics;
+        mach_msg_type_number_t _statisticsSize;
+        kern_return_t          status;
 
-        while (CFDictionaryContainsKey( session->_register, cfnumber ))
+        status = _DAServerCopyStatistics( session->_server, &_statistics, &_statisticsSize );
+
+        if ( status == KERN_SUCCESS )
         {
-            currentIndex = ++session->_registerIndex;
-            
-            /*
-             * skip 0 as key since it is being used as callback address to server and the server will disregard NULL values.
-             */
-            
-            if ( 0 == currentIndex )
-            {
-                currentIndex = ++session->_registerIndex;
-            }
-            CFRelease( cfnumber );
-            cfnumber = CFNumberCreate( NULL, kCFNumberSInt32Type, &currentIndex );
-        }
+            statistics = _DAUnserializeWithBytes( CFGetAllocator( session ), _statistics, _statisticsSize );
 
-        CFDictionarySetValue( session->_register, cfnumber, callback );
-        CFRelease( cfnumber );
-        pthread_mutex_unlock( &session->_registerLock );
+            vm_deallocate( mach_task_self( ), _statistics, _statisticsSize );
+        }
     }
-    return currentIndex;
+
+    return statistics;
 }
 
-__private_extern__ void DARemoveCallbackFromSessionWithKey(DASessionRef session, SInt32 index)
+DAReturn DASessionSetCoalescingInterval( DASessionRef session, CFTimeInterval interval )
 {
-    /*
-     * Remove the callback dict object from the session's register queue
-     */
-    SInt32 matchingKey = 0;
-    
-    if ( session )
+    DAReturn status = kDAReturnBadArgument;
+
+    if ( session && interval >= 0 && interval * 1000 <= _kDACoalescingIntervalMaximum )
     {
-        CFNumberRef number = CFNumberCreate( NULL, kCFNumberSInt32Type, &index );
-        pthread_mutex_lock( &session->_registerLock );
-        CFMutableDictionaryRef callback =  ( CFMutableDictionaryRef ) CFDictionaryGetValue( session->_register , number );
-        int block = ( uintptr_t ) ___CFDictionaryGetIntegerValue( callback, _kDACallbackBlockKey );
-        void *currentaddress = ( void * ) ( uintptr_t ) ___CFDictionaryGetIntegerValue( callback, _kDACallbackAddressKey );
-        if ( block )
+        status = _DAServerSessionSetCoalescingInterval( session->_server, ( uint32_t ) ( interval * 1000 ) );
+
+        if ( status == kDAReturnSuccess )
         {
-            Block_release ( currentaddress );
+            session->_interval = ( UInt32 ) ( interval * 1000 );
         }
-        CFDictionaryRemoveValue( session->_register , number );
-        CFNumberGetValue( number, kCFNumberSInt32Type, &matchingKey );
-        session->_registerIndex = matchingKey - 1;
-        pthread_mutex_unlock( &session->_registerLock );
-        CFRelease( number );
     }
+
+    return status;
 }
 
-__private_extern__ SInt32 DARemoveCallbackFromSession(DASessionRef session, mach_vm_offset_t address,
-                                mach_vm_offset_t context)
+void DASessionSetDescriptionCacheEnabled( DASessionRef session, Boolean enabled )
 {
-    SInt32 matchingKey = 0;
-    
-    /*
-     * Remove the callback dict object from the session's register queue
-     * by matching the address and context
-     */
-    
     if ( session )
     {
-        pthread_mutex_lock( &session->_registerLock );
-        CFIndex count = CFDictionaryGetCount( session->_register );
-        const void** keys = ( const void** ) malloc( sizeof(void*)*count );
-        const void** values = ( const void** ) malloc( sizeof(void*)*count );
-        SInt32 queueIndex;
+        session->_descriptionCache = enabled;
 
-        CFDictionaryGetKeysAndValues( session->_register, keys, values );
-        pthread_mutex_unlock( &session->_registerLock );
-        for ( queueIndex = 0; queueIndex < count; queueIndex++ )
+        if ( enabled == FALSE )
         {
-            CFMutableDictionaryRef callback = ( CFMutableDictionaryRef )( values[queueIndex] );
-            void *currentaddress = ( void * ) ( uintptr_t ) ___CFDictionaryGetIntegerValue( callback, _kDACallbackAddressKey );
-            void *currentcontext = ( void * ) ( uintptr_t ) ___CFDictionaryGetIntegerValue( callback, _kDACallbackContextKey );
-            int block = ( uintptr_t ) ___CFDictionaryGetIntegerValue( callback, _kDACallbackBlockKey );
-
-            if ( currentaddress == ( void * ) address && currentcontext ==(void *) context )
+            if ( OSAtomicCompareAndSwap32Barrier( __kDASessionDescriptionCacheStateRegistered, __kDASessionDescriptionCacheStateNone, &session->_descriptionCacheState ) )
             {
-                CFNumberRef cfnumber =  ( CFNumberRef )( keys[queueIndex] );
-                CFNumberGetValue( cfnumber, kCFNumberSInt32Type, &matchingKey );
-                if ( block )
+                SInt32 index;
+
+                /*
+                 * Withdraw every registration the cache holds, whatever their number.
+                 */
+
+                while ( ( index = DARemoveCallbackFromSession( session, 0, ( uintptr_t ) session ) ) )
                 {
-                    Block_release ( currentaddress );
+                    if ( _DASessionGetID( session ) )
+                    {
+                        _DAServerSessionUnregisterCallback( _DASessionGetID( session ), ( uintptr_t ) index, ( uintptr_t ) index );
+                    }
                 }
-                pthread_mutex_lock( &session->_registerLock );
-                CFDictionaryRemoveValue( session->_register , cfnumber );
-                session->_registerIndex = matchingKey - 1;
-                pthread_mutex_unlock( &session->_registerLock );
-                break;
             }
         }
-
-        free( keys );
-        free( values );
     }
-    return matchingKey;
 }
 
-__private_extern__ CFMutableDictionaryRef DAGetCallbackFromSession(DASessionRef session, SInt32 index)
+DAReturn DASessionSetGeneration( DASessionRef session, UInt64 generation )
 {
-    CFMutableDictionaryRef callback = 0;
-    
-    /*
-     * Get the callback object from the session's stored callback list
-     */
-    
+    DAReturn status = kDAReturnBadArgument;
+
     if ( session )
     {
-        CFNumberRef number = CFNumberCreate( NULL, kCFNumberSInt32Type, &index );
-        pthread_mutex_lock( &session->_registerLock );
-        callback =  ( CFMutableDictionaryRef ) CFDictionaryGetValue( session->_register , number );
-        pthread_mutex_unlock( &session->_registerLock );
-        CFRelease( number );
+        status = _DAServerSessionSetGeneration( session->_server, generation );
     }
-    return callback;
+
+    return status;
 }
 
-__private_extern__ DAReturn _DASessionRecreate( DASessionRef session )
+DAReturn DASessionSetQueueLimit( DASessionRef session, CFIndex limit )
 {
-    DAReturn status = kDAReturnSuccess;
-    SInt32 queueIndex = 1;
-    SInt32 index = 0;
-    
-    if ( false == DASessionEstablish(session) )
-    {
-        os_log(OS_LOG_DEFAULT, "failed to establish session with diskarbitrationd");
-        return kDAReturnBadArgument;
-    }
-    
-    DASessionSetDispatchQueue( session, session->_queue);
-    
-    pthread_mutex_lock( &session->_registerLock );
-    CFIndex count = CFDictionaryGetCount( session->_register );
-    pthread_mutex_unlock( &session->_registerLock );
-    CFNumberRef key;
-    
-    while( index < count )
+    DAReturn status = kDAReturnBadArgument;
+
+    if ( session && ( limit == 0 || ( limit >= _kDASessionQueueLimitMinimum && limit <= _kDASessionQueueLimitMaximum ) ) )
     {
-        key = CFNumberCreate( NULL, kCFNumberSInt32Type, &queueIndex );
-        if ( key )
+        status = _DAServerSessionSetQueueLimit( session->_server, ( uint32_t ) limit );
+
+        if ( status == kDAReturnSuccess )
         {
-            pthread_mutex_lock( &session->_registerLock );
-            CFMutableDictionaryRef callback = ( CFMutableDictionaryRef ) CFDictionaryGetValue( session->_register, key);
-            pthread_mutex_unlock( &session->_registerLock );
-            if ( callback )
-            {
-                int kind = (int)  ___CFDictionaryGetIntegerValue( callback, _kDACallbackKindKey );
-                int32_t order =  ___CFDictionaryGetIntegerValue( callback, _kDACallbackOrderKey );
-                CFDataRef match =  CFDictionaryGetValue( callback, _kDACallbackMatchKey );
-                CFDataRef watch =  CFDictionaryGetValue( callback, _kDACallbackWatchKey );
-            
-                _DAServerSessionRegisterCallback( _DASessionGetID( session ),
-                                             ( uintptr_t              ) queueIndex,
-                                             ( uintptr_t              ) queueIndex,
-                                             ( uint32_t                ) kind,
-                                             ( int32_t                ) order,
-                                             ( vm_address_t           ) ( match ? CFDataGetBytePtr( match ) : 0 ),
-                                             ( mach_msg_type_number_t ) ( match ? CFDataGetLength(  match ) : 0 ),
-                                             ( vm_address_t           ) ( watch ? CFDataGetBytePtr( watch ) : 0 ),
-                                             ( mach_msg_type_number_t ) ( watch ? CFDataGetLength(  watch ) : 0 ) );
-                index++;
-            }
-            CFRelease( key );
+            session->_queueLimit = ( UInt32 ) limit;
         }
-        queueIndex++;
     }
-    status = _DAServerSessionSetKeepAlive(session->_server);
-    
+
     return status;
 }
 
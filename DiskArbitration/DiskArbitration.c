@@ -50,6 +50,7 @@ CFArrayRef kDADiskDescriptionWatchVolumePath = NULL;
 __private_extern__ char *      _DADiskGetID( DADiskRef disk );
 __private_extern__ mach_port_t _DADiskGetSessionID( DADiskRef disk );
 __private_extern__ void        _DADiskInitialize( void );
+__private_extern__ void        _DADiskRemoveDescriptionFromSession( DADiskRef disk );
 __private_extern__ void        _DADiskSetDescription( DADiskRef disk, CFDictionaryRef description );
 #if TARGET_OS_OSX || TARGET_OS_MACCATALYST
 __private_extern__ AuthorizationRef _DASessionGetAuthorization( DASessionRef session );
@@ -72,9 +73,12 @@ __private_extern__ CFMutableDictionaryRef DACallbackCreate( CFAllocatorRef   all
 __private_extern__ SInt32 DAAddCallbackToSession(DASessionRef session, CFMutableDictionaryRef callback);
 __private_extern__ void DARemoveCallbackFromSessionWithKey(DASessionRef session, SInt32 index);
 __private_extern__ SInt32 DARemoveCallbackFromSession(DASessionRef session, mach_vm_offset_t address, mach_vm_offset_t context);
-__private_extern__ CFMutableDictionaryRef DAGetCallbackFromSession(DASessionRef session, SInt32 index);
+__private_extern__ CFMutableDictionaryRef DACopyCallbackFromSession(DASessionRef session, SInt32 index);
 __private_extern__ DAReturn _DASessionRecreate( DASessionRef session );
+__private_extern__ void _DASessionResync( DASessionRef session );
+__private_extern__ Boolean _DASessionDeferCallbackRegistration( DASessionRef session, SInt32 index );
 __private_extern__ bool _DASessionIsKeepAlive( DASessionRef session );
+__private_extern__ void _DASessionWaitForDelivery( DASessionRef session );
 
 
 static void __DAInitialize( void )
@@ -275,6 +279,109 @@ exit:
     return status;
 }
                               
+static DAReturn __DAQueueRequests( DASessionRef   session,
+                                   _DARequestKind kind,
+                                   CFArrayRef     argument0,
+                                   CFIndex        argument1,
+                                   CFTypeRef      argument3,
+                                   void *         address,
+                                   void *         context,
+                                   bool           block )
+{
+    DAReturn status;
+
+    status = kDAReturnBadArgument;
+
+    if ( session )
+    {
+        CFMutableArrayRef disks;
+        CFDataRef         _argument0 = NULL;
+        CFDataRef         _argument3 = NULL;
+
+        if ( _DASessionGetID( session ) == NULL  && _DASessionIsKeepAlive( session ) )
+        {
+            if ( _DASessionRecreate (session) != kDAReturnSuccess )
+            {
+                goto exit;
+            }
+        }
+
+        disks = CFArrayCreateMutable( kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks );
+
+        if ( disks )
+        {
+            CFIndex count;
+            CFIndex index;
+
+            count = CFArrayGetCount( argument0 );
+
+            for ( index = 0; index < count; index++ )
+            {
+                CFStringRef id;
+
+                id = CFStringCreateWithCString( kCFAllocatorDefault, _DADiskGetID( ( void * ) CFArrayGetValueAtIndex( argument0, index ) ), kCFStringEncodingUTF8 );
+
+                if ( id )
+                {
+                    CFArrayAppendValue( disks, id );
+
+                    CFRelease( id );
+                }
+            }
+
+            _argument0 = _DASerialize( kCFAllocatorDefault, disks );
+
+            CFRelease( disks );
+        }
+
+        if ( argument3 )  _argument3 = _DASerialize( kCFAllocatorDefault, argument3 );
+
+        if ( _argument0 )
+        {
+            CFMutableDictionaryRef callback;
+
+            /*
+             * The session keeps its own reference to the callback block, as well as the disks, so that
+             * the completion can match the dissenters the server reports by disk identifier.
+             */
+
+            callback = DACallbackCreate( kCFAllocatorDefault, ( uintptr_t ) ( block ? Block_copy( address ) : address ), context, UINT32_MAX, NULL, NULL, NULL, block );
+
+            if ( callback )
+            {
+                SInt32 index;
+
+                CFDictionarySetValue( callback, _kDACallbackDiskKey, argument0 );
+
+                index = DAAddCallbackToSession( session, callback );
+
+                CFRelease( callback );
+
+                status = _DAServerSessionQueueRequests( _DASessionGetID( session ),
+                                                        ( uint32_t               ) kind,
+                                                        ( vm_address_t           ) CFDataGetBytePtr( _argument0 ),
+                                                        ( mach_msg_type_number_t ) CFDataGetLength(  _argument0 ),
+                                                        ( int32_t                ) argument1,
+                                                        ( vm_address_t           ) ( _argument3 ? CFDataGetBytePtr( _argument3 ) : 0 ),
+                                                        ( mach_msg_type_number_t ) ( _argument3 ? CFDataGetLength(  _argument3 ) : 0 ),
+                                                        ( uintptr_t              ) index,
+                                                        ( uintptr_t              ) index );
+
+                if ( status )
+                {
+                    DARemoveCallbackFromSessionWithKey( session, index );
+                }
+            }
+
+            CFRelease( _argument0 );
+        }
+
+        if ( _argument3 )  CFRelease( _argument3 );
+    }
+exit:
+    return status;
+}
+
 static void __DAQueueResponse( DASessionRef    session,
                                void *          address,
                                void *          context,
@@ -452,6 +559,7 @@ static bool DARequestKindWithResponse(_DARequestKind kind)
         case _kDADiskRenameCallback:
         case _kDADiskUnmountCallback:
         case _kDADiskSetFSKitAdditionsCallback:
+        case _kDADiskBatchCallback:
         {
             daRequest = true;
             break;
@@ -472,9 +580,21 @@ __private_extern__ void _DADispatchCallback( DASessionRef    session,
     DADiskRef disk     = NULL;
     CFTypeRef response = NULL;
 
+    if ( kind == _kDASessionResyncCallback )
+    {
+        _DASessionResync( session );
+
+        return;
+    }
+
     if ( argument0 )
     {
         disk = _DADiskCreateFromSerialization( CFGetAllocator( session ), session, argument0 );
+
+        if ( disk && kind == _kDADiskDisappearedCallback )
+        {
+            _DADiskRemoveDescriptionFromSession( disk );
+        }
     }
    
     /*
@@ -483,7 +603,7 @@ __private_extern__ void _DADispatchCallback( DASessionRef    session,
      */
     SInt32 index = address;
 
-    CFMutableDictionaryRef callback = DAGetCallbackFromSession(session, index);
+    CFMutableDictionaryRef callback = DACopyCallbackFromSession(session, index);
     if (NULL == callback)
     {
         goto exit;
@@ -725,7 +845,62 @@ __private_extern__ void _DADispatchCallback( DASessionRef    session,
             ( ( DADiskSetFSKitAdditionsCallbackBlock ) address )( argument1 );
         }
 #endif /* DA_FSKIT */
+            break;
+
+        case _kDADiskBatchCallback:
+        {
+            CFArrayRef        disks;
+            CFMutableArrayRef dissenters;
+
+            disks = CFDictionaryGetValue( callback, _kDACallbackDiskKey );
+
+            dissenters = CFArrayCreateMutable( kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks );
+
+            if ( dissenters )
+            {
+                CFIndex count;
+                CFIndex item;
+
+                count = CFArrayGetCount( disks );
+
+                /*
+                 * The server reports the dissenters by disk identifier.  Line them up with the disks.
+                 */
+
+                for ( item = 0; item < count; item++ )
+                {
+                    DADissenterRef dissenter = NULL;
+                    CFStringRef    id;
+
+                    id = CFStringCreateWithCString( kCFAllocatorDefault, _DADiskGetID( ( void * ) CFArrayGetValueAtIndex( disks, item ) ), kCFStringEncodingUTF8 );
+
+                    if ( id )
+                    {
+                        if ( argument1 )
+                        {
+                            dissenter = ( void * ) CFDictionaryGetValue( argument1, id );
+                        }
+
+                        CFRelease( id );
+                    }
+
+                    CFArrayAppendValue( dissenters, dissenter ? ( CFTypeRef ) dissenter : kCFNull );
+                }
+
+                if ( block )
+                {
+                    ( ( DADiskManyCallbackBlock ) address )( disks, dissenters );
+                }
+                else
+                {
+                    ( ( DADiskManyCallback ) address )( disks, dissenters, context );
+                }
 
+                CFRelease( dissenters );
+            }
+
+            break;
+        }
     }
 
     if ( response )
@@ -757,6 +932,16 @@ exit:
         DARemoveCallbackFromSessionWithKey(session, index);
     }
 
+    if ( callback )
+    {
+        if ( ___CFDictionaryGetIntegerValue( callback, _kDACallbackBlockKey ) )
+        {
+            Block_release( ( void * ) ( uintptr_t ) ___CFDictionaryGetIntegerValue( callback, _kDACallbackAddressKey ) );
+        }
+
+        CFRelease( callback );
+    }
+
     if ( disk )
     {
         CFRelease( disk );
@@ -802,15 +987,19 @@ __private_extern__ void _DARegisterCallback( DASessionRef    session,
         CFMutableDictionaryRef   callback =  DACallbackCreate(kCFAllocatorDefault, address, context, kind, order, _match, _watch, block);
         SInt32 index = DAAddCallbackToSession(session, callback);
         CFRelease(callback);
-        _DAServerSessionRegisterCallback( _DASessionGetID( session ),
-                                          ( uintptr_t              ) index,
-                                          ( uintptr_t              ) index,
-                                          ( uint32_t                ) kind,
-                                          ( int32_t                ) order,
-                                          ( vm_address_t           ) ( _match ? CFDataGetBytePtr( _match ) : 0 ),
-                                          ( mach_msg_type_number_t ) ( _match ? CFDataGetLength(  _match ) : 0 ),
-                                          ( vm_address_t           ) ( _watch ? CFDataGetBytePtr( _watch ) : 0 ),
-                                          ( mach_msg_type_number_t ) ( _watch ? CFDataGetLength(  _watch ) : 0 ) );
+
+        if ( _DASessionDeferCallbackRegistration( session, index ) == FALSE )
+        {
+            _DAServerSessionRegisterCallback( _DASessionGetID( session ),
+                                              ( uintptr_t              ) index,
+                                              ( uintptr_t              ) index,
+                                              ( uint32_t                ) kind,
+                                              ( int32_t                ) order,
+                                              ( vm_address_t           ) ( _match ? CFDataGetBytePtr( _match ) : 0 ),
+                                              ( mach_msg_type_number_t ) ( _match ? CFDataGetLength(  _match ) : 0 ),
+                                              ( vm_address_t           ) ( _watch ? CFDataGetBytePtr( _watch ) : 0 ),
+                                              ( mach_msg_type_number_t ) ( _watch ? CFDataGetLength(  _watch ) : 0 ) );
+        }
 
         if ( _match )  CFRelease( _match );
         if ( _watch )  CFRelease( _watch );
@@ -837,6 +1026,8 @@ __private_extern__ void _DAUnregisterCallback( DASessionRef session, void * addr
 
         SInt32 matchingIndex = DARemoveCallbackFromSession(session, address, context);
         _DAServerSessionUnregisterCallback( _DASessionGetID( session ), ( uintptr_t ) matchingIndex, ( uintptr_t ) matchingIndex );
+
+        _DASessionWaitForDelivery( session );
     }
 }
 
@@ -1310,6 +1501,126 @@ void DADiskUnmount( DADiskRef disk, DADiskUnmountOptions options, DADiskUnmountC
     DADiskUnmountCommon( disk, options, callback, context, false, invalidToken );
 }
 
+__private_extern__ void DADiskRequestManyCommon( _DARequestKind     kind,
+                                                 CFArrayRef         disks,
+                                                 CFIndex            options,
+                                                 CFStringRef        arguments[],
+                                                 DADiskManyCallback callback,
+                                                 void *             context,
+                                                 bool               block )
+{
+    CFMutableStringRef argument;
+    DASessionRef       session;
+    DAReturn           status;
+
+    argument = NULL;
+    session  = NULL;
+
+    if ( arguments )
+    {
+        if ( arguments[0] )
+        {
+            argument = CFStringCreateMutableCopy( kCFAllocatorDefault, 0, arguments[0] );
+
+            if ( argument )
+            {
+                CFIndex index;
+
+                for ( index = 1; arguments[index]; index++ )
+                {
+                    CFStringAppend( argument, CFSTR( "," ) );
+                    CFStringAppend( argument, arguments[index] );
+                }
+            }
+        }
+    }
+
+    /*
+     * The disks are submitted together, so they must share a session.
+     */
+
+    if ( disks )
+    {
+        CFIndex count;
+        CFIndex index;
+
+        count = CFArrayGetCount( disks );
+
+        for ( index = 0; index < count; index++ )
+        {
+            DADiskRef disk;
+
+            disk = ( void * ) CFArrayGetValueAtIndex( disks, index );
+
+            if ( index == 0 )
+            {
+                session = _DADiskGetSession( disk );
+            }
+            else if ( _DADiskGetSession( disk ) != session )
+            {
+                session = NULL;
+
+                break;
+            }
+        }
+    }
+
+    status = __DAQueueRequests( session, kind, disks, options, argument, callback, context, block );
+
+    if ( argument )
+    {
+        CFRelease( argument );
+    }
+
+    if ( status )
+    {
+        if ( callback )
+        {
+            CFMutableArrayRef dissenters;
+
+            dissenters = CFArrayCreateMutable( kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks );
+
+            if ( dissenters )
+            {
+                DADissenterRef dissenter;
+
+                dissenter = DADissenterCreate( kCFAllocatorDefault, status, NULL );
+
+                if ( dissenter )
+                {
+                    CFIndex count;
+                    CFIndex index;
+
+                    count = disks ? CFArrayGetCount( disks ) : 0;
+
+                    for ( index = 0; index < count; index++ )
+                    {
+                        CFArrayAppendValue( dissenters, dissenter );
+                    }
+
+                    CFRelease( dissenter );
+                }
+
+                if ( block )
+                {
+                    ( ( DADiskManyCallbackBlock ) callback )( disks, dissenters );
+                }
+                else
+                {
+                    ( callback )( disks, dissenters, context );
+                }
+
+                CFRelease( dissenters );
+            }
+        }
+    }
+
+    if ( block && callback )
+    {
+        Block_release( callback );
+    }
+}
+
 void DARegisterDiskAppearedCallback( DASessionRef           session,
                                      CFDictionaryRef        match,
                                      DADiskAppearedCallback callback,
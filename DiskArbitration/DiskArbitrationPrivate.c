@@ -99,6 +99,13 @@ __private_extern__ void DADiskUnmountCommon( DADiskRef             disk,
                                              void *                context,
                                              bool                  block,
                                              audit_token_t         token );
+__private_extern__ void DADiskRequestManyCommon( _DARequestKind     kind,
+                                                 CFArrayRef         disks,
+                                                 CFIndex            options,
+                                                 CFStringRef        arguments[],
+                                                 DADiskManyCallback callback,
+                                                 void *             context,
+                                                 bool               block );
 __private_extern__ void DADiskClaimCommon ( DADiskRef                  disk,
                         DADiskClaimOptions         options,
                         DADiskClaimReleaseCallback release,
@@ -2790,6 +2797,38 @@ void DADiskUnmountWithBlock( DADiskRef                        disk,
     DADiskUnmountCommon ( disk, options, (void *) Block_copy ( callback ), NULL , true, invalidToken );
 }
 
+void DADiskMountMany( CFArrayRef         disks,
+                      DADiskMountOptions options,
+                      CFStringRef        arguments[],
+                      DADiskManyCallback callback,
+                      void *             context )
+{
+    DADiskRequestManyCommon( _kDADiskMount, disks, options, arguments, callback, context, false );
+}
+
+void DADiskMountManyWithBlock( CFArrayRef              disks,
+                               DADiskMountOptions      options,
+                               CFStringRef             arguments[],
+                               DADiskManyCallbackBlock callback )
+{
+    DADiskRequestManyCommon( _kDADiskMount, disks, options, arguments, ( void * ) Block_copy( callback ), NULL, true );
+}
+
+void DADiskUnmountMany( CFArrayRef           disks,
+                        DADiskUnmountOptions options,
+                        DADiskManyCallback   callback,
+                        void *               context )
+{
+    DADiskRequestManyCommon( _kDADiskUnmount, disks, options, NULL, callback, context, false );
+}
+
+void DADiskUnmountManyWithBlock( CFArrayRef              disks,
+                                 DADiskUnmountOptions    options,
+                                 DADiskManyCallbackBlock callback )
+{
+    DADiskRequestManyCommon( _kDADiskUnmount, disks, options, NULL, ( void * ) Block_copy( callback ), NULL, true );
+}
+
 void DADiskEjectWithBlock( DADiskRef                      disk,
                                 DADiskEjectOptions             options,
                                 DADiskEjectCallbackBlock __nullable callback )
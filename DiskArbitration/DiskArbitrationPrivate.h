@@ -301,6 +301,24 @@ extern const CFStringRef kDADiskDescriptionMediaMatchKey;
 
 extern const CFStringRef kDADiskDescriptionVolumeLifsURLKey;   /* ( CFString     ) */
 
+extern const CFStringRef kDAStatisticsCallbacksCoalescedKey;   /* ( CFNumber     ) */
+extern const CFStringRef kDAStatisticsRequestClassesKey;       /* ( CFArray      ) */
+extern const CFStringRef kDAStatisticsSessionResyncsKey;       /* ( CFNumber     ) */
+extern const CFStringRef kDAStatisticsSessionsKey;             /* ( CFArray      ) */
+
+extern const CFStringRef kDAStatisticsSessionNameKey;          /* ( CFString     ) */
+extern const CFStringRef kDAStatisticsSessionProcessIDKey;     /* ( CFNumber     ) */
+extern const CFStringRef kDAStatisticsSessionQueueBytesKey;    /* ( CFNumber     ) */
+extern const CFStringRef kDAStatisticsSessionQueueDepthKey;    /* ( CFNumber     ) */
+extern const CFStringRef kDAStatisticsSessionQueueLimitKey;    /* ( CFNumber     ) */
+
+extern const CFStringRef kDAStatisticsRequestClassNameKey;      /* ( CFString     ) */
+extern const CFStringRef kDAStatisticsRequestClassDepthKey;     /* ( CFNumber     ) */
+extern const CFStringRef kDAStatisticsRequestClassCancelledKey; /* ( CFNumber     ) */
+extern const CFStringRef kDAStatisticsRequestClassCountKey;     /* ( CFNumber     ) */
+extern const CFStringRef kDAStatisticsRequestClassWaitKey;      /* ( CFNumber     ) */
+extern const CFStringRef kDAStatisticsRequestClassWaitMaxKey;   /* ( CFNumber     ) */
+
 #ifndef __DISKARBITRATIOND__
 
 #if TARGET_OS_OSX || TARGET_OS_MACCATALYST
@@ -313,6 +331,19 @@ extern DADiskRef _DADiskCreateFromSerialization( CFAllocatorRef allocator, DASes
 
 extern DASessionRef _DADiskGetSession( DADiskRef disk );
 
+/*
+ * Encodings for _DADiskCopySerialization.  The encoding of a serialization is detected when it is
+ * passed to _DADiskCreateFromSerialization.
+ */
+
+enum
+{
+    kDADiskSerializationEncodingPropertyList = 0x1,
+    kDADiskSerializationEncodingCompact      = 0x2
+};
+
+extern CFDataRef _DADiskCopySerialization( DADiskRef disk, UInt32 encoding );
+
 /*
  * This is currently only available to clients with the entitlement "com.apple.private.diskarbitrationd.disk_set_adoption"
  */
@@ -345,6 +376,217 @@ extern void DARegisterDiskListCompleteCallback( DASessionRef session, DADiskList
 
 extern DAReturn DASessionKeepAlive( DASessionRef session , dispatch_queue_t queue);
 
+/*!
+ * @function   DASessionEnableCallbackRing
+ * @abstract   Delivers the session's callbacks through memory shared with diskarbitrationd.
+ * @param      session The session object.
+ * @param      size    The size of the shared memory in bytes.  Pass 0 for the default.
+ * @result     A result code.
+ * @discussion
+ * The callbacks are drained without a round trip to the server.  Callbacks that do not fit
+ * are delivered through the regular callback queue, in order.  Call this before the session
+ * is scheduled on a run loop or dispatch queue.
+ */
+
+extern DAReturn DASessionEnableCallbackRing( DASessionRef session, CFIndex size );
+
+/*!
+ * @function   DASessionSetConcurrentDeliveryQueue
+ * @abstract   Delivers the session's callbacks for different disks in parallel.
+ * @param      session The session object.
+ * @param      queue   The concurrent dispatch queue on which to deliver callbacks, or NULL to
+ * deliver them in order on the queue or run loop the session is scheduled on.
+ * @discussion
+ * The callbacks for a disk are delivered in order, one at a time.  Callbacks that concern no disk,
+ * such as the disk list complete and idle callbacks, are delivered once the callbacks before them
+ * have returned, on the queue or run loop the session is scheduled on.  Callbacks must therefore
+ * not wait on that queue or run loop.  The unregistration of a callback waits for the callbacks
+ * being delivered to return, unless it is made from one of them.  Call this before the session is
+ * scheduled.
+ */
+
+extern void DASessionSetConcurrentDeliveryQueue( DASessionRef session, dispatch_queue_t queue );
+
+/*!
+ * @function   DASessionSetCoalescingInterval
+ * @abstract   Coalesces the session's disk description changed callbacks.
+ * @param      session  The session object.
+ * @param      interval The interval in seconds, up to one second.  Pass 0 to disable coalescing.
+ * @result     A result code.
+ * @discussion
+ * Description changes for the same disk that occur within the interval are delivered as a single
+ * callback carrying the union of the changed keys.  Every other callback delivers the changes held
+ * so far first, so callbacks remain ordered.
+ */
+
+extern DAReturn DASessionSetCoalescingInterval( DASessionRef session, CFTimeInterval interval );
+
+/*!
+ * @function   DASessionSetDescriptionCacheEnabled
+ * @abstract   Enables or disables the session's cache of disk descriptions.
+ * @param      session The session object.
+ * @param      enabled Pass TRUE to answer descriptions from the cache.
+ * @discussion
+ * The cache is disabled by default.  Once it is enabled and the session is scheduled,
+ * DADiskCopyDescription answers from the cache for disks that were not created from a callback,
+ * and the session keeps the cache current from the server's description changed and disappeared
+ * notifications.  A cached description can trail a change by the time the session takes to
+ * process the notification.
+ */
+
+extern void DASessionSetDescriptionCacheEnabled( DASessionRef session, Boolean enabled );
+
+/*!
+ * @function   DASessionBeginCallbackRegistration
+ * @abstract   Holds back the callbacks registered on the session from the server.
+ * @param      session The session object.
+ * @discussion
+ * The callbacks registered from now on reach the server together, in one message, upon
+ * DASessionCommitCallbackRegistration.  Until then they see no callbacks.
+ */
+
+extern void DASessionBeginCallbackRegistration( DASessionRef session );
+
+/*!
+ * @function   DASessionCommitCallbackRegistration
+ * @abstract   Registers the callbacks held back since DASessionBeginCallbackRegistration.
+ * @param      session The session object.
+ * @result     A result code.
+ */
+
+extern DAReturn DASessionCommitCallbackRegistration( DASessionRef session );
+
+/*!
+ * @function   DASessionCancelRequest
+ * @abstract   Cancels the requests submitted on the session with the specified callback and context.
+ * @param      session  The session object.
+ * @param      callback The callback function or block given to the request, such as DADiskMount().
+ * @param      context  The user-defined context parameter given to the request.
+ * @result     A result code.  Returns kDAReturnNotFound if no such request is outstanding.
+ * @discussion
+ * A request that has yet to commence is dropped at once.  A request that has commenced stops at
+ * its next step, such as once its approval completes.  A mount, unmount or eject that is already
+ * underway is not interrupted.  The callback of a cancelled request is called with a dissenter
+ * whose status is unix_err( ECANCELED ).  A callback block must be passed as copied, since the
+ * session identifies the request by the block it keeps.
+ */
+
+extern DAReturn DASessionCancelRequest( DASessionRef session, void * callback, void * __nullable context );
+
+/*!
+ * @function   DASessionSetQueueLimit
+ * @abstract   Bounds the number of callbacks the server holds for the session.
+ * @param      session The session object.
+ * @param      limit   The number of callbacks, from 256 to 65536.  Pass 0 for the default.
+ * @result     A result code.
+ * @discussion
+ * A session that falls behind by more than the limit loses its pending disk appeared, disappeared,
+ * description changed, disk list complete and idle callbacks.  The session then resynchronizes:
+ * its disk appeared callbacks are replayed for the current disk list, followed by its disk list
+ * complete callbacks.  Callbacks for requests and approvals are never dropped.
+ */
+
+extern DAReturn DASessionSetQueueLimit( DASessionRef session, CFIndex limit );
+
+/*!
+ * @function   DASessionCopyDescriptions
+ * @abstract   Obtains the descriptions of many disks in one request to the server.
+ * @param      session The session object.
+ * @param      disks   The disks to describe, or NULL for every disk.
+ * @param      match   The match dictionary, or NULL to describe all of the disks.
+ * @result     The descriptions.  Returns NULL on failure.
+ * @discussion
+ * Should disks be given, the descriptions are in the same order, with kCFNull in place of a disk
+ * that has disappeared or does not match.  An element of disks that is not a disk object, or a
+ * match dictionary that cannot be serialized, fails the request.
+ */
+
+extern CFArrayRef DASessionCopyDescriptions( DASessionRef session, CFArrayRef disks, CFDictionaryRef match );
+
+/*!
+ * @function   DASessionCopyDiskList
+ * @abstract   Obtains the descriptions of every disk, and the disk list generation, at one instant.
+ * @param      session    The session object.
+ * @param      match      The match dictionary, or NULL to describe all of the disks.
+ * @param      generation The disk list generation of the descriptions.  Pass NULL if not needed.
+ * @result     The descriptions.  Returns NULL on failure.
+ * @discussion
+ * Pass the generation to DASessionSetGeneration before registering callbacks to hear only of what
+ * has happened to the disk list since.
+ */
+
+extern CFArrayRef DASessionCopyDiskList( DASessionRef session, CFDictionaryRef match, UInt64 * generation );
+
+/*!
+ * @function   DASessionSetGeneration
+ * @abstract   Registers subsequent callbacks for changes to the disk list since a generation.
+ * @param      session    The session object.
+ * @param      generation The disk list generation from DASessionCopyDiskList.  Pass 0 for none.
+ * @result     A result code.  Returns kDAReturnNotFound for a generation the server no longer
+ * knows, in which case the session should obtain the disk list anew.
+ * @discussion
+ * A disk appeared callback registered afterwards is replayed only for the disks that have appeared
+ * or whose description has changed since the generation.  A disk disappeared callback registered
+ * afterwards is replayed for the disks that have disappeared since the generation.  The generation
+ * is forgotten should the server restart, in which case the disk list is replayed in full.
+ */
+
+extern DAReturn DASessionSetGeneration( DASessionRef session, UInt64 generation );
+
+/*!
+ * @function   DASessionCopyStatistics
+ * @abstract   Obtains the statistics of diskarbitrationd.
+ * @param      session The session object.
+ * @result     The statistics, keyed by kDAStatistics keys.  Returns NULL on failure.
+ */
+
+extern CFDictionaryRef DASessionCopyStatistics( DASessionRef session );
+
+/*!
+ * @typedef    DADiskManyCallback
+ * @abstract   Type of the callback function used by DADiskMountMany() and DADiskUnmountMany().
+ * @param      disks      The disk objects.
+ * @param      dissenters The dissenter object for each disk, in the same order, or kCFNull on success.
+ * @param      context    The user-defined context parameter given to the mount or unmount function.
+ */
+
+typedef void ( *DADiskManyCallback )( CFArrayRef disks, CFArrayRef dissenters, void * __nullable context );
+
+/*!
+ * @function   DADiskMountMany
+ * @abstract   Mounts the volumes at the specified disk objects.
+ * @param      disks     The disk objects, which must be distinct and belong to the same session.
+ * @param      options   The mount options.
+ * @param      arguments The null-terminated list of mount options to pass to /sbin/mount -o.
+ * @param      callback  The callback function to call once every mount completes.
+ * @param      context   The user-defined context parameter to pass to the callback function.
+ * @discussion
+ * The mounts are submitted to the server in one message.  The volumes on different disks are
+ * mounted in parallel, each at its "standard" mount path.
+ */
+
+extern void DADiskMountMany( CFArrayRef                    disks,
+                             DADiskMountOptions            options,
+                             CFStringRef __nullable        arguments[_Nullable],
+                             DADiskManyCallback __nullable callback,
+                             void * __nullable             context );
+
+/*!
+ * @function   DADiskUnmountMany
+ * @abstract   Unmounts the volumes at the specified disk objects.
+ * @param      disks    The disk objects, which must be distinct and belong to the same session.
+ * @param      options  The unmount options.
+ * @param      callback The callback function to call once every unmount completes.
+ * @param      context  The user-defined context parameter to pass to the callback function.
+ * @discussion
+ * The unmounts are submitted to the server in one message.  The volumes on different disks are
+ * unmounted in parallel.
+ */
+
+extern void DADiskUnmountMany( CFArrayRef                    disks,
+                               DADiskUnmountOptions          options,
+                               DADiskManyCallback __nullable callback,
+                               void * __nullable             context );
 
 /*!
  * @typedef    DADiskAppearedCallbackBlock
@@ -519,6 +761,41 @@ extern void DADiskUnmountWithBlock( DADiskRef                        disk,
                                     DADiskUnmountOptions             options,
                                     DADiskUnmountCallbackBlock __nullable callback );
 
+/*!
+ * @typedef    DADiskManyCallbackBlock
+ * @abstract   Type of the callback block used by DADiskMountManyWithBlock() and DADiskUnmountManyWithBlock().
+ * @param      disks      The disk objects.
+ * @param      dissenters The dissenter object for each disk, in the same order, or kCFNull on success.
+ */
+
+typedef void ( ^DADiskManyCallbackBlock )( CFArrayRef disks, CFArrayRef dissenters );
+
+/*!
+ * @function   DADiskMountManyWithBlock
+ * @abstract   Mounts the volumes at the specified disk objects.
+ * @param      disks     The disk objects, which must belong to the same session.
+ * @param      options   The mount options.
+ * @param      arguments The null-terminated list of mount options to pass to /sbin/mount -o.
+ * @param      callback  The callback block to call once every mount completes.
+ */
+
+extern void DADiskMountManyWithBlock( CFArrayRef                         disks,
+                                      DADiskMountOptions                 options,
+                                      CFStringRef __nullable             arguments[_Nullable],
+                                      DADiskManyCallbackBlock __nullable callback );
+
+/*!
+ * @function   DADiskUnmountManyWithBlock
+ * @abstract   Unmounts the volumes at the specified disk objects.
+ * @param      disks    The disk objects, which must belong to the same session.
+ * @param      options  The unmount options.
+ * @param      callback The callback block to call once every unmount completes.
+ */
+
+extern void DADiskUnmountManyWithBlock( CFArrayRef                         disks,
+                                        DADiskUnmountOptions               options,
+                                        DADiskManyCallbackBlock __nullable callback );
+
 /*!
  * @typedef    DADiskUnmountApprovalCallbackBlock
  * @abstract   Type of the callback block used by DARegisterDiskUnmountApprovalCallbackBlock().
@@ -38,11 +38,14 @@
 #include <Foundation/Foundation.h>
 #include <DiskArbitration/DiskArbitration.h>
 #include <DiskArbitration/DiskArbitrationPrivate.h>
+#include <fstab.h>
 #include <paths.h>
 #include <time.h>
 #include <CoreAnalytics/CoreAnalytics.h>
 #include <bsm/libbsm.h>
 
+#include "../diskarbitrationd/fstabparse.h"
+
 #define kDAMaxArgLength 2048
 
 struct clarg {
@@ -85,6 +88,15 @@ enum {
     kDATestTelemetry,
     kDAValue,
     kDAUseAuditToken,
+    kDABenchNotifications,
+    kDAUseCallbackRing,
+    kDABenchEncoding,
+    kDACoalesce,
+    kDABenchDescription,
+    kDABenchSlowHandler,
+    kDABenchMountMap,
+    kDABenchMountPoint,
+    kDATestMountOptions,
     kDAHelp,
     kDALast
 } options;
@@ -131,6 +143,15 @@ static struct option opts[] = {
 { "setDiskAdoption",                            required_argument,      0,              kDASetDiskAdoption },
 { "testTelemetry",                              no_argument,            0,              kDATestTelemetry},
 { "useAuditToken",                              no_argument,            0,              kDAUseAuditToken},
+{ "benchNotifications",                         no_argument,            0,              kDABenchNotifications},
+{ "useCallbackRing",                            no_argument,            0,              kDAUseCallbackRing},
+{ "benchEncoding",                              no_argument,            0,              kDABenchEncoding},
+{ "coalesce",                                   required_argument,      0,              kDACoalesce},
+{ "benchDescription",                           no_argument,            0,              kDABenchDescription},
+{ "benchSlowHandler",                           no_argument,            0,              kDABenchSlowHandler},
+{ "benchMountMap",                              no_argument,            0,              kDABenchMountMap},
+{ "benchMountPoint",                            no_argument,            0,              kDABenchMountPoint},
+{ "testMountOptions",                           no_argument,            0,              kDATestMountOptions},
 { "help",                                       no_argument,            0,              kDAHelp },
 { 0,                   0,                      0,              0 }
 };
@@ -485,13 +506,20 @@ static void usage(void)
 "datest --rename --device <device>  --name <name> [--useBlockCallback --useAuditToken]\n"
 "datest --testDiskAppeared [--useBlockCallback] \n"
 "datest --testDiskDisAppeared --device <device> [--useBlockCallback] \n"
-"datest --testDiskDescChanged --device <device> [--useBlockCallback] [--checkRepairRunning]\n"
+"datest --testDiskDescChanged --device <device> [--useBlockCallback] [--checkRepairRunning] [--coalesce <ms>]\n"
 "datest --testDAIdle  [--useBlockCallback] \n"
 "datest --testDASessionKeepAliveWithDAIdle  \n"
 "datest --testDASessionKeepAliveWithDADiskAppeared  \n"
 "datest --testDASessionKeepAliveWithDARegisterDiskAppeared  \n"
 "datest --testDASessionKeepAliveWithDADiskDescriptionChanged \n"
 "datest --setDiskAdoption <y/n> --device <device> \n"
+"datest --benchNotifications [--value <rounds>] [--useCallbackRing] \n"
+"datest --benchEncoding --device <device> [--value <iterations>] \n"
+"datest --benchDescription --device <device> [--value <iterations>] \n"
+"datest --benchSlowHandler [--value <ms>] \n"
+"datest --benchMountMap --device <device> [--value <iterations>] \n"
+"datest --benchMountPoint [--value <images>] \n"
+"datest --testMountOptions --device <device> \n"
 #ifdef DA_FSKIT
 "datest --testSetFSKitAdditions --device <device> \n"
 #endif
@@ -1340,6 +1368,15 @@ static int testDiskDescriptionChanged(struct clarg actargs[kDALast])
     
     descCallback = ( checkRepairStatus ) ? DiskDescriptionRepairRunningCallback : DiskDescriptionChangedCallback;
     
+    if ( actargs[kDACoalesce].present )
+    {
+        if ( DASessionSetCoalescingInterval( _session, atoi( actargs[kDACoalesce].argument ) / 1000.0 ) != kDAReturnSuccess )
+        {
+            printf( "DASessionSetCoalescingInterval failed.\n" );
+            goto exit;
+        }
+    }
+
     if ( _session ) {
 
         if ( actargs[kDAUseBlockCallback].present )
@@ -1378,6 +1415,17 @@ static int testDiskDescriptionChanged(struct clarg actargs[kDALast])
         ret = -1;
     }
 
+    if ( actargs[kDACoalesce].present )
+    {
+        CFDictionaryRef statistics = DASessionCopyStatistics( _session );
+
+        if ( statistics )
+        {
+            CFShow( statistics );
+            CFRelease( statistics );
+        }
+    }
+
 exit:
     return ret;
 }
@@ -1913,133 +1961,1177 @@ exit:
     return ret;
 }
 
-int main (int argc, char * argv[])
+static void BenchDiskAppearedCallback( DADiskRef disk, void *context )
 {
+    ( *( uint64_t * ) context )++;
+}
 
-    int ch, longindex;
+static void BenchDiskListCompleteCallback( void *context )
+{
+    dispatch_semaphore_signal( ( dispatch_semaphore_t ) context );
+}
 
-    setlinebuf(stdout);
-    
-    if(argc == 1) {
-        usage();
+static int benchNotifications(struct clarg actargs[kDALast])
+{
+    int                     ret = 1;
+    int                     rounds = 100;
+    uint64_t                count = 0;
+    uint64_t                start;
+    uint64_t                elapsed;
+    dispatch_semaphore_t    complete;
+    DASessionRef            _session = DASessionCreate(kCFAllocatorDefault);
+
+    if ( !_session )
+    {
+        printf( "DASessionCreate failed.\n" );
+        goto exit;
     }
-    
-    
-    while ((ch = getopt_long_only(argc, argv, "", opts, &longindex)) != -1) {
-        
-        switch(ch) {
-            case kDAHelp:
-                usage();
-                break;
-            case '?':
-            case ':':
-                usage();
-                break;
-            default:
-                // common handling for all other options
-            {
-                struct option *opt = &opts[longindex];
-                
-                if(actargs[ch].present) {
-                    warnx("Option \"%s\" already specified", opt->name);
-                    usage();
-                    break;
-                } else {
-                    actargs[ch].present = 1;
-                }
-                
-                switch(opt->has_arg) {
-                    case no_argument:
-                        actargs[ch].hasArg = 0;
-                        break;
-                    case required_argument:
-                        actargs[ch].hasArg = 1;
-                        strlcpy(actargs[ch].argument, optarg, sizeof(actargs[ch].argument));
-                        break;
-                    case optional_argument:
-                        if(argv[optind] && argv[optind][0] != '-') {
-                            actargs[ch].hasArg = 1;
-                            strlcpy(actargs[ch].argument, argv[optind], sizeof(actargs[ch].argument));
-                        } else {
-                            actargs[ch].hasArg = 0;
-                        }
-                        break;
-                }
-            }
-                break;
+
+    if ( actargs[kDAValue].present )
+    {
+        rounds = atoi( actargs[kDAValue].argument );
+    }
+
+    if ( actargs[kDAUseCallbackRing].present )
+    {
+        if ( DASessionEnableCallbackRing( _session, 0 ) != kDAReturnSuccess )
+        {
+            printf( "DASessionEnableCallbackRing failed.\n" );
+            goto exit;
         }
     }
 
-    argc -= optind;
-    argc += optind;
-    
-    if(actargs[kDAMount].present) {
-        return testMount(actargs, 0);
+    myDispatchQueue = dispatch_queue_create("com.example.DiskArbTest", DISPATCH_QUEUE_SERIAL);
+    complete = dispatch_semaphore_create( 0 );
+
+    DASessionSetDispatchQueue( _session, myDispatchQueue );
+
+    /*
+     * Every registration for disk appeared replays the whole disk list to the session,
+     * followed by the disk list complete callback.
+     */
+
+    start = clock_gettime_nsec_np( CLOCK_UPTIME_RAW );
+
+    for ( int round = 0; round < rounds; round++ )
+    {
+        DARegisterDiskListCompleteCallback( _session, BenchDiskListCompleteCallback, complete );
+        DARegisterDiskAppearedCallback( _session, NULL, BenchDiskAppearedCallback, &count );
+
+        if ( dispatch_semaphore_wait( complete, dispatch_time( DISPATCH_TIME_NOW, 35 * NSEC_PER_SEC ) ) )
+        {
+            printf( "timed out waiting for disk list complete.\n" );
+            goto exit;
+        }
+
+        DAUnregisterCallback( _session, BenchDiskAppearedCallback, &count );
+        DAUnregisterCallback( _session, BenchDiskListCompleteCallback, complete );
     }
-    
-    if(actargs[kDAMountApproval].present) {
-        return testMount(actargs, 1);
+
+    elapsed = clock_gettime_nsec_np( CLOCK_UPTIME_RAW ) - start;
+
+    dispatch_sync( myDispatchQueue, ^{ } );
+
+    printf( "%llu notifications in %.3f s, %.0f notifications/sec (%s)\n",
+            count + rounds,
+            elapsed / 1e9,
+            ( count + rounds ) / ( elapsed / 1e9 ),
+            actargs[kDAUseCallbackRing].present ? "callback ring" : "callback queue" );
+
+    DASessionSetDispatchQueue( _session, NULL );
+
+    ret = 0;
+
+exit:
+    if ( _session )  CFRelease( _session );
+
+    return ret;
+}
+
+static int benchEncodingWith( DASessionRef session, DADiskRef disk, UInt32 encoding, const char * name, int iterations )
+{
+    CFDataRef   serialization;
+    CFDataRef   snapshot;
+    DADiskRef   source;
+    CFIndex     count = 0;
+    uint64_t    start;
+    uint64_t    encodeElapsed;
+    uint64_t    decodeElapsed;
+
+    /*
+     * Copy the description from the daemon once, into a disk object that holds it, so that the
+     * encode loop serializes that one dictionary rather than timing a round trip to the daemon.
+     */
+
+    snapshot = _DADiskCopySerialization( disk, kDADiskSerializationEncodingPropertyList );
+
+    if ( snapshot == NULL )
+    {
+        printf( "_DADiskCopySerialization failed.\n" );
+        return 1;
     }
 
-    if(actargs[kDAUnmount].present) {
-        return testUnmount(actargs, 0);
+    source = _DADiskCreateFromSerialization( kCFAllocatorDefault, session, snapshot );
+
+    CFRelease( snapshot );
+
+    if ( source == NULL )
+    {
+        printf( "_DADiskCreateFromSerialization failed.\n" );
+        return 1;
     }
-    
-    if(actargs[kDAUnmountApproval].present) {
-        return testUnmount(actargs, 1);
+
+    serialization = _DADiskCopySerialization( source, encoding );
+
+    if ( serialization == NULL )
+    {
+        printf( "_DADiskCopySerialization failed.\n" );
+        CFRelease( source );
+        return 1;
     }
 
-    if(actargs[kDAEject].present) {
-        return testEject(actargs, 0);
+    start = clock_gettime_nsec_np( CLOCK_UPTIME_RAW );
+
+    for ( int iteration = 0; iteration < iterations; iteration++ )
+    {
+        CFDataRef data = _DADiskCopySerialization( source, encoding );
+
+        if ( data )  CFRelease( data );
     }
-       
-    if(actargs[kDAEjectApproval].present) {
-        return testEject(actargs, 1);
+
+    encodeElapsed = clock_gettime_nsec_np( CLOCK_UPTIME_RAW ) - start;
+
+    start = clock_gettime_nsec_np( CLOCK_UPTIME_RAW );
+
+    for ( int iteration = 0; iteration < iterations; iteration++ )
+    {
+        DADiskRef copy = _DADiskCreateFromSerialization( kCFAllocatorDefault, session, serialization );
+
+        if ( copy )
+        {
+            CFDictionaryRef description = DADiskCopyDescription( copy );
+
+            if ( description )
+            {
+                count = CFDictionaryGetCount( description );
+
+                CFRelease( description );
+            }
+
+            CFRelease( copy );
+        }
     }
-       
-    if(actargs[kDARename].present) {
-        return testRename(actargs);
+
+    decodeElapsed = clock_gettime_nsec_np( CLOCK_UPTIME_RAW ) - start;
+
+    printf( "%-12s %ld keys, %6ld bytes, encode %8.0f ns, decode %8.0f ns\n",
+            name,
+            ( long ) count,
+            ( long ) CFDataGetLength( serialization ),
+            ( double ) encodeElapsed / iterations,
+            ( double ) decodeElapsed / iterations );
+
+    CFRelease( serialization );
+    CFRelease( source );
+
+    return 0;
+}
+
+static int benchEncoding(struct clarg actargs[kDALast])
+{
+    int                     ret = 1;
+    int                     iterations = 10000;
+    int                     validArgs[] = {kDADevice};
+    DASessionRef            _session = NULL;
+    DADiskRef               _disk = NULL;
+
+    if ( validateArguments( validArgs, sizeof(validArgs)/sizeof(int), actargs ) )
+    {
+        goto exit;
     }
-    
-    if(actargs[kDAEncode].present) {
-        return testEncode(actargs);
+
+    if ( actargs[kDAValue].present )
+    {
+        iterations = atoi( actargs[kDAValue].argument );
     }
-    
-    if(actargs[kDADiskAppeared].present) {
-        return testDiskAppeared(actargs);
+
+    if ( iterations <= 0 )
+    {
+        usage();
     }
 
-    if(actargs[kDADiskDisAppeared].present) {
-        return testDiskDisAppeared(actargs);
+    _session = DASessionCreate(kCFAllocatorDefault);
+
+    if ( !_session )
+    {
+        printf( "DASessionCreate failed.\n" );
+        goto exit;
     }
-    
-    if(actargs[kDADiskDescChanged].present) {
-        return testDiskDescriptionChanged(actargs);
+
+    _disk = DADiskCreateFromBSDName(kCFAllocatorDefault, _session, actargs[kDADevice].argument);
+
+    if ( !_disk )
+    {
+        printf( "%s does not exist.\n", actargs[kDADevice].argument);
+        goto exit;
     }
-    
-    if(actargs[kDAIdle].present) {
-        return testDAIdle(actargs);
+
+    /*
+     * The encode loop includes the copy of the description the disk object holds, the decode
+     * loop includes the creation of the disk object, as both are paid on every callback.
+     */
+
+    ret  = benchEncodingWith( _session, _disk, kDADiskSerializationEncodingPropertyList, "plist", iterations );
+    ret |= benchEncodingWith( _session, _disk, kDADiskSerializationEncodingCompact, "compact", iterations );
+
+exit:
+    if ( _disk )  CFRelease( _disk );
+    if ( _session )  CFRelease( _session );
+
+    return ret;
+}
+
+static int benchDescriptionWith( DASessionRef session, const char * device, Boolean cache, int iterations )
+{
+    DADiskRef   disk;
+    CFIndex     count = 0;
+    uint64_t    start;
+    uint64_t    elapsed;
+
+    DASessionSetDescriptionCacheEnabled( session, cache );
+
+    disk = DADiskCreateFromBSDName( kCFAllocatorDefault, session, device );
+
+    if ( disk == NULL )
+    {
+        printf( "%s does not exist.\n", device );
+        return 1;
     }
-    
-    if(actargs[kDASessionKeepAliveWithDAIdle].present) {
-        return testDASessionKeepAliveWithDAIdle(actargs);
+
+    start = clock_gettime_nsec_np( CLOCK_UPTIME_RAW );
+
+    for ( int iteration = 0; iteration < iterations; iteration++ )
+    {
+        CFDictionaryRef description = DADiskCopyDescription( disk );
+
+        if ( description )
+        {
+            count = CFDictionaryGetCount( description );
+
+            CFRelease( description );
+        }
     }
-    if(actargs[kDASessionKeepAliveWithDADiskAppeared].present) {
-        return testDASessionKeepAliveWithDADiskAppeared(actargs);
+
+    elapsed = clock_gettime_nsec_np( CLOCK_UPTIME_RAW ) - start;
+
+    printf( "%-12s %ld keys, copy %8.0f ns\n",
+            cache ? "cached" : "uncached",
+            ( long ) count,
+            ( double ) elapsed / iterations );
+
+    CFRelease( disk );
+
+    return 0;
+}
+
+static int benchDescription(struct clarg actargs[kDALast])
+{
+    int                     ret = 1;
+    int                     iterations = 10000;
+    int                     validArgs[] = {kDADevice};
+    DASessionRef            _session = NULL;
+
+    if ( validateArguments( validArgs, sizeof(validArgs)/sizeof(int), actargs ) )
+    {
+        goto exit;
     }
-    if(actargs[kDASessionKeepAliveWithDARegisterDiskAppeared].present) {
-        return testDASessionKeepAliveWithDARegisterDiskAppeared(actargs);
+
+    if ( actargs[kDAValue].present )
+    {
+        iterations = atoi( actargs[kDAValue].argument );
     }
-    if(actargs[kDASessionKeepAliveWithDADiskDescriptionChanged].present) {
-        return testDASessionKeepAliveWithDADiskDescriptionChanged(actargs);
+
+    if ( iterations <= 0 )
+    {
+        usage();
     }
 
-    if(actargs[kDASetFSKitAdditions].present) {
-        return testDASetFSKitAdditions(actargs);
+    _session = DASessionCreate(kCFAllocatorDefault);
+
+    if ( !_session )
+    {
+        printf( "DASessionCreate failed.\n" );
+        goto exit;
     }
-    
-    if(actargs[kDASetDiskAdoption].present) {
-        return testDASetDiskAdoption(actargs);
+
+    /*
+     * The cache is only used by a scheduled session, which is kept current by the server.
+     */
+
+    myDispatchQueue = dispatch_queue_create("com.example.DiskArbTest", DISPATCH_QUEUE_SERIAL);
+
+    DASessionSetDispatchQueue( _session, myDispatchQueue );
+
+    ret  = benchDescriptionWith( _session, actargs[kDADevice].argument, FALSE, iterations );
+    ret |= benchDescriptionWith( _session, actargs[kDADevice].argument, TRUE, iterations );
+
+    /*
+     * Compare with the inventory of every disk in a single request.
+     */
+
+    {
+        CFIndex     count = 0;
+        uint64_t    start;
+        uint64_t    elapsed;
+
+        start = clock_gettime_nsec_np( CLOCK_UPTIME_RAW );
+
+        for ( int iteration = 0; iteration < iterations; iteration++ )
+        {
+            CFArrayRef descriptions = DASessionCopyDescriptions( _session, NULL, NULL );
+
+            if ( descriptions )
+            {
+                count = CFArrayGetCount( descriptions );
+
+                CFRelease( descriptions );
+            }
+        }
+
+        elapsed = clock_gettime_nsec_np( CLOCK_UPTIME_RAW ) - start;
+
+        printf( "%-12s %ld disks, copy %8.0f ns\n", "all disks", ( long ) count, ( double ) elapsed / iterations );
+    }
+
+    /*
+     * Take a snapshot of the disk list and register since its generation.
+     */
+
+    {
+        CFArrayRef  descriptions;
+        UInt64      generation = 0;
+
+        descriptions = DASessionCopyDiskList( _session, NULL, &generation );
+
+        if ( descriptions == NULL || DASessionSetGeneration( _session, generation ) != kDAReturnSuccess )
+        {
+            printf( "disk list snapshot failed\n" );
+            ret = 1;
+        }
+        else
+        {
+            printf( "%-12s %ld disks, generation %llu\n", "snapshot", ( long ) CFArrayGetCount( descriptions ), generation );
+        }
+
+        if ( descriptions )  CFRelease( descriptions );
+    }
+
+    DASessionSetDispatchQueue( _session, NULL );
+
+exit:
+    if ( _session )  CFRelease( _session );
+
+    return ret;
+}
+
+static int slowHandlerDelay = 10;
+
+static void SlowDiskAppearedCallback( DADiskRef disk, void *context )
+{
+    usleep( slowHandlerDelay * 1000 );
+
+    __atomic_fetch_add( ( uint64_t * ) context, 1, __ATOMIC_RELAXED );
+}
+
+static int benchSlowHandlerWith( dispatch_queue_t concurrent, const char * name )
+{
+    int                     ret = 1;
+    uint64_t                count = 0;
+    uint64_t                start;
+    uint64_t                elapsed;
+    dispatch_semaphore_t    complete;
+    DASessionRef            _session = DASessionCreate(kCFAllocatorDefault);
+
+    if ( !_session )
+    {
+        printf( "DASessionCreate failed.\n" );
+        goto exit;
+    }
+
+    complete = dispatch_semaphore_create( 0 );
+
+    DASessionSetConcurrentDeliveryQueue( _session, concurrent );
+    DASessionSetDispatchQueue( _session, myDispatchQueue );
+
+    /*
+     * The disk list complete callback waits for every disk appeared callback before it.
+     */
+
+    start = clock_gettime_nsec_np( CLOCK_UPTIME_RAW );
+
+    DARegisterDiskListCompleteCallback( _session, BenchDiskListCompleteCallback, complete );
+    DARegisterDiskAppearedCallback( _session, NULL, SlowDiskAppearedCallback, &count );
+
+    if ( dispatch_semaphore_wait( complete, dispatch_time( DISPATCH_TIME_NOW, 120 * NSEC_PER_SEC ) ) )
+    {
+        printf( "timed out waiting for disk list complete.\n" );
+        goto exit;
+    }
+
+    elapsed = clock_gettime_nsec_np( CLOCK_UPTIME_RAW ) - start;
+
+    printf( "%-12s %llu disks at %d ms each in %.3f s\n", name, count, slowHandlerDelay, elapsed / 1e9 );
+
+    DAUnregisterCallback( _session, SlowDiskAppearedCallback, &count );
+    DAUnregisterCallback( _session, BenchDiskListCompleteCallback, complete );
+
+    DASessionSetDispatchQueue( _session, NULL );
+
+    ret = 0;
+
+exit:
+    if ( _session )  CFRelease( _session );
+
+    return ret;
+}
+
+static int benchSlowHandler(struct clarg actargs[kDALast])
+{
+    int ret;
+
+    if ( actargs[kDAValue].present )
+    {
+        slowHandlerDelay = atoi( actargs[kDAValue].argument );
+    }
+
+    myDispatchQueue = dispatch_queue_create("com.example.DiskArbTest", DISPATCH_QUEUE_SERIAL);
+
+    ret = benchSlowHandlerWith( NULL, "serial" );
+
+    if ( ret == 0 )
+    {
+        ret = benchSlowHandlerWith( dispatch_get_global_queue( QOS_CLASS_DEFAULT, 0 ), "concurrent" );
+    }
+
+    return ret;
+}
+
+static void BenchMountMapCallback( DADiskRef disk, DADissenterRef dissenter, void *context )
+{
+    if ( dissenter )
+    {
+        printf( "request failed with 0x%x\n", DADissenterGetStatus( dissenter ) );
+    }
+
+    dispatch_semaphore_signal( ( dispatch_semaphore_t ) context );
+}
+
+static int benchMountMapWith( DADiskRef disk, const char * name, int iterations )
+{
+    uint64_t                elapsed = 0;
+    uint64_t                first = 0;
+    dispatch_semaphore_t    complete;
+
+    complete = dispatch_semaphore_create( 0 );
+
+    /*
+     * The first mount may race the rebuild of the mount map list, which follows the change to
+     * the file rather than the mount, so it is measured on its own.
+     */
+
+    for ( int iteration = -1; iteration < iterations; iteration++ )
+    {
+        uint64_t start;
+
+        start = clock_gettime_nsec_np( CLOCK_UPTIME_RAW );
+
+        DADiskMount( disk, NULL, kDADiskMountOptionDefault, BenchMountMapCallback, complete );
+
+        if ( dispatch_semaphore_wait( complete, dispatch_time( DISPATCH_TIME_NOW, 60 * NSEC_PER_SEC ) ) )
+        {
+            printf( "timed out waiting for mount.\n" );
+            return 1;
+        }
+
+        if ( iteration >= 0 )
+        {
+            elapsed += clock_gettime_nsec_np( CLOCK_UPTIME_RAW ) - start;
+        }
+        else
+        {
+            first = clock_gettime_nsec_np( CLOCK_UPTIME_RAW ) - start;
+        }
+
+        DADiskUnmount( disk, kDADiskUnmountOptionDefault, BenchMountMapCallback, complete );
+
+        if ( dispatch_semaphore_wait( complete, dispatch_time( DISPATCH_TIME_NOW, 60 * NSEC_PER_SEC ) ) )
+        {
+            printf( "timed out waiting for unmount.\n" );
+            return 1;
+        }
+    }
+
+    printf( "%-12s first mount %10llu ns, mount %10.0f ns\n", name, first, ( double ) elapsed / iterations );
+
+    return 0;
+}
+
+static uint64_t benchMountMapParse( NSData * fstab, char * scratch, int * entries )
+{
+    char *   end;
+    char *   line;
+    uint64_t start;
+
+    /*
+     * Parse each line in place, just as the daemon does when it builds the mount map list, so
+     * the file is copied ahead of the clock.
+     */
+
+    memcpy( scratch, [fstab bytes], [fstab length] );
+
+    end = scratch + [fstab length];
+
+    *entries = 0;
+
+    start = clock_gettime_nsec_np( CLOCK_UPTIME_RAW );
+
+    for ( line = scratch; line < end; )
+    {
+        struct fstab fs;
+        char *       next;
+
+        next = memchr( line, '\n', end - line );
+
+        if ( next == NULL )
+        {
+            next = end;
+        }
+
+        *next = 0;
+
+        if ( fstabparse_r( line, &fs ) > 0 )
+        {
+            ( *entries )++;
+        }
+
+        line = next + 1;
+    }
+
+    return clock_gettime_nsec_np( CLOCK_UPTIME_RAW ) - start;
+}
+
+static int benchMountMap(struct clarg actargs[kDALast])
+{
+    int                     ret = 1;
+    int                     entries = 10000;
+    int                     iterations = 20;
+    int                     validArgs[] = {kDADevice};
+    DASessionRef            _session = NULL;
+    DADiskRef               _disk = NULL;
+    NSData                  *original = nil;
+    NSMutableData           *fstab;
+    char                    line[128];
+    char                    *scratch = NULL;
+    uint64_t                elapsed = 0;
+    int                     parsed = 0;
+
+    if ( validateArguments( validArgs, sizeof(validArgs)/sizeof(int), actargs ) )
+    {
+        goto exit;
+    }
+
+    if ( actargs[kDAValue].present )
+    {
+        iterations = atoi( actargs[kDAValue].argument );
+    }
+
+    if ( iterations <= 0 )
+    {
+        usage();
+    }
+
+    _session = DASessionCreate(kCFAllocatorDefault);
+
+    if ( !_session )
+    {
+        printf( "DASessionCreate failed.\n" );
+        goto exit;
+    }
+
+    _disk = DADiskCreateFromBSDName( kCFAllocatorDefault, _session, actargs[kDADevice].argument );
+
+    if ( !_disk )
+    {
+        printf( "%s does not exist.\n", actargs[kDADevice].argument );
+        goto exit;
+    }
+
+    myDispatchQueue = dispatch_queue_create("com.example.DiskArbTest", DISPATCH_QUEUE_SERIAL);
+
+    DASessionSetDispatchQueue( _session, myDispatchQueue );
+
+    ret = benchMountMapWith( _disk, "fstab", iterations );
+
+    if ( ret )
+    {
+        goto exit;
+    }
+
+    /*
+     * Pad a copy of the fstab with entries that match no volume, ahead of the entries already
+     * there, and measure the parse that a rebuild of the mount map list performs for each line
+     * it has not seen before.  The copy is held in memory, so that the fstab itself is never
+     * touched.  It is copied as bytes, since nothing requires it to be valid UTF-8.
+     */
+
+    original = [NSData dataWithContentsOfFile:@_PATH_FSTAB];
+
+    fstab = [NSMutableData dataWithCapacity:entries * 64];
+
+    for ( int entry = 0; entry < entries; entry++ )
+    {
+        [fstab appendBytes:line length:snprintf( line, sizeof( line ), "UUID=%08X-0000-4000-8000-%012X none apfs rw,noauto\n", arc4random( ), entry )];
+    }
+
+    if ( [original length] )
+    {
+        [fstab appendData:original];
+    }
+
+    scratch = malloc( [fstab length] + 1 );
+
+    if ( scratch == NULL )
+    {
+        printf( "unable to allocate %lu bytes.\n", ( unsigned long ) [fstab length] + 1 );
+        ret = 1;
+        goto exit;
+    }
+
+    for ( int iteration = 0; iteration < iterations; iteration++ )
+    {
+        elapsed += benchMountMapParse( fstab, scratch, &parsed );
+    }
+
+    printf( "%-12s parse %10.0f ns, %6.0f ns per entry (%d entries)\n", "fstab 10k", ( double ) elapsed / iterations, ( double ) elapsed / iterations / ( parsed ? parsed : 1 ), parsed );
+
+exit:
+    if ( _session )
+    {
+        DASessionSetDispatchQueue( _session, NULL );
+    }
+
+    if ( scratch )  free( scratch );
+    if ( _disk )  CFRelease( _disk );
+    if ( _session )  CFRelease( _session );
+
+    return ret;
+}
+
+static int benchMountPointRun( const char * command, char * output, size_t size )
+{
+    FILE *f = popen( command, "r" );
+    int   status;
+
+    if ( !f )
+    {
+        printf( "%s failed: %d (%s)\n", command, errno, strerror( errno ) );
+        return 1;
+    }
+
+    if ( output )
+    {
+        output[0] = 0;
+
+        if ( fgets( output, ( int ) size, f ) )
+        {
+            output[ strcspn( output, " \t\n" ) ] = 0;
+        }
+
+        while ( fgetc( f ) != EOF );
+    }
+
+    status = pclose( f );
+
+    if ( status )
+    {
+        printf( "%s failed with %d.\n", command, status );
+    }
+
+    return status ? 1 : 0;
+}
+
+static int benchMountPoint(struct clarg actargs[kDALast])
+{
+    int                     ret = 1;
+    int                     images = 200;
+    int                     attached = 0;
+    int                     mounted = 0;
+    uint64_t                elapsed = 0;
+    uint64_t                last = 0;
+    Boolean                 created = FALSE;
+    char                    folder[] = "/tmp/datest.XXXXXX";
+    char                    command[MAXPATHLEN * 2];
+    char                    (*devices)[MAXPATHLEN] = NULL;
+    DASessionRef            _session = NULL;
+    dispatch_semaphore_t    complete;
+
+    if ( actargs[kDAValue].present )
+    {
+        images = atoi( actargs[kDAValue].argument );
+    }
+
+    if ( images <= 0 )
+    {
+        usage();
+    }
+
+    devices = calloc( images, sizeof( *devices ) );
+
+    if ( !devices || mkdtemp( folder ) == NULL )
+    {
+        printf( "unable to create %s.\n", folder );
+        goto exit;
+    }
+
+    created = TRUE;
+
+    /*
+     * Attach that many copies of an image, a hundred at a time carrying the same volume name,
+     * so that every mount after the first of each hundred has to look past the names already
+     * taken under /Volumes.  No more than a hundred volumes of one name get a mount point.
+     */
+
+    for ( int group = 0; group * 100 < images; group++ )
+    {
+        snprintf( command, sizeof( command ), "hdiutil create -quiet -size 1m -fs 'MS-DOS FAT12' -volname UNTITLED%d -layout NONE %s/image.%d.dmg", group, folder, group );
+
+        if ( benchMountPointRun( command, NULL, 0 ) )
+        {
+            goto exit;
+        }
+    }
+
+    for ( attached = 0; attached < images; attached++ )
+    {
+        snprintf( command, sizeof( command ), "cp -c %s/image.%d.dmg %s/image%d.dmg && hdiutil attach -nomount %s/image%d.dmg", folder, attached / 100, folder, attached, folder, attached );
+
+        if ( benchMountPointRun( command, devices[attached], sizeof( devices[attached] ) ) || devices[attached][0] == 0 )
+        {
+            goto exit;
+        }
+    }
+
+    _session = DASessionCreate(kCFAllocatorDefault);
+
+    if ( !_session )
+    {
+        printf( "DASessionCreate failed.\n" );
+        goto exit;
+    }
+
+    myDispatchQueue = dispatch_queue_create("com.example.DiskArbTest", DISPATCH_QUEUE_SERIAL);
+
+    DASessionSetDispatchQueue( _session, myDispatchQueue );
+
+    complete = dispatch_semaphore_create( 0 );
+
+    for ( mounted = 0; mounted < images; mounted++ )
+    {
+        DADiskRef disk;
+        uint64_t  start;
+
+        disk = DADiskCreateFromBSDName( kCFAllocatorDefault, _session, devices[mounted] );
+
+        if ( !disk )
+        {
+            printf( "%s does not exist.\n", devices[mounted] );
+            goto exit;
+        }
+
+        start = clock_gettime_nsec_np( CLOCK_UPTIME_RAW );
+
+        DADiskMount( disk, NULL, kDADiskMountOptionDefault, BenchMountMapCallback, complete );
+
+        if ( dispatch_semaphore_wait( complete, dispatch_time( DISPATCH_TIME_NOW, 60 * NSEC_PER_SEC ) ) )
+        {
+            printf( "timed out waiting for mount.\n" );
+            CFRelease( disk );
+            goto exit;
+        }
+
+        last = clock_gettime_nsec_np( CLOCK_UPTIME_RAW ) - start;
+
+        elapsed += last;
+
+        CFRelease( disk );
+    }
+
+    printf( "%-12s mount %10.0f ns, last mount %10llu ns\n", "mount point", ( double ) elapsed / images, last );
+
+    ret = 0;
+
+exit:
+    /*
+     * Detaching the images unmounts their volumes as well.
+     */
+
+    while ( attached-- > 0 )
+    {
+        if ( devices[attached][0] )
+        {
+            snprintf( command, sizeof( command ), "hdiutil detach -quiet -force %s", devices[attached] );
+
+            benchMountPointRun( command, NULL, 0 );
+        }
+    }
+
+    if ( created )
+    {
+        snprintf( command, sizeof( command ), "rm -rf %s", folder );
+
+        benchMountPointRun( command, NULL, 0 );
+    }
+
+    if ( _session )
+    {
+        DASessionSetDispatchQueue( _session, NULL );
+    }
+
+    if ( _session )  CFRelease( _session );
+
+    free( devices );
+
+    return ret;
+}
+
+struct TestMountOptionsContext
+{
+    DAReturn             status;
+    dispatch_semaphore_t complete;
+};
+
+static void TestMountOptionsCallback( DADiskRef disk, DADissenterRef dissenter, void *context )
+{
+    struct TestMountOptionsContext * result = context;
+
+    result->status = dissenter ? DADissenterGetStatus( dissenter ) : kDAReturnSuccess;
+
+    dispatch_semaphore_signal( result->complete );
+}
+
+static int testMountOptions(struct clarg actargs[kDALast])
+{
+    int                             ret = 1;
+    int                             failed = 0;
+    int                             validArgs[] = {kDADevice};
+    Boolean                         trusted;
+    DASessionRef                    _session = NULL;
+    DADiskRef                       _disk = NULL;
+    CFDictionaryRef                 description = NULL;
+    struct TestMountOptionsContext  result;
+
+    /*
+     * Each case is a list of mount arguments and whether the daemon should refuse it to a user
+     * other than root, on a disk that is not trusted and on one that is.  An untrusted disk is
+     * refused suid and dev, and a trusted one is refused noowners and noperm, so the cases cover
+     * the forms an argument can take and the order in which arguments override one another.
+     */
+
+    static const struct
+    {
+        const char * arguments;
+        Boolean      untrusted;
+        Boolean      trusted;
+    } cases[] =
+    {
+        { "nosuid",                 FALSE, FALSE },
+        { "suid",                   TRUE,  FALSE },
+        { "dev",                    TRUE,  FALSE },
+        { "-osuid",                 TRUE,  FALSE },
+        { "-odev",                  TRUE,  FALSE },
+        { "suid=1",                 TRUE,  FALSE },
+        { "dev=1",                  TRUE,  FALSE },
+        { "-osuid=1",               TRUE,  FALSE },
+        { "nosuid,suid",            TRUE,  FALSE },
+        { "suid,nosuid",            FALSE, FALSE },
+        { "dev,nodev",              FALSE, FALSE },
+        { "nodev,-odev",            TRUE,  FALSE },
+        { "rdonly,nordonly,noro",   FALSE, FALSE },
+        { "noowners",               FALSE, TRUE  },
+        { "noperm",                 FALSE, TRUE  },
+        { "-onoowners",             FALSE, TRUE  },
+        { "owners=noowners",        FALSE, TRUE  },
+        { "perm=noperm",            FALSE, TRUE  },
+        { "=noowners",              FALSE, TRUE  },
+        { "owners=owners",          FALSE, FALSE },
+        { "owners,noowners",        FALSE, TRUE  },
+        { "noowners,owners",        FALSE, FALSE },
+        { "owners=noowners,perm",   FALSE, FALSE },
+    };
+
+    if ( validateArguments( validArgs, sizeof(validArgs)/sizeof(int), actargs ) )
+    {
+        goto exit;
+    }
+
+    if ( geteuid( ) == 0 )
+    {
+        printf( "must be run as a user other than root.\n" );
+        goto exit;
+    }
+
+    _session = DASessionCreate(kCFAllocatorDefault);
+
+    if ( !_session )
+    {
+        printf( "DASessionCreate failed.\n" );
+        goto exit;
+    }
+
+    _disk = DADiskCreateFromBSDName( kCFAllocatorDefault, _session, actargs[kDADevice].argument );
+
+    if ( !_disk )
+    {
+        printf( "%s does not exist.\n", actargs[kDADevice].argument );
+        goto exit;
+    }
+
+    description = DADiskCopyDescription( _disk );
+
+    if ( !description )
+    {
+        printf( "DADiskCopyDescription failed.\n" );
+        goto exit;
+    }
+
+    /*
+     * Trust follows the default preferences: internal fixed media is trusted, and external or
+     * removable media is not.
+     */
+
+    trusted = ( CFDictionaryGetValue( description, kDADiskDescriptionMediaRemovableKey ) != kCFBooleanTrue &&
+                CFDictionaryGetValue( description, kDADiskDescriptionDeviceInternalKey ) == kCFBooleanTrue );
+
+    myDispatchQueue = dispatch_queue_create("com.example.DiskArbTest", DISPATCH_QUEUE_SERIAL);
+
+    DASessionSetDispatchQueue( _session, myDispatchQueue );
+
+    result.complete = dispatch_semaphore_create( 0 );
+
+    for ( size_t index = 0; index < sizeof( cases ) / sizeof( cases[0] ); index++ )
+    {
+        CFStringRef arguments[2] = { NULL, NULL };
+        Boolean     expected;
+        Boolean     refused;
+
+        expected = trusted ? cases[index].trusted : cases[index].untrusted;
+
+        arguments[0] = CFStringCreateWithCString( kCFAllocatorDefault, cases[index].arguments, kCFStringEncodingUTF8 );
+
+        result.status = kDAReturnSuccess;
+
+        DADiskMountWithArguments( _disk, NULL, kDADiskMountOptionDefault, TestMountOptionsCallback, &result, arguments );
+
+        CFRelease( arguments[0] );
+
+        if ( dispatch_semaphore_wait( result.complete, dispatch_time( DISPATCH_TIME_NOW, 60 * NSEC_PER_SEC ) ) )
+        {
+            printf( "timed out waiting for mount.\n" );
+            goto exit;
+        }
+
+        /*
+         * Only the refusal is of interest.  An argument the file system does not understand
+         * may fail the mount for other reasons once the daemon has let it through.
+         */
+
+        refused = ( result.status == kDAReturnNotPrivileged );
+
+        printf( "%-24s %-8s %s\n", cases[index].arguments, refused ? "refused" : "allowed", ( refused == expected ) ? "ok" : "FAILED" );
+
+        if ( refused != expected )
+        {
+            failed++;
+        }
+
+        if ( result.status == kDAReturnSuccess )
+        {
+            DADiskUnmount( _disk, kDADiskUnmountOptionDefault, TestMountOptionsCallback, &result );
+
+            if ( dispatch_semaphore_wait( result.complete, dispatch_time( DISPATCH_TIME_NOW, 60 * NSEC_PER_SEC ) ) )
+            {
+                printf( "timed out waiting for unmount.\n" );
+                goto exit;
+            }
+        }
+    }
+
+    ret = failed ? 1 : 0;
+
+exit:
+    if ( _session )
+    {
+        DASessionSetDispatchQueue( _session, NULL );
+    }
+
+    if ( description )  CFRelease( description );
+    if ( _disk )  CFRelease( _disk );
+    if ( _session )  CFRelease( _session );
+
+    return ret;
+}
+
+int main (int argc, char * argv[])
+{
+
+    int ch, longindex;
+
+    setlinebuf(stdout);
+    
+    if(argc == 1) {
+        usage();
+    }
+    
+    
+    while ((ch = getopt_long_only(argc, argv, "", opts, &longindex)) != -1) {
+        
+        switch(ch) {
+            case kDAHelp:
+                usage();
+                break;
+            case '?':
+            case ':':
+                usage();
+                break;
+            default:
+                // common handling for all other options
+            {
+                struct option *opt = &opts[longindex];
+                
+                if(actargs[ch].present) {
+                    warnx("Option \"%s\" already specified", opt->name);
+                    usage();
+                    break;
+                } else {
+                    actargs[ch].present = 1;
+                }
+                
+                switch(opt->has_arg) {
+                    case no_argument:
+                        actargs[ch].hasArg = 0;
+                        break;
+                    case required_argument:
+                        actargs[ch].hasArg = 1;
+                        strlcpy(actargs[ch].argument, optarg, sizeof(actargs[ch].argument));
+                        break;
+                    case optional_argument:
+                        if(argv[optind] && argv[optind][0] != '-') {
+                            actargs[ch].hasArg = 1;
+                            strlcpy(actargs[ch].argument, argv[optind], sizeof(actargs[ch].argument));
+                        } else {
+                            actargs[ch].hasArg = 0;
+                        }
+                        break;
+                }
+            }
+                break;
+        }
+    }
+
+    argc -= optind;
+    argc += optind;
+    
+    if(actargs[kDAMount].present) {
+        return testMount(actargs, 0);
+    }
+    
+    if(actargs[kDAMountApproval].present) {
+        return testMount(actargs, 1);
+    }
+
+    if(actargs[kDAUnmount].present) {
+        return testUnmount(actargs, 0);
+    }
+    
+    if(actargs[kDAUnmountApproval].present) {
+        return testUnmount(actargs, 1);
+    }
+
+    if(actargs[kDAEject].present) {
+        return testEject(actargs, 0);
+    }
+       
+    if(actargs[kDAEjectApproval].present) {
+        return testEject(actargs, 1);
+    }
+       
+    if(actargs[kDARename].present) {
+        return testRename(actargs);
+    }
+    
+    if(actargs[kDAEncode].present) {
+        return testEncode(actargs);
+    }
+    
+    if(actargs[kDADiskAppeared].present) {
+        return testDiskAppeared(actargs);
+    }
+
+    if(actargs[kDADiskDisAppeared].present) {
+        return testDiskDisAppeared(actargs);
+    }
+    
+    if(actargs[kDADiskDescChanged].present) {
+        return testDiskDescriptionChanged(actargs);
+    }
+    
+    if(actargs[kDAIdle].present) {
+        return testDAIdle(actargs);
+    }
+    
+    if(actargs[kDASessionKeepAliveWithDAIdle].present) {
+        return testDASessionKeepAliveWithDAIdle(actargs);
+    }
+    if(actargs[kDASessionKeepAliveWithDADiskAppeared].present) {
+        return testDASessionKeepAliveWithDADiskAppeared(actargs);
+    }
+    if(actargs[kDASessionKeepAliveWithDARegisterDiskAppeared].present) {
+        return testDASessionKeepAliveWithDARegisterDiskAppeared(actargs);
+    }
+    if(actargs[kDASessionKeepAliveWithDADiskDescriptionChanged].present) {
+        return testDASessionKeepAliveWithDADiskDescriptionChanged(actargs);
+    }
+
+    if(actargs[kDASetFSKitAdditions].present) {
+        return testDASetFSKitAdditions(actargs);
+    }
+    
+    if(actargs[kDASetDiskAdoption].present) {
+        return testDASetDiskAdoption(actargs);
+    }
+
+    if(actargs[kDABenchNotifications].present) {
+        return benchNotifications(actargs);
+    }
+
+    if(actargs[kDABenchDescription].present) {
+        return benchDescription(actargs);
+    }
+
+    if(actargs[kDABenchSlowHandler].present) {
+        return benchSlowHandler(actargs);
+    }
+    if(actargs[kDABenchMountMap].present) {
+        return benchMountMap(actargs);
+    }
+    if(actargs[kDABenchMountPoint].present) {
+        return benchMountPoint(actargs);
+    }
+    if(actargs[kDATestMountOptions].present) {
+        return testMountOptions(actargs);
+    }
+    if(actargs[kDABenchEncoding].present) {
+        return benchEncoding(actargs);
     }
 
     /* default */
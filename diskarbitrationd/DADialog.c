@@ -85,9 +85,12 @@ static void __DADialogShow( CFMutableArrayRef diskinfoarray, _DAAgentAction acti
 
 static CFBooleanRef IsNotificationDisabled( CFStringRef preference)
 {
-    CFBooleanRef value = CFDictionaryGetValue( gDAPreferenceList, preference );
+    CFDictionaryRef preferences = DAPreferenceListCopy( );
+    CFBooleanRef value = CFDictionaryGetValue( preferences, preference );
 
     value = value ? value : kCFBooleanFalse;
+
+    CFRelease( preferences );
     
     return value;
     
@@ -56,6 +56,10 @@ struct __DADisk
     DACallbackRef          _claim;
     CFTypeRef              _context;
     CFTypeRef              _contextRe;
+    CFDataRef              _delta;
+    CFDataRef              _deltaCompact;
+    SInt64                 _deltaGeneration;
+    CFMutableSetRef        _deltaKeys;
     CFMutableDictionaryRef _description;
     CFURLRef               _device;
     char *                 _deviceLink[2];
@@ -64,12 +68,15 @@ struct __DADisk
     char *                 _containerId;
     SInt32                 _deviceUnit;
     DAFileSystemRef        _filesystem;
+    SInt64                 _generation;
     char *                 _id;
+    UInt64                 _listGeneration;
     io_service_t           _media;
     mode_t                 _mode;
     DADiskOptions          _options;
     io_object_t            _propertyNotification;
     CFDataRef              _serialization;
+    CFDataRef              _serializationCompact;
     DADiskState            _state;
     gid_t                  _userGID;
     uid_t                  _userUID;
@@ -104,6 +111,119 @@ static CFTypeID __kDADiskTypeID = _kCFRuntimeNotATypeID;
 
 extern CFHashCode CFHashBytes( UInt8 * bytes, CFIndex length );
 
+static CFDataRef __DADiskCreateDelta( DADiskRef disk, _DAEncoding encoding )
+{
+    CFMutableDictionaryRef delta;
+    CFDataRef              data = NULL;
+
+    delta = CFDictionaryCreateMutable( kCFAllocatorDefault, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks );
+
+    if ( delta )
+    {
+        CFMutableArrayRef removed;
+
+        removed = CFArrayCreateMutable( kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks );
+
+        const void ** keys;
+
+        keys = malloc( ( CFSetGetCount( disk->_deltaKeys ) + 1 ) * sizeof( void * ) );
+
+        if ( removed && keys )
+        {
+            CFIndex     count;
+            CFIndex     index;
+            CFNumberRef number;
+
+            count = CFSetGetCount( disk->_deltaKeys );
+
+            CFSetGetValues( disk->_deltaKeys, keys );
+
+            for ( index = 0; index < count; index++ )
+            {
+                CFTypeRef value;
+
+                value = CFDictionaryGetValue( disk->_description, keys[index] );
+
+                if ( value )
+                {
+                    CFDictionarySetValue( delta, keys[index], value );
+                }
+                else
+                {
+                    CFArrayAppendValue( removed, keys[index] );
+                }
+            }
+
+            if ( CFArrayGetCount( removed ) )
+            {
+                CFDictionarySetValue( delta, _kDADiskRemovedKeysKey, removed );
+            }
+
+            CFDictionarySetValue( delta, _kDADiskIDKey, CFDictionaryGetValue( disk->_description, _kDADiskIDKey ) );
+
+            number = CFNumberCreate( kCFAllocatorDefault, kCFNumberSInt64Type, &disk->_generation );
+
+            if ( number )
+            {
+                CFDictionarySetValue( delta, _kDADiskGenerationKey, number );
+
+                CFRelease( number );
+            }
+
+            number = CFNumberCreate( kCFAllocatorDefault, kCFNumberSInt64Type, &disk->_deltaGeneration );
+
+            if ( number )
+            {
+                CFDictionarySetValue( delta, _kDADiskBaseGenerationKey, number );
+
+                data = _DASerializeDiskDescriptionWithEncoding( CFGetAllocator( disk ), delta, encoding );
+
+                CFRelease( number );
+            }
+        }
+
+        if ( keys    )  free( keys );
+        if ( removed )  CFRelease( removed );
+
+        CFRelease( delta );
+    }
+
+    return data;
+}
+
+static CFDataRef __DADiskCreateSerialization( DADiskRef disk, _DAEncoding encoding )
+{
+    CFMutableDictionaryRef description;
+    CFDataRef              data = NULL;
+
+    /*
+     * The generation is kept out of the description proper, so that matching and the
+     * dialog paths never see it, and is added only to what is sent to the clients.
+     */
+
+    description = CFDictionaryCreateMutableCopy( kCFAllocatorDefault, 0, disk->_description );
+
+    if ( description )
+    {
+        CFNumberRef number;
+
+        number = CFNumberCreate( kCFAllocatorDefault, kCFNumberSInt64Type, &disk->_generation );
+
+        if ( number )
+        {
+            CFDictionarySetValue( description, _kDADiskGenerationKey, number );
+
+            data = _DASerializeDiskDescriptionWithEncoding( CFGetAllocator( disk ), description, encoding );
+
+            CFRelease( number );
+        }
+
+        CFRelease( description );
+    }
+
+    return data;
+}
+
 static CFStringRef __DADiskCopyDescription( CFTypeRef object )
 {
     DADiskRef disk = ( DADiskRef ) object;
@@ -134,6 +254,10 @@ static DADiskRef __DADiskCreate( CFAllocatorRef allocator, const char * id )
         disk->_claim                = NULL;
         disk->_context              = NULL;
         disk->_contextRe            = NULL;
+        disk->_delta                = NULL;
+        disk->_deltaCompact         = NULL;
+        disk->_deltaGeneration      = 1;
+        disk->_deltaKeys            = CFSetCreateMutable( allocator, 0, &kCFTypeSetCallBacks );
         disk->_description          = CFDictionaryCreateMutable( allocator, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks );
         disk->_device               = NULL;
         disk->_deviceLink[0]        = NULL;
@@ -144,12 +268,15 @@ static DADiskRef __DADiskCreate( CFAllocatorRef allocator, const char * id )
         disk->_containerId          = NULL;
         disk->_deviceUnit           = -1;
         disk->_filesystem           = NULL;
+        disk->_generation           = 1;
         disk->_id                   = strdup( id );
+        disk->_listGeneration       = 0;
         disk->_media                = IO_OBJECT_NULL;
         disk->_mode                 = 0750;
         disk->_options              = 0;
         disk->_propertyNotification = IO_OBJECT_NULL;
         disk->_serialization        = NULL;
+        disk->_serializationCompact = NULL;
         disk->_state                = 0;
         disk->_userGID              = ___GID_WHEEL;
         disk->_userUID              = ___UID_ROOT;
@@ -158,6 +285,7 @@ static DADiskRef __DADiskCreate( CFAllocatorRef allocator, const char * id )
         disk->_fskitAdditions       = NULL;
 #endif
 
+        assert( disk->_deltaKeys   );
         assert( disk->_description );
         assert( disk->_id          );
 
@@ -183,6 +311,9 @@ static void __DADiskDeallocate( CFTypeRef object )
     if ( disk->_claim                )  CFRelease( disk->_claim );
     if ( disk->_context              )  CFRelease( disk->_context );
     if ( disk->_contextRe            )  CFRelease( disk->_contextRe );
+    if ( disk->_delta                )  CFRelease( disk->_delta );
+    if ( disk->_deltaCompact         )  CFRelease( disk->_deltaCompact );
+    if ( disk->_deltaKeys            )  CFRelease( disk->_deltaKeys );
     if ( disk->_description          )  CFRelease( disk->_description );
     if ( disk->_device               )  CFRelease( disk->_device );
     if ( disk->_deviceLink[0]        )  free( disk->_deviceLink[0] );
@@ -194,6 +325,7 @@ static void __DADiskDeallocate( CFTypeRef object )
     if ( disk->_media                )  IOObjectRelease( disk->_media );
     if ( disk->_propertyNotification )  IOObjectRelease( disk->_propertyNotification );
     if ( disk->_serialization        )  CFRelease( disk->_serialization );
+    if ( disk->_serializationCompact )  CFRelease( disk->_serializationCompact );
     if ( disk->_containerId        )    free( disk->_containerId );
 #ifdef DA_FSKIT
     if ( disk->_fskitAdditions       )  CFRelease( disk->_fskitAdditions );
@@ -1213,6 +1345,11 @@ io_service_t DADiskGetIOMedia( DADiskRef disk )
     return disk->_media;
 }
 
+UInt64 DADiskGetListGeneration( DADiskRef disk )
+{
+    return disk->_listGeneration;
+}
+
 mode_t DADiskGetMode( DADiskRef disk )
 {
     mode_t mode;
@@ -1246,12 +1383,50 @@ CFDataRef DADiskGetSerialization( DADiskRef disk )
 {
     if ( disk->_serialization == NULL )
     {
-        disk->_serialization = _DASerializeDiskDescription( CFGetAllocator( disk ), disk->_description );
+        disk->_serialization = __DADiskCreateSerialization( disk, _kDAEncodingPropertyList );
     }
 
     return disk->_serialization;
 }
 
+CFDataRef DADiskGetSerializationDelta( DADiskRef disk, _DAEncoding encoding )
+{
+    CFDataRef * delta;
+
+    /*
+     * Send the full description once the delta is no longer meaningfully smaller.
+     */
+
+    if ( CFSetGetCount( disk->_deltaKeys ) * 2 > CFDictionaryGetCount( disk->_description ) )
+    {
+        return DADiskGetSerializationWithEncoding( disk, encoding );
+    }
+
+    delta = ( encoding & _kDAEncodingCompact ) ? &disk->_deltaCompact : &disk->_delta;
+
+    if ( *delta == NULL )
+    {
+        *delta = __DADiskCreateDelta( disk, encoding );
+    }
+
+    return *delta ? *delta : DADiskGetSerializationWithEncoding( disk, encoding );
+}
+
+CFDataRef DADiskGetSerializationWithEncoding( DADiskRef disk, _DAEncoding encoding )
+{
+    if ( ( encoding & _kDAEncodingCompact ) )
+    {
+        if ( disk->_serializationCompact == NULL )
+        {
+            disk->_serializationCompact = __DADiskCreateSerialization( disk, _kDAEncodingCompact );
+        }
+
+        return disk->_serializationCompact;
+    }
+
+    return DADiskGetSerialization( disk );
+}
+
 Boolean DADiskGetState( DADiskRef disk, DADiskState state )
 {
     return ( disk->_state & state ) ? TRUE : FALSE;
@@ -1394,6 +1569,27 @@ void DADiskSetContextRe( DADiskRef disk, CFTypeRef context )
     }
 }
 
+void DADiskResetDelta( DADiskRef disk )
+{
+    disk->_deltaGeneration = disk->_generation;
+
+    CFSetRemoveAllValues( disk->_deltaKeys );
+
+    if ( disk->_delta )
+    {
+        CFRelease( disk->_delta );
+
+        disk->_delta = NULL;
+    }
+
+    if ( disk->_deltaCompact )
+    {
+        CFRelease( disk->_deltaCompact );
+
+        disk->_deltaCompact = NULL;
+    }
+}
+
 void DADiskSetDescription( DADiskRef disk, CFStringRef description, CFTypeRef value )
 {
     if ( value )
@@ -1405,12 +1601,41 @@ void DADiskSetDescription( DADiskRef disk, CFStringRef description, CFTypeRef va
         CFDictionaryRemoveValue( disk->_description, description );
     }
 
+    /*
+     * Advance the generation and remember the key for the next delta.
+     */
+
+    disk->_generation++;
+
+    CFSetAddValue( disk->_deltaKeys, description );
+
+    if ( disk->_delta )
+    {
+        CFRelease( disk->_delta );
+
+        disk->_delta = NULL;
+    }
+
+    if ( disk->_deltaCompact )
+    {
+        CFRelease( disk->_deltaCompact );
+
+        disk->_deltaCompact = NULL;
+    }
+
     if ( disk->_serialization )
     {
         CFRelease( disk->_serialization );
 
         disk->_serialization = NULL;
     }
+
+    if ( disk->_serializationCompact )
+    {
+        CFRelease( disk->_serializationCompact );
+
+        disk->_serializationCompact = NULL;
+    }
 }
 
 void DADiskSetFileSystem( DADiskRef disk, DAFileSystemRef filesystem )
@@ -1430,6 +1655,11 @@ void DADiskSetFileSystem( DADiskRef disk, DAFileSystemRef filesystem )
     }
 }
 
+void DADiskSetListGeneration( DADiskRef disk, UInt64 generation )
+{
+    disk->_listGeneration = generation;
+}
+
 #ifdef DA_FSKIT
 
 /*
@@ -83,11 +83,14 @@ extern CFURLRef           DADiskGetDevice( DADiskRef disk );
 extern DAFileSystemRef    DADiskGetFileSystem( DADiskRef disk );
 extern const char *       DADiskGetID( DADiskRef disk );
 extern io_service_t       DADiskGetIOMedia( DADiskRef disk );
+extern UInt64             DADiskGetListGeneration( DADiskRef disk );
 extern mode_t             DADiskGetMode( DADiskRef disk );
 extern Boolean            DADiskGetOption( DADiskRef disk, DADiskOption option );
 extern DADiskOptions      DADiskGetOptions( DADiskRef disk );
 extern io_object_t        DADiskGetPropertyNotification( DADiskRef disk );
 extern CFDataRef          DADiskGetSerialization( DADiskRef disk );
+extern CFDataRef          DADiskGetSerializationDelta( DADiskRef disk, _DAEncoding encoding );
+extern CFDataRef          DADiskGetSerializationWithEncoding( DADiskRef disk, _DAEncoding encoding );
 extern Boolean            DADiskGetState( DADiskRef disk, DADiskState state );
 extern CFTypeID           DADiskGetTypeID( void );
 extern gid_t              DADiskGetUserGID( DADiskRef disk );
@@ -95,6 +98,7 @@ extern uid_t              DADiskGetUserUID( DADiskRef disk );
 extern uid_t              DADiskGetMountedByUserUID( DADiskRef disk );
 extern void               DADiskInitialize( void );
 extern Boolean            DADiskMatch( DADiskRef disk, CFDictionaryRef match );
+extern void               DADiskResetDelta( DADiskRef disk );
 extern void               DADiskSetBusy( DADiskRef disk, CFAbsoluteTime busy );
 extern void               DADiskSetBusyNotification( DADiskRef disk, io_object_t notification );
 extern void               DADiskSetBypath( DADiskRef disk, CFURLRef bypath );
@@ -104,6 +108,7 @@ extern void               DADiskSetContext( DADiskRef disk, CFTypeRef context );
 extern void               DADiskSetContextRe( DADiskRef disk, CFTypeRef context );
 extern void               DADiskSetDescription( DADiskRef disk, CFStringRef description, CFTypeRef value );
 extern void               DADiskSetFileSystem( DADiskRef disk, DAFileSystemRef filesystem );
+extern void               DADiskSetListGeneration( DADiskRef disk, UInt64 generation );
 extern void               DADiskSetOption( DADiskRef disk, DADiskOption option, Boolean value );
 extern void               DADiskSetOptions( DADiskRef disk, DADiskOptions options, Boolean value );
 extern void               DADiskSetPropertyNotification( DADiskRef disk, io_object_t notification );
@@ -511,26 +511,34 @@ DAFileSystemRef DAFileSystemCreate( CFAllocatorRef allocator, CFURLRef path )
 
     if ( properties )
     {
-        CFURLRef id;
+        filesystem = DAFileSystemCreateWithProperties( allocator, path, properties );
 
-        /*
-         * Create the file system object's unique identifier.
-         */
+        CFRelease( properties );
+    }
 
-        id = CFURLCopyAbsoluteURL( path );
+    return filesystem;
+}
 
-        if ( id )
-        {
-            /*
-             * Create the file system object.
-             */
+DAFileSystemRef DAFileSystemCreateWithProperties( CFAllocatorRef allocator, CFURLRef path, CFDictionaryRef properties )
+{
+    DAFileSystemRef filesystem = NULL;
+    CFURLRef        id;
 
-            filesystem = __DAFileSystemCreate( allocator, id, properties );
+    /*
+     * Create the file system object's unique identifier.
+     */
 
-            CFRelease( id );
-        }
+    id = CFURLCopyAbsoluteURL( path );
 
-        CFRelease( properties );
+    if ( id )
+    {
+        /*
+         * Create the file system object.
+         */
+
+        filesystem = __DAFileSystemCreate( allocator, id, properties );
+
+        CFRelease( id );
     }
 
     return filesystem;
@@ -570,6 +578,11 @@ dispatch_mach_t DAFileSystemCreateMachChannel( void )
     return DACommandCreateMachChannel();
 }
 
+CFURLRef DAFileSystemGetID( DAFileSystemRef filesystem )
+{
+    return filesystem->_id;
+}
+
 CFStringRef DAFileSystemGetKind( DAFileSystemRef filesystem )
 {
     return CFDictionaryGetValue( filesystem->_properties, kCFBundleNameKey );
@@ -586,6 +599,11 @@ CFDictionaryRef DAFileSystemGetProbeList( DAFileSystemRef filesystem )
     return CFDictionaryGetValue( filesystem->_properties, CFSTR( kFSMediaTypesKey ) );
 }
 
+CFDictionaryRef DAFileSystemGetProperties( DAFileSystemRef filesystem )
+{
+    return filesystem->_properties;
+}
+
 CFBooleanRef DAFileSystemIsFSModule( DAFileSystemRef filesystem )
 {
     return CFDictionaryGetValue( filesystem->_properties , CFSTR( kFSisModuleKey ) );
@@ -35,7 +35,7 @@ extern "C" {
 
 typedef struct __DAFileSystem * DAFileSystemRef;
 typedef struct __DAFileSystemContext __DAFileSystemContext;
-// When adding filesystem argument strings, remember to check for them in DAMountContainsArgument()
+// When adding filesystem argument strings, remember to check for them in __DAMountOptionsGetArgument()
 extern const CFStringRef kDAFileSystemMountArgumentForce;
 extern const CFStringRef kDAFileSystemMountArgumentNoDevice;
 extern const CFStringRef kDAFileSystemMountArgumentDevice;
@@ -67,14 +67,20 @@ extern DAFileSystemRef DAFileSystemCreate( CFAllocatorRef allocator, CFURLRef pa
 
 extern DAFileSystemRef DAFileSystemCreateFromProperties( CFAllocatorRef allocator, CFDictionaryRef properties );
 
+extern DAFileSystemRef DAFileSystemCreateWithProperties( CFAllocatorRef allocator, CFURLRef path, CFDictionaryRef properties );
+
 extern dispatch_mach_t DAFileSystemCreateMachChannel( void );
 
+extern CFURLRef DAFileSystemGetID( DAFileSystemRef filesystem );
+
 extern CFStringRef DAFileSystemGetKind( DAFileSystemRef filesystem );
 
 extern CFStringRef DAFileSystemCopyFSBundleID( DAFileSystemRef filesystem );
 
 extern CFDictionaryRef DAFileSystemGetProbeList( DAFileSystemRef filesystem );
 
+extern CFDictionaryRef DAFileSystemGetProperties( DAFileSystemRef filesystem );
+
 extern CFBooleanRef DAFileSystemIsFSModule( DAFileSystemRef filesystem );
 
 extern Boolean DAFilesystemShouldMountWithUserFS( DAFileSystemRef filesystem ,
@@ -46,7 +46,10 @@ __private_extern__ const CFStringRef _kDACallbackSessionKey       = CFSTR( "DACa
 __private_extern__ const CFStringRef _kDACallbackTimeKey          = CFSTR( "DACallbackTime"      );
 __private_extern__ const CFStringRef _kDACallbackWatchKey         = CFSTR( "DACallbackWatch"     );
 
+__private_extern__ const CFStringRef _kDADiskBaseGenerationKey    = CFSTR( "DADiskBaseGeneration" );
+__private_extern__ const CFStringRef _kDADiskGenerationKey        = CFSTR( "DADiskGeneration"    );
 __private_extern__ const CFStringRef _kDADiskIDKey                = CFSTR( "DADiskID"            );
+__private_extern__ const CFStringRef _kDADiskRemovedKeysKey       = CFSTR( "DADiskRemovedKeys"   );
 
 __private_extern__ const CFStringRef _kDADissenterProcessIDKey    = CFSTR( "DAProcessID"         );
 __private_extern__ const CFStringRef _kDADissenterStatusKey       = CFSTR( "DAStatus"            );
@@ -55,12 +58,16 @@ __private_extern__ const CFStringRef _kDADissenterStatusStringKey = CFSTR( "DASt
 __private_extern__ const CFStringRef _kDARequestArgument1Key      = CFSTR( "DARequestArgument1"  );
 __private_extern__ const CFStringRef _kDARequestArgument2Key      = CFSTR( "DARequestArgument2"  );
 __private_extern__ const CFStringRef _kDARequestArgument3Key      = CFSTR( "DARequestArgument3"  );
+__private_extern__ const CFStringRef _kDARequestBatchKey          = CFSTR( "DARequestBatch"      );
 __private_extern__ const CFStringRef _kDARequestCallbackKey       = CFSTR( "DARequestCallback"   );
+__private_extern__ const CFStringRef _kDARequestClassKey          = CFSTR( "DARequestClass"      );
 __private_extern__ const CFStringRef _kDARequestDiskKey           = CFSTR( "DARequestDisk"       );
 __private_extern__ const CFStringRef _kDARequestDissenterKey      = CFSTR( "DARequestDissenter"  );
 __private_extern__ const CFStringRef _kDARequestKindKey           = CFSTR( "DARequestKind"       );
 __private_extern__ const CFStringRef _kDARequestLinkKey           = CFSTR( "DARequestLink"       );
 __private_extern__ const CFStringRef _kDARequestStateKey          = CFSTR( "DARequestState"      );
+__private_extern__ const CFStringRef _kDARequestTagKey            = CFSTR( "DARequestTag"        );
+__private_extern__ const CFStringRef _kDARequestTimeKey           = CFSTR( "DARequestTime"       );
 __private_extern__ const CFStringRef _kDARequestUserGIDKey        = CFSTR( "DARequestUserGID"    );
 __private_extern__ const CFStringRef _kDARequestUserUIDKey        = CFSTR( "DARequestUserUID"    );
 
@@ -115,6 +122,22 @@ const CFStringRef kDADiskDescriptionFSKitPrefix        = CFSTR( "FS"
 
 const CFStringRef kDADiskDescriptionRepairRunningKey   = CFSTR( "DARepairRunning"   );
 
+const CFStringRef kDAStatisticsCallbacksCoalescedKey   = CFSTR( "DACallbacksCoalesced" );
+const CFStringRef kDAStatisticsRequestClassesKey       = CFSTR( "DARequestClasses"     );
+const CFStringRef kDAStatisticsSessionResyncsKey       = CFSTR( "DASessionResyncs"     );
+const CFStringRef kDAStatisticsSessionsKey             = CFSTR( "DASessions"           );
+const CFStringRef kDAStatisticsSessionNameKey          = CFSTR( "DASessionName"        );
+const CFStringRef kDAStatisticsSessionProcessIDKey     = CFSTR( "DASessionProcessID"   );
+const CFStringRef kDAStatisticsSessionQueueBytesKey    = CFSTR( "DASessionQueueBytes"  );
+const CFStringRef kDAStatisticsSessionQueueDepthKey    = CFSTR( "DASessionQueueDepth"  );
+const CFStringRef kDAStatisticsSessionQueueLimitKey    = CFSTR( "DASessionQueueLimit"  );
+const CFStringRef kDAStatisticsRequestClassNameKey      = CFSTR( "DARequestClassName"      );
+const CFStringRef kDAStatisticsRequestClassDepthKey     = CFSTR( "DARequestClassDepth"     );
+const CFStringRef kDAStatisticsRequestClassCancelledKey = CFSTR( "DARequestClassCancelled" );
+const CFStringRef kDAStatisticsRequestClassCountKey     = CFSTR( "DARequestClassCount"     );
+const CFStringRef kDAStatisticsRequestClassWaitKey      = CFSTR( "DARequestClassWait"      );
+const CFStringRef kDAStatisticsRequestClassWaitMaxKey   = CFSTR( "DARequestClassWaitMax"   );
+
 static const char * __kDAKindNameList[] =
 {
     "disk appeared",
@@ -135,8 +158,86 @@ static const char * __kDAKindNameList[] =
     "idle",
     "disk list complete",
     "disk fskit additions changed",
+    "disk batch",
+};
+
+/*
+ * The compact encoding refers to well-known description keys by their index in this list.  The
+ * list is part of the wire format; append new keys at the end only.
+ */
+
+static const CFStringRef * __kDACompactKeyList[] =
+{
+    NULL,
+    &_kDADiskIDKey,
+    &kDADiskDescriptionVolumeKindKey,
+    &kDADiskDescriptionVolumeMountableKey,
+    &kDADiskDescriptionVolumeNameKey,
+    &kDADiskDescriptionVolumeNetworkKey,
+    &kDADiskDescriptionVolumePathKey,
+    &kDADiskDescriptionVolumeTypeKey,
+    &kDADiskDescriptionVolumeUUIDKey,
+    &kDADiskDescriptionVolumeLifsURLKey,
+    &kDADiskDescriptionMediaBlockSizeKey,
+    &kDADiskDescriptionMediaBSDMajorKey,
+    &kDADiskDescriptionMediaBSDMinorKey,
+    &kDADiskDescriptionMediaBSDNameKey,
+    &kDADiskDescriptionMediaBSDUnitKey,
+    &kDADiskDescriptionMediaContentKey,
+    &kDADiskDescriptionMediaEjectableKey,
+    &kDADiskDescriptionMediaIconKey,
+    &kDADiskDescriptionMediaKindKey,
+    &kDADiskDescriptionMediaLeafKey,
+    &kDADiskDescriptionMediaNameKey,
+    &kDADiskDescriptionMediaPathKey,
+    &kDADiskDescriptionMediaRemovableKey,
+    &kDADiskDescriptionMediaSizeKey,
+    &kDADiskDescriptionMediaTypeKey,
+    &kDADiskDescriptionMediaUUIDKey,
+    &kDADiskDescriptionMediaWholeKey,
+    &kDADiskDescriptionMediaWritableKey,
+    &kDADiskDescriptionMediaEncryptedKey,
+    &kDADiskDescriptionMediaEncryptionDetailKey,
+    &kDADiskDescriptionDeviceGUIDKey,
+    &kDADiskDescriptionDeviceInternalKey,
+    &kDADiskDescriptionDeviceModelKey,
+    &kDADiskDescriptionDevicePathKey,
+    &kDADiskDescriptionDeviceProtocolKey,
+    &kDADiskDescriptionDeviceRevisionKey,
+    &kDADiskDescriptionDeviceUnitKey,
+    &kDADiskDescriptionDeviceVendorKey,
+    &kDADiskDescriptionDeviceTDMLockedKey,
+    &kDADiskDescriptionBusNameKey,
+    &kDADiskDescriptionBusPathKey,
+    &kDADiskDescriptionAppearanceTimeKey,
+    &kDADiskDescriptionMediaMatchKey,
+    &kDADiskDescriptionRepairRunningKey,
+    &_kDADiskGenerationKey,
+    &_kDADiskBaseGenerationKey,
+    &_kDADiskRemovedKeysKey
 };
 
+#define __kDACompactKeyListCount ( sizeof( __kDACompactKeyList ) / sizeof( __kDACompactKeyList[0] ) )
+
+static const char __kDACompactMagic[4] = { 'D', 'A', 'D', 'C' };
+
+#define __kDACompactVersion 1
+
+typedef struct
+{
+    char     magic[4];
+    uint16_t version;
+    uint16_t count;
+} __DACompactHeader;
+
+typedef struct
+{
+    uint16_t key;
+    uint8_t  type;
+    uint8_t  keyLength;
+    uint32_t length;
+} __DACompactField;
+
 extern CFIndex __CFBinaryPlistWriteToStream( CFPropertyListRef plist, CFTypeRef stream );
 
 __private_extern__ int ___statfs( const char * path, struct statfs * buf, int flags )
@@ -359,6 +460,175 @@ __private_extern__ const char * _DACallbackKindGetName( _DACallbackKind kind )
     }
 }
 
+__private_extern__ Boolean _DACallbackRingDequeue( _DACallbackRing *   ring,
+                                                   uint32_t            size,
+                                                   CFAllocatorRef      allocator,
+                                                   _DACallbackKind *   kind,
+                                                   mach_vm_offset_t *  address,
+                                                   mach_vm_offset_t *  context,
+                                                   CFDataRef *         argument0,
+                                                   CFTypeRef *         argument1 )
+{
+    uint8_t * data;
+    uint64_t  head;
+    uint64_t  tail;
+
+    /*
+     * Consume the next callback record from the ring.  The ring is read by the client only, so
+     * the tail is advanced once the record has been copied out of the shared memory.
+     */
+
+    data = ( uint8_t * ) ( ring + 1 );
+
+    head = atomic_load_explicit( &ring->head, memory_order_acquire );
+    tail = atomic_load_explicit( &ring->tail, memory_order_relaxed );
+
+    while ( tail != head )
+    {
+        _DACallbackRingRecord * record;
+        uint32_t                offset;
+
+        offset = ( uint32_t ) ( tail % size );
+
+        record = ( void * ) ( data + offset );
+
+        if ( record->size < sizeof( record->size ) + sizeof( record->kind ) || record->size > size - offset || ( record->size & 0x7 ) )
+        {
+            break;
+        }
+
+        if ( record->kind == _kDACallbackRingRecordPad )
+        {
+            tail += record->size;
+
+            continue;
+        }
+
+        if ( record->size < sizeof( _DACallbackRingRecord ) + record->argument0Size + record->argument1Size )
+        {
+            break;
+        }
+
+        *kind      = record->kind;
+        *address   = record->address;
+        *context   = record->context;
+        *argument0 = NULL;
+        *argument1 = NULL;
+
+        if ( record->argument0Size )
+        {
+            *argument0 = CFDataCreate( allocator, ( void * ) ( record + 1 ), record->argument0Size );
+        }
+
+        if ( record->argument1Size )
+        {
+            *argument1 = _DAUnserializeWithBytes( allocator, ( vm_address_t ) ( record + 1 ) + record->argument0Size, record->argument1Size );
+        }
+
+        tail += record->size;
+
+        atomic_store_explicit( &ring->tail, tail, memory_order_release );
+
+        return TRUE;
+    }
+
+    atomic_store_explicit( &ring->tail, tail, memory_order_release );
+
+    return FALSE;
+}
+
+__private_extern__ Boolean _DACallbackRingEnqueue( _DACallbackRing * ring,
+                                                   uint32_t          size,
+                                                   _DACallbackKind   kind,
+                                                   mach_vm_offset_t  address,
+                                                   mach_vm_offset_t  context,
+                                                   CFDataRef         argument0,
+                                                   CFDataRef         argument1 )
+{
+    _DACallbackRingRecord * record;
+    uint8_t *               data;
+    uint64_t                head;
+    uint32_t                length;
+    uint32_t                offset;
+    uint64_t                tail;
+    uint64_t                used;
+
+    /*
+     * Produce a callback record into the ring.  The tail is written by the client, so it is not
+     * trusted beyond the bounds check below.  A record never wraps; the remainder of the ring is
+     * padded instead.
+     */
+
+    data = ( uint8_t * ) ( ring + 1 );
+
+    length = sizeof( _DACallbackRingRecord );
+    length += argument0 ? CFDataGetLength( argument0 ) : 0;
+    length += argument1 ? CFDataGetLength( argument1 ) : 0;
+    length = ( length + 0x7 ) & ~0x7;
+
+    if ( length > size )
+    {
+        return FALSE;
+    }
+
+    head = atomic_load_explicit( &ring->head, memory_order_relaxed );
+    tail = atomic_load_explicit( &ring->tail, memory_order_acquire );
+
+    used = head - tail;
+
+    if ( used > size )
+    {
+        return FALSE;
+    }
+
+    offset = ( uint32_t ) ( head % size );
+
+    if ( length > size - offset )
+    {
+        if ( used + ( size - offset ) + length > size )
+        {
+            return FALSE;
+        }
+
+        record = ( void * ) ( data + offset );
+
+        record->size = size - offset;
+        record->kind = _kDACallbackRingRecordPad;
+
+        used += size - offset;
+        head += size - offset;
+
+        offset = 0;
+    }
+    else if ( used + length > size )
+    {
+        return FALSE;
+    }
+
+    record = ( void * ) ( data + offset );
+
+    record->size          = length;
+    record->kind          = kind;
+    record->address       = address;
+    record->context       = context;
+    record->argument0Size = argument0 ? ( uint32_t ) CFDataGetLength( argument0 ) : 0;
+    record->argument1Size = argument1 ? ( uint32_t ) CFDataGetLength( argument1 ) : 0;
+
+    if ( argument0 )
+    {
+        bcopy( CFDataGetBytePtr( argument0 ), ( void * ) ( record + 1 ), record->argument0Size );
+    }
+
+    if ( argument1 )
+    {
+        bcopy( CFDataGetBytePtr( argument1 ), ( uint8_t * ) ( record + 1 ) + record->argument0Size, record->argument1Size );
+    }
+
+    atomic_store_explicit( &ring->head, head + length, memory_order_seq_cst );
+
+    return TRUE;
+}
+
 __private_extern__ const char * _DARequestKindGetName( _DARequestKind kind )
 {
     const char * unknownKind = "Unknown Kind";
@@ -457,6 +727,489 @@ __private_extern__ CFDataRef _DASerializeDiskDescription( CFAllocatorRef allocat
     return data;
 }
 
+static uint16_t __DACompactGetKeyID( CFStringRef key )
+{
+    uint16_t index;
+
+    for ( index = 1; index < __kDACompactKeyListCount; index++ )
+    {
+        if ( *__kDACompactKeyList[index] == key )
+        {
+            return index;
+        }
+    }
+
+    for ( index = 1; index < __kDACompactKeyListCount; index++ )
+    {
+        if ( CFEqual( *__kDACompactKeyList[index], key ) )
+        {
+            return index;
+        }
+    }
+
+    return 0;
+}
+
+static Boolean __DACompactAppendField( CFMutableDataRef data, CFStringRef key, CFTypeRef value )
+{
+    static const UInt8 padding[4] = { 0 };
+
+    __DACompactField field;
+    UInt8            keyBuffer[UINT8_MAX];
+    CFIndex          keyLength;
+    const UInt8 *    bytes;
+    UInt8            buffer[PATH_MAX];
+    CFDataRef        object;
+    CFTypeID         type;
+
+    field.key       = __DACompactGetKeyID( key );
+    field.keyLength = 0;
+
+    if ( field.key == 0 )
+    {
+        CFIndex length;
+
+        length = CFStringGetLength( key );
+
+        if ( CFStringGetBytes( key, CFRangeMake( 0, length ), kCFStringEncodingUTF8, 0, FALSE, keyBuffer, sizeof( keyBuffer ), &keyLength ) != length )
+        {
+            return FALSE;
+        }
+
+        field.keyLength = keyLength;
+    }
+
+    object = NULL;
+
+    type = CFGetTypeID( value );
+
+    if ( type == CFBooleanGetTypeID( ) )
+    {
+        field.type   = CFBooleanGetValue( value ) ? _kDACompactTypeTrue : _kDACompactTypeFalse;
+        field.length = 0;
+
+        bytes = NULL;
+    }
+    else if ( type == CFNumberGetTypeID( ) )
+    {
+        if ( CFNumberIsFloatType( value ) )
+        {
+            Float64 number;
+
+            CFNumberGetValue( value, kCFNumberFloat64Type, &number );
+
+            field.type = _kDACompactTypeReal;
+
+            memcpy( buffer, &number, sizeof( number ) );
+        }
+        else
+        {
+            SInt64 number;
+
+            CFNumberGetValue( value, kCFNumberSInt64Type, &number );
+
+            field.type = _kDACompactTypeInteger;
+
+            memcpy( buffer, &number, sizeof( number ) );
+        }
+
+        field.length = sizeof( SInt64 );
+
+        bytes = buffer;
+    }
+    else if ( type == CFStringGetTypeID( ) )
+    {
+        CFIndex length;
+
+        length = CFStringGetLength( value );
+
+        bytes = ( const UInt8 * ) CFStringGetCStringPtr( value, kCFStringEncodingUTF8 );
+
+        if ( bytes )
+        {
+            field.length = strlen( ( const char * ) bytes );
+        }
+        else
+        {
+            CFIndex size;
+
+            CFStringGetBytes( value, CFRangeMake( 0, length ), kCFStringEncodingUTF8, 0, FALSE, NULL, 0, &size );
+
+            object = CFDataCreateMutable( kCFAllocatorDefault, size );
+
+            if ( object == NULL )
+            {
+                return FALSE;
+            }
+
+            CFDataSetLength( ( CFMutableDataRef ) object, size );
+
+            CFStringGetBytes( value, CFRangeMake( 0, length ), kCFStringEncodingUTF8, 0, FALSE, CFDataGetMutableBytePtr( ( CFMutableDataRef ) object ), size, NULL );
+
+            field.length = size;
+
+            bytes = CFDataGetBytePtr( object );
+        }
+
+        field.type = _kDACompactTypeString;
+    }
+    else if ( type == CFDataGetTypeID( ) )
+    {
+        field.type   = _kDACompactTypeData;
+        field.length = CFDataGetLength( value );
+
+        bytes = CFDataGetBytePtr( value );
+    }
+    else if ( type == CFUUIDGetTypeID( ) )
+    {
+        CFUUIDBytes uuid;
+
+        uuid = CFUUIDGetUUIDBytes( value );
+
+        memcpy( buffer, &uuid, sizeof( uuid ) );
+
+        field.type   = _kDACompactTypeUUID;
+        field.length = sizeof( uuid );
+
+        bytes = buffer;
+    }
+    else if ( type == CFURLGetTypeID( ) && CFURLGetFileSystemRepresentation( value, TRUE, buffer, sizeof( buffer ) ) )
+    {
+        field.type   = _kDACompactTypeURL;
+        field.length = strlen( ( const char * ) buffer );
+
+        bytes = buffer;
+    }
+    else
+    {
+        object = _DASerialize( kCFAllocatorDefault, value );
+
+        if ( object == NULL )
+        {
+            return FALSE;
+        }
+
+        field.type   = _kDACompactTypePropertyList;
+        field.length = CFDataGetLength( object );
+
+        bytes = CFDataGetBytePtr( object );
+    }
+
+    CFDataAppendBytes( data, ( void * ) &field, sizeof( field ) );
+
+    if ( field.keyLength )  CFDataAppendBytes( data, keyBuffer, field.keyLength );
+
+    if ( field.length    )  CFDataAppendBytes( data, bytes, field.length );
+
+    CFDataAppendBytes( data, padding, ( 4 - ( ( field.keyLength + field.length ) & 0x3 ) ) & 0x3 );
+
+    if ( object )  CFRelease( object );
+
+    return TRUE;
+}
+
+static CFDataRef __DASerializeDiskDescriptionCompact( CFAllocatorRef allocator, CFDictionaryRef description )
+{
+    CFIndex          count;
+    CFMutableDataRef data;
+
+    count = CFDictionaryGetCount( description );
+
+    if ( count > UINT16_MAX )
+    {
+        return NULL;
+    }
+
+    data = CFDataCreateMutable( allocator, 0 );
+
+    if ( data )
+    {
+        __DACompactHeader header;
+        const void **     keys;
+        const void **     values;
+        CFIndex           index;
+
+        memcpy( header.magic, __kDACompactMagic, sizeof( header.magic ) );
+
+        header.version = __kDACompactVersion;
+        header.count   = count;
+
+        CFDataAppendBytes( data, ( void * ) &header, sizeof( header ) );
+
+        keys   = malloc( count * sizeof( void * ) );
+        values = malloc( count * sizeof( void * ) );
+
+        if ( keys && values )
+        {
+            CFDictionaryGetKeysAndValues( description, keys, values );
+
+            for ( index = 0; index < count; index++ )
+            {
+                if ( CFGetTypeID( keys[index] ) != CFStringGetTypeID( ) )
+                {
+                    break;
+                }
+
+                if ( __DACompactAppendField( data, keys[index], values[index] ) == FALSE )
+                {
+                    break;
+                }
+            }
+        }
+        else
+        {
+            index = -1;
+        }
+
+        if ( keys   )  free( keys );
+        if ( values )  free( values );
+
+        if ( index != count )
+        {
+            CFRelease( data );
+
+            data = NULL;
+        }
+    }
+
+    return data;
+}
+
+static Boolean __DACompactIsValid( CFDataRef data )
+{
+    const __DACompactHeader * header;
+
+    if ( CFDataGetLength( data ) < ( CFIndex ) sizeof( __DACompactHeader ) )
+    {
+        return FALSE;
+    }
+
+    header = ( const void * ) CFDataGetBytePtr( data );
+
+    if ( memcmp( header->magic, __kDACompactMagic, sizeof( header->magic ) ) )
+    {
+        return FALSE;
+    }
+
+    return ( header->version == __kDACompactVersion ) ? TRUE : FALSE;
+}
+
+static Boolean __DACompactGetNextField( CFDataRef data, CFIndex * offset, __DACompactField * field, const UInt8 ** key, const UInt8 ** value )
+{
+    const UInt8 * bytes;
+    CFIndex       length;
+    CFIndex       size;
+
+    bytes  = CFDataGetBytePtr( data );
+    length = CFDataGetLength( data );
+
+    if ( *offset + ( CFIndex ) sizeof( __DACompactField ) > length )
+    {
+        return FALSE;
+    }
+
+    memcpy( field, bytes + *offset, sizeof( __DACompactField ) );
+
+    size = field->keyLength + ( CFIndex ) field->length;
+
+    if ( *offset + ( CFIndex ) sizeof( __DACompactField ) + size > length )
+    {
+        return FALSE;
+    }
+
+    if ( field->key >= __kDACompactKeyListCount )
+    {
+        return FALSE;
+    }
+
+    if ( field->key == 0 && field->keyLength == 0 )
+    {
+        return FALSE;
+    }
+
+    *key   = bytes + *offset + sizeof( __DACompactField );
+    *value = *key + field->keyLength;
+
+    *offset += sizeof( __DACompactField ) + ( ( size + 0x3 ) & ~0x3 );
+
+    return TRUE;
+}
+
+static CFTypeRef __DACompactCreateValue( CFAllocatorRef allocator, _DACompactType type, const UInt8 * value, CFIndex length )
+{
+    CFTypeRef object = NULL;
+
+    switch ( type )
+    {
+        case _kDACompactTypeFalse:
+        {
+            object = CFRetain( kCFBooleanFalse );
+
+            break;
+        }
+        case _kDACompactTypeTrue:
+        {
+            object = CFRetain( kCFBooleanTrue );
+
+            break;
+        }
+        case _kDACompactTypeInteger:
+        {
+            SInt64 number;
+
+            if ( length == sizeof( number ) )
+            {
+                memcpy( &number, value, sizeof( number ) );
+
+                object = CFNumberCreate( allocator, kCFNumberSInt64Type, &number );
+            }
+
+            break;
+        }
+        case _kDACompactTypeReal:
+        {
+            Float64 number;
+
+            if ( length == sizeof( number ) )
+            {
+                memcpy( &number, value, sizeof( number ) );
+
+                object = CFNumberCreate( allocator, kCFNumberFloat64Type, &number );
+            }
+
+            break;
+        }
+        case _kDACompactTypeString:
+        {
+            object = CFStringCreateWithBytes( allocator, value, length, kCFStringEncodingUTF8, FALSE );
+
+            break;
+        }
+        case _kDACompactTypeData:
+        {
+            object = CFDataCreate( allocator, value, length );
+
+            break;
+        }
+        case _kDACompactTypeUUID:
+        {
+            CFUUIDBytes uuid;
+
+            if ( length == sizeof( uuid ) )
+            {
+                memcpy( &uuid, value, sizeof( uuid ) );
+
+                object = CFUUIDCreateFromUUIDBytes( allocator, uuid );
+            }
+
+            break;
+        }
+        case _kDACompactTypeURL:
+        {
+            object = CFURLCreateFromFileSystemRepresentation( allocator, value, length, TRUE );
+
+            break;
+        }
+        case _kDACompactTypePropertyList:
+        {
+            CFDataRef data;
+
+            data = CFDataCreateWithBytesNoCopy( allocator, value, length, kCFAllocatorNull );
+
+            if ( data )
+            {
+                object = CFPropertyListCreateWithData( allocator, data, kCFPropertyListMutableContainers, NULL, NULL );
+
+                CFRelease( data );
+            }
+
+            break;
+        }
+    }
+
+    return object;
+}
+
+static CFMutableDictionaryRef __DAUnserializeDiskDescriptionCompact( CFAllocatorRef allocator, CFDataRef data )
+{
+    CFMutableDictionaryRef description;
+    const __DACompactHeader * header;
+
+    header = ( const void * ) CFDataGetBytePtr( data );
+
+    description = CFDictionaryCreateMutable( allocator, header->count, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks );
+
+    if ( description )
+    {
+        CFIndex offset;
+        CFIndex index;
+
+        offset = sizeof( __DACompactHeader );
+
+        for ( index = 0; index < header->count; index++ )
+        {
+            __DACompactField field;
+            const UInt8 *    key;
+            const UInt8 *    value;
+            CFStringRef      string;
+            CFTypeRef        object;
+
+            if ( __DACompactGetNextField( data, &offset, &field, &key, &value ) == FALSE )
+            {
+                break;
+            }
+
+            if ( field.key )
+            {
+                string = CFRetain( *__kDACompactKeyList[field.key] );
+            }
+            else
+            {
+                string = CFStringCreateWithBytes( allocator, key, field.keyLength, kCFStringEncodingUTF8, FALSE );
+            }
+
+            object = __DACompactCreateValue( allocator, field.type, value, field.length );
+
+            if ( string && object )
+            {
+                CFDictionarySetValue( description, string, object );
+            }
+
+            if ( string )  CFRelease( string );
+            if ( object )  CFRelease( object );
+        }
+
+        if ( index != header->count )
+        {
+            CFRelease( description );
+
+            description = NULL;
+        }
+    }
+
+    return description;
+}
+
+__private_extern__ CFDataRef _DASerializeDiskDescriptionWithEncoding( CFAllocatorRef allocator, CFDictionaryRef description, _DAEncoding encoding )
+{
+    CFDataRef data = NULL;
+
+    if ( description )
+    {
+        if ( ( encoding & _kDAEncodingCompact ) )
+        {
+            data = __DASerializeDiskDescriptionCompact( allocator, description );
+        }
+
+        if ( data == NULL )
+        {
+            data = _DASerializeDiskDescription( allocator, description );
+        }
+    }
+
+    return data;
+}
+
 __private_extern__ CFTypeRef _DAUnserialize( CFAllocatorRef allocator, CFDataRef data )
 {
     return CFPropertyListCreateWithData( allocator, data, kCFPropertyListImmutable, NULL, NULL );
@@ -466,6 +1219,11 @@ __private_extern__ CFMutableDictionaryRef _DAUnserializeDiskDescription( CFAlloc
 {
     CFMutableDictionaryRef description;
 
+    if ( __DACompactIsValid( data ) )
+    {
+        return __DAUnserializeDiskDescriptionCompact( allocator, data );
+    }
+
     description = ( void * ) CFPropertyListCreateWithData( allocator, data, kCFPropertyListMutableContainers, NULL, NULL );
 
     if ( description )
@@ -518,6 +1276,111 @@ __private_extern__ CFMutableDictionaryRef _DAUnserializeDiskDescription( CFAlloc
     return description;
 }
 
+__private_extern__ CFTypeRef _DAUnserializeDiskDescriptionCopyValue( CFAllocatorRef allocator, CFDataRef data, CFStringRef key )
+{
+    CFTypeRef object = NULL;
+
+    if ( __DACompactIsValid( data ) )
+    {
+        _DACompactType type;
+        const UInt8 *  value;
+        CFIndex        length;
+
+        if ( _DAUnserializeDiskDescriptionGetField( data, key, &type, &value, &length ) )
+        {
+            object = __DACompactCreateValue( allocator, type, value, length );
+        }
+    }
+    else
+    {
+        CFDictionaryRef description;
+
+        description = _DAUnserializeDiskDescription( allocator, data );
+
+        if ( description )
+        {
+            object = CFDictionaryGetValue( description, key );
+
+            if ( object )  CFRetain( object );
+
+            CFRelease( description );
+        }
+    }
+
+    return object;
+}
+
+__private_extern__ Boolean _DAUnserializeDiskDescriptionGetField( CFDataRef data, CFStringRef key, _DACompactType * type, const UInt8 ** value, CFIndex * length )
+{
+    /*
+     * Locate a field in a compact serialization without decoding the rest of it.  The value is
+     * returned as a pointer into the serialization.
+     */
+
+    if ( __DACompactIsValid( data ) )
+    {
+        const __DACompactHeader * header;
+        uint16_t                  id;
+        CFIndex                   offset;
+        CFIndex                   index;
+
+        header = ( const void * ) CFDataGetBytePtr( data );
+
+        id = __DACompactGetKeyID( key );
+
+        offset = sizeof( __DACompactHeader );
+
+        for ( index = 0; index < header->count; index++ )
+        {
+            __DACompactField field;
+            const UInt8 *    fieldKey;
+            const UInt8 *    fieldValue;
+
+            if ( __DACompactGetNextField( data, &offset, &field, &fieldKey, &fieldValue ) == FALSE )
+            {
+                break;
+            }
+
+            if ( id )
+            {
+                if ( field.key != id )
+                {
+                    continue;
+                }
+            }
+            else
+            {
+                CFStringRef string;
+                Boolean     match;
+
+                if ( field.key )
+                {
+                    continue;
+                }
+
+                string = CFStringCreateWithBytesNoCopy( kCFAllocatorDefault, fieldKey, field.keyLength, kCFStringEncodingUTF8, FALSE, kCFAllocatorNull );
+
+                match = string ? CFEqual( string, key ) : FALSE;
+
+                if ( string )  CFRelease( string );
+
+                if ( match == FALSE )
+                {
+                    continue;
+                }
+            }
+
+            *type   = field.type;
+            *value  = fieldValue;
+            *length = field.length;
+
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
 __private_extern__ CFMutableDictionaryRef _DAUnserializeDiskDescriptionWithBytes( CFAllocatorRef allocator, vm_address_t bytes, vm_size_t length )
 {
     CFMutableDictionaryRef description = NULL;
@@ -25,6 +25,7 @@
 #define __DISKARBITRATIOND_DAINTERNAL__
 
 #include <mach/mach.h>
+#include <stdatomic.h>
 #include <sys/mount.h>
 #include <CoreFoundation/CoreFoundation.h>
 
@@ -69,7 +70,10 @@ enum
     _kDAIdleCallback,
     _kDADiskListCompleteCallback,
     _kDADiskSetFSKitAdditionsCallback,
-    _kDADiskLastKind = _kDADiskSetFSKitAdditionsCallback
+    _kDADiskBatchCallback,
+    _kDADiskLastKind = _kDADiskBatchCallback,
+
+    _kDASessionResyncCallback = 0x00000100
 };
 
 typedef UInt32 _DACallbackKind;
@@ -88,6 +92,65 @@ enum
 
 typedef UInt32 _DARequestKind;
 
+enum
+{
+    _kDAEncodingPropertyList = 0x00000001,
+    _kDAEncodingCompact      = 0x00000002,
+    _kDAEncodingDelta        = 0x00000004
+};
+
+typedef UInt32 _DAEncoding;
+
+enum
+{
+    _kDACompactTypeFalse,
+    _kDACompactTypeTrue,
+    _kDACompactTypeInteger,
+    _kDACompactTypeReal,
+    _kDACompactTypeString,
+    _kDACompactTypeData,
+    _kDACompactTypeUUID,
+    _kDACompactTypeURL,
+    _kDACompactTypePropertyList
+};
+
+typedef UInt8 _DACompactType;
+
+#define _kDACallbackRingVersion     1
+#define _kDACallbackRingSizeDefault 0x00040000
+#define _kDACallbackRingSizeMaximum 0x01000000
+#define _kDACallbackRingSizeMinimum 0x00004000
+
+#define _kDACallbackRingRecordPad   0xFFFFFFFF
+
+#define _kDACoalescingIntervalMaximum 1000
+
+#define _kDADiskListRemovalsLimit 256
+
+#define _kDASessionQueueLimitDefault 4096
+#define _kDASessionQueueLimitMaximum 65536
+#define _kDASessionQueueLimitMinimum 256
+
+typedef struct
+{
+    uint32_t              version;
+    uint32_t              size;
+    _Atomic( uint32_t )   armed;
+    _Atomic( uint32_t )   overflow;
+    _Atomic( uint64_t )   head __attribute__( ( aligned( 64 ) ) );
+    _Atomic( uint64_t )   tail __attribute__( ( aligned( 64 ) ) );
+} _DACallbackRing;
+
+typedef struct
+{
+    uint32_t size;
+    uint32_t kind;
+    uint64_t address;
+    uint64_t context;
+    uint32_t argument0Size;
+    uint32_t argument1Size;
+} _DACallbackRingRecord;
+
 const char * _kDAAuthorizeRightAdopt;
 const char * _kDAAuthorizeRightEncode;
 const char * _kDAAuthorizeRightMount;
@@ -107,7 +170,10 @@ const CFStringRef _kDACallbackSessionKey;       /* ( DASession    ) */
 const CFStringRef _kDACallbackTimeKey;          /* ( CFDate       ) */
 const CFStringRef _kDACallbackWatchKey;         /* ( CFArray      ) */
 
+const CFStringRef _kDADiskBaseGenerationKey;    /* ( CFNumber     ) */
+const CFStringRef _kDADiskGenerationKey;        /* ( CFNumber     ) */
 const CFStringRef _kDADiskIDKey;                /* ( CFData       ) */
+const CFStringRef _kDADiskRemovedKeysKey;       /* ( CFArray      ) */
 
 const CFStringRef _kDADissenterProcessIDKey;    /* ( CFNumber     ) */
 const CFStringRef _kDADissenterStatusKey;       /* ( CFNumber     ) */
@@ -116,12 +182,16 @@ const CFStringRef _kDADissenterStatusStringKey; /* ( CFString     ) */
 const CFStringRef _kDARequestArgument1Key;      /* ( CFType       ) */
 const CFStringRef _kDARequestArgument2Key;      /* ( CFType       ) */
 const CFStringRef _kDARequestArgument3Key;      /* ( CFType       ) */
+const CFStringRef _kDARequestBatchKey;          /* ( CFDictionary ) */
 const CFStringRef _kDARequestCallbackKey;       /* ( DACallback   ) */
+const CFStringRef _kDARequestClassKey;          /* ( CFNumber     ) */
 const CFStringRef _kDARequestDiskKey;           /* ( DADisk       ) */
 const CFStringRef _kDARequestDissenterKey;      /* ( DADissenter  ) */
 const CFStringRef _kDARequestKindKey;           /* ( CFNumber     ) */
 const CFStringRef _kDARequestLinkKey;           /* ( CFArray      ) */
 const CFStringRef _kDARequestStateKey;          /* ( CFNumber     ) */
+const CFStringRef _kDARequestTagKey;            /* ( CFNumber     ) */
+const CFStringRef _kDARequestTimeKey;           /* ( CFDate       ) */
 const CFStringRef _kDARequestUserGIDKey;        /* ( CFNumber     ) */
 const CFStringRef _kDARequestUserUIDKey;        /* ( CFNumber     ) */
 
@@ -138,12 +208,30 @@ __private_extern__ char *       ___CFStringCopyCString( CFStringRef string );
 __private_extern__ char *       ___CFURLCopyFileSystemRepresentation( CFURLRef url );
 
 __private_extern__ const char * _DACallbackKindGetName( _DACallbackKind kind );
+__private_extern__ Boolean      _DACallbackRingDequeue( _DACallbackRing *   ring,
+                                                        uint32_t            size,
+                                                        CFAllocatorRef      allocator,
+                                                        _DACallbackKind *   kind,
+                                                        mach_vm_offset_t *  address,
+                                                        mach_vm_offset_t *  context,
+                                                        CFDataRef *         argument0,
+                                                        CFTypeRef *         argument1 );
+__private_extern__ Boolean      _DACallbackRingEnqueue( _DACallbackRing * ring,
+                                                        uint32_t          size,
+                                                        _DACallbackKind   kind,
+                                                        mach_vm_offset_t  address,
+                                                        mach_vm_offset_t  context,
+                                                        CFDataRef         argument0,
+                                                        CFDataRef         argument1 );
 __private_extern__ const char * _DARequestKindGetName( _DARequestKind kind );
 
 __private_extern__ CFDataRef              _DASerialize( CFAllocatorRef allocator, CFTypeRef object );
 __private_extern__ CFDataRef              _DASerializeDiskDescription( CFAllocatorRef allocator, CFDictionaryRef description );
+__private_extern__ CFDataRef              _DASerializeDiskDescriptionWithEncoding( CFAllocatorRef allocator, CFDictionaryRef description, _DAEncoding encoding );
 __private_extern__ CFTypeRef              _DAUnserialize( CFAllocatorRef allocator, CFDataRef data );
 __private_extern__ CFMutableDictionaryRef _DAUnserializeDiskDescription( CFAllocatorRef allocator, CFDataRef data );
+__private_extern__ CFTypeRef              _DAUnserializeDiskDescriptionCopyValue( CFAllocatorRef allocator, CFDataRef data, CFStringRef key );
+__private_extern__ Boolean                _DAUnserializeDiskDescriptionGetField( CFDataRef data, CFStringRef key, _DACompactType * type, const UInt8 ** value, CFIndex * length );
 __private_extern__ CFMutableDictionaryRef _DAUnserializeDiskDescriptionWithBytes( CFAllocatorRef allocator, vm_address_t bytes, vm_size_t length );
 __private_extern__ CFTypeRef              _DAUnserializeWithBytes( CFAllocatorRef allocator, vm_address_t bytes, vm_size_t length );
 
@@ -41,6 +41,7 @@
 #include <notify.h>
 #include <notify_keys.h>
 #include <signal.h>
+#include <stdlib.h>
 #include <sysexits.h>
 #include <unistd.h>
 #include <sys/param.h>
@@ -76,18 +77,16 @@ gid_t                  gDAConsoleUserGID               = 0;
 uid_t                  gDAConsoleUserUID               = 0;
 CFArrayRef             gDAConsoleUserList              = NULL;
 CFMutableArrayRef      gDADiskList                     = NULL; // Should be accessed only under DAServerWorkLoop()
+UInt64                 gDADiskListGeneration           = 0;
+UInt64                 gDADiskListHorizon              = 0;
+CFMutableArrayRef      gDADiskListRemovals             = NULL;
 Boolean                gDAExit                         = FALSE;
-CFMutableArrayRef      gDAFileSystemList               = NULL;
-CFMutableArrayRef      gDAFileSystemProbeList          = NULL;
 Boolean                gDAIdle                         = TRUE;
 Boolean                gDAIdleTimerRunning             = FALSE;
 CFAbsoluteTime         gDAIdleStartTime;
 io_iterator_t          gDAMediaAppearedNotification    = IO_OBJECT_NULL;
 io_iterator_t          gDAMediaDisappearedNotification = IO_OBJECT_NULL;
 IONotificationPortRef  gDAMediaPort                    = NULL;
-CFMutableArrayRef      gDAMountMapList1                = NULL;
-CFMutableArrayRef      gDAMountMapList2                = NULL;
-CFMutableDictionaryRef gDAPreferenceList               = NULL;
 CFMutableArrayRef      gDAMountPointList               = NULL;
 CFMutableDictionaryRef gDADanglingVolumeList           = NULL;
 pid_t                  gDAProcessID                    = 0;
@@ -96,6 +95,7 @@ char *                 gDAProcessNameID                = NULL;
 CFMutableArrayRef      gDARequestList                  = NULL;
 CFMutableArrayRef      gDAResponseList                 = NULL;
 CFMutableArrayRef      gDASessionList                  = NULL;
+DAStatistics           gDAStatistics                   = { 0 };
 CFMutableDictionaryRef gDAUnitList                     = NULL;
 Boolean                gDAUnlockedState                = FALSE;
 
@@ -357,46 +357,19 @@ static void __DAMain( void *__unused context )
 
     assert( gDADiskList );
 
-    /*
-     * Create the file system list.
-     */
-
-    gDAFileSystemList = CFArrayCreateMutable( kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks );
-
-    assert( gDAFileSystemList );
-
-    /*
-     * Create the file system probe list.
-     */
-
-    gDAFileSystemProbeList = CFArrayCreateMutable( kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks );
+    gDADiskListRemovals = CFArrayCreateMutable( kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks );
 
-    assert( gDAFileSystemProbeList );
+    assert( gDADiskListRemovals );
 
     /*
-     * Create the mount map list.
+     * Start the disk list generation from a random epoch in its upper half, so that generations
+     * handed out by an earlier instance of the daemon, in this boot or another, are told apart
+     * from ours whatever the clock does in between.
      */
 
-    gDAMountMapList1 = CFArrayCreateMutable( kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks );
-
-    assert( gDAMountMapList1 );
+    gDADiskListGeneration = ( ( UInt64 ) arc4random( ) ) << 32;
+    gDADiskListHorizon    = gDADiskListGeneration;
 
-    /*
-     * Create the mount map list.
-     */
-
-    gDAMountMapList2 = CFArrayCreateMutable( kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks );
-
-    assert( gDAMountMapList2 );
-
-    /*
-     * Create the preference list.
-     */
-
-    gDAPreferenceList = CFDictionaryCreateMutable( kCFAllocatorDefault, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks );
-
-    assert( gDAPreferenceList );
-    
     /*
      * Create the mount  list.
      */
@@ -702,6 +675,12 @@ static void __DAMain( void *__unused context )
 
     DAMountMapListRefresh2( );
 
+    /*
+     * Keep the preference, file system and mount map lists fresh from here on.
+     */
+
+    DAConfigurationListWatch( );
+
     /*
      * Process the initial set of media objects in I/O Kit.
      */
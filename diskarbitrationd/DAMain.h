@@ -28,10 +28,22 @@
 #include <CoreFoundation/CoreFoundation.h>
 #include <IOKit/IOKitLib.h>
 
+#include "DARequest.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
 
+typedef struct
+{
+    UInt64 callbacksCoalesced;
+    UInt64 requestCancelled[kDARequestClassCount];
+    UInt64 requestCount[kDARequestClassCount];
+    UInt64 requestWait[kDARequestClassCount];    /* in milliseconds, from dispatchable to commenced */
+    UInt64 requestWaitMax[kDARequestClassCount]; /* in milliseconds, from dispatchable to commenced */
+    UInt64 sessionResyncs;
+} DAStatistics;
+
 extern const char *           kDAMainMountPointFolder;
 extern const char *           kDAMainMountPointFolderCookieFile;
 extern const char *           kDAMainDataVolumeMountPointFolder;
@@ -42,18 +54,16 @@ extern gid_t                  gDAConsoleUserGID;
 extern uid_t                  gDAConsoleUserUID;
 extern CFArrayRef             gDAConsoleUserList;
 extern CFMutableArrayRef      gDADiskList;
+extern UInt64                 gDADiskListGeneration;
+extern UInt64                 gDADiskListHorizon;
+extern CFMutableArrayRef      gDADiskListRemovals;
 extern Boolean                gDAExit;
-extern CFMutableArrayRef      gDAFileSystemList;
-extern CFMutableArrayRef      gDAFileSystemProbeList;
 extern Boolean                gDAIdle;
 extern Boolean                gDAIdleTimerRunning;
 extern CFAbsoluteTime         gDAIdleStartTime;
 extern io_iterator_t          gDAMediaAppearedNotification;
 extern io_iterator_t          gDAMediaDisappearedNotification;
 extern IONotificationPortRef  gDAMediaPort;
-extern CFMutableArrayRef      gDAMountMapList1;
-extern CFMutableArrayRef      gDAMountMapList2;
-extern CFMutableDictionaryRef gDAPreferenceList;
 extern CFMutableArrayRef      gDAMountPointList;
 extern CFMutableDictionaryRef gDADanglingVolumeList;
 extern pid_t                  gDAProcessID;
@@ -62,6 +72,7 @@ extern char *                 gDAProcessNameID;
 extern CFMutableArrayRef      gDARequestList;
 extern CFMutableArrayRef      gDAResponseList;
 extern CFMutableArrayRef      gDASessionList;
+extern DAStatistics           gDAStatistics;
 extern CFMutableDictionaryRef gDAUnitList;
 extern Boolean                gDAUnlockedState;
 
@@ -31,8 +31,9 @@
 #include "DASupport.h"
 #include "DATelemetry.h"
 
-#include <mntopts.h>
+#include <dirent.h>
 #include <fstab.h>
+#include <pthread.h>
 #include <sys/stat.h>
 #include <IOKit/pwr_mgt/IOPMLib.h>
 #include <os/variant_private.h>
@@ -59,6 +60,13 @@ struct __DAMountCallbackContext
 
 typedef struct __DAMountCallbackContext __DAMountCallbackContext;
 
+#define __kDAMountPointIndexLimit 100
+
+static pthread_mutex_t        __gDAMountPointListLock = PTHREAD_MUTEX_INITIALIZER;
+static CFMutableSetRef        __gDAMountPointList     = NULL;
+static CFMutableDictionaryRef __gDAMountPointNextList = NULL;
+static char                   __gDAMountPointFolder[MAXPATHLEN];
+
 static void __DAMountWithArgumentsCallbackStage1( int status, void * context );
 static void __DAMountWithArgumentsCallbackStage2( int status, void * context );
 static void __DAMountWithArgumentsCallbackStage3( int status, void * context );
@@ -204,8 +212,9 @@ static void __DAMountWithArgumentsCallbackStage1( int status, void * parameter )
                 CFArrayAppendValue( gDAMountPointList, context->mountpoint );
             }
             CFStringRef preferredMountMethod = NULL;
+            CFDictionaryRef preferences = DAPreferenceListCopy( );
 #if TARGET_OS_OSX
-            preferredMountMethod = CFDictionaryGetValue( gDAPreferenceList, kDAPreferenceMountMethodkey );
+            preferredMountMethod = CFDictionaryGetValue( preferences, kDAPreferenceMountMethodkey );
 #else
             if ( true == DAMountGetPreference( context->disk, kDAMountPreferenceEnableUserFSMount ) )
             {
@@ -226,6 +235,8 @@ static void __DAMountWithArgumentsCallbackStage1( int status, void * parameter )
                                             context,
                                             context->options,
                                             NULL );
+
+            CFRelease( preferences );
         }
         else
         {
@@ -373,347 +384,650 @@ void DAMount( DADiskRef disk, CFURLRef mountpoint, DAMountCallback callback, voi
 }
 
 /*
- * For a list of arguments in the form of "arg1,arg2,arg3,etc.", check these arguments for mount flags.
- * Each argument is expected to be single strings, with no '=' or other getopt()-adjacent format.
+ * Mount options are kept parsed while a mount is put together.  The flags of the known mount
+ * arguments are tracked in a bitset, and every option is kept in order for the string that is
+ * handed to the mount command once at the end.
  */
-static Boolean __DAMountCheckMntOptsForString( CFMutableStringRef mntOpsStr , CFStringRef argument )
+
+enum
 {
-    mntoptparse_t mp;
-    CFRange result;
-    int mntflags = 0;
-    int altflags = 0;
-    int getmntSilentCurrent;
-    uint64_t bufSize;
-    char *optionBuffer;
-    Boolean containsValue = FALSE;
-    static const struct mntopt mopts[] = {
-        MOPT_STDOPTS,
-        MOPT_UPDATE,
-        MOPT_FORCE,
-        MOPT_BROWSE,
-        { NULL }
-    };
-    
-    bufSize = CFStringGetMaximumSizeForEncoding( CFStringGetLength( mntOpsStr ) ,
-                                                 kCFStringEncodingUTF8 );
-    
-    if ( bufSize == kCFNotFound )
-    {
-        bufSize = MAXPATHLEN;
-    }
-    
-    optionBuffer = malloc( bufSize );
-    
-    if ( optionBuffer == NULL )
-    {
-        DALogError( "Failed to malloc buffer" );
-        return FALSE;
-    }
-    
-    if ( CFStringGetCString( mntOpsStr , optionBuffer , bufSize , kCFStringEncodingUTF8 ) == FALSE )
-    {
-        DALogError( "Failed to copy argument" );
-        free( optionBuffer );
-        return FALSE;
-    }
-    
-    getmntSilentCurrent = getmnt_silent;
-    getmnt_silent = 1; // let getmntopts() return to the caller
-    mp = getmntopts( optionBuffer , mopts , &mntflags , &altflags );
-    getmnt_silent = getmntSilentCurrent;
-    
-    if ( mp == NULL )
-    {
-        DALogError( "Failed to get mnt opts" );
-        free( optionBuffer );
-        return FALSE;
-    }
-    
-    // Check the "no" and flag-friendly options first before the string searching options
-    if ( CFEqual( argument , kDAFileSystemMountArgumentForce ) )
+    __kDAMountOptionForce       = 0x00000001,
+    __kDAMountOptionNoDevice    = 0x00000002,
+    __kDAMountOptionDevice      = 0x00000004,
+    __kDAMountOptionNoExecute   = 0x00000008,
+    __kDAMountOptionNoOwnership = 0x00000010,
+    __kDAMountOptionOwnership   = 0x00000020,
+    __kDAMountOptionPermission  = 0x00000040,
+    __kDAMountOptionNoSetUserID = 0x00000080,
+    __kDAMountOptionSetUserID   = 0x00000100,
+    __kDAMountOptionNoWrite     = 0x00000200,
+    __kDAMountOptionUnion       = 0x00000400,
+    __kDAMountOptionUpdate      = 0x00000800,
+    __kDAMountOptionNoBrowse    = 0x00001000,
+    __kDAMountOptionSnapshot    = 0x00002000,
+    __kDAMountOptionNoFollow    = 0x00004000
+};
+
+struct __DAMountOptionRule
+{
+    const char * name;
+    UInt32       set;
+    UInt32       clear;
+};
+
+typedef struct __DAMountOptionRule __DAMountOptionRule;
+
+/*
+ * The options understood by getmntopts() for the known mount arguments.  An option sets its
+ * flags and clears the flags it overrides, and the last option to touch a flag decides it.
+ */
+
+static const __DAMountOptionRule __kDAMountOptionRuleList[] =
+{
+    { "force",    __kDAMountOptionForce,       0                                                       },
+    { "noforce",  0,                           __kDAMountOptionForce                                   },
+    { "dev",      __kDAMountOptionDevice,      __kDAMountOptionNoDevice                                },
+    { "nodev",    __kDAMountOptionNoDevice,    __kDAMountOptionDevice                                  },
+    { "exec",     0,                           __kDAMountOptionNoExecute                               },
+    { "noexec",   __kDAMountOptionNoExecute,   0                                                       },
+    { "owners",   __kDAMountOptionOwnership,   __kDAMountOptionNoOwnership                             },
+    { "noowners", __kDAMountOptionNoOwnership, __kDAMountOptionOwnership | __kDAMountOptionPermission  },
+    { "perm",     __kDAMountOptionPermission,  __kDAMountOptionNoOwnership                             },
+    { "noperm",   __kDAMountOptionNoOwnership, __kDAMountOptionOwnership | __kDAMountOptionPermission  },
+    { "suid",     __kDAMountOptionSetUserID,   __kDAMountOptionNoSetUserID                             },
+    { "nosuid",   __kDAMountOptionNoSetUserID, __kDAMountOptionSetUserID                               },
+    { "rdonly",   __kDAMountOptionNoWrite,     0                                                       },
+    { "nordonly", 0,                           __kDAMountOptionNoWrite                                 },
+    { "ro",       __kDAMountOptionNoWrite,     0                                                       },
+    { "noro",     0,                           __kDAMountOptionNoWrite                                 },
+    { "rw",       0,                           __kDAMountOptionNoWrite                                 },
+    { "union",    __kDAMountOptionUnion,       0                                                       },
+    { "nounion",  0,                           __kDAMountOptionUnion                                   },
+    { "update",   __kDAMountOptionUpdate,      0                                                       },
+    { "noupdate", 0,                           __kDAMountOptionUpdate                                  },
+    { "browse",   0,                           __kDAMountOptionNoBrowse                                },
+    { "nobrowse", __kDAMountOptionNoBrowse,    0                                                       },
+    { "follow",   0,                           __kDAMountOptionNoFollow                                },
+    { "nofollow", __kDAMountOptionNoFollow,    0                                                       },
+    { NULL,       0,                           0                                                       }
+};
+
+struct __DAMountOptions
+{
+    UInt32            flags;
+    UInt32            mask;
+    CFMutableArrayRef list;
+    CFMutableArrayRef defaults;
+};
+
+typedef struct __DAMountOptions __DAMountOptions;
+
+static UInt32 __DAMountOptionsGetArgument( CFStringRef argument )
+{
+    /*
+     * Obtain the flag for a known mount argument.
+     */
+
+    if ( CFEqual( argument, kDAFileSystemMountArgumentForce        ) )  return __kDAMountOptionForce;
+    if ( CFEqual( argument, kDAFileSystemMountArgumentNoDevice     ) )  return __kDAMountOptionNoDevice;
+    if ( CFEqual( argument, kDAFileSystemMountArgumentDevice       ) )  return __kDAMountOptionDevice;
+    if ( CFEqual( argument, kDAFileSystemMountArgumentNoExecute    ) )  return __kDAMountOptionNoExecute;
+    if ( CFEqual( argument, kDAFileSystemMountArgumentNoOwnership  ) )  return __kDAMountOptionNoOwnership;
+    if ( CFEqual( argument, kDAFileSystemMountArgumentNoPermission ) )  return __kDAMountOptionNoOwnership;
+    if ( CFEqual( argument, kDAFileSystemMountArgumentOwnership    ) )  return __kDAMountOptionOwnership;
+    if ( CFEqual( argument, kDAFileSystemMountArgumentPermission   ) )  return __kDAMountOptionPermission;
+    if ( CFEqual( argument, kDAFileSystemMountArgumentNoSetUserID  ) )  return __kDAMountOptionNoSetUserID;
+    if ( CFEqual( argument, kDAFileSystemMountArgumentSetUserID    ) )  return __kDAMountOptionSetUserID;
+    if ( CFEqual( argument, kDAFileSystemMountArgumentNoWrite      ) )  return __kDAMountOptionNoWrite;
+    if ( CFEqual( argument, kDAFileSystemMountArgumentUnion        ) )  return __kDAMountOptionUnion;
+    if ( CFEqual( argument, kDAFileSystemMountArgumentUpdate       ) )  return __kDAMountOptionUpdate;
+    if ( CFEqual( argument, kDAFileSystemMountArgumentNoBrowse     ) )  return __kDAMountOptionNoBrowse;
+    if ( CFEqual( argument, kDAFileSystemMountArgumentSnapshot     ) )  return __kDAMountOptionSnapshot;
+    if ( CFEqual( argument, kDAFileSystemMountArgumentNoFollow     ) )  return __kDAMountOptionNoFollow;
+
+    return 0;
+}
+
+static UInt32 __DAMountOptionsGetRule( const char * option, UInt32 * clear )
+{
+    size_t       length;
+    const char * value;
+    UInt32       index;
+
+    /*
+     * Obtain the flags an option sets and clears.  An option may take one of these forms:
+     * 1. a single string (ex. noowners, nodev, nofollow)
+     * 2. a -o option (ex. -onoowners)
+     * 3. a -s option (ex. -s=/path/to/snapshot)
+     * 4. an argument mapping (ex. owners=noowners), which is treated as noowners
+     * 5. an option with a value (ex. suid=1), which is treated as the option itself, as it is
+     *    by getmntopts()
+     */
+
+    *clear = 0;
+
+    if ( option[0] == '-' )
     {
-        containsValue = ( mntflags & MNT_FORCE ) ? TRUE : FALSE;
+        if ( option[1] == 's' && option[2] )
+        {
+            return __kDAMountOptionSnapshot;
+        }
+
+        if ( option[1] != 'o' || option[2] == 0 )
+        {
+            return 0;
+        }
+
+        option += 2;
     }
-    else if ( CFEqual( argument , kDAFileSystemMountArgumentNoDevice ) )
+
+    value = strchr( option, '=' );
+
+    length = value ? ( size_t ) ( value - option ) : strlen( option );
+
+    if ( value )
     {
-        containsValue = ( mntflags & MNT_NODEV ) ? TRUE : FALSE;
+        value++;
+
+        if ( strchr( value, '=' ) == NULL )
+        {
+            if ( length == 0 ||
+                 ( length == strlen( "owners" ) && strncasecmp( option, "owners", length ) == 0 ) ||
+                 ( length == strlen( "perm"   ) && strncasecmp( option, "perm",   length ) == 0 ) )
+            {
+                if ( strstr( value, "noowners" ) || strstr( value, "noperm" ) )
+                {
+                    option = "noowners";
+                    length = strlen( option );
+                }
+            }
+        }
     }
-    else if ( CFEqual( argument , kDAFileSystemMountArgumentNoOwnership )
-        || CFEqual( argument , kDAFileSystemMountArgumentNoPermission ) )
+
+    /*
+     * Match the rule on the name of the option alone, before any value.
+     */
+
+    for ( index = 0; __kDAMountOptionRuleList[index].name; index++ )
     {
-        containsValue = ( mntflags & MNT_IGNORE_OWNERSHIP ) ? TRUE : FALSE;
+        if ( strlen( __kDAMountOptionRuleList[index].name ) == length &&
+             strncasecmp( option, __kDAMountOptionRuleList[index].name, length ) == 0 )
+        {
+            *clear = __kDAMountOptionRuleList[index].clear;
+
+            return __kDAMountOptionRuleList[index].set;
+        }
     }
-    else if ( CFEqual( argument , kDAFileSystemMountArgumentNoSetUserID ) )
+
+    return 0;
+}
+
+static void __DAMountOptionsApply( __DAMountOptions * options, CFStringRef string, Boolean fallback )
+{
+    char *  buffer;
+    CFIndex size;
+
+    /*
+     * Fold the flags of a comma separated list of options into the bitset.  Options that are
+     * appended take precedence over all that came before them.  Fallback options yield to all
+     * that came before them, so they only decide the flags no option has decided yet.
+     */
+
+    size = CFStringGetMaximumSizeForEncoding( CFStringGetLength( string ), kCFStringEncodingUTF8 ) + 1;
+
+    buffer = malloc( size );
+
+    if ( buffer )
     {
-        containsValue = ( mntflags & MNT_NOSUID ) ? TRUE : FALSE;
+        if ( CFStringGetCString( string, buffer, size, kCFStringEncodingUTF8 ) )
+        {
+            UInt32 flags = 0;
+            UInt32 mask  = 0;
+            char * option;
+            char * state;
+
+            /*
+             * Within a list the last option wins, so the list is folded on its own as it is
+             * walked, and then decides the flags it is allowed to.
+             */
+
+            for ( option = strtok_r( buffer, ",", &state ); option; option = strtok_r( NULL, ",", &state ) )
+            {
+                UInt32 clear;
+                UInt32 set;
+
+                set = __DAMountOptionsGetRule( option, &clear );
+
+                flags = ( flags & ~clear ) | set;
+                mask |= set | clear;
+            }
+
+            if ( fallback )
+            {
+                mask &= ~options->mask;
+            }
+
+            options->flags = ( options->flags & ~mask ) | ( flags & mask );
+            options->mask |= mask;
+        }
+
+        free( buffer );
     }
-    else if ( CFEqual( argument , kDAFileSystemMountArgumentNoWrite ) )
+}
+
+static Boolean __DAMountOptionsCreate( __DAMountOptions * options )
+{
+    options->flags    = 0;
+    options->mask     = 0;
+    options->list     = CFArrayCreateMutable( kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks );
+    options->defaults = CFArrayCreateMutable( kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks );
+
+    return ( options->list && options->defaults ) ? TRUE : FALSE;
+}
+
+static void __DAMountOptionsRelease( __DAMountOptions * options )
+{
+    if ( options->list     )  CFRelease( options->list     );
+    if ( options->defaults )  CFRelease( options->defaults );
+
+    options->list     = NULL;
+    options->defaults = NULL;
+}
+
+static void __DAMountOptionsAppend( __DAMountOptions * options, CFStringRef string )
+{
+    /*
+     * Add options that take precedence over all options added so far.
+     */
+
+    if ( CFStringGetLength( string ) )
     {
-        containsValue = ( mntflags & MNT_RDONLY ) ? TRUE : FALSE;
+        CFArrayAppendValue( options->list, string );
+
+        __DAMountOptionsApply( options, string, FALSE );
     }
-    else if ( CFEqual( argument , kDAFileSystemMountArgumentUnion ) )
+}
+
+static void __DAMountOptionsAppendDefault( __DAMountOptions * options, CFStringRef string )
+{
+    /*
+     * Add options that yield to all options added so far.  They end up ahead of them in the
+     * options string, where the mount command gives them the lower precedence.
+     */
+
+    if ( CFStringGetLength( string ) )
     {
-        containsValue = ( mntflags & MNT_UNION ) ? TRUE : FALSE;
+        CFArrayAppendValue( options->defaults, string );
+
+        __DAMountOptionsApply( options, string, TRUE );
     }
-    else if ( CFEqual( argument , kDAFileSystemMountArgumentUpdate ) )
+}
+
+static Boolean __DAMountOptionsContains( __DAMountOptions * options, UInt32 option )
+{
+    return ( options->flags & option ) ? TRUE : FALSE;
+}
+
+static CFStringRef __DAMountOptionsCopyString( __DAMountOptions * options )
+{
+    CFMutableStringRef string;
+
+    /*
+     * Render the options in precedence order, from the last default added up to the last
+     * option appended.
+     */
+
+    string = CFStringCreateMutable( kCFAllocatorDefault, 0 );
+
+    if ( string )
     {
-        containsValue = ( mntflags & MNT_UPDATE ) ? TRUE : FALSE;
+        CFIndex count;
+        CFIndex index;
+
+        count = CFArrayGetCount( options->defaults );
+
+        for ( index = count - 1; index >= 0; index-- )
+        {
+            if ( CFStringGetLength( string ) )
+            {
+                CFStringAppend( string, CFSTR( "," ) );
+            }
+
+            CFStringAppend( string, CFArrayGetValueAtIndex( options->defaults, index ) );
+        }
+
+        count = CFArrayGetCount( options->list );
+
+        for ( index = 0; index < count; index++ )
+        {
+            if ( CFStringGetLength( string ) )
+            {
+                CFStringAppend( string, CFSTR( "," ) );
+            }
+
+            CFStringAppend( string, CFArrayGetValueAtIndex( options->list, index ) );
+        }
+
+        CFStringTrim( string, CFSTR( "," ) );
     }
-    else if ( CFEqual( argument , kDAFileSystemMountArgumentNoBrowse ) )
+
+    return string;
+}
+
+/*
+ * For a list of arguments in the form of "arg1,arg2,arg3,etc.", find the specified argument.
+ * The forms each argument may take are those understood by __DAMountOptionsGetRule().
+ */
+Boolean DAMountContainsArgument( CFStringRef arguments, CFStringRef argument )
+{
+    __DAMountOptions options = { 0 };
+
+    if ( arguments == NULL )
     {
-        containsValue = ( mntflags & MNT_DONTBROWSE ) ? TRUE : FALSE;
+        return FALSE;
     }
-    else if ( CFEqual( argument , kDAFileSystemMountArgumentNoFollow ) )
+
+    /*
+     * Only the bitset is needed to answer, so the options themselves are not kept.
+     */
+
+    __DAMountOptionsApply( &options, arguments, FALSE );
+
+    return __DAMountOptionsContains( &options, __DAMountOptionsGetArgument( argument ) );
+}
+
+static Boolean __DAMountPointListLoad( void )
+{
+    /*
+     * Seed the index of names in use under the mount point folder, which is kept current as
+     * mount points are made and removed from then on.  The caller holds the lock.
+     */
+
+    if ( __gDAMountPointList == NULL )
     {
-        containsValue = ( mntflags & MNT_NOFOLLOW ) ? TRUE : FALSE;
+        DIR * folder;
+
+        if ( realpath( kDAMainMountPointFolder, __gDAMountPointFolder ) == NULL )
+        {
+            return FALSE;
+        }
+
+        __gDAMountPointList = CFSetCreateMutable( kCFAllocatorDefault, 0, &kCFTypeSetCallBacks );
+
+        if ( __gDAMountPointList == NULL )
+        {
+            return FALSE;
+        }
+
+        __gDAMountPointNextList = CFDictionaryCreateMutable( kCFAllocatorDefault, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks );
+
+        if ( __gDAMountPointNextList == NULL )
+        {
+            CFRelease( __gDAMountPointList );
+
+            __gDAMountPointList = NULL;
+
+            return FALSE;
+        }
+
+        folder = opendir( __gDAMountPointFolder );
+
+        if ( folder )
+        {
+            struct dirent * item;
+
+            while ( ( item = readdir( folder ) ) )
+            {
+                if ( strcmp( item->d_name, "." ) && strcmp( item->d_name, ".." ) )
+                {
+                    CFStringRef name;
+
+                    name = CFStringCreateWithCString( kCFAllocatorDefault, item->d_name, kCFStringEncodingUTF8 );
+
+                    if ( name )
+                    {
+                        CFSetAddValue( __gDAMountPointList, name );
+
+                        CFRelease( name );
+                    }
+                }
+            }
+
+            closedir( folder );
+        }
     }
-    else if ( CFEqual( argument , kDAFileSystemMountArgumentNoExecute ) )
+
+    return TRUE;
+}
+
+static void __DAMountPointListReload( void )
+{
+    /*
+     * Rebuild the index from the mount point folder, once the folder is found to have changed
+     * behind our back.
+     */
+
+    pthread_mutex_lock( &__gDAMountPointListLock );
+
+    if ( __gDAMountPointList )
     {
-        containsValue = ( mntflags & MNT_NOEXEC ) ? TRUE : FALSE;
+        CFRelease( __gDAMountPointList );
+
+        __gDAMountPointList = NULL;
     }
-    else if ( CFEqual( argument , kDAFileSystemMountArgumentDevice ) )
+
+    if ( __gDAMountPointNextList )
     {
-        // Only return true if the arguments explicitly asked for "dev"
-        // Not passing "nodev" is not the same as passing "dev"
-        if ( ! ( mntflags & MNT_NODEV ) )
-        {
-            result = CFStringFind( mntOpsStr , kDAFileSystemMountArgumentDevice , 0 );
-            containsValue = ( result.location != kCFNotFound ) ? TRUE : FALSE;
-        }
+        CFRelease( __gDAMountPointNextList );
+
+        __gDAMountPointNextList = NULL;
     }
-    else if ( CFEqual( argument , kDAFileSystemMountArgumentOwnership ) )
+
+    __DAMountPointListLoad( );
+
+    pthread_mutex_unlock( &__gDAMountPointListLock );
+}
+
+static const char * __DAMountPointListGetName( const char * path )
+{
+    const char * folder;
+
+    /*
+     * Obtain the name of a mount point made directly under the mount point folder, as seen
+     * from either side of the data volume firmlink.
+     */
+
+    if ( strncmp( path, kDAMainDataVolumeMountPointFolder, strlen( kDAMainDataVolumeMountPointFolder ) ) == 0 )
     {
-        // Only return true if the arguments explicitly asked for "owners"
-        // Not passing "noowners" is not the same as passing "owners"
-        if ( ! ( mntflags & MNT_IGNORE_OWNERSHIP ) )
+        if ( strncmp( path, __gDAMountPointFolder, strlen( __gDAMountPointFolder ) ) )
         {
-            result = CFStringFind( mntOpsStr , kDAFileSystemMountArgumentOwnership , 0 );
-            containsValue = ( result.location != kCFNotFound ) ? TRUE : FALSE;
+            path += strlen( kDAMainDataVolumeMountPointFolder );
         }
     }
-    else if ( CFEqual( argument , kDAFileSystemMountArgumentPermission ) )
+
+    folder = strncmp( path, __gDAMountPointFolder, strlen( __gDAMountPointFolder ) ) ? kDAMainMountPointFolder : __gDAMountPointFolder;
+
+    if ( strncmp( path, folder, strlen( folder ) ) == 0 )
     {
-        // Only return true if the arguments explicitly asked for "perm"
-        // Not passing "noperm" is not the same as passing "perm"
-        if ( ! ( mntflags & MNT_IGNORE_OWNERSHIP ) )
+        path += strlen( folder );
+
+        if ( path[0] == '/' && path[1] && strchr( path + 1, '/' ) == NULL )
         {
-            result = CFStringFind( mntOpsStr , kDAFileSystemMountArgumentPermission , 0 );
-            containsValue = ( result.location != kCFNotFound ) ? TRUE : FALSE;
+            return path + 1;
         }
     }
-    else if ( CFEqual( argument , kDAFileSystemMountArgumentSetUserID ) )
+
+    return NULL;
+}
+
+static CFIndex __DAMountPointListGetNext( const char * base )
+{
+    CFIndex index = 0;
+
+    /*
+     * Obtain the lowest suffix that may still be free for the volume name.  The caller holds
+     * the lock.
+     */
+
+    if ( __gDAMountPointNextList )
     {
-        // Only return true if the arguments explicitly asked for "suid"
-        // Not passing "nosuid" is not the same as passing "suid"
-        if ( ! ( mntflags & MNT_NOSUID ) )
+        CFStringRef key;
+
+        key = CFStringCreateWithCString( kCFAllocatorDefault, base, kCFStringEncodingUTF8 );
+
+        if ( key )
         {
-            result = CFStringFind( mntOpsStr , kDAFileSystemMountArgumentSetUserID , 0 );
-            containsValue = ( result.location != kCFNotFound ) ? TRUE : FALSE;
+            CFNumberRef next;
+
+            next = CFDictionaryGetValue( __gDAMountPointNextList, key );
+
+            if ( next )
+            {
+                CFNumberGetValue( next, kCFNumberCFIndexType, &index );
+            }
+
+            CFRelease( key );
         }
     }
-    
-    freemntopts( mp );
-    free( optionBuffer );
-    
-    return containsValue;
+
+    return index;
 }
 
-/*
- * Given a single string beginning with '-', check if this string matches the following formats;
- * 1. -o (ex. -onoowners, -oowners=-onoowners)
- * 2. -s (ex. -s=/path/to/snapshot)
- * Return the option supplied by -o, or verify that kDAFileSystemMountArgumentSnapshot is found
- * if that is the argument we are searching for.
- */
-static CFStringRef __DAMountGetOpt( CFStringRef optArgStr , CFStringRef argument , Boolean *foundArgument ) {
-    char *argv[2];
-    char *optArgCStr;
-    char opt;
-    int oldOptErr = opterr;
-    CFStringRef argumentToAdd = NULL;
-    Boolean containsValue = FALSE;
-    uint64_t bufSize = CFStringGetMaximumSizeForEncoding( CFStringGetLength( optArgStr ) ,
-                                                          kCFStringEncodingUTF8 );
-    
-    if ( bufSize == kCFNotFound )
-    {
-        bufSize = MAXPATHLEN;
-    }
-    
-    optArgCStr = malloc( bufSize );
-    
-    if ( optArgCStr != NULL )
+static void __DAMountPointListSetNext( const char * base, CFIndex index )
+{
+    CFStringRef key;
+
+    /*
+     * Record the lowest suffix that may still be free for the volume name.  The caller holds
+     * the lock.
+     */
+
+    key = CFStringCreateWithCString( kCFAllocatorDefault, base, kCFStringEncodingUTF8 );
+
+    if ( key )
     {
-        if ( CFStringGetCString( optArgStr , optArgCStr , bufSize ,
-                                 kCFStringEncodingUTF8 ) == FALSE )
+        if ( index )
         {
-            DALogError( "Failed to copy option argument" );
-            free( optArgCStr );
-            return argumentToAdd;
+            CFNumberRef next;
+
+            next = CFNumberCreate( kCFAllocatorDefault, kCFNumberCFIndexType, &index );
+
+            if ( next )
+            {
+                CFDictionarySetValue( __gDAMountPointNextList, key, next );
+
+                CFRelease( next );
+            }
         }
         else
         {
-            argv[0] = optArgCStr;
-            argv[1] = NULL;
-        }
-        
-        optreset = 1;
-        optind = 0;
-        opterr = 0;
-        while ( !containsValue && ( opt = getopt( 1 , argv , "o:s:") ) != -1 )
-        {
-            switch ( opt ) {
-                case 'o':
-                    // Get mount flag
-                    argumentToAdd = CFStringCreateWithCString( kCFAllocatorDefault ,
-                                                               optarg ,
-                                                               kCFStringEncodingUTF8 );
-                    break;
-                case 's':
-                    // Snapshot argument - not a mount flag, but needs to be checked by DA
-                    if ( CFEqual( argument , kDAFileSystemMountArgumentSnapshot ) )
-                    {
-                        containsValue = TRUE;
-                        *foundArgument = containsValue;
-                    }
-                    break;
-                default:
-                    break;
-            }
+            CFDictionaryRemoveValue( __gDAMountPointNextList, key );
         }
-        opterr = oldOptErr;
-        free( optArgCStr );
+
+        CFRelease( key );
     }
-    
-    return argumentToAdd;
 }
 
-/*
- * For a list of arguments in the form of "arg1,arg2,arg3,etc.", find the specified argument.
- * Each argument is expected to take one of the following forms:
- * 1. a single string (ex. noowners, nodev, nofollow)
- * 2. an option string that is accepted for getopt() for the following options:
- *    2a. -o (ex. -onoowners, -oowners=-onoowners)
- *    2b. -s (ex. -s=/path/to/snapshot)
- */
-Boolean DAMountContainsArgument( CFStringRef arguments, CFStringRef argument )
+static Boolean __DAMountPointListContainsName( const char * name )
 {
-    Boolean containsValue = FALSE;
-    CFMutableStringRef mutableArguments = NULL;
-    CFArrayRef argumentList;
-    CFIndex    argumentListCount;
-    CFIndex    argumentListIndex;
-    
-    if ( arguments == NULL )
+    Boolean contains = FALSE;
+
+    pthread_mutex_lock( &__gDAMountPointListLock );
+
+    if ( __gDAMountPointList )
     {
-        return FALSE;
+        CFStringRef string;
+
+        string = CFStringCreateWithCString( kCFAllocatorDefault, name, kCFStringEncodingUTF8 );
+
+        if ( string )
+        {
+            contains = CFSetContainsValue( __gDAMountPointList, string );
+
+            CFRelease( string );
+        }
     }
-    
-    mutableArguments = CFStringCreateMutable( kCFAllocatorDefault , 0 );
-    
-    if ( mutableArguments == NULL )
+
+    pthread_mutex_unlock( &__gDAMountPointListLock );
+
+    return contains;
+}
+
+static void __DAMountPointListAddName( const char * base, CFIndex index, const char * name )
+{
+    pthread_mutex_lock( &__gDAMountPointListLock );
+
+    if ( __gDAMountPointList )
     {
-        return FALSE;
+        CFStringRef string;
+
+        string = CFStringCreateWithCString( kCFAllocatorDefault, name, kCFStringEncodingUTF8 );
+
+        if ( string )
+        {
+            CFSetAddValue( __gDAMountPointList, string );
+
+            CFRelease( string );
+        }
+
+        __DAMountPointListSetNext( base, index + 1 );
     }
-    
-    /* Process each individual argument at a time, separated by comma. */
-    argumentList = CFStringCreateArrayBySeparatingStrings( kCFAllocatorDefault , arguments , CFSTR( "," ) );
 
-    if ( argumentList )
+    pthread_mutex_unlock( &__gDAMountPointListLock );
+}
+
+static void __DAMountPointListRemovePath( const char * path )
+{
+    pthread_mutex_lock( &__gDAMountPointListLock );
+
+    if ( __gDAMountPointList )
     {
-        argumentListCount = CFArrayGetCount( argumentList );
+        const char * name;
 
-        for ( argumentListIndex = 0; !containsValue && argumentListIndex < argumentListCount; argumentListIndex++ )
+        name = __DAMountPointListGetName( path );
+
+        if ( name )
         {
-            CFStringRef currentArgument = CFArrayGetValueAtIndex( argumentList, argumentListIndex );
-            CFStringRef argumentToAdd = NULL;
-            
-            if ( currentArgument != NULL )
-            {
-                /* If this argument starts with a -o or -s, prepare argv to call getopt() */
-                if ( CFStringHasPrefix( currentArgument , CFSTR( "-" ) ) )
-                {
-                    argumentToAdd = __DAMountGetOpt( currentArgument , argument , &containsValue );
-                }
-                else
-                {
-                    /* Add this argument verbatim to the list of mount flags to process */
-                    argumentToAdd = CFStringCreateCopy( kCFAllocatorDefault, currentArgument );
-                }
-            }
-            
-            if ( argumentToAdd != NULL )
+            CFStringRef string;
+
+            string = CFStringCreateWithCString( kCFAllocatorDefault, name, kCFStringEncodingUTF8 );
+
+            if ( string )
             {
-                /* Check for argument mapping '(""/owners/perm)=(noowners/noperm)' */
-                CFStringRef itemOne;
-                CFStringRef itemTwo;
-                CFRange result;
-                Boolean foundNoowners = FALSE;
-                CFArrayRef pair = CFStringCreateArrayBySeparatingStrings( kCFAllocatorDefault ,
-                                                                          argumentToAdd ,
-                                                                          CFSTR( "=" ) );
-                if ( pair != NULL )
+                const char * suffix;
+
+                CFSetRemoveValue( __gDAMountPointList, string );
+
+                CFRelease( string );
+
+                /*
+                 * Bring the next suffix for the volume name back down to the one just freed,
+                 * whether the name carries a suffix or not.
+                 */
+
+                __DAMountPointListSetNext( name, 0 );
+
+                suffix = strrchr( name, ' ' );
+
+                if ( suffix && suffix[1] && strspn( suffix + 1, "0123456789" ) == strlen( suffix + 1 ) && suffix[1] != '0' )
                 {
-                    /*
-                     * Check if the first string is "", "owners", "perm"
-                     * and the second string is "noowners" or "noperm".
-                     * Treat this argument as "noowners".
-                     */
-                    if ( CFArrayGetCount( pair ) == 2 )
+                    char    base[MAXPATHLEN];
+                    CFIndex index;
+
+                    index = strtol( suffix + 1, NULL, 10 );
+
+                    strlcpy( base, name, MIN( sizeof( base ), ( size_t ) ( suffix - name + 1 ) ) );
+
+                    if ( index < __DAMountPointListGetNext( base ) )
                     {
-                        itemOne = CFArrayGetValueAtIndex( pair , 0 );
-                        itemTwo = CFArrayGetValueAtIndex( pair , 1 );
-                        
-                        if ( CFStringGetLength( itemOne ) == 0
-                             || ! CFStringCompare( itemOne ,
-                                                   kDAFileSystemMountArgumentOwnership ,
-                                                   kCFCompareCaseInsensitive )
-                             || ! CFStringCompare( itemOne ,
-                                                   kDAFileSystemMountArgumentPermission ,
-                                                   kCFCompareCaseInsensitive ) )
-                        {
-                            result = CFStringFind( itemTwo , kDAFileSystemMountArgumentNoOwnership , 0 );
-                            foundNoowners = ( result.location != kCFNotFound );
-                            
-                            if ( ! foundNoowners )
-                            {
-                                result = CFStringFind( itemTwo , kDAFileSystemMountArgumentNoPermission , 0 );
-                                foundNoowners = ( result.location != kCFNotFound );
-                            }
-                            
-                            if ( foundNoowners )
-                            {
-                                CFRelease( argumentToAdd );
-                                argumentToAdd = CFStringCreateCopy( kCFAllocatorDefault ,
-                                                                    kDAFileSystemMountArgumentNoOwnership );
-                            }
-                        }
+                        __DAMountPointListSetNext( base, index );
                     }
-                    CFRelease( pair );
-                }
-                
-                /* If this is not the first argument, separate with a comma */
-                if ( CFStringGetLength( mutableArguments ) > 0 )
-                {
-                    CFStringAppend( mutableArguments , CFSTR(",") );
                 }
-                CFStringAppend( mutableArguments , argumentToAdd );
-                CFRelease( argumentToAdd );
             }
         }
-        
-        CFRelease( argumentList );
-    }
-    
-    /* Updated argument string now only contains comma separated string suitable for getmntopts() */
-    if ( !containsValue && CFStringGetLength( mutableArguments ) > 0 )
-    {
-        containsValue = __DAMountCheckMntOptsForString( mutableArguments , argument );
     }
-        
-    CFRelease( mutableArguments );
-    
-    return containsValue;
+
+    pthread_mutex_unlock( &__gDAMountPointListLock );
 }
 
 CFURLRef DAMountCreateMountPoint( DADiskRef disk )
@@ -727,7 +1041,8 @@ CFURLRef DAMountCreateMountPointWithAction( DADiskRef disk, DAMountPointAction a
     CFURLRef    mountpoint;
     char        name[MAXPATHLEN];
     char        path[MAXPATHLEN];
-    char        realMainMountPoint[MAXPATHLEN];
+    char        bypath[MAXPATHLEN];
+    Boolean     reloaded;
     CFStringRef string;
 
     mountpoint = NULL;
@@ -768,22 +1083,86 @@ CFURLRef DAMountCreateMountPointWithAction( DADiskRef disk, DAMountPointAction a
         }
 
         /*
-         * Create the mount point path.
+         * Create the mount point path.  The names in use under the mount point folder are
+         * looked up in the index, starting from the lowest suffix that may still be free, so
+         * that the names already taken are passed over without a trip to the file system.
          */
 
-        if ( NULL == realpath( kDAMainMountPointFolder, realMainMountPoint) )
+        pthread_mutex_lock( &__gDAMountPointListLock );
+
+        if ( __DAMountPointListLoad( ) == FALSE )
         {
+            pthread_mutex_unlock( &__gDAMountPointListLock );
+
+            CFRelease( string );
+
             goto exit;
         }
-        for ( index = 0; index < 100; index++ )
+
+        index = ( action == kDAMountPointActionNone ) ? 0 : __DAMountPointListGetNext( name );
+
+        pthread_mutex_unlock( &__gDAMountPointListLock );
+
+        reloaded = FALSE;
+
+        bypath[0] = 0;
+
+        if ( action == kDAMountPointActionMove && DADiskGetBypath( disk ) )
+        {
+            if ( CFURLGetFileSystemRepresentation( DADiskGetBypath( disk ), TRUE, ( void * ) bypath, sizeof( bypath ) ) == FALSE )
+            {
+                bypath[0] = 0;
+            }
+        }
+
+        for ( ; ; index++ )
         {
+            int error = 0;
+
+            if ( index >= __kDAMountPointIndexLimit )
+            {
+                /*
+                 * The index may still hold names that were removed behind our back, so rebuild it
+                 * and look again from the lowest suffix before giving up.
+                 */
+
+                if ( reloaded )
+                {
+                    break;
+                }
+
+                __DAMountPointListReload( );
+
+                reloaded = TRUE;
+
+                index = 0;
+            }
+
             if ( index == 0 )
             {
-                snprintf( path, sizeof( path ), "%s/%s", realMainMountPoint, name );
+                snprintf( path, sizeof( path ), "%s/%s", __gDAMountPointFolder, name );
             }
             else
             {
-                snprintf( path, sizeof( path ), "%s/%s %lu", realMainMountPoint, name, index );
+                snprintf( path, sizeof( path ), "%s/%s %lu", __gDAMountPointFolder, name, index );
+            }
+
+            if ( action != kDAMountPointActionNone )
+            {
+                /*
+                 * A name in the index is taken, and is skipped without a trip to the file system,
+                 * except that a mount point that is moved may land back where it already is.  A
+                 * name not in the index goes on to be made, and any leftover in its way is dealt
+                 * with there.
+                 */
+
+                if ( __DAMountPointListContainsName( strrchr( path, '/' ) + 1 ) )
+                {
+                    if ( strcmp( path, bypath ) )
+                    {
+                        continue;
+                    }
+                }
             }
 
             switch ( action )
@@ -808,6 +1187,10 @@ CFURLRef DAMountCreateMountPointWithAction( DADiskRef disk, DAMountPointAction a
                             {
                                 mountpoint = CFURLCreateFromFileSystemRepresentation( kCFAllocatorDefault, ( void * ) path, strlen( path ), TRUE );
                             }
+                            else
+                            {
+                                error = errno;
+                            }
                         }
                     }
 
@@ -818,25 +1201,36 @@ CFURLRef DAMountCreateMountPointWithAction( DADiskRef disk, DAMountPointAction a
                     /*
                      * Create the mount point.
                      */
-///w:start
-                    struct statfs fs     = { 0 };
-                    int status = statfs( path, &fs );
 
-                    if (status == 0 && strncmp( fs.f_mntonname, kDAMainDataVolumeMountPointFolder, strlen( kDAMainDataVolumeMountPointFolder ) ) == 0 )
+                    if ( mkdir( path, 0111 ) )
                     {
-                        mountpoint = CFURLCreateFromFileSystemRepresentation( kCFAllocatorDefault, ( void * ) path, strlen( path ), TRUE );
-                        if ( mountpoint )
+                        error = errno;
+///w:start
+                        if ( error == EEXIST )
                         {
-                            if ( ___CFArrayContainsValue(gDAMountPointList, mountpoint) == FALSE )
+                            struct statfs fs     = { 0 };
+                            int status = statfs( path, &fs );
+
+                            if (status == 0 && strncmp( fs.f_mntonname, kDAMainDataVolumeMountPointFolder, strlen( kDAMainDataVolumeMountPointFolder ) ) == 0 )
                             {
-                                DAMountRemoveMountPoint( mountpoint );
+                                mountpoint = CFURLCreateFromFileSystemRepresentation( kCFAllocatorDefault, ( void * ) path, strlen( path ), TRUE );
+                                if ( mountpoint )
+                                {
+                                    if ( ___CFArrayContainsValue(gDAMountPointList, mountpoint) == FALSE )
+                                    {
+                                        DAMountRemoveMountPoint( mountpoint );
+                                    }
+                                    CFRelease ( mountpoint );
+                                    mountpoint = NULL;
+                                }
+
+                                error = mkdir( path, 0111 ) ? errno : 0;
                             }
-                            CFRelease ( mountpoint );
-                            mountpoint = NULL;
                         }
-                    }
 ///w:stop
-                    if ( mkdir( path, 0111 ) == 0 )
+                    }
+
+                    if ( error == 0 )
                     {
                         if ( DADiskGetUserUID( disk ) )
                         {
@@ -854,20 +1248,19 @@ CFURLRef DAMountCreateMountPointWithAction( DADiskRef disk, DAMountPointAction a
                      * Move the mount point.
                      */
 
-                    CFURLRef url;
-
-                    url = DADiskGetBypath( disk );
-
-                    if ( url )
+                    if ( bypath[0] )
                     {
-                        char source[MAXPATHLEN];
-
-                        if ( CFURLGetFileSystemRepresentation( url, TRUE, ( void * ) source, sizeof( source ) ) &&
-                            strncmp( source, kDAMainMountPointFolder, strlen( kDAMainMountPointFolder ) ) == 0 )
+                        if ( strncmp( bypath, kDAMainMountPointFolder, strlen( kDAMainMountPointFolder ) ) == 0 )
                         {
-                            if ( renamex_np( source, path , RENAME_NOFOLLOW_ANY) == 0 )
+                            if ( renamex_np( bypath, path , RENAME_NOFOLLOW_ANY) == 0 )
                             {
                                 mountpoint = CFURLCreateFromFileSystemRepresentation( kCFAllocatorDefault, ( void * ) path, strlen( path ), TRUE );
+
+                                __DAMountPointListRemovePath( bypath );
+                            }
+                            else
+                            {
+                                error = errno;
                             }
                         }
                     }
@@ -884,8 +1277,32 @@ CFURLRef DAMountCreateMountPointWithAction( DADiskRef disk, DAMountPointAction a
 
             if ( mountpoint )
             {
+                if ( action != kDAMountPointActionNone )
+                {
+                    __DAMountPointListAddName( name, index, strrchr( path, '/' ) + 1 );
+                }
+
                 break;
             }
+
+            if ( error == EEXIST || error == ENOTEMPTY )
+            {
+                /*
+                 * The name was taken behind our back, so the index is out of date.  It is rebuilt
+                 * from the folder the first time, and the name merely recorded after that.
+                 */
+
+                if ( reloaded )
+                {
+                    __DAMountPointListAddName( name, index, strrchr( path, '/' ) + 1 );
+                }
+                else
+                {
+                    __DAMountPointListReload( );
+
+                    reloaded = TRUE;
+                }
+            }
         }
     }
 
@@ -898,7 +1315,10 @@ exit:
 
 Boolean DAMountGetPreference( DADiskRef disk, DAMountPreference preference )
 {
-    CFBooleanRef value;
+    CFDictionaryRef preferences;
+    CFBooleanRef    value;
+
+    preferences = DAPreferenceListCopy( );
 
     switch ( preference )
     {
@@ -910,7 +1330,7 @@ Boolean DAMountGetPreference( DADiskRef disk, DAMountPreference preference )
 
             if ( DADiskGetDescription( disk, kDADiskDescriptionMediaRemovableKey ) == kCFBooleanTrue )
             {
-                value = CFDictionaryGetValue( gDAPreferenceList, kDAPreferenceMountDeferRemovableKey );
+                value = CFDictionaryGetValue( preferences, kDAPreferenceMountDeferRemovableKey );
 
                 value = value ? value : kCFBooleanTrue;
             }
@@ -922,13 +1342,13 @@ Boolean DAMountGetPreference( DADiskRef disk, DAMountPreference preference )
 
                 if ( DADiskGetDescription( disk, kDADiskDescriptionDeviceInternalKey ) == kCFBooleanTrue )
                 {
-                    value = CFDictionaryGetValue( gDAPreferenceList, kDAPreferenceMountDeferInternalKey );
+                    value = CFDictionaryGetValue( preferences, kDAPreferenceMountDeferInternalKey );
 
                     value = value ? value : kCFBooleanFalse;
                 }
                 else
                 {
-                    value = CFDictionaryGetValue( gDAPreferenceList, kDAPreferenceMountDeferExternalKey );
+                    value = CFDictionaryGetValue( preferences, kDAPreferenceMountDeferExternalKey );
 
                     value = value ? value : kCFBooleanTrue;
                 }
@@ -944,7 +1364,7 @@ Boolean DAMountGetPreference( DADiskRef disk, DAMountPreference preference )
 
             if ( DADiskGetDescription( disk, kDADiskDescriptionMediaRemovableKey ) == kCFBooleanTrue )
             {
-                value = CFDictionaryGetValue( gDAPreferenceList, kDAPreferenceMountTrustRemovableKey );
+                value = CFDictionaryGetValue( preferences, kDAPreferenceMountTrustRemovableKey );
 
                 value = value ? value : kCFBooleanFalse;
             }
@@ -956,13 +1376,13 @@ Boolean DAMountGetPreference( DADiskRef disk, DAMountPreference preference )
 
                 if ( DADiskGetDescription( disk, kDADiskDescriptionDeviceInternalKey ) == kCFBooleanTrue )
                 {
-                    value = CFDictionaryGetValue( gDAPreferenceList, kDAPreferenceMountTrustInternalKey );
+                    value = CFDictionaryGetValue( preferences, kDAPreferenceMountTrustInternalKey );
 
                     value = value ? value : kCFBooleanTrue;
                 }
                 else
                 {
-                    value = CFDictionaryGetValue( gDAPreferenceList, kDAPreferenceMountTrustExternalKey );
+                    value = CFDictionaryGetValue( preferences, kDAPreferenceMountTrustExternalKey );
 
                     value = value ? value : kCFBooleanFalse;
                 }
@@ -976,7 +1396,7 @@ Boolean DAMountGetPreference( DADiskRef disk, DAMountPreference preference )
             * Determine whether auto mounts are allowed
             */
 
-            value = CFDictionaryGetValue( gDAPreferenceList, kDAPreferenceAutoMountDisableKey );
+            value = CFDictionaryGetValue( preferences, kDAPreferenceAutoMountDisableKey );
 #if TARGET_OS_OSX
             value = value ? value : kCFBooleanFalse;
 #else
@@ -993,7 +1413,7 @@ Boolean DAMountGetPreference( DADiskRef disk, DAMountPreference preference )
 #if TARGET_OS_IOS
             if ( DADiskGetDescription( disk, kDADiskDescriptionDeviceInternalKey ) == kCFBooleanFalse )
             {
-                value = CFDictionaryGetValue( gDAPreferenceList, kDAPreferenceEnableUserFSMountExternalKey );
+                value = CFDictionaryGetValue( preferences, kDAPreferenceEnableUserFSMountExternalKey );
 
                 value = value ? value : kCFBooleanTrue;
             }
@@ -1001,13 +1421,13 @@ Boolean DAMountGetPreference( DADiskRef disk, DAMountPreference preference )
             {
                 if ( DADiskGetDescription( disk, kDADiskDescriptionDeviceInternalKey ) == kCFBooleanTrue )
                 {
-                    value = CFDictionaryGetValue( gDAPreferenceList, kDAPreferenceEnableUserFSMountInternalKey );
+                    value = CFDictionaryGetValue( preferences, kDAPreferenceEnableUserFSMountInternalKey );
 
                     value = value ? value : kCFBooleanFalse;
                 }
                 else
                 {
-                    value = CFDictionaryGetValue( gDAPreferenceList, kDAPreferenceEnableUserFSMountRemovableKey );
+                    value = CFDictionaryGetValue( preferences, kDAPreferenceEnableUserFSMountRemovableKey );
 
                     value = value ? value : kCFBooleanFalse;
                 }
@@ -1025,7 +1445,7 @@ Boolean DAMountGetPreference( DADiskRef disk, DAMountPreference preference )
             * Determine whether we should always run fsck when mounting - used for testing
             */
 
-            value = CFDictionaryGetValue( gDAPreferenceList, kDAPreferenceMountAlwaysRepairKey );
+            value = CFDictionaryGetValue( preferences, kDAPreferenceMountAlwaysRepairKey );
 
             value = value ? value : kCFBooleanFalse;
 
@@ -1040,6 +1460,8 @@ Boolean DAMountGetPreference( DADiskRef disk, DAMountPreference preference )
         }
     }
 
+    CFRelease( preferences );
+
     assert( value );
 
     return CFBooleanGetValue( value );
@@ -1101,10 +1523,19 @@ void DAMountRemoveMountPoint( CFURLRef mountpoint )
                  * Remove the mount point.
                  */
 
-                int status = rmdir( path );
+                int status = rmdir( path ) ? errno : 0;
                 if (status != 0)
                 {
-                    DALogInfo( "rmdir failed to remove path %s with status %d.", path, errno );
+                    DALogInfo( "rmdir failed to remove path %s with status %d.", path, status );
+                }
+
+                /*
+                 * Release the name in the mount point index, unless it is still there.
+                 */
+
+                if ( status == 0 || status == ENOENT )
+                {
+                    __DAMountPointListRemovePath( path );
                 }
             }
         }
@@ -1125,12 +1556,11 @@ void DAMountWithArguments( DADiskRef disk, CFURLRef mountpoint, DAMountCallback
     CFBooleanRef               automatic  = kCFBooleanTrue;
     CFBooleanRef               check      = NULL;
     __DAMountCallbackContext * context    = NULL;
-    CFIndex                    count      = 0;
     DAFileSystemRef            filesystem = DADiskGetFileSystem( disk );
     Boolean                    force      = FALSE;
-    CFIndex                    index      = 0;
     CFDictionaryRef            map        = NULL;
-    CFMutableStringRef         options    = NULL;
+    __DAMountOptions           options    = { 0 };
+    CFStringRef                optString  = NULL;
     int                        status     = 0;
     CFURLRef                   devicePath = NULL;
 
@@ -1160,9 +1590,7 @@ void DAMountWithArguments( DADiskRef disk, CFURLRef mountpoint, DAMountCallback
      * Prepare the mount options.
      */
 
-    options = CFStringCreateMutable( kCFAllocatorDefault, 0 );
-
-    if ( options == NULL )
+    if ( __DAMountOptionsCreate( &options ) == FALSE )
     {
         status = ENOMEM;
 
@@ -1185,14 +1613,12 @@ void DAMountWithArguments( DADiskRef disk, CFURLRef mountpoint, DAMountCallback
         }
         else
         {
-            CFStringAppend( options, argument );
-            CFStringAppend( options, CFSTR( "," ) );
+            __DAMountOptionsAppend( &options, argument );
         }
     }
 
     va_end( arguments );
 
-    CFStringTrim( options, CFSTR( "," ) );
 ///w:start
     context->automatic = ( automatic == NULL ) ? TRUE : FALSE;
 ///w:stop
@@ -1232,9 +1658,7 @@ void DAMountWithArguments( DADiskRef disk, CFURLRef mountpoint, DAMountCallback
             Boolean noRolePresent =   ( DAAPFSNoVolumeRole ( disk ) == TRUE );
             if ( isSystem == TRUE )
             {
-                CFStringInsert( options, 0, CFSTR( "," ) );
-                CFStringInsert( options, 0, kDAFileSystemMountArgumentNoWrite );
-
+                __DAMountOptionsAppendDefault( &options, kDAFileSystemMountArgumentNoWrite );
             }
             
             /*
@@ -1243,8 +1667,7 @@ void DAMountWithArguments( DADiskRef disk, CFURLRef mountpoint, DAMountCallback
 #if TARGET_OS_OSX
             if ( os_variant_is_basesystem( "com.apple.diskarbitrationd" ) && ( ( isSystem == TRUE ) || ( noRolePresent == TRUE ) ) )
             {
-                CFStringInsert( options, 0, CFSTR( "," ) );
-                CFStringInsert( options, 0, kDAFileSystemMountArgumentNoBrowse );
+                __DAMountOptionsAppendDefault( &options, kDAFileSystemMountArgumentNoBrowse );
             }
 #endif
         }
@@ -1255,15 +1678,14 @@ void DAMountWithArguments( DADiskRef disk, CFURLRef mountpoint, DAMountCallback
     */
     if ( ( context->automatic == TRUE ) && ( DADiskGetState( disk, _kDADiskStateMountQuarantined ) ) )
     {
-        CFStringInsert( options, 0, CFSTR( "," ) );
-        CFStringInsert( options, 0, CFSTR( "quarantine" ) );
+        __DAMountOptionsAppendDefault( &options, CFSTR( "quarantine" ) );
     }
     
     /*
      * Determine whether the volume is to be updated.
      */
 
-    if ( DAMountContainsArgument( options, kDAFileSystemMountArgumentUpdate ) )
+    if ( __DAMountOptionsContains( &options, __kDAMountOptionUpdate ) )
     {
         if ( mountpoint )
         {
@@ -1284,7 +1706,7 @@ void DAMountWithArguments( DADiskRef disk, CFURLRef mountpoint, DAMountCallback
         CFRetain( mountpoint );
     }
 
-    if ( DAMountContainsArgument( options, kDAFileSystemMountArgumentSnapshot ) )
+    if ( __DAMountOptionsContains( &options, __kDAMountOptionSnapshot ) )
     {
         if ( mountpoint == NULL )
         {
@@ -1309,80 +1731,16 @@ void DAMountWithArguments( DADiskRef disk, CFURLRef mountpoint, DAMountCallback
     }
 
     /*
-     * Scan the mount map list.
+     * Look up the mount map list.
      */
 
-    count = CFArrayGetCount( gDAMountMapList1 );
-
-    for ( index = 0; index < count; index++ )
-    {
-        map = CFArrayGetValueAtIndex( gDAMountMapList1, index );
-
-        if ( map )
-        {
-            CFTypeRef   id;
-            CFStringRef kind;
-
-            id   = CFDictionaryGetValue( map, kDAMountMapProbeIDKey );
-            kind = CFDictionaryGetValue( map, kDAMountMapProbeKindKey );
-
-            if ( kind )
-            {
-                /*
-                 * Determine whether the volume kind matches.
-                 */
-
-                if ( CFEqual( kind, DAFileSystemGetKind( filesystem ) ) == FALSE )
-                {
-                    continue;
-                }
-            }
-
-            if ( CFGetTypeID( id ) == CFUUIDGetTypeID( ) )
-            {
-                /*
-                 * Determine whether the volume UUID matches.
-                 */
-
-                if ( DADiskCompareDescription( disk, kDADiskDescriptionVolumeUUIDKey, id ) == kCFCompareEqualTo )
-                {
-                    break;
-                }
-            }
-            else if ( CFGetTypeID( id ) == CFStringGetTypeID( ) )
-            {
-                /*
-                 * Determine whether the volume name matches.
-                 */
-
-                if ( DADiskCompareDescription( disk, kDADiskDescriptionVolumeNameKey, id ) == kCFCompareEqualTo )
-                {
-                    break;
-                }
-            }
-            else if ( CFGetTypeID( id ) == CFDictionaryGetTypeID( ) )
-            {
-                boolean_t match = FALSE;
-
-                /*
-                 * Determine whether the device description matches.
-                 */
-
-                IOServiceMatchPropertyTable( DADiskGetIOMedia( disk ), id, &match );
-
-                if ( match )
-                {
-                    break;
-                }
-            }
-        }
-    }
+    map = DAMountMapListGetMatch1( disk, filesystem );
 
     /*
      * Process the map.
      */
 
-    if ( index < count )
+    if ( map )
     {
         CFStringRef string;
 
@@ -1409,8 +1767,7 @@ void DAMountWithArguments( DADiskRef disk, CFURLRef mountpoint, DAMountCallback
 
         if ( string )
         {
-            CFStringInsert( options, 0, CFSTR( "," ) );
-            CFStringInsert( options, 0, string );
+            __DAMountOptionsAppendDefault( &options, string );
         }
 
         /*
@@ -1429,37 +1786,16 @@ void DAMountWithArguments( DADiskRef disk, CFURLRef mountpoint, DAMountCallback
     }
 
     /*
-     * Scan the mount map list.
+     * Look up the mount map list.
      */
 
-    count = CFArrayGetCount( gDAMountMapList2 );
-
-    for ( index = 0; index < count; index++ )
-    {
-        map = CFArrayGetValueAtIndex( gDAMountMapList2, index );
-
-        if ( map )
-        {
-            CFTypeRef id;
-
-            id = CFDictionaryGetValue( map, kDAMountMapProbeIDKey );
-
-            /*
-             * Determine whether the volume UUID matches.
-             */
-
-            if ( DADiskCompareDescription( disk, kDADiskDescriptionVolumeUUIDKey, id ) == kCFCompareEqualTo )
-            {
-                break;
-            }
-        }
-    }
+    map = DAMountMapListGetMatch2( disk );
 
     /*
      * Process the map.
      */
 
-    if ( index < count )
+    if ( map )
     {
         CFStringRef string;
 
@@ -1471,8 +1807,7 @@ void DAMountWithArguments( DADiskRef disk, CFURLRef mountpoint, DAMountCallback
 
         if ( string )
         {
-            CFStringInsert( options, 0, CFSTR( "," ) );
-            CFStringInsert( options, 0, string );
+            __DAMountOptionsAppendDefault( &options, string );
         }
     }
 
@@ -1525,57 +1860,59 @@ void DAMountWithArguments( DADiskRef disk, CFURLRef mountpoint, DAMountCallback
 
     if ( DADiskGetDescription( disk, kDADiskDescriptionMediaWritableKey ) == kCFBooleanFalse )
     {
-        CFStringInsert( options, 0, CFSTR( "," ) );
-        CFStringInsert( options, 0, kDAFileSystemMountArgumentNoWrite );
+        __DAMountOptionsAppendDefault( &options, kDAFileSystemMountArgumentNoWrite );
     }
 
     if ( DAMountGetPreference( disk, kDAMountPreferenceTrust ) == FALSE )
     {
-        CFStringInsert( options, 0, CFSTR( "," ) );
-        CFStringInsert( options, 0, kDAFileSystemMountArgumentNoSetUserID );
-
-        CFStringInsert( options, 0, CFSTR( "," ) );
-        CFStringInsert( options, 0, kDAFileSystemMountArgumentNoOwnership );
-
-        CFStringInsert( options, 0, CFSTR( "," ) );
-        CFStringInsert( options, 0, kDAFileSystemMountArgumentNoDevice );
+        __DAMountOptionsAppendDefault( &options, kDAFileSystemMountArgumentNoSetUserID );
+        __DAMountOptionsAppendDefault( &options, kDAFileSystemMountArgumentNoOwnership );
+        __DAMountOptionsAppendDefault( &options, kDAFileSystemMountArgumentNoDevice );
     }
     
 ///w:start
     if ( CFEqual( DAFileSystemGetKind( filesystem ), CFSTR( "hfs" ) ) )
     {
-        ___CFStringInsertFormat( options, 0, CFSTR( "-m=%o," ), 0755 );
+        CFStringRef string;
 
-        if ( DADiskGetUserGID( disk ) )
-        {
-            ___CFStringInsertFormat( options, 0, CFSTR( "-g=%d," ), DADiskGetUserGID( disk ) );
-        }
-        else
-        {
-            ___CFStringInsertFormat( options, 0, CFSTR( "-g=%d," ), ___GID_UNKNOWN );
-        }
+        string = CFStringCreateWithFormat( kCFAllocatorDefault,
+                                           NULL,
+                                           CFSTR( "-u=%d,-g=%d,-m=%o" ),
+                                           DADiskGetUserUID( disk ) ? DADiskGetUserUID( disk ) : ___UID_UNKNOWN,
+                                           DADiskGetUserGID( disk ) ? DADiskGetUserGID( disk ) : ___GID_UNKNOWN,
+                                           0755 );
 
-        if ( DADiskGetUserUID( disk ) )
-        {
-            ___CFStringInsertFormat( options, 0, CFSTR( "-u=%d," ), DADiskGetUserUID( disk ) );
-        }
-        else
+        if ( string )
         {
-            ___CFStringInsertFormat( options, 0, CFSTR( "-u=%d," ), ___UID_UNKNOWN );
+            __DAMountOptionsAppendDefault( &options, string );
+
+            CFRelease( string );
         }
     }
 ///w:stop
 
-    CFStringTrim( options, CFSTR( "," ) );
-    
-    DALogInfo(" Mount options %@", options);
+    /*
+     * Render the mount options for the mount command, which is the only time they are turned
+     * into a string.
+     */
+
+    optString = __DAMountOptionsCopyString( &options );
+
+    if ( optString == NULL )
+    {
+        status = ENOMEM;
+
+        goto DAMountWithArgumentsErr;
+    }
+
+    DALogInfo(" Mount options %@", optString);
     /*
      * Determine whether the volume is to be repaired.
      */
 
     if ( check == NULL )
     {
-        if ( DAMountContainsArgument( options, kDAFileSystemMountArgumentNoWrite ) )
+        if ( __DAMountOptionsContains( &options, __kDAMountOptionNoWrite ) )
         {
             check = kCFBooleanFalse;
         }
@@ -1624,7 +1961,7 @@ void DAMountWithArguments( DADiskRef disk, CFURLRef mountpoint, DAMountCallback
     context->disk            = disk;
     context->force           = force;
     context->mountpoint      = mountpoint;
-    context->options         = options;
+    context->options         = optString;
     context->devicePath      = devicePath;
     context->contDisk        = NULL;
     context->fd              = -1;
@@ -1703,9 +2040,9 @@ DAMountWithArgumentsErr:
             CFRelease( mountpoint );
         }
 
-        if ( options )
+        if ( optString )
         {
-            CFRelease( options );
+            CFRelease( optString );
         }
 
         if ( callback )
@@ -1713,4 +2050,6 @@ DAMountWithArgumentsErr:
             ( callback )( status, NULL, callbackContext );
         }
     }
+
+    __DAMountOptionsRelease( &options );
 }
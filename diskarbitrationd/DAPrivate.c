@@ -89,7 +89,7 @@ __DAFileSystemSetAdoptionErr:
     return status;
 }
 
-DAReturn _DADiskRefresh( DADiskRef disk )
+DAReturn _DADiskRefresh( DADiskRef disk, CFDictionaryRef volumes )
 {
     DAReturn status;
 
@@ -97,21 +97,11 @@ DAReturn _DADiskRefresh( DADiskRef disk )
 
     if ( DADiskGetDescription( disk, kDADiskDescriptionVolumePathKey ) )
     {
-        struct statfs * mountList;
-        int             mountListCount;
-        int             mountListIndex;
+        const struct statfs * fs;
 
-        mountListCount = getmntinfo( &mountList, MNT_NOWAIT );
+        fs = DAVolumeListGetVolume( volumes, DADiskGetID( disk ) );
 
-        for ( mountListIndex = 0; mountListIndex < mountListCount; mountListIndex++ )
-        {
-            if ( strcmp( _DAVolumeGetID( mountList + mountListIndex ), DADiskGetID( disk ) ) == 0 )
-            {
-                break;
-            }
-        }
-
-        if ( mountListIndex < mountListCount )
+        if ( fs )
         {
             CFMutableArrayRef keys;
 
@@ -121,7 +111,7 @@ DAReturn _DADiskRefresh( DADiskRef disk )
             {
                 CFTypeRef object;
 ///w:start
-                if ( strcmp( mountList[mountListIndex].f_fstypename, "hfs" ) == 0 )
+                if ( strcmp( fs->f_fstypename, "hfs" ) == 0 )
                 {
                     object = _FSCopyNameForVolumeFormatAtURL( DADiskGetDescription( disk, kDADiskDescriptionVolumePathKey ) );
 
@@ -144,8 +134,8 @@ DAReturn _DADiskRefresh( DADiskRef disk )
                  */
                 CFURLRef path;
                 path = CFURLCreateFromFileSystemRepresentation( kCFAllocatorDefault,
-                                                                ( void * ) mountList[mountListIndex].f_mntonname,
-                                                                strlen( mountList[mountListIndex].f_mntonname ),
+                                                                ( void * ) fs->f_mntonname,
+                                                                strlen( fs->f_mntonname ),
                                                                 TRUE );
                 if ( path )
                 {
@@ -161,7 +151,7 @@ DAReturn _DADiskRefresh( DADiskRef disk )
                                 char source[MAXPATHLEN];
                                 if (CFURLGetFileSystemRepresentation( danglingPath, TRUE, ( void * ) source, sizeof( source ) ) )
                                 {
-                                    if (strncmp( mountList[mountListIndex].f_mntonname, source, strlen( source ) ) == 0 )
+                                    if (strncmp( fs->f_mntonname, source, strlen( source ) ) == 0 )
                                     {
                                         DALogInfo("dangling mountpoint present ignore mountpoint %@", disk);
                                         ignoreMount = true;
@@ -295,27 +285,17 @@ DAReturn _DADiskRefresh( DADiskRef disk )
     }
     else
     {
-        struct statfs * mountList;
-        int             mountListCount;
-        int             mountListIndex;
+        const struct statfs * fs;
 
-        mountListCount = getmntinfo( &mountList, MNT_NOWAIT );
-
-        for ( mountListIndex = 0; mountListIndex < mountListCount; mountListIndex++ )
-        {
-            if ( strcmp( _DAVolumeGetID( mountList + mountListIndex ), DADiskGetID( disk ) ) == 0 )
-            {
-                break;
-            }
-        }
+        fs = DAVolumeListGetVolume( volumes, DADiskGetID( disk ) );
 
-        if ( mountListIndex < mountListCount )
+        if ( fs )
         {
             CFURLRef path;
 
             path = CFURLCreateFromFileSystemRepresentation( kCFAllocatorDefault,
-                                                            ( void * ) mountList[mountListIndex].f_mntonname,
-                                                            strlen( mountList[mountListIndex].f_mntonname ),
+                                                            ( void * ) fs->f_mntonname,
+                                                            strlen( fs->f_mntonname ),
                                                             TRUE );
 
             if ( path )
@@ -41,7 +41,7 @@ struct __DADiskEncryptionContext
 
 typedef struct __DADiskEncryptionContext __DADiskEncryptionContext;
 
-extern DAReturn _DADiskRefresh( DADiskRef disk );
+extern DAReturn _DADiskRefresh( DADiskRef disk, CFDictionaryRef volumes );
 
 extern DAReturn _DADiskSetAdoption( DADiskRef disk, Boolean adoption );
 
@@ -262,6 +262,7 @@ void DAProbe( DADiskRef disk, DADiskRef containerDisk, DAProbeCallback callback,
 
     CFMutableArrayRef          candidates = NULL;
     __DAProbeCallbackContext * context    = NULL;
+    CFArrayRef                 probeList;
     CFNumberRef                size       = NULL;
     int                        status     = 0;
 
@@ -298,7 +299,11 @@ void DAProbe( DADiskRef disk, DADiskRef containerDisk, DAProbeCallback callback,
      * Prepare the probe candidates.
      */
 
-    candidates = CFArrayCreateMutableCopy( kCFAllocatorDefault, 0, gDAFileSystemProbeList );
+    probeList = DAFileSystemProbeListCopy( );
+
+    candidates = CFArrayCreateMutableCopy( kCFAllocatorDefault, 0, probeList );
+
+    CFRelease( probeList );
 
     if ( candidates == NULL )
     {
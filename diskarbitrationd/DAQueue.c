@@ -33,6 +33,8 @@
 #include "DAStage.h"
 #include "DAServer.h"
 
+#include <errno.h>
+
 struct __DAResponseContext
 {
     DAResponseCallback callback;
@@ -47,6 +49,77 @@ const int32_t __kDAResponseTimerLimit = 10;
 
 static void __DAResponseTimerRefresh( void );
 
+static void __DADiskListAdvance( DADiskRef disk )
+{
+    /*
+     * Stamp the disk with a new disk list generation.
+     */
+
+    gDADiskListGeneration++;
+
+    DADiskSetListGeneration( disk, gDADiskListGeneration );
+}
+
+static CFArrayRef __DADiskListRemovalCreate( DADiskRef disk )
+{
+    CFDataRef   id;
+    CFNumberRef generation;
+    CFArrayRef  removal = NULL;
+    CFDataRef   serialization;
+    UInt64      value;
+
+    /*
+     * Remember no more of the disk than its identifier, its disk list generation and its
+     * serialization, so that a removal does not hold on to the disk and its I/O Kit objects.
+     */
+
+    value = DADiskGetListGeneration( disk );
+
+    id            = CFDataCreate( kCFAllocatorDefault, ( void * ) DADiskGetID( disk ), strlen( DADiskGetID( disk ) ) + 1 );
+    generation    = CFNumberCreate( kCFAllocatorDefault, kCFNumberSInt64Type, &value );
+    serialization = DADiskGetSerialization( disk );
+
+    if ( id && generation && serialization )
+    {
+        CFTypeRef values[3];
+
+        values[_kDADiskListRemovalID           ] = id;
+        values[_kDADiskListRemovalGeneration   ] = generation;
+        values[_kDADiskListRemovalSerialization] = serialization;
+
+        removal = CFArrayCreate( kCFAllocatorDefault, values, 3, &kCFTypeArrayCallBacks );
+    }
+
+    if ( id         )  CFRelease( id );
+    if ( generation )  CFRelease( generation );
+
+    return removal;
+}
+
+static void __DADiskListRemovalMatch( const void * key, const void * value, void * context )
+{
+    CFDictionaryRef description = *( ( void * * ) context );
+
+    if ( description )
+    {
+        /*
+         * The media of a removed disk is gone, so a match against its properties is taken as met.
+         */
+
+        if ( CFEqual( key, kDADiskDescriptionMediaMatchKey ) == FALSE )
+        {
+            CFTypeRef compare;
+
+            compare = CFDictionaryGetValue( description, key );
+
+            if ( compare == NULL || CFEqual( value, compare ) == FALSE )
+            {
+                *( ( void * * ) context ) = NULL;
+            }
+        }
+    }
+}
+
 static void __DAQueueCallbacks( _DACallbackKind kind, DADiskRef argument0, CFTypeRef argument1 )
 {
     CFIndex count;
@@ -77,6 +150,183 @@ static void __DAQueueCallbacks( _DACallbackKind kind, DADiskRef argument0, CFTyp
     }
 }
 
+static UInt64 __gDAQueueVirtualTime[ kDARequestClassCount ] = { 0 };
+
+static Boolean __DAQueueRequestHasUnit( DARequestRef request, UInt32 unit )
+{
+    CFArrayRef link;
+
+    if ( DADiskGetBSDUnit( DARequestGetDisk( request ) ) == unit )
+    {
+        return TRUE;
+    }
+
+    link = DARequestGetLink( request );
+
+    if ( link )
+    {
+        CFIndex count;
+        CFIndex index;
+
+        count = CFArrayGetCount( link );
+
+        for ( index = 0; index < count; index++ )
+        {
+            DARequestRef subrequest;
+
+            subrequest = ( void * ) CFArrayGetValueAtIndex( link, index );
+
+            if ( DADiskGetBSDUnit( DARequestGetDisk( subrequest ) ) == unit )
+            {
+                return TRUE;
+            }
+        }
+    }
+
+    return FALSE;
+}
+
+static Boolean __DAQueueRequestIsOrdered( DARequestRef request1, DARequestRef request2 )
+{
+    CFArrayRef link;
+
+    /*
+     * Determine whether two requests must be dispatched in the order in which they were queued.
+     * That holds for requests of one session, for requests on one unit and for any request
+     * without a disk.
+     */
+
+    if ( DARequestGetDisk( request1 ) == NULL || DARequestGetDisk( request2 ) == NULL )
+    {
+        return TRUE;
+    }
+
+    if ( DARequestGetSession( request1 ) == DARequestGetSession( request2 ) )
+    {
+        return TRUE;
+    }
+
+    if ( __DAQueueRequestHasUnit( request2, DADiskGetBSDUnit( DARequestGetDisk( request1 ) ) ) )
+    {
+        return TRUE;
+    }
+
+    link = DARequestGetLink( request1 );
+
+    if ( link )
+    {
+        CFIndex count;
+        CFIndex index;
+
+        count = CFArrayGetCount( link );
+
+        for ( index = 0; index < count; index++ )
+        {
+            DARequestRef subrequest;
+
+            subrequest = ( void * ) CFArrayGetValueAtIndex( link, index );
+
+            if ( __DAQueueRequestHasUnit( request2, DADiskGetBSDUnit( DARequestGetDisk( subrequest ) ) ) )
+            {
+                return TRUE;
+            }
+        }
+    }
+
+    return FALSE;
+}
+
+static void __DAQueueRequestInsert( DARequestRef request )
+{
+    DARequestClass class;
+    CFIndex        count;
+    Boolean        found;
+    CFIndex        index;
+    UInt64         last;
+    DASessionRef   session;
+    UInt64         tag;
+    UInt64         time;
+
+    /*
+     * Queue the request fairly.  The request queue is kept in order of class first, so that an
+     * interactive request is dispatched ahead of a background one, and within a class in order
+     * of a virtual finish tag, so that sessions take turns one request at a time regardless of
+     * how many requests each has queued.  A request is never moved ahead of one it is ordered
+     * with, which keeps the per-disk dependencies the stage dispatch relies on.
+     */
+
+    class   = DARequestGetClass( request );
+    session = DARequestGetSession( request );
+
+    found = FALSE;
+    last  = 0;
+    time  = __gDAQueueVirtualTime[ class ];
+
+    count = CFArrayGetCount( gDARequestList );
+
+    for ( index = 0; index < count; index++ )
+    {
+        DARequestRef item;
+
+        item = ( void * ) CFArrayGetValueAtIndex( gDARequestList, index );
+
+        if ( DARequestGetClass( item ) == class )
+        {
+            /*
+             * The virtual time of the class is the earliest tag still queued in it.
+             */
+
+            if ( found == FALSE || DARequestGetTag( item ) < time )
+            {
+                time = DARequestGetTag( item );
+            }
+
+            found = TRUE;
+
+            if ( DARequestGetSession( item ) == session )
+            {
+                if ( DARequestGetTag( item ) > last )
+                {
+                    last = DARequestGetTag( item );
+                }
+            }
+        }
+    }
+
+    __gDAQueueVirtualTime[ class ] = time;
+
+    tag = ( ( last > time ) ? last : time ) + 1;
+
+    DARequestSetTag( request, tag );
+
+    for ( index = count; index > 0; index-- )
+    {
+        DARequestRef item;
+
+        item = ( void * ) CFArrayGetValueAtIndex( gDARequestList, index - 1 );
+
+        if ( __DAQueueRequestIsOrdered( item, request ) )
+        {
+            break;
+        }
+
+        if ( DARequestGetClass( item ) < class )
+        {
+            break;
+        }
+
+        if ( DARequestGetClass( item ) == class )
+        {
+            if ( DARequestGetTag( item ) <= tag )
+            {
+                break;
+            }
+        }
+    }
+
+    CFArrayInsertValueAtIndex( gDARequestList, index, request );
+}
+
 static void __DAQueueRequest( _DARequestKind kind, DADiskRef argument0, CFIndex argument1, CFTypeRef argument2, CFTypeRef argument3, DACallbackRef callback )
 {
     DARequestRef request;
@@ -344,6 +594,8 @@ Boolean _DAResponseDispatch( CFTypeRef response, SInt32 responseID )
 
 void DADiskAppearedCallback( DADiskRef disk )
 {
+    __DADiskListAdvance( disk );
+
     __DAQueueCallbacks( _kDADiskAppearedCallback, disk, NULL );
 }
 
@@ -358,6 +610,8 @@ void DADiskClaimReleaseCallback( DADiskRef disk, DACallbackRef callback, DARespo
 
 void DADiskDescriptionChangedCallback( DADiskRef disk, CFTypeRef key )
 {
+    __DADiskListAdvance( disk );
+
     if ( CFGetTypeID( key ) == CFArrayGetTypeID( ) )
     {
         __DAQueueCallbacks( _kDADiskDescriptionChangedCallback, disk, key );
@@ -374,10 +628,52 @@ void DADiskDescriptionChangedCallback( DADiskRef disk, CFTypeRef key )
 
         CFRelease( keys );
     }
+
+    /*
+     * The next delta is taken against the description the sessions were just sent.
+     */
+
+    DADiskResetDelta( disk );
 }
 
 void DADiskDisappearedCallback( DADiskRef disk )
 {
+    CFArrayRef removal;
+
+    __DADiskListAdvance( disk );
+
+    /*
+     * Remember the disappearance so that a session registering since an earlier generation
+     * can be told about it.  The oldest removals are forgotten past the limit, and the list
+     * horizon moves forward with them.
+     */
+
+    removal = __DADiskListRemovalCreate( disk );
+
+    if ( removal )
+    {
+        CFArrayAppendValue( gDADiskListRemovals, removal );
+
+        CFRelease( removal );
+    }
+    else
+    {
+        /*
+         * A removal we cannot remember must not be missed by a session, so move the horizon past it.
+         */
+
+        gDADiskListHorizon = gDADiskListGeneration;
+    }
+
+    if ( CFArrayGetCount( gDADiskListRemovals ) > _kDADiskListRemovalsLimit )
+    {
+        removal = CFArrayGetValueAtIndex( gDADiskListRemovals, 0 );
+
+        CFNumberGetValue( CFArrayGetValueAtIndex( removal, _kDADiskListRemovalGeneration ), kCFNumberSInt64Type, &gDADiskListHorizon );
+
+        CFArrayRemoveValueAtIndex( gDADiskListRemovals, 0 );
+    }
+
     __DAQueueCallbacks( _kDADiskDisappearedCallback, disk, NULL );
 }
 
@@ -494,7 +790,7 @@ void DAQueueCallback( DACallbackRef callback, DADiskRef argument0, CFTypeRef arg
                     {
                         DACallbackSetDisk( callback, argument0 );
 
-                        DACallbackSetArgument0( callback, DADiskGetSerialization( argument0 ) );
+                        DACallbackSetArgument0( callback, DADiskGetSerializationWithEncoding( argument0, DASessionGetEncoding( session ) ) );
 
                         DASessionQueueCallback( session, callback );
 
@@ -519,7 +815,7 @@ void DAQueueCallback( DACallbackRef callback, DADiskRef argument0, CFTypeRef arg
                 {
                     DACallbackSetDisk( callback, argument0 );
 
-                    DACallbackSetArgument0( callback, DADiskGetSerialization( argument0 ) );
+                    DACallbackSetArgument0( callback, DADiskGetSerializationWithEncoding( argument0, DASessionGetEncoding( session ) ) );
 
                     DACallbackSetArgument1( callback, argument1 );
 
@@ -578,7 +874,7 @@ void DAQueueCallback( DACallbackRef callback, DADiskRef argument0, CFTypeRef arg
                             {
                                 DACallbackSetDisk( callback, argument0 );
 
-                                DACallbackSetArgument0( callback, DADiskGetSerialization( argument0 ) );
+                                DACallbackSetArgument0( callback, DADiskGetSerializationWithEncoding( argument0, DASessionGetEncoding( session ) ) );
 
                                 DACallbackSetArgument1( callback, argument1 );
 
@@ -637,7 +933,7 @@ void DAQueueCallback( DACallbackRef callback, DADiskRef argument0, CFTypeRef arg
                             {
                                 DACallbackSetDisk( callback, argument0 );
 
-                                DACallbackSetArgument0( callback, DADiskGetSerialization( argument0 ) );
+                                DACallbackSetArgument0( callback, DADiskGetSerializationWithEncoding( argument0, DASessionGetEncoding( session ) ) );
 
                                 DACallbackSetArgument1( callback, argument1 );
 
@@ -708,7 +1004,14 @@ void DAQueueCallback( DACallbackRef callback, DADiskRef argument0, CFTypeRef arg
 
                                     DACallbackSetDisk( callback, argument0 );
 
-                                    DACallbackSetArgument0( callback, DADiskGetSerialization( argument0 ) );
+                                    if ( ( DASessionGetEncoding( session ) & _kDAEncodingDelta ) )
+                                    {
+                                        DACallbackSetArgument0( callback, DADiskGetSerializationDelta( argument0, DASessionGetEncoding( session ) ) );
+                                    }
+                                    else
+                                    {
+                                        DACallbackSetArgument0( callback, DADiskGetSerializationWithEncoding( argument0, DASessionGetEncoding( session ) ) );
+                                    }
 
                                     DACallbackSetArgument1( callback, intersection );
 
@@ -724,6 +1027,20 @@ void DAQueueCallback( DACallbackRef callback, DADiskRef argument0, CFTypeRef arg
 
                     break;
                 }
+                case _kDADiskBatchCallback:
+                {
+                    DACallbackSetArgument1( callback, argument1 );
+
+                    DASessionQueueCallback( session, callback );
+
+                    DALogDebug( "  dispatched callback, id = %016llX:%016llX, kind = %s, dissenters = %ld.",
+                                DACallbackGetAddress( callback ),
+                                DACallbackGetContext( callback ),
+                                _DACallbackKindGetName( DACallbackGetKind( callback ) ),
+                                CFDictionaryGetCount( argument1 ) );
+
+                    break;
+                }
                 case _kDAIdleCallback:
                 case _kDADiskListCompleteCallback:
                 {
@@ -775,6 +1092,90 @@ void DAQueueCallbacks( DASessionRef session, _DACallbackKind kind, DADiskRef arg
     }
 }
 
+DAReturn DAQueueCancelRequests( DASessionRef session, mach_vm_offset_t address, mach_vm_offset_t context )
+{
+    CFIndex  count;
+    CFIndex  index;
+    DAReturn status;
+
+    status = kDAReturnNotFound;
+
+    count = CFArrayGetCount( gDARequestList );
+
+    for ( index = count - 1; index > -1; index-- )
+    {
+        DACallbackRef callback;
+        DARequestRef  request;
+
+        request = ( void * ) CFArrayGetValueAtIndex( gDARequestList, index );
+
+        callback = DARequestGetCallback( request );
+
+        if ( callback == NULL && DARequestGetBatch( request ) )
+        {
+            callback = DARequestBatchGetCallback( DARequestGetBatch( request ) );
+        }
+
+        if ( callback == NULL )
+        {
+            continue;
+        }
+
+        if ( DACallbackGetSession( callback ) != session )
+        {
+            continue;
+        }
+
+        if ( DACallbackGetAddress( callback ) != address || DACallbackGetContext( callback ) != context )
+        {
+            continue;
+        }
+
+        status = kDAReturnSuccess;
+
+        if ( DARequestGetLink( request ) )
+        {
+            CFArrayRef link;
+            CFIndex    subcount;
+            CFIndex    subindex;
+
+            link = DARequestGetLink( request );
+
+            subcount = CFArrayGetCount( link );
+
+            for ( subindex = 0; subindex < subcount; subindex++ )
+            {
+                DARequestSetState( ( void * ) CFArrayGetValueAtIndex( link, subindex ), kDARequestStateCancelled, TRUE );
+            }
+        }
+
+        /*
+         * A request that has yet to commence is dropped at once.  A request that has commenced is
+         * completed by the stage once its outstanding step, such as an approval, comes back.
+         */
+
+        if ( DARequestGetState( request, kDARequestStateStagedProbe | kDARequestStateStagedApprove | _kDARequestStateStagedAuthorize ) )
+        {
+            DARequestSetState( request, kDARequestStateCancelled, TRUE );
+        }
+        else
+        {
+            gDAStatistics.requestCancelled[ DARequestGetClass( request ) ]++;
+
+            DARequestDispatchCallback( request, unix_err( ECANCELED ) );
+
+            CFArrayRemoveValueAtIndex( gDARequestList, index );
+        }
+    }
+
+    if ( status == kDAReturnSuccess )
+    {
+        DAStageSignal( );
+    }
+
+    return status;
+}
+
 void DAQueueReleaseDisk( DADiskRef disk )
 {
     CFIndex count;
@@ -848,7 +1249,8 @@ void DAQueueReleaseSession( DASessionRef session )
 
         if ( request )
         {
-            DACallbackRef callback;
+            CFMutableDictionaryRef batch;
+            DACallbackRef          callback;
 
             callback = DARequestGetCallback( request );
 
@@ -859,6 +1261,25 @@ void DAQueueReleaseSession( DASessionRef session )
                     DARequestSetCallback( request, NULL );
                 }
             }
+
+            /*
+             * The requests of a batch share the batch callback, which goes with its session too.
+             */
+
+            batch = DARequestGetBatch( request );
+
+            if ( batch )
+            {
+                callback = ( void * ) CFDictionaryGetValue( batch, _kDARequestCallbackKey );
+
+                if ( callback )
+                {
+                    if ( DACallbackGetSession( callback ) == session )
+                    {
+                        CFDictionaryRemoveValue( batch, _kDARequestCallbackKey );
+                    }
+                }
+            }
         }
     }
 
@@ -887,6 +1308,68 @@ void DAQueueReleaseSession( DASessionRef session )
     }
 }
 
+void DAQueueRemovalCallback( DACallbackRef callback, CFArrayRef removal )
+{
+    DASessionRef session;
+
+    session = DACallbackGetSession( callback );
+
+    DALogDebugHeader( "%s -> %@", gDAProcessNameID, session );
+
+    if ( DASessionGetState( session, kDASessionStateZombie ) == FALSE )
+    {
+        if ( DACallbackGetAddress( callback ) )
+        {
+            CFDictionaryRef match;
+            CFDataRef       serialization;
+
+            match = DACallbackGetMatch( callback );
+
+            serialization = CFArrayGetValueAtIndex( removal, _kDADiskListRemovalSerialization );
+
+            if ( match )
+            {
+                CFDictionaryRef description;
+
+                description = _DAUnserializeDiskDescription( kCFAllocatorDefault, serialization );
+
+                if ( description )
+                {
+                    CFDictionaryRef context;
+
+                    context = description;
+
+                    CFDictionaryApplyFunction( match, __DADiskListRemovalMatch, &context );
+
+                    CFRelease( description );
+
+                    if ( context == NULL )
+                    {
+                        return;
+                    }
+                }
+            }
+
+            callback = DACallbackCreateCopy( kCFAllocatorDefault, callback );
+
+            if ( callback )
+            {
+                DACallbackSetArgument0( callback, serialization );
+
+                DASessionQueueCallback( session, callback );
+
+                DALogDebug( "  dispatched callback, id = %016llX:%016llX, kind = %s, disk = %s.",
+                            DACallbackGetAddress( callback ),
+                            DACallbackGetContext( callback ),
+                            _DACallbackKindGetName( DACallbackGetKind( callback ) ),
+                            CFDataGetBytePtr( CFArrayGetValueAtIndex( removal, _kDADiskListRemovalID ) ) );
+
+                CFRelease( callback );
+            }
+        }
+    }
+}
+
 void DAQueueRequest( DARequestRef request )
 {
     DAReturn status;
@@ -997,7 +1480,7 @@ void DAQueueRequest( DARequestRef request )
                                     {
                                         CFArrayAppendValue( link, subrequest );
 
-                                        CFArrayAppendValue( gDARequestList, subrequest );
+                                        __DAQueueRequestInsert( subrequest );
 
                                         CFRelease( subrequest );
                                     }
@@ -1022,7 +1505,7 @@ void DAQueueRequest( DARequestRef request )
     }
     else
     {
-        CFArrayAppendValue( gDARequestList, request );
+        __DAQueueRequestInsert( request );
 
         DAStageSignal( );
     }
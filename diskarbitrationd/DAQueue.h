@@ -37,6 +37,13 @@ extern "C" {
 
 typedef void ( *DAResponseCallback )( CFTypeRef response, void * context );
 
+enum
+{
+    _kDADiskListRemovalID            = 0,
+    _kDADiskListRemovalGeneration    = 1,
+    _kDADiskListRemovalSerialization = 2
+};
+
 extern Boolean _DAResponseDispatch( CFTypeRef response, SInt32 responseID );
 
 extern void DADiskAppearedCallback( DADiskRef disk );
@@ -75,10 +82,14 @@ extern void DAQueueCallback( DACallbackRef callback, DADiskRef argument0, CFType
 
 extern void DAQueueCallbacks( DASessionRef session, _DACallbackKind kind, DADiskRef argument0, CFTypeRef argument1 );
 
+extern DAReturn DAQueueCancelRequests( DASessionRef session, mach_vm_offset_t address, mach_vm_offset_t context );
+
 extern void DAQueueReleaseDisk( DADiskRef disk );
 
 extern void DAQueueReleaseSession( DASessionRef session );
 
+extern void DAQueueRemovalCallback( DACallbackRef callback, CFArrayRef removal );
+
 extern void DAQueueRequest( DARequestRef request );
 
 extern void DAQueueUnregisterCallback( DACallbackRef callback );
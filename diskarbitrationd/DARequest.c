@@ -119,13 +119,41 @@ static void __DARequestAuthorize( DARequestRef        request,
 }
 #endif
 ///w:stop
+static void __DARequestCommence( DARequestRef request )
+{
+    DARequestClass class;
+    UInt64         wait;
+
+    /*
+     * Account for the time the request spent dispatchable in the request queue before it commenced.
+     * The probe and approval stages that follow are not part of the wait.
+     */
+
+    DARequestSetState( request, kDARequestStateCommenced, TRUE );
+
+    class = DARequestGetClass( request );
+
+    wait = ( CFAbsoluteTimeGetCurrent( ) - DARequestGetTime( request ) ) * 1000;
+
+    gDAStatistics.requestCount[class]++;
+
+    gDAStatistics.requestWait[class] += wait;
+
+    if ( gDAStatistics.requestWaitMax[class] < wait )
+    {
+        gDAStatistics.requestWaitMax[class] = wait;
+    }
+}
+
 static void __DARequestDispatchCallback( DARequestRef request, DADissenterRef dissenter )
 {
-    DACallbackRef callback;
+    CFMutableDictionaryRef batch;
+    DACallbackRef          callback;
 
+    batch    = DARequestGetBatch( request );
     callback = DARequestGetCallback( request );
 
-    if ( callback )
+    if ( callback || batch )
     {
         CFArrayRef link;
 
@@ -155,7 +183,21 @@ static void __DARequestDispatchCallback( DARequestRef request, DADissenterRef di
             }
         }
 
-        DAQueueCallback( callback, DARequestGetDisk( request ), dissenter );
+        if ( callback )
+        {
+            DAQueueCallback( callback, DARequestGetDisk( request ), dissenter );
+        }
+
+        if ( batch )
+        {
+            CFRetain( batch );
+
+            DARequestSetBatch( request, NULL );
+
+            DARequestBatchLeave( batch, DADiskGetID( DARequestGetDisk( request ) ), dissenter );
+
+            CFRelease( batch );
+        }
     }
 }
 
@@ -982,11 +1024,21 @@ static Boolean __DARequestRefresh( DARequestRef request )
         }
         else
         {
+            CFDictionaryRef volumes;
+
             CFRetain( request );
 
             DADiskSetState( disk, kDADiskStateCommandActive, TRUE );
 
-            status = _DADiskRefresh( disk );
+            /*
+             * Refresh against the mount table snapshot shared by every refresh in this pass.
+             */
+
+            volumes = DAVolumeListCopy( );
+
+            status = _DADiskRefresh( disk, volumes );
+
+            if ( volumes )  CFRelease( volumes );
 
             __DARequestRefreshCallback( status ? ENOTSUP : 0, request );
 
@@ -1492,7 +1544,7 @@ static void __DARequestUnmountCallback( int status, void * context )
 
         for ( mountListIndex = 0; mountListIndex < mountListCount; mountListIndex++ )
         {
-            if ( strncmp( _DAVolumeGetID( mountList + mountListIndex ), DADiskGetID( disk ), strlen( DADiskGetID( disk ) ) + 1 ) == 0 )
+            if ( strncmp( DAVolumeGetID( mountList + mountListIndex ), DADiskGetID( disk ), strlen( DADiskGetID( disk ) ) + 1 ) == 0 )
             {
                 break;
             }
@@ -1865,6 +1917,102 @@ static void __DARequestUnmountTickleCallback( int status, void * context )
 }
 ///w:stop
 
+CFMutableDictionaryRef DARequestBatchCreate( CFAllocatorRef allocator, DACallbackRef callback )
+{
+    CFMutableDictionaryRef batch;
+
+    /*
+     * A batch gathers the outcome of the requests submitted together under one callback.  It keeps
+     * the callback, the dissenters by disk identifier and, under the link key, the count of requests
+     * outstanding, which starts with a hold for the submission itself.
+     */
+
+    batch = CFDictionaryCreateMutable( allocator, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks );
+
+    if ( batch )
+    {
+        CFMutableDictionaryRef dissenters;
+
+        dissenters = CFDictionaryCreateMutable( allocator, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks );
+
+        if ( dissenters )
+        {
+            CFDictionarySetValue( batch, _kDARequestCallbackKey, callback );
+
+            CFDictionarySetValue( batch, _kDARequestDissenterKey, dissenters );
+
+            ___CFDictionarySetIntegerValue( batch, _kDARequestLinkKey, 1 );
+
+            CFRelease( dissenters );
+        }
+        else
+        {
+            CFRelease( batch );
+
+            batch = NULL;
+        }
+    }
+
+    return batch;
+}
+
+void DARequestBatchEnter( CFMutableDictionaryRef batch )
+{
+    ___CFDictionarySetIntegerValue( batch, _kDARequestLinkKey, ___CFDictionaryGetIntegerValue( batch, _kDARequestLinkKey ) + 1 );
+}
+
+DACallbackRef DARequestBatchGetCallback( CFMutableDictionaryRef batch )
+{
+    return ( void * ) CFDictionaryGetValue( batch, _kDARequestCallbackKey );
+}
+
+void DARequestBatchLeave( CFMutableDictionaryRef batch, const char * id, DADissenterRef dissenter )
+{
+    CFIndex count;
+
+    if ( id && dissenter )
+    {
+        CFStringRef key;
+
+        key = CFStringCreateWithCString( kCFAllocatorDefault, id, kCFStringEncodingUTF8 );
+
+        if ( key )
+        {
+            CFDictionarySetValue( ( void * ) CFDictionaryGetValue( batch, _kDARequestDissenterKey ), key, dissenter );
+
+            CFRelease( key );
+        }
+    }
+
+    count = ___CFDictionaryGetIntegerValue( batch, _kDARequestLinkKey ) - 1;
+
+    ___CFDictionarySetIntegerValue( batch, _kDARequestLinkKey, count );
+
+    if ( count == 0 )
+    {
+        DACallbackRef callback;
+
+        callback = ( void * ) CFDictionaryGetValue( batch, _kDARequestCallbackKey );
+
+        if ( callback )
+        {
+            DAQueueCallback( callback, NULL, CFDictionaryGetValue( batch, _kDARequestDissenterKey ) );
+        }
+    }
+}
+
+const char * DARequestClassGetName( DARequestClass class )
+{
+    switch ( class )
+    {
+        case kDARequestClassInteractive: return "interactive";
+        case kDARequestClassNormal:      return "normal";
+        case kDARequestClassBackground:  return "background";
+    }
+
+    return "unknown";
+}
+
 DARequestRef DARequestCreate( CFAllocatorRef allocator,
                               _DARequestKind kind,
                               DADiskRef      argument0,
@@ -1881,8 +2029,51 @@ DARequestRef DARequestCreate( CFAllocatorRef allocator,
 
     if ( request )
     {
+        DARequestClass class;
+        CFDateRef      time;
+
         ___CFDictionarySetIntegerValue( request, _kDARequestKindKey, kind );
 
+        /*
+         * Classify the request for the request queue.  An eject or unmount is what a user waits
+         * on, whereas a probe or refresh merely brings the description up to date.
+         */
+
+        switch ( kind )
+        {
+            case _kDADiskEject:
+            case _kDADiskUnmount:
+            {
+                class = kDARequestClassInteractive;
+
+                break;
+            }
+            case _kDADiskProbe:
+            case _kDADiskRefresh:
+            {
+                class = kDARequestClassBackground;
+
+                break;
+            }
+            default:
+            {
+                class = kDARequestClassNormal;
+
+                break;
+            }
+        }
+
+        ___CFDictionarySetIntegerValue( request, _kDARequestClassKey, class );
+
+        time = CFDateCreate( kCFAllocatorDefault, CFAbsoluteTimeGetCurrent( ) );
+
+        if ( time )
+        {
+            CFDictionarySetValue( request, _kDARequestTimeKey, time );
+
+            CFRelease( time );
+        }
+
         if ( argument0 )  CFDictionarySetValue( request, _kDARequestDiskKey, argument0 );
         if ( argument1 )  ___CFDictionarySetIntegerValue( request, _kDARequestArgument1Key, argument1 );
         if ( argument2 )  CFDictionarySetValue( request, _kDARequestArgument2Key, argument2 );
@@ -1913,8 +2104,37 @@ Boolean DARequestDispatch( DARequestRef request )
         {
             if ( DADiskGetState( disk, kDADiskStateCommandActive ) == FALSE )
             {
-                if ( DADiskGetState( disk, kDADiskStateStagedAppear ) )
+                if ( DARequestGetState( request, kDARequestStateCancelled ) )
+                {
+                    /*
+                     * The request was cancelled after it commenced.  No stage of it is outstanding
+                     * here, so complete it just as if it had been dissented.
+                     */
+
+                    gDAStatistics.requestCancelled[ DARequestGetClass( request ) ]++;
+
+                    DARequestDispatchCallback( request, unix_err( ECANCELED ) );
+
+                    DAStageSignal( );
+
+                    dispatch = TRUE;
+                }
+                else if ( DADiskGetState( disk, kDADiskStateStagedAppear ) == FALSE )
+                {
+                    /*
+                     * The request is not dispatchable until its disk has appeared, so hold its wait
+                     * clock at the present.
+                     */
+
+                    DARequestSetTime( request, CFAbsoluteTimeGetCurrent( ) );
+                }
+                else
                 {
+                    if ( DARequestGetState( request, kDARequestStateCommenced ) == FALSE )
+                    {
+                        __DARequestCommence( request );
+                    }
+
                     switch ( DARequestGetKind( request ) )
                     {
                         case _kDADiskClaim:
@@ -2009,11 +2229,21 @@ CFTypeRef DARequestGetArgument3( DARequestRef request )
     return CFDictionaryGetValue( ( void * ) request, _kDARequestArgument3Key );
 }
 
+CFMutableDictionaryRef DARequestGetBatch( DARequestRef request )
+{
+    return ( void * ) CFDictionaryGetValue( ( void * ) request, _kDARequestBatchKey );
+}
+
 DACallbackRef DARequestGetCallback( DARequestRef request )
 {
     return ( void * ) CFDictionaryGetValue( ( void * ) request, _kDARequestCallbackKey );
 }
 
+DARequestClass DARequestGetClass( DARequestRef request )
+{
+    return ___CFDictionaryGetIntegerValue( ( void * ) request, _kDARequestClassKey );
+}
+
 DADiskRef DARequestGetDisk( DARequestRef request )
 {
     return ( void * ) CFDictionaryGetValue( ( void * ) request, _kDARequestDiskKey );
@@ -2034,11 +2264,52 @@ CFArrayRef DARequestGetLink( DARequestRef request )
     return CFDictionaryGetValue( ( void * ) request, _kDARequestLinkKey );
 }
 
+DASessionRef DARequestGetSession( DARequestRef request )
+{
+    DACallbackRef callback;
+
+    callback = DARequestGetCallback( request );
+
+    if ( callback == NULL )
+    {
+        CFMutableDictionaryRef batch;
+
+        batch = DARequestGetBatch( request );
+
+        if ( batch )
+        {
+            callback = DARequestBatchGetCallback( batch );
+        }
+    }
+
+    return callback ? DACallbackGetSession( callback ) : NULL;
+}
+
 Boolean DARequestGetState( DARequestRef request, DARequestState state )
 {
     return ( ___CFDictionaryGetIntegerValue( ( void * ) request, _kDARequestStateKey ) & state ) ? TRUE : FALSE;
 }
 
+UInt64 DARequestGetTag( DARequestRef request )
+{
+    return ___CFDictionaryGetIntegerValue( ( void * ) request, _kDARequestTagKey );
+}
+
+CFAbsoluteTime DARequestGetTime( DARequestRef request )
+{
+    CFDateRef      date;
+    CFAbsoluteTime time = 0;
+
+    date = CFDictionaryGetValue( ( void * ) request, _kDARequestTimeKey );
+
+    if ( date )
+    {
+        time = CFDateGetAbsoluteTime( date );
+    }
+
+    return time;
+}
+
 gid_t DARequestGetUserGID( DARequestRef request )
 {
     return ___CFDictionaryGetIntegerValue( ( void * ) request, _kDARequestUserGIDKey );
@@ -2049,6 +2320,18 @@ uid_t DARequestGetUserUID( DARequestRef request )
     return ___CFDictionaryGetIntegerValue( ( void * ) request, _kDARequestUserUIDKey );
 }
 
+void DARequestSetBatch( DARequestRef request, CFMutableDictionaryRef batch )
+{
+    if ( batch )
+    {
+        CFDictionarySetValue( ( void * ) request, _kDARequestBatchKey, batch );
+    }
+    else
+    {
+        CFDictionaryRemoveValue( ( void * ) request, _kDARequestBatchKey );
+    }
+}
+
 void DARequestSetCallback( DARequestRef request, DACallbackRef callback )
 {
     if ( callback )
@@ -2099,6 +2382,25 @@ void DARequestSetState( DARequestRef request, DARequestState state, Boolean valu
     ___CFDictionarySetIntegerValue( ( void * ) request, _kDARequestStateKey, state );
 }
 
+void DARequestSetTag( DARequestRef request, UInt64 tag )
+{
+    ___CFDictionarySetIntegerValue( ( void * ) request, _kDARequestTagKey, tag );
+}
+
+void DARequestSetTime( DARequestRef request, CFAbsoluteTime time )
+{
+    CFDateRef date;
+
+    date = CFDateCreate( kCFAllocatorDefault, time );
+
+    if ( date )
+    {
+        CFDictionarySetValue( ( void * ) request, _kDARequestTimeKey, date );
+
+        CFRelease( date );
+    }
+}
+
 void DARequestSetArgument2( DARequestRef request, CFTypeRef argument2)
 {
     if ( argument2 )
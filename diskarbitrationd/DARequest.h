@@ -44,11 +44,23 @@ enum
     _kDARequestStateStagedAuthorize      = 0x00200000,
 ///w:stop
     kDARequestStateStagedProbe   = 0x00010000,
-    kDARequestStateStagedApprove = 0x00100000
+    kDARequestStateStagedApprove = 0x00100000,
+    kDARequestStateCancelled     = 0x01000000,
+    kDARequestStateCommenced     = 0x02000000
 };
 
 typedef UInt32 DARequestState;
 
+enum
+{
+    kDARequestClassInteractive = 0,
+    kDARequestClassNormal      = 1,
+    kDARequestClassBackground  = 2,
+    kDARequestClassCount       = 3
+};
+
+typedef UInt32 DARequestClass;
+
 extern DARequestRef DARequestCreate( CFAllocatorRef allocator,
                                      _DARequestKind kind,
                                      DADiskRef      argument0,
@@ -59,25 +71,40 @@ extern DARequestRef DARequestCreate( CFAllocatorRef allocator,
                                      gid_t          userGID,
                                      DACallbackRef  callback );
 
+extern CFMutableDictionaryRef DARequestBatchCreate( CFAllocatorRef allocator, DACallbackRef callback );
+extern void                   DARequestBatchEnter( CFMutableDictionaryRef batch );
+extern DACallbackRef          DARequestBatchGetCallback( CFMutableDictionaryRef batch );
+extern void                   DARequestBatchLeave( CFMutableDictionaryRef batch, const char * id, DADissenterRef dissenter );
+
+extern const char * DARequestClassGetName( DARequestClass class );
+
 extern Boolean DARequestDispatch( DARequestRef request );
 
-extern void           DARequestDispatchCallback( DARequestRef request, DAReturn status );
-extern CFIndex        DARequestGetArgument1( DARequestRef request );
-extern CFTypeRef      DARequestGetArgument2( DARequestRef request );
-extern CFTypeRef      DARequestGetArgument3( DARequestRef request );
-extern DACallbackRef  DARequestGetCallback( DARequestRef request );
-extern DADiskRef      DARequestGetDisk( DARequestRef request );
-extern DADissenterRef DARequestGetDissenter( DARequestRef request );
-extern _DARequestKind DARequestGetKind( DARequestRef request );
-extern CFArrayRef     DARequestGetLink( DARequestRef request );
-extern Boolean        DARequestGetState( DARequestRef request, DARequestState state );
-extern gid_t          DARequestGetUserGID( DARequestRef request );
-extern uid_t          DARequestGetUserUID( DARequestRef request );
-extern void           DARequestSetCallback( DARequestRef request, DACallbackRef callback );
-extern void           DARequestSetDissenter( DARequestRef request, DADissenterRef dissenter );
-extern void           DARequestSetLink( DARequestRef request, CFArrayRef link );
-extern void           DARequestSetState( DARequestRef request, DARequestState state, Boolean value );
-extern void           DARequestSetArgument2( DARequestRef request, CFTypeRef argument2);
+extern void                   DARequestDispatchCallback( DARequestRef request, DAReturn status );
+extern CFIndex                DARequestGetArgument1( DARequestRef request );
+extern CFTypeRef              DARequestGetArgument2( DARequestRef request );
+extern CFTypeRef              DARequestGetArgument3( DARequestRef request );
+extern CFMutableDictionaryRef DARequestGetBatch( DARequestRef request );
+extern DACallbackRef          DARequestGetCallback( DARequestRef request );
+extern DARequestClass         DARequestGetClass( DARequestRef request );
+extern DADiskRef              DARequestGetDisk( DARequestRef request );
+extern DADissenterRef         DARequestGetDissenter( DARequestRef request );
+extern _DARequestKind         DARequestGetKind( DARequestRef request );
+extern CFArrayRef             DARequestGetLink( DARequestRef request );
+extern DASessionRef           DARequestGetSession( DARequestRef request );
+extern Boolean                DARequestGetState( DARequestRef request, DARequestState state );
+extern UInt64                 DARequestGetTag( DARequestRef request );
+extern CFAbsoluteTime         DARequestGetTime( DARequestRef request );
+extern gid_t                  DARequestGetUserGID( DARequestRef request );
+extern uid_t                  DARequestGetUserUID( DARequestRef request );
+extern void                   DARequestSetBatch( DARequestRef request, CFMutableDictionaryRef batch );
+extern void                   DARequestSetCallback( DARequestRef request, DACallbackRef callback );
+extern void                   DARequestSetDissenter( DARequestRef request, DADissenterRef dissenter );
+extern void                   DARequestSetLink( DARequestRef request, CFArrayRef link );
+extern void                   DARequestSetState( DARequestRef request, DARequestState state, Boolean value );
+extern void                   DARequestSetTag( DARequestRef request, UInt64 tag );
+extern void                   DARequestSetTime( DARequestRef request, CFAbsoluteTime time );
+extern void                   DARequestSetArgument2( DARequestRef request, CFTypeRef argument2);
 
 #ifdef __cplusplus
 }
@@ -323,7 +323,7 @@ static void __DAMediaPropertyChangedCallback( void * context, io_service_t servi
 
                     for ( mountListIndex = 0; mountListIndex < mountListCount; mountListIndex++ )
                     {
-                        if ( strcmp( _DAVolumeGetID( mountList + mountListIndex ), DADiskGetID( disk ) ) == 0 )
+                        if ( strcmp( DAVolumeGetID( mountList + mountListIndex ), DADiskGetID( disk ) ) == 0 )
                         {
                             break;
                         }
@@ -546,6 +546,73 @@ static void __DAMediaPropertyChangedCallback( void * context, io_service_t servi
     }
 }
 
+static void __DADiskListQueueCallback( DACallbackRef callback, UInt64 generation )
+{
+    CFIndex count;
+    CFIndex index;
+
+    if ( DACallbackGetKind( callback ) == _kDADiskAppearedCallback )
+    {
+        /*
+         * Replay the disk list to a disk appeared callback, skipping disks that have neither
+         * appeared nor changed since the given generation.
+         */
+
+        count = CFArrayGetCount( gDADiskList );
+
+        for ( index = 0; index < count; index++ )
+        {
+            DADiskRef disk;
+
+            disk = ( void * ) CFArrayGetValueAtIndex( gDADiskList, index );
+
+            if ( DADiskGetState( disk, kDADiskStateStagedAppear ) )
+            {
+                if ( DADiskGetListGeneration( disk ) > generation )
+                {
+                    DAQueueCallback( callback, disk, NULL );
+                }
+            }
+        }
+    }
+    else if ( DACallbackGetKind( callback ) == _kDADiskDisappearedCallback )
+    {
+        if ( generation == 0 )
+        {
+            return;
+        }
+
+        /*
+         * Replay the removals since the given generation to a disk disappeared callback.  A
+         * disk that has since reappeared under the same identifier is replayed as appeared.
+         */
+
+        count = CFArrayGetCount( gDADiskListRemovals );
+
+        for ( index = 0; index < count; index++ )
+        {
+            CFArrayRef removal;
+            UInt64     value;
+
+            removal = CFArrayGetValueAtIndex( gDADiskListRemovals, index );
+
+            CFNumberGetValue( CFArrayGetValueAtIndex( removal, _kDADiskListRemovalGeneration ), kCFNumberSInt64Type, &value );
+
+            if ( value > generation )
+            {
+                DADiskRef current;
+
+                current = DADiskListGetDisk( ( const char * ) CFDataGetBytePtr( CFArrayGetValueAtIndex( removal, _kDADiskListRemovalID ) ) );
+
+                if ( current == NULL || DADiskGetState( current, kDADiskStateStagedAppear ) == FALSE )
+                {
+                    DAQueueRemovalCallback( callback, removal );
+                }
+            }
+        }
+    }
+}
+
 static DASessionRef __DASessionListGetSession( mach_port_t sessionID )
 {
     CFIndex count;
@@ -1752,6 +1819,172 @@ exit:
 }
 #endif
 
+kern_return_t _DAServerCopyStatistics( mach_port_t _session, vm_address_t * _statistics, mach_msg_type_number_t * _statisticsSize )
+{
+    kern_return_t status;
+
+    status = kDAReturnBadArgument;
+
+    DALogDebugHeader( "? [?]:%d -> %s", _session, gDAProcessNameID );
+
+    if ( _session )
+    {
+        DASessionRef session;
+
+        session = __DASessionListGetSession( _session );
+
+        if ( session )
+        {
+            CFMutableDictionaryRef statistics;
+
+            DALogDebugHeader( "%@ -> %s", session, gDAProcessNameID );
+
+            status = kDAReturnNoResources;
+
+            statistics = CFDictionaryCreateMutable( kCFAllocatorDefault, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks );
+
+            if ( statistics )
+            {
+                CFMutableArrayRef classes;
+                CFDataRef         data;
+                CFMutableArrayRef sessions;
+
+                ___CFDictionarySetIntegerValue( statistics, kDAStatisticsCallbacksCoalescedKey, gDAStatistics.callbacksCoalesced );
+                ___CFDictionarySetIntegerValue( statistics, kDAStatisticsSessionResyncsKey,     gDAStatistics.sessionResyncs     );
+
+                sessions = CFArrayCreateMutable( kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks );
+
+                if ( sessions )
+                {
+                    CFIndex count;
+                    CFIndex index;
+
+                    count = CFArrayGetCount( gDASessionList );
+
+                    for ( index = 0; index < count; index++ )
+                    {
+                        CFMutableDictionaryRef entry;
+                        DASessionRef           item;
+
+                        item = ( void * ) CFArrayGetValueAtIndex( gDASessionList, index );
+
+                        entry = CFDictionaryCreateMutable( kCFAllocatorDefault, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks );
+
+                        if ( entry )
+                        {
+                            CFStringRef name;
+
+                            name = CFStringCreateWithCString( kCFAllocatorDefault, _DASessionGetName( item ), kCFStringEncodingUTF8 );
+
+                            if ( name )
+                            {
+                                CFDictionarySetValue( entry, kDAStatisticsSessionNameKey, name );
+
+                                CFRelease( name );
+                            }
+
+                            ___CFDictionarySetIntegerValue( entry, kDAStatisticsSessionProcessIDKey,  DASessionGetProcessID( item ) );
+                            ___CFDictionarySetIntegerValue( entry, kDAStatisticsSessionQueueBytesKey, DASessionGetCallbackQueueSize( item ) );
+                            ___CFDictionarySetIntegerValue( entry, kDAStatisticsSessionQueueDepthKey, CFArrayGetCount( DASessionGetCallbackQueue( item ) ) );
+                            ___CFDictionarySetIntegerValue( entry, kDAStatisticsSessionQueueLimitKey, DASessionGetQueueLimit( item ) );
+
+                            CFArrayAppendValue( sessions, entry );
+
+                            CFRelease( entry );
+                        }
+                    }
+
+                    CFDictionarySetValue( statistics, kDAStatisticsSessionsKey, sessions );
+
+                    CFRelease( sessions );
+                }
+
+                classes = CFArrayCreateMutable( kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks );
+
+                if ( classes )
+                {
+                    DARequestClass class;
+
+                    for ( class = 0; class < kDARequestClassCount; class++ )
+                    {
+                        CFMutableDictionaryRef entry;
+
+                        entry = CFDictionaryCreateMutable( kCFAllocatorDefault, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks );
+
+                        if ( entry )
+                        {
+                            CFIndex     count;
+                            CFIndex     depth;
+                            CFIndex     index;
+                            CFStringRef name;
+
+                            name = CFStringCreateWithCString( kCFAllocatorDefault, DARequestClassGetName( class ), kCFStringEncodingUTF8 );
+
+                            if ( name )
+                            {
+                                CFDictionarySetValue( entry, kDAStatisticsRequestClassNameKey, name );
+
+                                CFRelease( name );
+                            }
+
+                            depth = 0;
+
+                            count = CFArrayGetCount( gDARequestList );
+
+                            for ( index = 0; index < count; index++ )
+                            {
+                                if ( DARequestGetClass( ( void * ) CFArrayGetValueAtIndex( gDARequestList, index ) ) == class )
+                                {
+                                    depth++;
+                                }
+                            }
+
+                            ___CFDictionarySetIntegerValue( entry, kDAStatisticsRequestClassDepthKey,     depth                                 );
+                            ___CFDictionarySetIntegerValue( entry, kDAStatisticsRequestClassCancelledKey, gDAStatistics.requestCancelled[class] );
+                            ___CFDictionarySetIntegerValue( entry, kDAStatisticsRequestClassCountKey,     gDAStatistics.requestCount[class]     );
+                            ___CFDictionarySetIntegerValue( entry, kDAStatisticsRequestClassWaitKey,      gDAStatistics.requestWait[class]      );
+                            ___CFDictionarySetIntegerValue( entry, kDAStatisticsRequestClassWaitMaxKey,   gDAStatistics.requestWaitMax[class]   );
+
+                            CFArrayAppendValue( classes, entry );
+
+                            CFRelease( entry );
+                        }
+                    }
+
+                    CFDictionarySetValue( statistics, kDAStatisticsRequestClassesKey, classes );
+
+                    CFRelease( classes );
+                }
+
+                data = _DASerialize( kCFAllocatorDefault, statistics );
+
+                if ( data )
+                {
+                    *_statistics = ___CFDataCopyBytes( data, _statisticsSize );
+
+                    if ( *_statistics )
+                    {
+                        DALogDebug( "  copied statistics, id = %@.", session );
+
+                        status = kDAReturnSuccess;
+                    }
+
+                    CFRelease( data );
+                }
+
+                CFRelease( statistics );
+            }
+        }
+    }
+
+    if ( status )
+    {
+        DALogDebug( "unable to copy statistics, id = ? [?]:%d (status code 0x%08X).", _session, status );
+    }
+
+    return status;
+}
+
 kern_return_t _DAServerDiskCopyDescription( mach_port_t _session, caddr_t _disk, vm_address_t * _description, mach_msg_type_number_t * _descriptionSize )
 {
     kern_return_t status;
@@ -1775,7 +2008,7 @@ kern_return_t _DAServerDiskCopyDescription( mach_port_t _session, caddr_t _disk,
             {
                 CFDataRef description;
 
-                description = DADiskGetSerialization( disk );
+                description = DADiskGetSerializationWithEncoding( disk, DASessionGetEncoding( session ) );
 
                 if ( description )
                 {
@@ -2158,81 +2391,326 @@ kern_return_t _DAServerSessionCopyCallbackQueue( mach_port_t _session, vm_addres
 
 
 
-kern_return_t _DAServerSessionCreate( mach_port_t   _session,
-                                      caddr_t       _name,
-                                      audit_token_t _token,
-                                      mach_port_t * _server )
+kern_return_t _DAServerSessionCopyDescriptions( mach_port_t             _session,
+                                                vm_address_t            _disks,
+                                                mach_msg_type_number_t  _disksSize,
+                                                vm_address_t            _match,
+                                                mach_msg_type_number_t  _matchSize,
+                                                vm_address_t *          _descriptions,
+                                                mach_msg_type_number_t * _descriptionsSize )
 {
     kern_return_t status;
 
     status = kDAReturnBadArgument;
 
-    DALogDebugHeader( "%s [%d] -> %s", _name, audit_token_to_pid( _token ), gDAProcessNameID );
+    DALogDebugHeader( "? [?]:%d -> %s", _session, gDAProcessNameID );
 
     if ( _session )
     {
         DASessionRef session;
-#ifdef DA_FSKIT
-        bool is_fskitd;
-#endif /* DA_FSKIT */
-      
-
-#ifdef DA_FSKIT
-        is_fskitd = _DAServerCheckEntitlement(_token, CFSTR("com.apple.private.diskarbitrationd.is_fskitd"));
-#endif /* DA_FSKIT */
-
-        /*
-         * Create the session.
-         */
 
-        session = DASessionCreate( kCFAllocatorDefault, _name, audit_token_to_pid( _token ) );
+        session = __DASessionListGetSession( _session );
 
         if ( session )
         {
+            CFArrayRef        disks = NULL;
+            CFDictionaryRef   match = NULL;
+            CFMutableArrayRef descriptions;
+
             DALogDebugHeader( "%@ -> %s", session, gDAProcessNameID );
 
-            DALogDebug( "  created session, id = %@.", session );
+            if ( _disks )
+            {
+                disks = _DAUnserializeWithBytes( kCFAllocatorDefault, _disks, _disksSize );
+            }
 
-            *_server = DASessionGetServerPort( session );
+            if ( _match )
+            {
+                match = _DAUnserializeDiskDescriptionWithBytes( kCFAllocatorDefault, _match, _matchSize );
+            }
 
-            /*
-             * Add the session object to our tables.
-             */
+            descriptions = NULL;
 
-            ___os_transaction_begin( );
+            if ( ( _disks == 0 || ( disks && CFGetTypeID( disks ) == CFArrayGetTypeID( ) ) ) && ( _match == 0 || match ) )
+            {
+                status = kDAReturnNoResources;
 
-            CFArrayAppendValue( gDASessionList, session );
+                descriptions = CFArrayCreateMutable( kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks );
+            }
 
-            /*
-             * Add the session to our run loop.
-             */
+            if ( descriptions )
+            {
+                CFDataRef data;
+                CFIndex   count;
+                CFIndex   index;
 
-            DASessionScheduleWithDispatch( session ); 
+                /*
+                 * Answer for the disks asked for, in order, with empty data for each disk that is gone
+                 * or does not match.  Otherwise answer for every matching disk that has appeared.
+                 */
 
-#ifdef DA_FSKIT
-            DASessionSetIsFSKitd( session, is_fskitd );
-#endif
+                count = disks ? CFArrayGetCount( disks ) : CFArrayGetCount( gDADiskList );
 
-            CFRelease( session );
+                for ( index = 0; index < count; index++ )
+                {
+                    CFDataRef description = NULL;
+                    DADiskRef disk        = NULL;
 
-            status = kDAReturnSuccess;
+                    if ( disks )
+                    {
+                        CFDataRef id;
+
+                        id = CFArrayGetValueAtIndex( disks, index );
+
+                        if ( CFGetTypeID( id ) == CFDataGetTypeID( ) )
+                        {
+                            if ( CFDataGetLength( id ) && CFDataGetBytePtr( id )[ CFDataGetLength( id ) - 1 ] == 0 )
+                            {
+                                disk = DADiskListGetDisk( ( const char * ) CFDataGetBytePtr( id ) );
+                            }
+                        }
+
+                        if ( disk )
+                        {
+                            /*
+                             * A disk that has yet to appear is answered for as if it were gone.
+                             */
+
+                            if ( DADiskGetState( disk, kDADiskStateStagedAppear ) == FALSE )
+                            {
+                                disk = NULL;
+                            }
+                        }
+                    }
+                    else
+                    {
+                        disk = ( void * ) CFArrayGetValueAtIndex( gDADiskList, index );
+
+                        if ( DADiskGetState( disk, kDADiskStateStagedAppear ) == FALSE )
+                        {
+                            continue;
+                        }
+                    }
+
+                    if ( disk )
+                    {
+                        if ( match == NULL || DADiskMatch( disk, match ) )
+                        {
+                            description = DADiskGetSerializationWithEncoding( disk, DASessionGetEncoding( session ) );
+                        }
+                    }
+
+                    if ( description )
+                    {
+                        CFArrayAppendValue( descriptions, description );
+                    }
+                    else if ( disks )
+                    {
+                        CFDataRef empty;
+
+                        empty = CFDataCreate( kCFAllocatorDefault, NULL, 0 );
+
+                        if ( empty )
+                        {
+                            CFArrayAppendValue( descriptions, empty );
+
+                            CFRelease( empty );
+                        }
+                    }
+                }
+
+                data = _DASerialize( kCFAllocatorDefault, descriptions );
+
+                if ( data )
+                {
+                    *_descriptions = ___CFDataCopyBytes( data, _descriptionsSize );
+
+                    if ( *_descriptions )
+                    {
+                        DALogDebug( "  copied disk descriptions, count = %ld.", CFArrayGetCount( descriptions ) );
+
+                        status = kDAReturnSuccess;
+                    }
+
+                    CFRelease( data );
+                }
+
+                CFRelease( descriptions );
+            }
+
+            if ( disks )  CFRelease( disks );
+            if ( match )  CFRelease( match );
         }
     }
 
-exit:
     if ( status )
     {
-        DALogDebug( "unable to create session, id = %s [%d].", _name, audit_token_to_pid( _token ) );
+        DALogDebug( "unable to copy disk descriptions (status code 0x%08X).", status );
     }
 
     return status;
 }
 
-kern_return_t _DAServerSessionQueueRequestWithUserToken( mach_port_t            _session,
-                                                         uint32_t               _kind,
-                                                         audit_token_t          _userToken,
-                                                         caddr_t                _argument0,
-                                                         int32_t                _argument1,
+kern_return_t _DAServerSessionCopyDiskList( mach_port_t              _session,
+                                            vm_address_t             _match,
+                                            mach_msg_type_number_t   _matchSize,
+                                            uint64_t *               _generation,
+                                            vm_address_t *           _descriptions,
+                                            mach_msg_type_number_t * _descriptionsSize )
+{
+    kern_return_t status;
+
+    /*
+     * The work loop is serial, so the descriptions and the generation describe the same disk
+     * list, which is the one a session registering since that generation starts from.
+     */
+
+    status = _DAServerSessionCopyDescriptions( _session, 0, 0, _match, _matchSize, _descriptions, _descriptionsSize );
+
+    if ( status == kDAReturnSuccess )
+    {
+        *_generation = gDADiskListGeneration;
+    }
+
+    return status;
+}
+
+kern_return_t _DAServerSessionCreate( mach_port_t   _session,
+                                      caddr_t       _name,
+                                      uint32_t      _encodings,
+                                      audit_token_t _token,
+                                      mach_port_t * _server,
+                                      uint32_t *    _encoding )
+{
+    kern_return_t status;
+
+    status = kDAReturnBadArgument;
+
+    DALogDebugHeader( "%s [%d] -> %s", _name, audit_token_to_pid( _token ), gDAProcessNameID );
+
+    if ( _session )
+    {
+        DASessionRef session;
+#ifdef DA_FSKIT
+        bool is_fskitd;
+#endif /* DA_FSKIT */
+      
+
+#ifdef DA_FSKIT
+        is_fskitd = _DAServerCheckEntitlement(_token, CFSTR("com.apple.private.diskarbitrationd.is_fskitd"));
+#endif /* DA_FSKIT */
+
+        /*
+         * Create the session.
+         */
+
+        session = DASessionCreate( kCFAllocatorDefault, _name, audit_token_to_pid( _token ) );
+
+        if ( session )
+        {
+            DALogDebugHeader( "%@ -> %s", session, gDAProcessNameID );
+
+            DALogDebug( "  created session, id = %@.", session );
+
+            *_server = DASessionGetServerPort( session );
+
+            /*
+             * Choose the encoding for disk descriptions sent to this session.
+             */
+
+            if ( ( _encodings & _kDAEncodingCompact ) )
+            {
+                DASessionSetEncoding( session, _kDAEncodingCompact );
+            }
+
+            if ( ( _encodings & _kDAEncodingDelta ) )
+            {
+                DASessionSetEncoding( session, DASessionGetEncoding( session ) | _kDAEncodingDelta );
+            }
+
+            *_encoding = DASessionGetEncoding( session );
+
+            DALogDebug( "  negotiated encoding, id = %@, encoding = 0x%08X.", session, *_encoding );
+
+            /*
+             * Add the session object to our tables.
+             */
+
+            ___os_transaction_begin( );
+
+            CFArrayAppendValue( gDASessionList, session );
+
+            /*
+             * Add the session to our run loop.
+             */
+
+            DASessionScheduleWithDispatch( session ); 
+
+#ifdef DA_FSKIT
+            DASessionSetIsFSKitd( session, is_fskitd );
+#endif
+
+            CFRelease( session );
+
+            status = kDAReturnSuccess;
+        }
+    }
+
+exit:
+    if ( status )
+    {
+        DALogDebug( "unable to create session, id = %s [%d].", _name, audit_token_to_pid( _token ) );
+    }
+
+    return status;
+}
+
+kern_return_t _DAServerSessionCreateCallbackRing( mach_port_t _session, uint32_t _size, mach_port_t * _ring, uint32_t * _ringSize )
+{
+    kern_return_t status;
+
+    status = kDAReturnBadArgument;
+
+    DALogDebugHeader( "? [?]:%d -> %s", _session, gDAProcessNameID );
+
+    if ( _session )
+    {
+        DASessionRef session;
+
+        session = __DASessionListGetSession( _session );
+
+        if ( session )
+        {
+            DALogDebugHeader( "%@ -> %s", session, gDAProcessNameID );
+
+            status = DASessionCreateCallbackRing( session, _size, _ring, _ringSize );
+
+            if ( status == KERN_SUCCESS )
+            {
+                DALogDebug( "  created callback ring, id = %@, size = %u.", session, *_ringSize );
+
+                status = kDAReturnSuccess;
+            }
+            else
+            {
+                status = kDAReturnNoResources;
+            }
+        }
+    }
+
+    if ( status )
+    {
+        DALogDebug( "unable to create callback ring, id = ? [?]:%d (status code 0x%08X).", _session, status );
+    }
+
+    return status;
+}
+
+kern_return_t _DAServerSessionQueueRequestWithUserToken( mach_port_t            _session,
+                                                         uint32_t               _kind,
+                                                         audit_token_t          _userToken,
+                                                         caddr_t                _argument0,
+                                                         int32_t                _argument1,
                                                          vm_address_t           _argument2,
                                                          mach_msg_type_number_t _argument2Size,
                                                          vm_address_t           _argument3,
@@ -2259,17 +2737,18 @@ kern_return_t _DAServerSessionQueueRequestWithUserToken( mach_port_t
     return kDAReturnNotPrivileged;
 }
 
-kern_return_t _DAServerSessionQueueRequest( mach_port_t            _session,
-                                            uint32_t                _kind,
-                                            caddr_t                _argument0,
-                                            int32_t                _argument1,
-                                            vm_address_t           _argument2,
-                                            mach_msg_type_number_t _argument2Size,
-                                            vm_address_t           _argument3,
-                                            mach_msg_type_number_t _argument3Size,
-                                            mach_vm_offset_t       _address,
-                                            mach_vm_offset_t       _context,
-                                            audit_token_t          _token )
+static kern_return_t __DAServerSessionQueueRequest( mach_port_t            _session,
+                                                    uint32_t               _kind,
+                                                    caddr_t                _argument0,
+                                                    int32_t                _argument1,
+                                                    vm_address_t           _argument2,
+                                                    mach_msg_type_number_t _argument2Size,
+                                                    vm_address_t           _argument3,
+                                                    mach_msg_type_number_t _argument3Size,
+                                                    mach_vm_offset_t       _address,
+                                                    mach_vm_offset_t       _context,
+                                                    audit_token_t          _token,
+                                                    CFMutableDictionaryRef batch )
 {
     kern_return_t status;
 
@@ -2310,12 +2789,18 @@ kern_return_t _DAServerSessionQueueRequest( mach_port_t            _session,
                     argument3 = _DAUnserializeWithBytes( kCFAllocatorDefault, _argument3, _argument3Size );
                 }
 
-                callback = DACallbackCreate( kCFAllocatorDefault, session, _address, _context, _kind, 0, NULL, NULL );
+                /*
+                 * A request submitted as part of a batch reports to the batch rather than to its own callback.
+                 */
+
+                callback = batch ? NULL : DACallbackCreate( kCFAllocatorDefault, session, _address, _context, _kind, 0, NULL, NULL );
                 
                 request = DARequestCreate( kCFAllocatorDefault, _kind, disk, _argument1, argument2, argument3, audit_token_to_euid( _token ), audit_token_to_egid( _token ), callback );
 
                 if ( request )
                 {
+                    DARequestSetBatch( request, batch );
+
                     switch ( _kind )
                     {
                         case _kDADiskEject:
@@ -2557,6 +3042,11 @@ kern_return_t _DAServerSessionQueueRequest( mach_port_t            _session,
 
                     if ( status == kDAReturnSuccess )
                     {
+                        if ( batch )
+                        {
+                            DARequestBatchEnter( batch );
+                        }
+
                         DAQueueRequest( request );
 
                         DALogInfo( "  %@ queued solicitation, id = %016llX:%016llX, kind = %s, disk = %@, options = 0x%08X.",
@@ -2602,132 +3092,319 @@ kern_return_t _DAServerSessionQueueRequest( mach_port_t            _session,
     return status;
 }
 
-kern_return_t _DAServerSessionQueueResponse( mach_port_t            _session,
+kern_return_t _DAServerSessionQueueRequest( mach_port_t            _session,
+                                            uint32_t               _kind,
+                                            caddr_t                _argument0,
+                                            int32_t                _argument1,
+                                            vm_address_t           _argument2,
+                                            mach_msg_type_number_t _argument2Size,
+                                            vm_address_t           _argument3,
+                                            mach_msg_type_number_t _argument3Size,
+                                            mach_vm_offset_t       _address,
+                                            mach_vm_offset_t       _context,
+                                            audit_token_t          _token )
+{
+    return __DAServerSessionQueueRequest( _session,
+                                          _kind,
+                                          _argument0,
+                                          _argument1,
+                                          _argument2,
+                                          _argument2Size,
+                                          _argument3,
+                                          _argument3Size,
+                                          _address,
+                                          _context,
+                                          _token,
+                                          NULL );
+}
+
+kern_return_t _DAServerSessionQueueRequests( mach_port_t            _session,
+                                             uint32_t               _kind,
+                                             vm_address_t           _disks,
+                                             mach_msg_type_number_t _disksSize,
+                                             int32_t                _argument1,
+                                             vm_address_t           _argument3,
+                                             mach_msg_type_number_t _argument3Size,
                                              mach_vm_offset_t       _address,
                                              mach_vm_offset_t       _context,
-                                             uint32_t                _kind,
-                                             caddr_t                _disk,
-                                             vm_address_t           _response,
-                                             mach_msg_type_number_t _responseSize,
-                                             int32_t                _responseID )
+                                             audit_token_t          _token )
 {
+    CFArrayRef    disks = NULL;
     kern_return_t status;
 
     status = kDAReturnBadArgument;
 
     DALogDebugHeader( "? [?]:%d -> %s", _session, gDAProcessNameID );
 
-    if ( _session )
+    if ( _session && _disks )
     {
-        DASessionRef session;
-
-        session = __DASessionListGetSession( _session );
+        if ( _kind == _kDADiskMount || _kind == _kDADiskUnmount )
+        {
+            disks = _DAUnserializeWithBytes( kCFAllocatorDefault, _disks, _disksSize );
+        }
+    }
 
-        if ( session )
+    if ( disks )
+    {
+        if ( CFGetTypeID( disks ) == CFArrayGetTypeID( ) )
         {
-            CFTypeRef response = NULL;
+            CFMutableSetRef set;
 
-            DALogDebugHeader( "%@ -> %s", session, gDAProcessNameID );
+            /*
+             * A disk may appear only once in a batch, since the dissenters are reported by disk.
+             */
 
-            if ( _response )
-            {
-                response = _DAUnserializeWithBytes( kCFAllocatorDefault, _response, _responseSize );
-            }
+            set = CFSetCreateMutable( kCFAllocatorDefault, 0, &kCFTypeSetCallBacks );
 
-            if ( _DAResponseDispatch( response, _responseID ) == FALSE )
+            if ( set )
             {
-                DALogDebug( "  dispatched response, id = %016llX:%016llX, kind = %s, disk = %s, orphaned.", _address, _context, _DACallbackKindGetName( _kind ), _disk );
-            }
+                CFIndex count;
+                CFIndex index;
 
-            if ( response )
-            {
-                CFRelease( response );
-            }
+                count = CFArrayGetCount( disks );
 
-            status = kDAReturnSuccess;
-        }
-    }
+                for ( index = 0; index < count; index++ )
+                {
+                    CFTypeRef id;
 
-    if ( status )
-    {
-        DALogDebug( "unable to dispatch response, id = %016llX:%016llX, disk = %s (status code 0x%08X).", _address, _context, _disk, status );
-    }
+                    id = CFArrayGetValueAtIndex( disks, index );
 
-    return status;
-}
+                    if ( CFGetTypeID( id ) != CFStringGetTypeID( ) || CFSetContainsValue( set, id ) )
+                    {
+                        break;
+                    }
 
-kern_return_t _DAServerSessionRegisterCallback( mach_port_t            _session,
-                                                mach_vm_offset_t       _address,
-                                                mach_vm_offset_t       _context,
-                                                uint32_t                _kind,
-                                                int32_t                _order,
-                                                vm_address_t           _match,
-                                                mach_msg_type_number_t _matchSize,
-                                                vm_address_t           _watch,
-                                                mach_msg_type_number_t _watchSize )
-{
-    kern_return_t status;
+                    CFSetAddValue( set, id );
+                }
 
-    status = kDAReturnBadArgument;
+                CFRelease( set );
 
-    DALogDebugHeader( "? [?]:%d -> %s", _session, gDAProcessNameID );
+                if ( index < count )
+                {
+                    CFRelease( disks );
 
-    if ( _session )
+                    disks = NULL;
+                }
+            }
+        }
+    }
+
+    if ( disks )
     {
         DASessionRef session;
 
         session = __DASessionListGetSession( _session );
 
-        if ( session )
+        if ( session && CFGetTypeID( disks ) == CFArrayGetTypeID( ) )
         {
-            DACallbackRef   callback;
-            CFDictionaryRef match = NULL;
-            CFArrayRef      watch = NULL;
+            DACallbackRef callback;
 
             DALogDebugHeader( "%@ -> %s", session, gDAProcessNameID );
 
-            if ( _kDADiskLastKind < _kind )
-            {
-                goto exit;
-            }
-
-            if ( _match )
-            {
-                match = _DAUnserializeDiskDescriptionWithBytes( kCFAllocatorDefault, _match, _matchSize );
-            }
-
-            if ( _watch )
-            {
-                watch = _DAUnserializeWithBytes( kCFAllocatorDefault, _watch, _watchSize );
-            }
-
-            callback = DACallbackCreate( kCFAllocatorDefault, session, _address, _context, _kind, _order, match, watch );
+            callback = DACallbackCreate( kCFAllocatorDefault, session, _address, _context, _kDADiskBatchCallback, 0, NULL, NULL );
 
             if ( callback )
             {
-                DASessionRegisterCallback( session, callback );
+                CFMutableDictionaryRef batch;
 
-                DALogDebug( "  registered callback, id = %016llX:%016llX, kind = %s.", _address, _context, _DACallbackKindGetName( _kind ) );
+                batch = DARequestBatchCreate( kCFAllocatorDefault, callback );
 
-                if ( DACallbackGetKind( callback ) == _kDADiskAppearedCallback )
+                if ( batch )
                 {
                     CFIndex count;
                     CFIndex index;
-                   
-                    count = CFArrayGetCount( gDADiskList );
+
+                    count = CFArrayGetCount( disks );
+
+                    /*
+                     * Queue each request just as if it had come in a message of its own.  The requests
+                     * for different disks proceed in parallel, while the requests for one disk proceed
+                     * in turn.  A request that cannot be queued is reported among the dissenters.
+                     */
 
                     for ( index = 0; index < count; index++ )
                     {
-                        DADiskRef disk;
+                        CFStringRef id;
+                        char *      path = NULL;
 
-                        disk = ( void * ) CFArrayGetValueAtIndex( gDADiskList, index );
+                        id = CFArrayGetValueAtIndex( disks, index );
+
+                        if ( CFGetTypeID( id ) == CFStringGetTypeID( ) )
+                        {
+                            path = ___CFStringCopyCString( id );
+                        }
 
-                        if ( DADiskGetState( disk, kDADiskStateStagedAppear ) )
+                        if ( path )
                         {
-                            DAQueueCallback( callback, disk, NULL );
+                            kern_return_t result;
+
+                            result = __DAServerSessionQueueRequest( _session,
+                                                                    _kind,
+                                                                    path,
+                                                                    _argument1,
+                                                                    0,
+                                                                    0,
+                                                                    _argument3,
+                                                                    _argument3Size,
+                                                                    _address,
+                                                                    _context,
+                                                                    _token,
+                                                                    batch );
+
+                            if ( result )
+                            {
+                                DADissenterRef dissenter;
+
+                                dissenter = DADissenterCreate( kCFAllocatorDefault, result );
+
+                                DARequestBatchEnter( batch );
+
+                                DARequestBatchLeave( batch, path, dissenter );
+
+                                CFRelease( dissenter );
+                            }
+
+                            free( path );
                         }
                     }
 
+                    DARequestBatchLeave( batch, NULL, NULL );
+
+                    status = kDAReturnSuccess;
+
+                    CFRelease( batch );
+                }
+
+                CFRelease( callback );
+            }
+        }
+
+        CFRelease( disks );
+    }
+
+    if ( status )
+    {
+        DALogDebug( "unable to queue solicitations, id = %016llX:%016llX, kind = %s (status code 0x%08X).",
+                    _address,
+                    _context,
+                    _DARequestKindGetName( _kind ),
+                    status );
+    }
+
+    return status;
+}
+
+kern_return_t _DAServerSessionQueueResponse( mach_port_t            _session,
+                                             mach_vm_offset_t       _address,
+                                             mach_vm_offset_t       _context,
+                                             uint32_t                _kind,
+                                             caddr_t                _disk,
+                                             vm_address_t           _response,
+                                             mach_msg_type_number_t _responseSize,
+                                             int32_t                _responseID )
+{
+    kern_return_t status;
+
+    status = kDAReturnBadArgument;
+
+    DALogDebugHeader( "? [?]:%d -> %s", _session, gDAProcessNameID );
+
+    if ( _session )
+    {
+        DASessionRef session;
+
+        session = __DASessionListGetSession( _session );
+
+        if ( session )
+        {
+            CFTypeRef response = NULL;
+
+            DALogDebugHeader( "%@ -> %s", session, gDAProcessNameID );
+
+            if ( _response )
+            {
+                response = _DAUnserializeWithBytes( kCFAllocatorDefault, _response, _responseSize );
+            }
+
+            if ( _DAResponseDispatch( response, _responseID ) == FALSE )
+            {
+                DALogDebug( "  dispatched response, id = %016llX:%016llX, kind = %s, disk = %s, orphaned.", _address, _context, _DACallbackKindGetName( _kind ), _disk );
+            }
+
+            if ( response )
+            {
+                CFRelease( response );
+            }
+
+            status = kDAReturnSuccess;
+        }
+    }
+
+    if ( status )
+    {
+        DALogDebug( "unable to dispatch response, id = %016llX:%016llX, disk = %s (status code 0x%08X).", _address, _context, _disk, status );
+    }
+
+    return status;
+}
+
+kern_return_t _DAServerSessionRegisterCallback( mach_port_t            _session,
+                                                mach_vm_offset_t       _address,
+                                                mach_vm_offset_t       _context,
+                                                uint32_t                _kind,
+                                                int32_t                _order,
+                                                vm_address_t           _match,
+                                                mach_msg_type_number_t _matchSize,
+                                                vm_address_t           _watch,
+                                                mach_msg_type_number_t _watchSize )
+{
+    kern_return_t status;
+
+    status = kDAReturnBadArgument;
+
+    DALogDebugHeader( "? [?]:%d -> %s", _session, gDAProcessNameID );
+
+    if ( _session )
+    {
+        DASessionRef session;
+
+        session = __DASessionListGetSession( _session );
+
+        if ( session )
+        {
+            DACallbackRef   callback;
+            CFDictionaryRef match = NULL;
+            CFArrayRef      watch = NULL;
+
+            DALogDebugHeader( "%@ -> %s", session, gDAProcessNameID );
+
+            if ( _kDADiskLastKind < _kind )
+            {
+                goto exit;
+            }
+
+            if ( _match )
+            {
+                match = _DAUnserializeDiskDescriptionWithBytes( kCFAllocatorDefault, _match, _matchSize );
+            }
+
+            if ( _watch )
+            {
+                watch = _DAUnserializeWithBytes( kCFAllocatorDefault, _watch, _watchSize );
+            }
+
+            callback = DACallbackCreate( kCFAllocatorDefault, session, _address, _context, _kind, _order, match, watch );
+
+            if ( callback )
+            {
+                DASessionRegisterCallback( session, callback );
+
+                DALogDebug( "  registered callback, id = %016llX:%016llX, kind = %s.", _address, _context, _DACallbackKindGetName( _kind ) );
+
+                if ( DACallbackGetKind( callback ) == _kDADiskAppearedCallback )
+                {
+                    __DADiskListQueueCallback( callback, DASessionGetGeneration( session ) );
+
                     DAQueueCallbacks( session, _kDADiskListCompleteCallback, NULL, NULL );
 
                     if ( gDAIdle )
@@ -2750,6 +3427,10 @@ kern_return_t _DAServerSessionRegisterCallback( mach_port_t            _session,
                         DASessionSetState( session, kDASessionStateIdle, FALSE );
                     }
                 }
+                else if ( DACallbackGetKind( callback ) == _kDADiskDisappearedCallback )
+                {
+                    __DADiskListQueueCallback( callback, DASessionGetGeneration( session ) );
+                }
 ///w:start
 #if TARGET_OS_OSX
                 else if ( DACallbackGetKind( callback ) == _kDADiskEjectApprovalCallback )
@@ -2808,6 +3489,152 @@ exit:
     return status;
 }
 
+kern_return_t _DAServerSessionRegisterCallbacks( mach_port_t _session, vm_address_t _callbacks, mach_msg_type_number_t _callbacksSize )
+{
+    CFArrayRef    callbacks = NULL;
+    kern_return_t status;
+
+    status = kDAReturnBadArgument;
+
+    if ( _session && _callbacks )
+    {
+        callbacks = _DAUnserializeWithBytes( kCFAllocatorDefault, _callbacks, _callbacksSize );
+    }
+
+    if ( callbacks )
+    {
+        if ( CFGetTypeID( callbacks ) == CFArrayGetTypeID( ) )
+        {
+            CFIndex count;
+            CFIndex index;
+
+            status = kDAReturnSuccess;
+
+            count = CFArrayGetCount( callbacks );
+
+            /*
+             * Register each callback just as if it had come in a message of its own.
+             */
+
+            for ( index = 0; index < count; index++ )
+            {
+                CFDictionaryRef callback;
+                kern_return_t   result = kDAReturnBadArgument;
+
+                callback = CFArrayGetValueAtIndex( callbacks, index );
+
+                if ( CFGetTypeID( callback ) == CFDictionaryGetTypeID( ) )
+                {
+                    CFDataRef match;
+                    CFDataRef watch;
+
+                    match = CFDictionaryGetValue( callback, _kDACallbackMatchKey );
+                    watch = CFDictionaryGetValue( callback, _kDACallbackWatchKey );
+
+                    if ( ( match == NULL || CFGetTypeID( match ) == CFDataGetTypeID( ) ) &&
+                         ( watch == NULL || CFGetTypeID( watch ) == CFDataGetTypeID( ) ) )
+                    {
+                        result = _DAServerSessionRegisterCallback( _session,
+                                                                   ( mach_vm_offset_t       ) ___CFDictionaryGetIntegerValue( callback, _kDACallbackAddressKey ),
+                                                                   ( mach_vm_offset_t       ) ___CFDictionaryGetIntegerValue( callback, _kDACallbackContextKey ),
+                                                                   ( uint32_t               ) ___CFDictionaryGetIntegerValue( callback, _kDACallbackKindKey    ),
+                                                                   ( int32_t                ) ___CFDictionaryGetIntegerValue( callback, _kDACallbackOrderKey   ),
+                                                                   ( vm_address_t           ) ( match ? CFDataGetBytePtr( match ) : 0 ),
+                                                                   ( mach_msg_type_number_t ) ( match ? CFDataGetLength(  match ) : 0 ),
+                                                                   ( vm_address_t           ) ( watch ? CFDataGetBytePtr( watch ) : 0 ),
+                                                                   ( mach_msg_type_number_t ) ( watch ? CFDataGetLength(  watch ) : 0 ) );
+                    }
+                }
+
+                if ( result )
+                {
+                    status = result;
+                }
+            }
+        }
+
+        CFRelease( callbacks );
+    }
+
+    if ( status )
+    {
+        DALogDebug( "unable to register callbacks, id = ? [?]:%d (status code 0x%08X).", _session, status );
+    }
+
+    return status;
+}
+
+kern_return_t _DAServerSessionResync( mach_port_t _session )
+{
+    kern_return_t status;
+
+    status = kDAReturnBadArgument;
+
+    DALogDebugHeader( "? [?]:%d -> %s", _session, gDAProcessNameID );
+
+    if ( _session )
+    {
+        DASessionRef session;
+
+        session = __DASessionListGetSession( _session );
+
+        if ( session )
+        {
+            DALogDebugHeader( "%@ -> %s", session, gDAProcessNameID );
+
+            if ( DASessionGetState( session, kDASessionStateResync ) )
+            {
+                CFArrayRef callbacks;
+                CFIndex    count;
+                CFIndex    index;
+
+                DASessionSetState( session, kDASessionStateResync, FALSE );
+
+                /*
+                 * Replay the disk list, as we would for a new registration, now that the client
+                 * has dropped what it knew.
+                 */
+
+                callbacks = DASessionGetCallbackRegister( session );
+
+                count = CFArrayGetCount( callbacks );
+
+                for ( index = 0; index < count; index++ )
+                {
+                    DACallbackRef callback;
+
+                    callback = ( void * ) CFArrayGetValueAtIndex( callbacks, index );
+
+                    if ( DACallbackGetKind( callback ) == _kDADiskAppearedCallback )
+                    {
+                        __DADiskListQueueCallback( callback, 0 );
+                    }
+                }
+
+                DAQueueCallbacks( session, _kDADiskListCompleteCallback, NULL, NULL );
+
+                if ( gDAIdle )
+                {
+                    DAQueueCallbacks( session, _kDAIdleCallback, NULL, NULL );
+
+                    DASessionSetState( session, kDASessionStateIdle, TRUE );
+                }
+
+                DALogDebug( "  resynchronized session, id = %@.", session );
+            }
+
+            status = kDAReturnSuccess;
+        }
+    }
+
+    if ( status )
+    {
+        DALogDebug( "unable to resynchronize session, id = ? [?]:%d.", _session );
+    }
+
+    return status;
+}
+
 kern_return_t _DAServerSessionRelease( mach_port_t _session )
 {
     kern_return_t status;
@@ -2846,37 +3673,170 @@ kern_return_t _DAServerSessionRelease( mach_port_t _session )
 
             DAQueueReleaseSession( session );
 
-            /*
-             * Remove the session object from our tables.
-             */
+            /*
+             * Remove the session object from our tables.
+             */
+
+            DASessionSetState( session, kDASessionStateZombie, TRUE );
+
+
+            if ( DASessionGetKeepAlive( session ) == false )
+            {
+                ___os_transaction_end( );
+
+                __DASetIdleTimer();
+            }
+
+            ___CFArrayRemoveValue( gDASessionList, session );
+            
+            status = kDAReturnSuccess;
+        }
+    }
+
+    if ( status )
+    {
+        DALogDebug( "unable to release session, id = ? [?]:%d.", _session );
+    }
+
+    return status;
+}
+
+
+kern_return_t _DAServerSessionCancel( mach_port_t _session )
+
+{
+    kern_return_t status;
+
+    status = kDAReturnBadArgument;
+
+    DALogDebugHeader( "? [?]:%d -> %s", _session, gDAProcessNameID );
+
+    if ( _session )
+    {
+        DASessionRef session;
+
+        session = __DASessionListGetSession( _session );
+
+        if ( session )
+        {
+            DASessionCancelChannel( session );
+            status = kDAReturnSuccess;
+        }
+    }
+}
+
+kern_return_t _DAServerSessionCancelRequest( mach_port_t _session, mach_vm_offset_t _address, mach_vm_offset_t _context )
+{
+    kern_return_t status;
+
+    status = kDAReturnBadArgument;
+
+    DALogDebugHeader( "? [?]:%d -> %s", _session, gDAProcessNameID );
+
+    if ( _session )
+    {
+        DASessionRef session;
+
+        session = __DASessionListGetSession( _session );
+
+        if ( session )
+        {
+            DALogDebugHeader( "%@ -> %s", session, gDAProcessNameID );
+
+            status = DAQueueCancelRequests( session, _address, _context );
+
+            if ( status == kDAReturnSuccess )
+            {
+                DALogInfo( "  %@ cancelled solicitation, id = %016llX:%016llX.", session, _address, _context );
+            }
+        }
+    }
+
+    if ( status )
+    {
+        DALogDebug( "unable to cancel solicitation, id = %016llX:%016llX (status code 0x%08X).", _address, _context, status );
+    }
+
+    return status;
+}
+
+#if TARGET_OS_OSX
+kern_return_t _DAServerSessionSetAuthorization( mach_port_t _session, AuthorizationExternalForm _authorization )
+{
+    kern_return_t status;
+
+    status = kDAReturnBadArgument;
+
+    DALogDebugHeader( "? [?]:%d -> %s", _session, gDAProcessNameID );
+
+    if ( _session )
+    {
+        DASessionRef session;
+
+        session = __DASessionListGetSession( _session );
+
+        if ( session )
+        {
+            AuthorizationRef authorization;
+
+            DALogDebugHeader( "%@ -> %s", session, gDAProcessNameID );
+
+            status = AuthorizationCreateFromExternalForm( &_authorization, &authorization );
+
+            if ( status == errAuthorizationSuccess )
+            {
+                DASessionSetAuthorization( session, authorization );
+
+                DALogDebug( "  set authorization, id = %@.", session );
+
+                status = kDAReturnSuccess;
+            }
+        }
+    }
+
+    if ( status )
+    {
+        DALogDebug( "unable to set authorization, id = ? [?]:%d.", _session );
+    }
+
+    return status;
+}
+#endif
+
+kern_return_t _DAServerSessionSetKeepAlive(  mach_port_t _session )
+{
+    kern_return_t status;
 
-            DASessionSetState( session, kDASessionStateZombie, TRUE );
+    status = kDAReturnBadArgument;
 
+    DALogDebugHeader( "? [?]:%d -> %s", _session, gDAProcessNameID );
 
-            if ( DASessionGetKeepAlive( session ) == false )
-            {
-                ___os_transaction_end( );
+    if ( _session )
+    {
+        DASessionRef session;
 
-                __DASetIdleTimer();
-            }
+        session = __DASessionListGetSession( _session );
 
-            ___CFArrayRemoveValue( gDASessionList, session );
-            
+        if ( session )
+        {
+            DALogDebugHeader( "%@ -> %s", session, gDAProcessNameID );
+            DALogDebug( "  set keepalive, id = %@.", session );
+            DASessionSetKeepAlive( session, true );
+            ___os_transaction_end( );
+            __DASetIdleTimer();
             status = kDAReturnSuccess;
         }
     }
 
     if ( status )
     {
-        DALogDebug( "unable to release session, id = ? [?]:%d.", _session );
+        DALogDebug( "unable to set keep alive,  (status code 0x%08X).", status );
     }
 
     return status;
 }
 
-
-kern_return_t _DAServerSessionCancel( mach_port_t _session )
-
+kern_return_t _DAServerSessionSetClientPort( mach_port_t _session, mach_port_t _client )
 {
     kern_return_t status;
 
@@ -2892,14 +3852,25 @@ kern_return_t _DAServerSessionCancel( mach_port_t _session )
 
         if ( session )
         {
-            DASessionCancelChannel( session );
+            DALogDebugHeader( "%@ -> %s", session, gDAProcessNameID );
+
+            DASessionSetClientPort( session, _client );
+
+            DALogDebug( "  set client port, id = %@.", session );
+
             status = kDAReturnSuccess;
         }
     }
+
+    if ( status )
+    {
+        DALogDebug( "unable to set client port, id = ? [?]:%d.", _session );
+    }
+
+    return status;
 }
 
-#if TARGET_OS_OSX
-kern_return_t _DAServerSessionSetAuthorization( mach_port_t _session, AuthorizationExternalForm _authorization )
+kern_return_t _DAServerSessionSetCoalescingInterval( mach_port_t _session, uint32_t _interval )
 {
     kern_return_t status;
 
@@ -2915,17 +3886,13 @@ kern_return_t _DAServerSessionSetAuthorization( mach_port_t _session, Authorizat
 
         if ( session )
         {
-            AuthorizationRef authorization;
-
             DALogDebugHeader( "%@ -> %s", session, gDAProcessNameID );
 
-            status = AuthorizationCreateFromExternalForm( &_authorization, &authorization );
-
-            if ( status == errAuthorizationSuccess )
+            if ( _interval <= _kDACoalescingIntervalMaximum )
             {
-                DASessionSetAuthorization( session, authorization );
+                DASessionSetCoalescingInterval( session, _interval );
 
-                DALogDebug( "  set authorization, id = %@.", session );
+                DALogDebug( "  set coalescing interval, id = %@, interval = %u ms.", session, _interval );
 
                 status = kDAReturnSuccess;
             }
@@ -2934,14 +3901,13 @@ kern_return_t _DAServerSessionSetAuthorization( mach_port_t _session, Authorizat
 
     if ( status )
     {
-        DALogDebug( "unable to set authorization, id = ? [?]:%d.", _session );
+        DALogDebug( "unable to set coalescing interval, id = ? [?]:%d.", _session );
     }
 
     return status;
 }
-#endif
 
-kern_return_t _DAServerSessionSetKeepAlive(  mach_port_t _session )
+kern_return_t _DAServerSessionSetGeneration( mach_port_t _session, uint64_t _generation )
 {
     kern_return_t status;
 
@@ -2958,23 +3924,36 @@ kern_return_t _DAServerSessionSetKeepAlive(  mach_port_t _session )
         if ( session )
         {
             DALogDebugHeader( "%@ -> %s", session, gDAProcessNameID );
-            DALogDebug( "  set keepalive, id = %@.", session );
-            DASessionSetKeepAlive( session, true );
-            ___os_transaction_end( );
-            __DASetIdleTimer();
-            status = kDAReturnSuccess;
+
+            /*
+             * A generation is only good if it carries our epoch and we still remember every removal
+             * since it, which rules out a generation handed out by an earlier instance of the daemon.
+             */
+
+            if ( _generation == 0 || ( ( _generation >> 32 ) == ( gDADiskListGeneration >> 32 ) && _generation >= gDADiskListHorizon && _generation <= gDADiskListGeneration ) )
+            {
+                DASessionSetGeneration( session, _generation );
+
+                DALogDebug( "  set generation, id = %@, generation = %llu.", session, _generation );
+
+                status = kDAReturnSuccess;
+            }
+            else
+            {
+                status = kDAReturnNotFound;
+            }
         }
     }
 
     if ( status )
     {
-        DALogDebug( "unable to set keep alive,  (status code 0x%08X).", status );
+        DALogDebug( "unable to set generation, id = ? [?]:%d (status code 0x%08X).", _session, status );
     }
 
     return status;
 }
 
-kern_return_t _DAServerSessionSetClientPort( mach_port_t _session, mach_port_t _client )
+kern_return_t _DAServerSessionSetQueueLimit( mach_port_t _session, uint32_t _limit )
 {
     kern_return_t status;
 
@@ -2992,17 +3971,20 @@ kern_return_t _DAServerSessionSetClientPort( mach_port_t _session, mach_port_t _
         {
             DALogDebugHeader( "%@ -> %s", session, gDAProcessNameID );
 
-            DASessionSetClientPort( session, _client );
+            if ( _limit == 0 || ( _limit >= _kDASessionQueueLimitMinimum && _limit <= _kDASessionQueueLimitMaximum ) )
+            {
+                DASessionSetQueueLimit( session, _limit );
 
-            DALogDebug( "  set client port, id = %@.", session );
+                DALogDebug( "  set queue limit, id = %@, limit = %u.", session, DASessionGetQueueLimit( session ) );
 
-            status = kDAReturnSuccess;
+                status = kDAReturnSuccess;
+            }
         }
     }
 
     if ( status )
     {
-        DALogDebug( "unable to set client port, id = ? [?]:%d.", _session );
+        DALogDebug( "unable to set queue limit, id = ? [?]:%d.", _session );
     }
 
     return status;
@@ -3123,95 +4105,277 @@ void _DADiskCreateFromFSStat(struct statfs *fs)
 
 }
     
-void _DAVolumeMountedCallback(  )
+static CFDictionaryRef __gDAVolumeListPrevious = NULL;
+
+static Boolean __DAVolumeEqual( const struct statfs * fs1, const struct statfs * fs2 )
 {
-  
-        struct statfs * mountList;
-        int             mountListCount;
-        int             mountListIndex;
+    /*
+     * Compare the identity and the mount state of two mount table entries, leaving out the
+     * usage counts that change as the volume is written.
+     */
 
-        mountListCount = getmntinfo( &mountList, MNT_NOWAIT );
+    if ( fs1->f_fsid.val[0] != fs2->f_fsid.val[0] )  return FALSE;
+    if ( fs1->f_fsid.val[1] != fs2->f_fsid.val[1] )  return FALSE;
+    if ( fs1->f_flags       != fs2->f_flags       )  return FALSE;
+    if ( fs1->f_owner       != fs2->f_owner       )  return FALSE;
 
-        for ( mountListIndex = 0; mountListIndex < mountListCount; mountListIndex++ )
-        {
-            DADiskRef disk;
-            
-            disk = DADiskListGetDisk( _DAVolumeGetID( mountList + mountListIndex ) );
+    if ( strcmp( fs1->f_fstypename, fs2->f_fstypename ) )  return FALSE;
+    if ( strcmp( fs1->f_mntfromname, fs2->f_mntfromname ) )  return FALSE;
+    if ( strcmp( fs1->f_mntonname, fs2->f_mntonname ) )  return FALSE;
 
-            if ( disk )
-            {
-                if ( DADiskGetDescription( disk, kDADiskDescriptionVolumePathKey ) == NULL )
-                {
-///w:start
-                    if ( DADiskGetDescription( disk, kDADiskDescriptionVolumeMountableKey ) == kCFBooleanFalse )
-                    {
-                        DADiskProbe( disk, NULL );
-                    }
-///w:stop
-                    DADiskRefresh( disk, NULL );
-                }
-            }
-            else
-            {
-///w:start
-                if ( strncmp( mountList[mountListIndex].f_mntfromname, _PATH_DEV "disk", strlen( _PATH_DEV "disk" ) ) )
-///w:stop
-                    if ( ( mountList[mountListIndex].f_flags & MNT_UNION ) == 0 )
-                    {
-                        if ( strcmp( mountList[mountListIndex].f_fstypename, "devfs" ) )
-                        {
-                            _DADiskCreateFromFSStat( &mountList[mountListIndex] );
-                            DAStageSignal( );
-                        }
-                    }
-            }
-        }
-      
+    return TRUE;
 }
 
-void _DAVolumeUnmountedCallback(  )
+struct __DAVolumeListContext
+{
+    CFDictionaryRef   list;
+    CFMutableArrayRef added;
+    CFMutableArrayRef changed;
+    CFMutableArrayRef removed;
+};
+
+typedef struct __DAVolumeListContext __DAVolumeListContext;
+
+static void __DAVolumeListCompareValue( const void * key, const void * value, void * context )
+{
+    __DAVolumeListContext * delta = context;
+    CFDataRef               previous;
+
+    previous = __gDAVolumeListPrevious ? CFDictionaryGetValue( __gDAVolumeListPrevious, key ) : NULL;
+
+    if ( previous == NULL )
+    {
+        CFArrayAppendValue( delta->added, value );
+    }
+    else if ( __DAVolumeEqual( ( void * ) CFDataGetBytePtr( previous ), ( void * ) CFDataGetBytePtr( value ) ) == FALSE )
+    {
+        CFArrayAppendValue( delta->changed, value );
+    }
+}
+
+static void __DAVolumeListRemoveValue( const void * key, const void * value, void * context )
+{
+    __DAVolumeListContext * delta = context;
+
+    if ( CFDictionaryContainsKey( delta->list, key ) == FALSE )
+    {
+        CFArrayAppendValue( delta->removed, value );
+    }
+}
+
+static Boolean __DAVolumeListUpdate( CFMutableArrayRef added, CFMutableArrayRef changed, CFMutableArrayRef removed )
+{
+    __DAVolumeListContext delta;
+    CFDictionaryRef       list;
+    Boolean               known;
+
+    /*
+     * Compare the mount table against the one seen on the previous notification, keyed by
+     * volume ID, and sort each entry into those added, changed or removed since.  The delta
+     * is unknown on the first notification, where every entry is reported as added.  The
+     * mount table is taken from the shared snapshot, which the refreshes that follow reuse.
+     */
+
+    DAVolumeListInvalidate( );
+
+    list = DAVolumeListCopy( );
+
+    if ( list == NULL )
+    {
+        return FALSE;
+    }
+
+    if ( CFDictionaryGetCount( list ) == 0 )
+    {
+        CFRelease( list );
+
+        return FALSE;
+    }
+
+    known = __gDAVolumeListPrevious ? TRUE : FALSE;
+
+    delta.list    = list;
+    delta.added   = added;
+    delta.changed = changed;
+    delta.removed = removed;
+
+    CFDictionaryApplyFunction( list, __DAVolumeListCompareValue, &delta );
+
+    if ( __gDAVolumeListPrevious )
+    {
+        CFDictionaryApplyFunction( __gDAVolumeListPrevious, __DAVolumeListRemoveValue, &delta );
+
+        CFRelease( __gDAVolumeListPrevious );
+    }
+
+    __gDAVolumeListPrevious = list;
+
+    return known;
+}
+
+static void __DAVolumeListRefresh( CFArrayRef volumes )
 {
     CFIndex count;
     CFIndex index;
 
+    count = CFArrayGetCount( volumes );
 
+    for ( index = 0; index < count; index++ )
+    {
+        DADiskRef disk;
 
-        count = CFArrayGetCount( gDADiskList );
+        disk = DADiskListGetDisk( DAVolumeGetID( ( void * ) CFDataGetBytePtr( CFArrayGetValueAtIndex( volumes, index ) ) ) );
 
-        for ( index = 0; index < count; index++ )
+        if ( disk )
         {
-            DADiskRef disk;
-
-            disk = ( void * ) CFArrayGetValueAtIndex( gDADiskList, index );
-
             if ( DADiskGetDescription( disk, kDADiskDescriptionVolumePathKey ) )
             {
                 DADiskRefresh( disk, NULL );
             }
         }
-        
+    }
 }
 
-void _DAVolumeUpdatedCallback(  )
+static void __DAVolumeListRefreshAll( void )
 {
     CFIndex count;
     CFIndex index;
 
- 
-        
-        count = CFArrayGetCount( gDADiskList );
+    count = CFArrayGetCount( gDADiskList );
 
-        for ( index = 0; index < count; index++ )
+    for ( index = 0; index < count; index++ )
+    {
+        DADiskRef disk;
+
+        disk = ( void * ) CFArrayGetValueAtIndex( gDADiskList, index );
+
+        if ( DADiskGetDescription( disk, kDADiskDescriptionVolumePathKey ) )
         {
-            DADiskRef disk;
+            DADiskRefresh( disk, NULL );
+        }
+    }
+}
 
-            disk = ( void * ) CFArrayGetValueAtIndex( gDADiskList, index );
+static void __DAVolumeListAppeared( CFArrayRef volumes )
+{
+    CFIndex count;
+    CFIndex index;
 
-            if ( DADiskGetDescription( disk, kDADiskDescriptionVolumePathKey ) )
+    count = CFArrayGetCount( volumes );
+
+    for ( index = 0; index < count; index++ )
+    {
+        DADiskRef       disk;
+        struct statfs * fs;
+
+        fs = ( void * ) CFDataGetBytePtr( CFArrayGetValueAtIndex( volumes, index ) );
+
+        disk = DADiskListGetDisk( DAVolumeGetID( fs ) );
+
+        if ( disk )
+        {
+            if ( DADiskGetDescription( disk, kDADiskDescriptionVolumePathKey ) == NULL )
             {
+///w:start
+                if ( DADiskGetDescription( disk, kDADiskDescriptionVolumeMountableKey ) == kCFBooleanFalse )
+                {
+                    DADiskProbe( disk, NULL );
+                }
+///w:stop
                 DADiskRefresh( disk, NULL );
             }
         }
+        else
+        {
+///w:start
+            if ( strncmp( fs->f_mntfromname, _PATH_DEV "disk", strlen( _PATH_DEV "disk" ) ) )
+///w:stop
+                if ( ( fs->f_flags & MNT_UNION ) == 0 )
+                {
+                    if ( strcmp( fs->f_fstypename, "devfs" ) )
+                    {
+                        _DADiskCreateFromFSStat( fs );
+                        DAStageSignal( );
+                    }
+                }
+        }
+    }
+}
+
+static Boolean __DAVolumeListProcess( Boolean * changes )
+{
+    CFMutableArrayRef added;
+    CFMutableArrayRef changed;
+    Boolean           known = FALSE;
+    CFMutableArrayRef removed;
+
+    /*
+     * Act on the delta of the mount table, whichever notification brought it in.  The mount,
+     * unmount and update notifications arrive on channels of their own and may be coalesced,
+     * so each one takes on every change since the last.
+     */
+
+    *changes = FALSE;
+
+    added   = CFArrayCreateMutable( kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks );
+    changed = CFArrayCreateMutable( kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks );
+    removed = CFArrayCreateMutable( kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks );
+
+    if ( added && changed && removed )
+    {
+        known = __DAVolumeListUpdate( added, changed, removed );
+
+        __DAVolumeListAppeared( added );
+
+        __DAVolumeListRefresh( changed );
+
+        __DAVolumeListRefresh( removed );
+
+        *changes = ( CFArrayGetCount( added ) || CFArrayGetCount( changed ) || CFArrayGetCount( removed ) ) ? TRUE : FALSE;
+    }
+
+    if ( added   )  CFRelease( added   );
+    if ( changed )  CFRelease( changed );
+    if ( removed )  CFRelease( removed );
+
+    return known;
+}
+
+void _DAVolumeMountedCallback(  )
+{
+    Boolean changes;
+
+    __DAVolumeListProcess( &changes );
+}
+
+void _DAVolumeUnmountedCallback(  )
+{
+    Boolean changes;
+
+    /*
+     * Without a previous mount table the unmounted volumes are unknown, so every mounted disk
+     * is refreshed instead.
+     */
+
+    if ( __DAVolumeListProcess( &changes ) == FALSE )
+    {
+        __DAVolumeListRefreshAll( );
+    }
+}
+
+void _DAVolumeUpdatedCallback(  )
+{
+    Boolean changes;
+
+    /*
+     * A volume rename leaves the mount table as it was, so an update that changes no entry
+     * still refreshes every mounted disk.
+     */
+
+    if ( __DAVolumeListProcess( &changes ) == FALSE || changes == FALSE )
+    {
+        __DAVolumeListRefreshAll( );
+    }
 }
 
 dispatch_workloop_t DAServerWorkLoop( void )
@@ -24,10 +24,12 @@
 #include "DASession.h"
 
 #include "DACallback.h"
+#include "DAMain.h"
 #include "DAServer.h"
 #include "DASupport.h"
 
 #include <mach/mach.h>
+#include <mach/mach_vm.h>
 #include <CoreFoundation/CoreFoundation.h>
 #include <CoreFoundation/CFRuntime.h>
 #include <dispatch/private.h>
@@ -39,11 +41,20 @@ struct __DASession
     AuthorizationRef   _authorization;
 #endif
     mach_port_t        _client;
+    CFMutableArrayRef  _coalesce;
+    UInt32             _coalesceID;
+    _DAEncoding        _encoding;
+    UInt64             _generation;
+    UInt32             _interval;
     char *             _name;
     pid_t              _pid;
     DASessionOptions   _options;
     CFMutableArrayRef  _queue;
+    UInt32             _queueLimit;
     CFMutableArrayRef  _register;
+    CFMutableBagRef    _resync;
+    _DACallbackRing *  _ring;
+    uint32_t           _ringSize;
     dispatch_mach_t     _serverChannel;
     mach_port_t         _server;
     DASessionState      _state;
@@ -61,6 +72,29 @@ static void         __DASessionDeallocate( CFTypeRef object );
 static Boolean      __DASessionEqual( CFTypeRef object1, CFTypeRef object2 );
 static CFHashCode   __DASessionHash( CFTypeRef object );
 
+static void __DASessionNotify( DASessionRef session )
+{
+    if ( session->_client )
+    {
+        mach_msg_header_t message;
+        kern_return_t     status;
+
+        message.msgh_bits        = MACH_MSGH_BITS( MACH_MSG_TYPE_COPY_SEND, 0 );
+        message.msgh_id          = 0;
+        message.msgh_local_port  = MACH_PORT_NULL;
+        message.msgh_remote_port = session->_client;
+        message.msgh_reserved    = 0;
+        message.msgh_size        = sizeof( message );
+
+        status = mach_msg( &message, MACH_SEND_MSG | MACH_SEND_TIMEOUT, message.msgh_size, 0, MACH_PORT_NULL, 0, MACH_PORT_NULL );
+
+        if ( status == MACH_SEND_TIMED_OUT )
+        {
+            mach_msg_destroy( &message );
+        }
+    }
+}
+
 static const CFRuntimeClass __DASessionClass =
 {
     0,
@@ -114,11 +148,20 @@ static DASessionRef __DASessionCreate( CFAllocatorRef allocator )
         session->_authorization = NULL;
 #endif
         session->_client        = MACH_PORT_NULL;
+        session->_coalesce      = CFArrayCreateMutable( allocator, 0, &kCFTypeArrayCallBacks );
+        session->_coalesceID    = 0;
+        session->_encoding      = _kDAEncodingPropertyList;
+        session->_generation    = 0;
+        session->_interval      = 0;
         session->_name          = NULL;
         session->_pid           = 0;
         session->_options       = 0;
         session->_queue         = CFArrayCreateMutable( allocator, 0, &kCFTypeArrayCallBacks );
+        session->_queueLimit    = _kDASessionQueueLimitDefault;
         session->_register      = CFArrayCreateMutable( allocator, 0, &kCFTypeArrayCallBacks );
+        session->_resync        = CFBagCreateMutable( allocator, 0, &kCFTypeBagCallBacks );
+        session->_ring          = NULL;
+        session->_ringSize      = 0;
         session->_server        = NULL;
         session->_state         = 0;
         session->_keepAlive     = false;
@@ -126,8 +169,10 @@ static DASessionRef __DASessionCreate( CFAllocatorRef allocator )
         session->_isFskitd      = false;
 #endif
 
+        assert( session->_coalesce );
         assert( session->_queue    );
         assert( session->_register );
+        assert( session->_resync   );
     }
 
     return session;
@@ -140,9 +185,12 @@ static void __DASessionDeallocate( CFTypeRef object )
     if ( session->_authorization )  AuthorizationFree( session->_authorization, kAuthorizationFlagDefaults );
 #endif
     if ( session->_client        )  mach_port_deallocate( mach_task_self( ), session->_client );
+    if ( session->_coalesce      )  CFRelease( session->_coalesce );
     if ( session->_name          )  free( session->_name );
     if ( session->_queue         )  CFRelease( session->_queue );
     if ( session->_register      )  CFRelease( session->_register );
+    if ( session->_resync        )  CFRelease( session->_resync );
+    if ( session->_ring          )  mach_vm_deallocate( mach_task_self( ), ( mach_vm_address_t ) session->_ring, sizeof( _DACallbackRing ) + session->_ringSize );
 
 
     if ( session->_server )
@@ -238,6 +286,77 @@ DASessionRef DASessionCreate( CFAllocatorRef allocator, const char * _name, pid_
 
     return NULL;
 }
+kern_return_t DASessionCreateCallbackRing( DASessionRef session, uint32_t size, mach_port_t * ring, uint32_t * ringSize )
+{
+    mach_vm_address_t address;
+    kern_return_t     status;
+
+    /*
+     * Create the memory shared with the client for callback delivery.  An existing ring is kept
+     * as is, since the client may still hold undelivered records in it.
+     */
+
+    if ( session->_ring )
+    {
+        return KERN_INVALID_ARGUMENT;
+    }
+
+    if ( size == 0 )
+    {
+        size = _kDACallbackRingSizeDefault;
+    }
+
+    size = MAX( size, _kDACallbackRingSizeMinimum );
+    size = MIN( size, _kDACallbackRingSizeMaximum );
+
+    size = ( uint32_t ) mach_vm_round_page( sizeof( _DACallbackRing ) + size ) - sizeof( _DACallbackRing );
+    size = size & ~0x7;
+
+    address = 0;
+
+    status = mach_vm_allocate( mach_task_self( ), &address, sizeof( _DACallbackRing ) + size, VM_FLAGS_ANYWHERE );
+
+    if ( status == KERN_SUCCESS )
+    {
+        memory_object_size_t entrySize;
+
+        entrySize = sizeof( _DACallbackRing ) + size;
+
+        status = mach_make_memory_entry_64( mach_task_self( ),
+                                            &entrySize,
+                                            address,
+                                            VM_PROT_READ | VM_PROT_WRITE,
+                                            ring,
+                                            MACH_PORT_NULL );
+
+        if ( status == KERN_SUCCESS )
+        {
+            _DACallbackRing * header;
+
+            header = ( void * ) address;
+
+            header->version = _kDACallbackRingVersion;
+            header->size    = size;
+
+            atomic_store( &header->armed,    1 );
+            atomic_store( &header->overflow, CFArrayGetCount( session->_queue ) ? 1 : 0 );
+            atomic_store( &header->head,     0 );
+            atomic_store( &header->tail,     0 );
+
+            session->_ring     = header;
+            session->_ringSize = size;
+
+            *ringSize = size;
+
+            return KERN_SUCCESS;
+        }
+
+        mach_vm_deallocate( mach_task_self( ), address, sizeof( _DACallbackRing ) + size );
+    }
+
+    return status;
+}
+
 #if TARGET_OS_OSX
 AuthorizationRef DASessionGetAuthorization( DASessionRef session )
 {
@@ -250,11 +369,55 @@ CFMutableArrayRef DASessionGetCallbackQueue( DASessionRef session )
     return session->_queue;
 }
 
+CFIndex DASessionGetCallbackQueueSize( DASessionRef session )
+{
+    CFIndex count;
+    CFIndex index;
+    CFIndex size;
+
+    /*
+     * Account for the disk descriptions we hold for the client, which make up the bulk of a queue.
+     */
+
+    size = 0;
+
+    count = CFArrayGetCount( session->_queue );
+
+    for ( index = 0; index < count; index++ )
+    {
+        CFTypeRef argument0;
+
+        argument0 = DACallbackGetArgument0( ( void * ) CFArrayGetValueAtIndex( session->_queue, index ) );
+
+        if ( argument0 && CFGetTypeID( argument0 ) == CFDataGetTypeID( ) )
+        {
+            size += CFDataGetLength( argument0 );
+        }
+    }
+
+    return size;
+}
+
 CFMutableArrayRef DASessionGetCallbackRegister( DASessionRef session )
 {
     return session->_register;
 }
 
+UInt32 DASessionGetCoalescingInterval( DASessionRef session )
+{
+    return session->_interval;
+}
+
+_DAEncoding DASessionGetEncoding( DASessionRef session )
+{
+    return session->_encoding;
+}
+
+UInt64 DASessionGetGeneration( DASessionRef session )
+{
+    return session->_generation;
+}
+
 mach_port_t DASessionGetID( DASessionRef session )
 {
     return session->_server;
@@ -280,6 +443,16 @@ DASessionOptions DASessionGetOptions( DASessionRef session )
     return session->_options;
 }
 
+pid_t DASessionGetProcessID( DASessionRef session )
+{
+    return session->_pid;
+}
+
+UInt32 DASessionGetQueueLimit( DASessionRef session )
+{
+    return session->_queueLimit;
+}
+
 mach_port_t DASessionGetServerPort( DASessionRef session )
 {
     return  session->_server ;
@@ -305,34 +478,360 @@ void DASessionInitialize( void )
     __kDASessionTypeID = _CFRuntimeRegisterClass( &__DASessionClass );
 }
 
-void DASessionQueueCallback( DASessionRef session, DACallbackRef callback )
+static Boolean __DASessionCallbackIsNotification( DACallbackRef callback )
+{
+    /*
+     * Determine whether the callback reports disk state, which a resynchronization replays, as
+     * opposed to a request completion or an approval that the client must see.
+     */
+
+    switch ( DACallbackGetKind( callback ) )
+    {
+        case _kDADiskAppearedCallback:
+        case _kDADiskDescriptionChangedCallback:
+        case _kDADiskDisappearedCallback:
+        case _kDADiskListCompleteCallback:
+        case _kDAIdleCallback:
+        {
+            return TRUE;
+        }
+        default:
+        {
+            return FALSE;
+        }
+    }
+}
+
+static Boolean __DASessionCallbackIsReplayed( DASessionRef session, DACallbackRef callback )
+{
+    /*
+     * Determine whether a resynchronization covers the callback, in which case it can be dropped.
+     * The replay reports only the disks that exist, so a disappearance is kept unless the client
+     * never learned of the disk, because we also dropped the appearance that would announce it.
+     */
+
+    switch ( DACallbackGetKind( callback ) )
+    {
+        case _kDADiskAppearedCallback:
+        {
+            CFBagAddValue( session->_resync, DACallbackGetDisk( callback ) );
+
+            return TRUE;
+        }
+        case _kDADiskDisappearedCallback:
+        {
+            if ( DACallbackGetDisk( callback ) == NULL )
+            {
+                return FALSE;
+            }
+
+            if ( CFBagContainsValue( session->_resync, DACallbackGetDisk( callback ) ) )
+            {
+                CFBagRemoveValue( session->_resync, DACallbackGetDisk( callback ) );
+
+                return TRUE;
+            }
+
+            return FALSE;
+        }
+        default:
+        {
+            return __DASessionCallbackIsNotification( callback );
+        }
+    }
+}
+
+static void __DASessionQueueResync( DASessionRef session )
+{
+    DACallbackRef callback;
+    CFIndex       count;
+    CFIndex       index;
+
+    /*
+     * The client is not draining its queue.  Drop the disk state callbacks we hold for it and ask
+     * it to resynchronize instead, which bounds what a stalled client costs us.
+     */
+
+    DALogError( "%@ fell behind by %ld callbacks, resynchronizing.", session, CFArrayGetCount( session->_queue ) );
+
+    count = CFArrayGetCount( session->_queue );
+
+    for ( index = 0; index < count; )
+    {
+        if ( __DASessionCallbackIsReplayed( session, ( void * ) CFArrayGetValueAtIndex( session->_queue, index ) ) )
+        {
+            CFArrayRemoveValueAtIndex( session->_queue, index );
+
+            count--;
+        }
+        else
+        {
+            index++;
+        }
+    }
+
+    callback = DACallbackCreate( kCFAllocatorDefault, session, 0, 0, _kDASessionResyncCallback, 0, NULL, NULL );
+
+    if ( callback )
+    {
+        CFArrayAppendValue( session->_queue, callback );
+
+        CFRelease( callback );
+    }
+
+    session->_state |= kDASessionStateResync;
+
+    gDAStatistics.sessionResyncs++;
+
+    if ( CFArrayGetCount( session->_queue ) == 1 )
+    {
+        __DASessionNotify( session );
+    }
+}
+
+static void __DASessionQueueCallback( DASessionRef session, DACallbackRef callback )
 {
     session->_state &= ~kDASessionStateIdle;
-    
+
+    if ( ( session->_state & kDASessionStateResync ) )
+    {
+        /*
+         * The resynchronization replays the disk state, so there is no need to report it now.
+         */
+
+        if ( __DASessionCallbackIsReplayed( session, callback ) )
+        {
+            return;
+        }
+    }
+
+    if ( session->_ring )
+    {
+        /*
+         * Write the callback straight into the shared ring, unless older callbacks are still
+         * waiting in the regular queue, in which case ordering requires that we queue behind them.
+         */
+
+        if ( CFArrayGetCount( session->_queue ) == 0 )
+        {
+            CFTypeRef argument1;
+            CFDataRef data;
+            Boolean   queued;
+
+            /*
+             * A drained ring is the equivalent of a drained queue for response timeouts.
+             */
+
+            if ( atomic_load( &session->_ring->tail ) == atomic_load( &session->_ring->head ) )
+            {
+                session->_state &= ~kDASessionStateTimeout;
+            }
+
+            argument1 = DACallbackGetArgument1( callback );
+
+            data = argument1 ? _DASerialize( kCFAllocatorDefault, argument1 ) : NULL;
+
+            queued = FALSE;
+
+            if ( data || argument1 == NULL )
+            {
+                queued = _DACallbackRingEnqueue( session->_ring,
+                                                 session->_ringSize,
+                                                 DACallbackGetKind( callback ),
+                                                 DACallbackGetAddress( callback ),
+                                                 DACallbackGetContext( callback ),
+                                                 ( CFDataRef ) DACallbackGetArgument0( callback ),
+                                                 data );
+            }
+
+            if ( data )  CFRelease( data );
+
+            if ( queued )
+            {
+                if ( session->_client )
+                {
+                    if ( atomic_exchange( &session->_ring->armed, 0 ) )
+                    {
+                        __DASessionNotify( session );
+                    }
+                }
+
+                return;
+            }
+        }
+
+        atomic_store( &session->_ring->overflow, 1 );
+    }
+
+    /*
+     * Leave room for a replay of the disk list on top of the limit, so that a resynchronization
+     * cannot in itself exceed it.
+     */
+
+    if ( CFArrayGetCount( session->_queue ) >= session->_queueLimit + CFArrayGetCount( gDADiskList ) )
+    {
+        /*
+         * Disappearances are never dropped, so a session that is already resynchronizing may
+         * exceed the limit with them; there is no need to ask it to resynchronize again.
+         */
+
+        if ( ( session->_state & kDASessionStateResync ) == 0 )
+        {
+            __DASessionQueueResync( session );
+        }
+
+        if ( __DASessionCallbackIsReplayed( session, callback ) )
+        {
+            return;
+        }
+    }
+
     CFArrayAppendValue( session->_queue, callback );
 
     if ( CFArrayGetCount( session->_queue ) == 1 )
     {
-        if ( session->_client )
+        __DASessionNotify( session );
+    }
+}
+
+static void __DASessionCoalesceFlush( DASessionRef session )
+{
+    CFIndex count;
+    CFIndex index;
+
+    count = CFArrayGetCount( session->_coalesce );
+
+    for ( index = 0; index < count; index++ )
+    {
+        __DASessionQueueCallback( session, ( void * ) CFArrayGetValueAtIndex( session->_coalesce, index ) );
+    }
+
+    CFArrayRemoveAllValues( session->_coalesce );
+
+    session->_coalesceID++;
+}
+
+static void __DASessionCoalesceCallback( DASessionRef session, DACallbackRef callback )
+{
+    CFIndex count;
+    CFIndex index;
+
+    count = CFArrayGetCount( session->_coalesce );
+
+    for ( index = 0; index < count; index++ )
+    {
+        DACallbackRef item;
+
+        item = ( void * ) CFArrayGetValueAtIndex( session->_coalesce, index );
+
+        if ( DACallbackGetAddress( item ) == DACallbackGetAddress( callback ) &&
+             DACallbackGetContext( item ) == DACallbackGetContext( callback ) &&
+             CFEqual( DACallbackGetDisk( item ), DACallbackGetDisk( callback ) ) )
         {
-            mach_msg_header_t message;
-            kern_return_t     status;
+            CFMutableArrayRef keys;
 
-            message.msgh_bits        = MACH_MSGH_BITS( MACH_MSG_TYPE_COPY_SEND, 0 );
-            message.msgh_id          = 0;
-            message.msgh_local_port  = MACH_PORT_NULL;
-            message.msgh_remote_port = session->_client;
-            message.msgh_reserved    = 0;
-            message.msgh_size        = sizeof( message );
+            /*
+             * Merge the change into the pending callback for the disk, which then carries the union
+             * of the changed keys and the latest description.
+             */
 
-            status = mach_msg( &message, MACH_SEND_MSG | MACH_SEND_TIMEOUT, message.msgh_size, 0, MACH_PORT_NULL, 0, MACH_PORT_NULL );
+            keys = CFArrayCreateMutableCopy( kCFAllocatorDefault, 0, DACallbackGetArgument1( item ) );
 
-            if ( status == MACH_SEND_TIMED_OUT )
+            if ( keys )
             {
-                mach_msg_destroy( &message );
+                CFArrayRef changes;
+                CFIndex    changesCount;
+                CFIndex    changesIndex;
+
+                changes = DACallbackGetArgument1( callback );
+
+                changesCount = CFArrayGetCount( changes );
+
+                for ( changesIndex = 0; changesIndex < changesCount; changesIndex++ )
+                {
+                    CFTypeRef key;
+
+                    key = CFArrayGetValueAtIndex( changes, changesIndex );
+
+                    if ( CFArrayContainsValue( keys, CFRangeMake( 0, CFArrayGetCount( keys ) ), key ) == FALSE )
+                    {
+                        CFArrayAppendValue( keys, key );
+                    }
+                }
+
+                DACallbackSetArgument0( item, DADiskGetSerializationWithEncoding( DACallbackGetDisk( callback ), session->_encoding ) );
+
+                DACallbackSetArgument1( item, keys );
+
+                CFRelease( keys );
+
+                gDAStatistics.callbacksCoalesced++;
+
+                return;
+            }
+
+            break;
+        }
+    }
+
+    if ( index < count )
+    {
+        /*
+         * The merge failed, so deliver what we have in order and continue without coalescing.
+         */
+
+        __DASessionCoalesceFlush( session );
+
+        __DASessionQueueCallback( session, callback );
+
+        return;
+    }
+
+    CFArrayAppendValue( session->_coalesce, callback );
+
+    if ( count == 0 )
+    {
+        UInt32 id;
+
+        id = session->_coalesceID;
+
+        CFRetain( session );
+
+        dispatch_after( dispatch_time( DISPATCH_TIME_NOW, session->_interval * NSEC_PER_MSEC ), DAServerWorkLoop( ), ^
+        {
+            if ( session->_coalesceID == id )
+            {
+                if ( DASessionGetState( session, kDASessionStateZombie ) == FALSE )
+                {
+                    __DASessionCoalesceFlush( session );
+                }
             }
+
+            CFRelease( session );
+        } );
+    }
+}
+
+void DASessionQueueCallback( DASessionRef session, DACallbackRef callback )
+{
+    if ( session->_interval )
+    {
+        /*
+         * Hold description changes for the coalescing interval.  Any other callback delivers the
+         * held changes first, which keeps all other callbacks strictly ordered against them.
+         */
+
+        if ( DACallbackGetKind( callback ) == _kDADiskDescriptionChangedCallback )
+        {
+            __DASessionCoalesceCallback( session, callback );
+
+            return;
         }
+
+        __DASessionCoalesceFlush( session );
     }
+
+    __DASessionQueueCallback( session, callback );
 }
 
 void DASessionRegisterCallback( DASessionRef session, DACallbackRef callback )
@@ -377,28 +876,39 @@ void DASessionSetClientPort( DASessionRef session, mach_port_t client )
 
     if ( CFArrayGetCount( session->_queue ) )
     {
-        if ( session->_client )
+        __DASessionNotify( session );
+    }
+    else if ( session->_ring )
+    {
+        if ( atomic_load( &session->_ring->head ) != atomic_load( &session->_ring->tail ) )
         {
-            mach_msg_header_t message;
-            kern_return_t     status;
-
-            message.msgh_bits        = MACH_MSGH_BITS( MACH_MSG_TYPE_COPY_SEND, 0 );
-            message.msgh_id          = 0;
-            message.msgh_local_port  = MACH_PORT_NULL;
-            message.msgh_remote_port = session->_client;
-            message.msgh_reserved    = 0;
-            message.msgh_size        = sizeof( message );
+            atomic_store( &session->_ring->armed, 0 );
 
-            status = mach_msg( &message, MACH_SEND_MSG | MACH_SEND_TIMEOUT, message.msgh_size, 0, MACH_PORT_NULL, 0, MACH_PORT_NULL );
-
-            if ( status == MACH_SEND_TIMED_OUT )
-            {
-                mach_msg_destroy( &message );
-            }
+            __DASessionNotify( session );
         }
     }
 }
 
+void DASessionSetCoalescingInterval( DASessionRef session, UInt32 interval )
+{
+    if ( interval == 0 )
+    {
+        __DASessionCoalesceFlush( session );
+    }
+
+    session->_interval = interval;
+}
+
+void DASessionSetEncoding( DASessionRef session, _DAEncoding encoding )
+{
+    session->_encoding = encoding;
+}
+
+void DASessionSetGeneration( DASessionRef session, UInt64 generation )
+{
+    session->_generation = generation;
+}
+
 #ifdef DA_FSKIT
 void DASessionSetIsFSKitd( DASessionRef session, Boolean value )
 {
@@ -417,10 +927,20 @@ void DASessionSetOptions( DASessionRef session, DASessionOptions options, Boolea
     session->_options |= value ? options : 0;
 }
 
+void DASessionSetQueueLimit( DASessionRef session, UInt32 limit )
+{
+    session->_queueLimit = limit ? limit : _kDASessionQueueLimitDefault;
+}
+
 void DASessionSetState( DASessionRef session, DASessionState state, Boolean value )
 {
     session->_state &= ~state;
     session->_state |= value ? state : 0;
+
+    if ( ( state & kDASessionStateResync ) && value == FALSE )
+    {
+        CFBagRemoveAllValues( session->_resync );
+    }
 }
 
 void DASessionSetKeepAlive( DASessionRef session , bool value)
@@ -466,5 +986,22 @@ void DASessionUnregisterCallback( DASessionRef session, DACallbackRef callback )
             }
         }
     }
+
+    count = CFArrayGetCount( session->_coalesce );
+
+    for ( index = count - 1; index > -1; index-- )
+    {
+        DACallbackRef item;
+
+        item = ( void * ) CFArrayGetValueAtIndex( session->_coalesce, index );
+
+        if ( DACallbackGetAddress( item ) == DACallbackGetAddress( callback ) )
+        {
+            if ( DACallbackGetContext( item ) == DACallbackGetContext( callback ) )
+            {
+                CFArrayRemoveValueAtIndex( session->_coalesce, index );
+            }
+        }
+    }
 }
 
@@ -31,6 +31,8 @@
 #include <Security/Authorization.h>
 #endif
 
+#include "DAInternal.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -47,6 +49,7 @@ typedef UInt32 DASessionOptions;
 enum
 {
     kDASessionStateIdle    = 0x00000001,
+    kDASessionStateResync  = 0x00000002,
     kDASessionStateTimeout = 0x01000000,
     kDASessionStateZombie  = 0x10000000
 };
@@ -61,15 +64,22 @@ typedef struct __DASession * DASessionRef;
 extern const char * _DASessionGetName( DASessionRef session );
 ///w:stop
 extern DASessionRef      DASessionCreate( CFAllocatorRef allocator, const char * _name, pid_t _pid );
+extern kern_return_t     DASessionCreateCallbackRing( DASessionRef session, uint32_t size, mach_port_t * ring, uint32_t * ringSize );
 #if TARGET_OS_OSX
 extern AuthorizationRef  DASessionGetAuthorization( DASessionRef session );
 #endif
 extern CFMutableArrayRef DASessionGetCallbackQueue( DASessionRef session );
+extern CFIndex           DASessionGetCallbackQueueSize( DASessionRef session );
 extern CFMutableArrayRef DASessionGetCallbackRegister( DASessionRef session );
+extern UInt32            DASessionGetCoalescingInterval( DASessionRef session );
+extern _DAEncoding       DASessionGetEncoding( DASessionRef session );
+extern UInt64            DASessionGetGeneration( DASessionRef session );
 extern mach_port_t       DASessionGetID( DASessionRef session );
 extern Boolean           DASessionGetIsFSKitd( DASessionRef session );
 extern Boolean           DASessionGetOption( DASessionRef session, DASessionOption option );
 extern DASessionOptions  DASessionGetOptions( DASessionRef session );
+extern pid_t             DASessionGetProcessID( DASessionRef session );
+extern UInt32            DASessionGetQueueLimit( DASessionRef session );
 extern mach_port_t       DASessionGetServerPort( DASessionRef session );
 extern Boolean           DASessionGetState( DASessionRef session, DASessionState state );
 extern CFTypeID          DASessionGetTypeID( void );
@@ -81,11 +91,15 @@ extern void              DASessionRegisterCallback( DASessionRef session, DACall
 extern void              DASessionSetAuthorization( DASessionRef session, AuthorizationRef authorization );
 #endif
 extern void              DASessionSetClientPort( DASessionRef session, mach_port_t client );
+extern void              DASessionSetCoalescingInterval( DASessionRef session, UInt32 interval );
+extern void              DASessionSetEncoding( DASessionRef session, _DAEncoding encoding );
+extern void              DASessionSetGeneration( DASessionRef session, UInt64 generation );
 #ifdef DA_FSKIT
 extern void              DASessionSetIsFSKitd( DASessionRef session, Boolean value );
 #endif
 extern void              DASessionSetOption( DASessionRef session, DASessionOption option, Boolean value );
 extern void              DASessionSetOptions( DASessionRef session, DASessionOptions options, Boolean value );
+extern void              DASessionSetQueueLimit( DASessionRef session, UInt32 limit );
 extern void              DASessionSetState( DASessionRef session, DASessionState state, Boolean value );
 extern void              DASessionSetKeepAlive( DASessionRef session , bool value);
 extern void              DASessionUnregisterCallback( DASessionRef session, DACallbackRef callback );
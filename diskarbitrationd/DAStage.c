@@ -138,13 +138,17 @@ static void __DAStageAppeared( DADiskRef disk )
 
 static void __DAStageDispatch( void * info )
 {
-    static Boolean fresh = FALSE;
-
     CFAbsoluteTime clock;
     CFIndex        count;
     CFIndex        index;
     Boolean        quiet = TRUE;
 
+    /*
+     * Start this pass with a fresh mount table snapshot.
+     */
+
+    DAVolumeListInvalidate( );
+
     /*
      * Determine whether a unit has quiesced.  We do not allow I/O Kit to stay busy excessively.
      */
@@ -212,17 +216,6 @@ static void __DAStageDispatch( void * info )
         {
             if ( DADiskGetState( disk, kDADiskStateStagedProbe ) == FALSE )
             {
-                if ( fresh )
-                {
-                    DAFileSystemListRefresh( );
-
-                    DAMountMapListRefresh1( );
-                    
-                    DAMountMapListRefresh2( );
-
-                    fresh = FALSE;
-                }
-
                 __DAStageProbe( disk );
             }
             else if ( DADiskGetState( disk, kDADiskStateStagedPeek ) == FALSE )
@@ -411,24 +404,6 @@ static void __DAStageDispatch( void * info )
 
                     if ( dispatch )
                     {
-                        /*
-                         * Prepare to dispatch the request.
-                         */
-
-                        if ( DARequestGetKind( request ) == _kDADiskMount )
-                        {
-                            if ( fresh )
-                            {
-                                DAFileSystemListRefresh( );
-
-                                DAMountMapListRefresh1( );
-
-                                DAMountMapListRefresh2( );
-
-                                fresh = FALSE;
-                            }
-                        }
-
                         /*
                          * Dispatch the request.
                          */
@@ -486,8 +461,6 @@ static void __DAStageDispatch( void * info )
 
     if ( quiet )
     {
-        fresh = TRUE;
-        
         if ( gDAIdle == FALSE )
         {
             ___os_transaction_end( );
@@ -862,7 +835,7 @@ static void __DAStageProbeCallback( int             status,
 
         for ( mountListIndex = 0; mountListIndex < mountListCount; mountListIndex++ )
         {
-            if ( strcmp( _DAVolumeGetID( mountList + mountListIndex ), DADiskGetID( disk ) ) == 0 )
+            if ( strcmp( DAVolumeGetID( mountList + mountListIndex ), DADiskGetID( disk ) ) == 0 )
             {
                 /*
                  * We have determined that the disk is mounted.
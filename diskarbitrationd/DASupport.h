@@ -53,7 +53,8 @@ extern void DAAuthorizeWithCallback( DASessionRef        session,
 
 extern const CFStringRef kDAFileSystemKey; /* ( DAFileSystem ) */
 
-extern void DAFileSystemListRefresh( void );
+extern CFArrayRef DAFileSystemProbeListCopy( void );
+extern void       DAFileSystemListRefresh( void );
 #ifdef DA_FSKIT
 extern void DAProbeWithFSKit( CFStringRef deviceName ,
                               CFStringRef bundleID ,
@@ -82,8 +83,10 @@ extern const CFStringRef kDAMountMapMountPathKey;      /* ( CFURL     ) */
 extern const CFStringRef kDAMountMapProbeIDKey;        /* ( CFUUID    ) */
 extern const CFStringRef kDAMountMapProbeKindKey;      /* ( CFString  ) */
 
-extern void DAMountMapListRefresh1( void );
-extern void DAMountMapListRefresh2( void );
+extern CFDictionaryRef DAMountMapListGetMatch1( DADiskRef disk, DAFileSystemRef filesystem );
+extern CFDictionaryRef DAMountMapListGetMatch2( DADiskRef disk );
+extern void            DAMountMapListRefresh1( void );
+extern void            DAMountMapListRefresh2( void );
 
 extern const CFStringRef kDAPreferenceMountDeferExternalKey;         /* ( CFBoolean ) */
 extern const CFStringRef kDAPreferenceMountDeferInternalKey;         /* ( CFBoolean ) */
@@ -101,7 +104,10 @@ extern const CFStringRef kDAPreferenceDisableUnreadableNotificationKey; /* ( CFB
 extern const CFStringRef kDAPreferenceDisableUnrepairableNotificationKey; /* ( CFBoolean ) */
 extern const CFStringRef kDAPreferenceMountAlwaysRepairKey;               /* ( CFBoolean ) */
 
-extern void DAPreferenceListRefresh( void );
+extern CFDictionaryRef DAPreferenceListCopy( void );
+extern void            DAPreferenceListRefresh( void );
+
+extern void DAConfigurationListWatch( void );
 
 enum
 {
@@ -120,6 +126,11 @@ extern Boolean DAUnitGetState( DADiskRef disk, DAUnitState state );
 extern Boolean DAUnitGetStateRecursively( DADiskRef disk, DAUnitState state );
 extern void    DAUnitSetState( DADiskRef disk, DAUnitState state, Boolean value );
 
+extern const char *          DAVolumeGetID( const struct statfs * fs );
+extern CFDictionaryRef       DAVolumeListCopy( void );
+extern const struct statfs * DAVolumeListGetVolume( CFDictionaryRef list, const char * id );
+extern void                  DAVolumeListInvalidate( void );
+
 #if TARGET_OS_IOS
 extern Boolean DADeviceIsUnlocked( void );
 #endif
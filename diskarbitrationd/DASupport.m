@@ -23,6 +23,7 @@
 
 #include "DASupport.h"
 
+#include "fstabparse.h"
 #include "vsdb.h"
 #include "DABase.h"
 #include "DAFileSystem.h"
@@ -34,13 +35,16 @@
 #include "DAProbe.h"
 #include "DATelemetry.h"
 #include "DAMount.h"
+#include "DAServer.h"
 
 #include <dirent.h>
+#include <fcntl.h>
 #include <fsproperties.h>
 #include <fstab.h>
 #include <libgen.h>
 #include <pthread.h>
 #include <sys/loadable_fs.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <IOKit/IOBSD.h>
 #include <IOKit/storage/IOBlockStorageDevice.h>
@@ -362,21 +366,89 @@ void DAAuthorizeWithCallback( DASessionRef        session,
 }
 #endif
 
+static dispatch_queue_t __DAConfigurationGetQueue( void )
+{
+    static dispatch_queue_t queue = NULL;
+    static dispatch_once_t  once;
+
+    /*
+     * The configuration lists are rebuilt on a queue of their own, away from the workloop,
+     * and only published once they are complete.
+     */
+
+    dispatch_once( &once, ^
+    {
+        queue = dispatch_queue_create( "diskarbitrationd/configuration", DISPATCH_QUEUE_SERIAL );
+    } );
+
+    return queue;
+}
+
+static CFTypeRef __DAConfigurationCopy( CFTypeRef _Atomic * snapshot )
+{
+    CFTypeRef value;
+
+    /*
+     * Take a reference on the current snapshot of a configuration list.  A snapshot is never
+     * modified once published, so it can be read without a lock for as long as it is held.
+     *
+     * This must be called on the workloop.  A retired snapshot is released on the workloop, so
+     * only there is the snapshot certain to outlive the load and the retain that follows it.
+     */
+
+    value = atomic_load_explicit( snapshot, memory_order_acquire );
+
+    return value ? CFRetain( value ) : NULL;
+}
+
+static void __DAConfigurationPublish( CFTypeRef _Atomic * snapshot, CFTypeRef value )
+{
+    CFTypeRef retired;
+
+    /*
+     * Publish a new snapshot of a configuration list with a single pointer swap.  Rebuilds run
+     * one at a time on the configuration queue, so snapshots are published in the order they
+     * were built.  The snapshot it replaces is retired on the workloop, so that a reader on the
+     * workloop that loaded the old snapshot is done with it before it is released.
+     */
+
+    retired = atomic_exchange_explicit( snapshot, CFRetain( value ), memory_order_acq_rel );
+
+    if ( retired )
+    {
+        dispatch_async( DAServerWorkLoop( ), ^
+        {
+            CFRelease( retired );
+        } );
+    }
+}
+
+static CFTypeRef _Atomic __gDAFileSystemProbeList = NULL;
+
 static struct timespec __gDAFileSystemListTime1 = { 0, 0 };
 static struct timespec __gDAFileSystemListTime2 = { 0, 0 };
 
 const CFStringRef kDAFileSystemKey = CFSTR( "DAFileSystem" );
 
+struct __DAFileSystemProbeListContext
+{
+    DAFileSystemRef   filesystem;
+    CFMutableArrayRef list;
+};
+
+typedef struct __DAFileSystemProbeListContext __DAFileSystemProbeListContext;
+
 static void __DAFileSystemProbeListAppendValue( const void * key, const void * value, void * context )
 {
-    CFMutableDictionaryRef probe;
+    __DAFileSystemProbeListContext * probeContext = context;
+    CFMutableDictionaryRef           probe;
 
     probe = CFDictionaryCreateMutableCopy( kCFAllocatorDefault, 0, value );
 
     if ( probe )
     {
-        CFDictionarySetValue( probe, kDAFileSystemKey, context );
-        CFArrayAppendValue( gDAFileSystemProbeList, probe );
+        CFDictionarySetValue( probe, kDAFileSystemKey, probeContext->filesystem );
+        CFArrayAppendValue( probeContext->list, probe );
         CFRelease( probe );
     }
 }
@@ -392,7 +464,7 @@ static CFComparisonResult __DAFileSystemProbeListCompare( const void * value1, c
     return CFNumberCompare( order1, order2, NULL );
 }
 
-static void __DAFileSystemListRefresh( const char * directory )
+static void __DAFileSystemListRefresh( const char * directory, CFMutableArrayRef list, CFMutableArrayRef probeList )
 {
     CFURLRef base;
 
@@ -477,13 +549,18 @@ static void __DAFileSystemListRefresh( const char * directory )
 
                                 DALogDebug( "  created filesystem, id = %@.", filesystem );
 
-                                CFArrayAppendValue( gDAFileSystemList, filesystem );
+                                CFArrayAppendValue( list, filesystem );
 
                                 probe = DAFileSystemGetProbeList( filesystem );
 
                                 if ( probe )
                                 {
-                                    CFDictionaryApplyFunction( probe, __DAFileSystemProbeListAppendValue, filesystem );
+                                    __DAFileSystemProbeListContext probeContext;
+
+                                    probeContext.filesystem = filesystem;
+                                    probeContext.list       = probeList;
+
+                                    CFDictionaryApplyFunction( probe, __DAFileSystemProbeListAppendValue, &probeContext );
                                 }
 
                                 CFRelease( filesystem );
@@ -1314,215 +1391,1074 @@ int __DARepairWithFSKit( void *parameter )
 
 #endif /* DA_FSKIT */
 
-void DAFileSystemListRefresh( void )
+#define __kDAFileSystemCacheMagic   0x44416673 /* 'DAfs' */
+#define __kDAFileSystemCachePath    "/var/db/" _kDADaemonName ".filesystems"
+#define __kDAFileSystemCacheVersion 1
+
+struct __DAFileSystemCacheHeader
 {
-    struct stat status1;
-    struct stat status2;
+    uint32_t magic;
+    uint32_t version;
+    uint32_t exclusions;
+    uint32_t size;
+    int64_t  time1;
+    int64_t  time2;
+};
+
+typedef struct __DAFileSystemCacheHeader __DAFileSystemCacheHeader;
+
+static const CFStringRef __kDAFileSystemCacheBundlesKey    = CFSTR( "Bundles"    );
+static const CFStringRef __kDAFileSystemCacheIndexKey      = CFSTR( "Index"      );
+static const CFStringRef __kDAFileSystemCacheKeyKey        = CFSTR( "Key"        );
+static const CFStringRef __kDAFileSystemCachePathKey       = CFSTR( "Path"       );
+static const CFStringRef __kDAFileSystemCacheProbesKey     = CFSTR( "Probes"     );
+static const CFStringRef __kDAFileSystemCachePropertiesKey = CFSTR( "Properties" );
+static const CFStringRef __kDAFileSystemCacheTimeKey       = CFSTR( "Time"       );
+
+static uint32_t __DAFileSystemCacheGetExclusions( void )
+{
+    uint32_t exclusions = 0;
 
     /*
-     * Determine whether the file system list is up-to-date.
+     * The bundles skipped in favor of FSKit modules depend on feature flags, which are part of
+     * the cache key, so that a change to them is not masked by the cache.
      */
 
-    if ( stat( FS_DIR_LOCATION, &status1 ) )
+#ifdef DA_FSKIT
+    if ( !gFSKitMissing )
     {
-        __gDAFileSystemListTime1.tv_sec  = 0;
-        __gDAFileSystemListTime1.tv_nsec = 0;
-    }
+        if ( os_feature_enabled(FSKit, msdosUseFSKitModule) )
+        {
+            exclusions |= 0x00000001;
+        }
 
-    if ( stat( ___FS_DEFAULT_DIR, &status2 ) )
-    {
-        __gDAFileSystemListTime2.tv_sec  = 0;
-        __gDAFileSystemListTime2.tv_nsec = 0;
+        if ( os_feature_enabled(DiskArbitration , FSKitModulesProbe) )
+        {
+            exclusions |= 0x00000002;
+        }
     }
+#endif
 
-    if ( __gDAFileSystemListTime1.tv_sec  != status1.st_mtimespec.tv_sec  ||
-         __gDAFileSystemListTime1.tv_nsec != status1.st_mtimespec.tv_nsec ||
-         __gDAFileSystemListTime2.tv_sec  != status2.st_mtimespec.tv_sec  ||
-         __gDAFileSystemListTime2.tv_nsec != status2.st_mtimespec.tv_nsec )
-    {
-        __gDAFileSystemListTime1.tv_sec  = status1.st_mtimespec.tv_sec;
-        __gDAFileSystemListTime1.tv_nsec = status1.st_mtimespec.tv_nsec;
-        __gDAFileSystemListTime2.tv_sec  = status2.st_mtimespec.tv_sec;
-        __gDAFileSystemListTime2.tv_nsec = status2.st_mtimespec.tv_nsec;
-
-        /*
-         * Clear the file system list.
-         */
-
-        CFArrayRemoveAllValues( gDAFileSystemList );
-        CFArrayRemoveAllValues( gDAFileSystemProbeList );
+    return exclusions;
+}
 
-        /*
-         * Build the file system list.
-         */
+static int64_t __DAFileSystemCacheGetTime( const char * bundle )
+{
+    char        path[MAXPATHLEN];
+    struct stat status;
 
-        __DAFileSystemListRefresh( FS_DIR_LOCATION );
-        __DAFileSystemListRefresh( ___FS_DEFAULT_DIR );
+    /*
+     * Key each bundle on the modification time of its property list, or of the bundle itself
+     * where the property list is not in the usual place.
+     */
 
-        /*
-         * Order the probe list.
-         */
+    snprintf( path, sizeof( path ), "%s/Contents/Info.plist", bundle );
 
-        CFArraySortValues( gDAFileSystemProbeList,
-                           CFRangeMake( 0, CFArrayGetCount( gDAFileSystemProbeList ) ),
-                           __DAFileSystemProbeListCompare,
-                           NULL );
+    if ( stat( path, &status ) && stat( bundle, &status ) )
+    {
+        return 0;
     }
-}
-
-static struct timespec __gDAMountMapListTime1 = { 0, 0 };
-static struct timespec __gDAMountMapListTime2 = { 0, 0 };
 
-const CFStringRef kDAMountMapMountAutomaticKey = CFSTR( "DAMountAutomatic" );
-const CFStringRef kDAMountMapMountOptionsKey   = CFSTR( "DAMountOptions"   );
-const CFStringRef kDAMountMapMountPathKey      = CFSTR( "DAMountPath"      );
-const CFStringRef kDAMountMapProbeIDKey        = CFSTR( "DAProbeID"        );
-const CFStringRef kDAMountMapProbeKindKey      = CFSTR( "DAProbeKind"      );
+    return ( int64_t ) status.st_mtimespec.tv_sec * NSEC_PER_SEC + status.st_mtimespec.tv_nsec;
+}
 
-// TODO: Figure out security policy for rdar://143332014
-static BOOL __DAShouldAddMountMapEntry( )
+static int64_t __DAFileSystemCacheGetListTime( struct timespec time )
 {
-    return YES;
+    return ( int64_t ) time.tv_sec * NSEC_PER_SEC + time.tv_nsec;
 }
 
-static CFDictionaryRef __DAMountMapCreate1( CFAllocatorRef allocator, struct fstab * fs )
+static Boolean __DAFileSystemCacheRestore( CFDictionaryRef cache, CFMutableArrayRef list, CFMutableArrayRef probeList )
 {
-    CFMutableDictionaryRef map = NULL;
-    static BOOL fstabEntryAdded = NO; // Don't post the event again during subsequent refreshes
-    
-    if ( strcmp( fs->fs_type, FSTAB_SW ) )
+    CFArrayRef bundles;
+    CFIndex    count;
+    CFIndex    index;
+    CFArrayRef probes;
+
+    bundles = CFDictionaryGetValue( cache, __kDAFileSystemCacheBundlesKey );
+    probes  = CFDictionaryGetValue( cache, __kDAFileSystemCacheProbesKey  );
+
+    if ( bundles == NULL || CFGetTypeID( bundles ) != CFArrayGetTypeID( ) )
     {
-        char * idAsCString = fs->fs_spec;
+        return FALSE;
+    }
 
-        strsep( &idAsCString, "=" );
+    if ( probes == NULL || CFGetTypeID( probes ) != CFArrayGetTypeID( ) )
+    {
+        return FALSE;
+    }
 
-        if ( idAsCString )
+    /*
+     * Restore the file system list, so long as no bundle has changed since the cache was saved.
+     */
+
+    count = CFArrayGetCount( bundles );
+
+    for ( index = 0; index < count; index++ )
+    {
+        CFDictionaryRef bundle;
+        DAFileSystemRef filesystem;
+        char            path[MAXPATHLEN];
+        CFStringRef     pathAsString;
+        CFDictionaryRef properties;
+        CFNumberRef     time;
+        int64_t         timeAsInteger;
+        CFURLRef        url;
+
+        bundle = CFArrayGetValueAtIndex( bundles, index );
+
+        if ( CFGetTypeID( bundle ) != CFDictionaryGetTypeID( ) )
         {
-            CFStringRef idAsString;
+            return FALSE;
+        }
 
-            idAsString = CFStringCreateWithCString( kCFAllocatorDefault, idAsCString, kCFStringEncodingUTF8 );
+        pathAsString = CFDictionaryGetValue( bundle, __kDAFileSystemCachePathKey       );
+        properties   = CFDictionaryGetValue( bundle, __kDAFileSystemCachePropertiesKey );
+        time         = CFDictionaryGetValue( bundle, __kDAFileSystemCacheTimeKey       );
 
-            if ( idAsString )
-            {
-                CFTypeRef entryID = NULL;
+        if ( pathAsString == NULL || CFGetTypeID( pathAsString ) != CFStringGetTypeID( ) )
+        {
+            return FALSE;
+        }
 
-                if ( strcmp( fs->fs_spec, "UUID" ) == 0 )
-                {
-                    entryID = ___CFUUIDCreateFromString( kCFAllocatorDefault, idAsString );
-                }
-                else if ( strcmp( fs->fs_spec, "LABEL" ) == 0 )
-                {
-                    entryID = CFRetain( idAsString );
-                }
-                else if ( strcmp( fs->fs_spec, "DEVICE" ) == 0 )
-                {
-                    entryID = ___CFDictionaryCreateFromXMLString( kCFAllocatorDefault, idAsString );
-                }
+        if ( properties == NULL || CFGetTypeID( properties ) != CFDictionaryGetTypeID( ) )
+        {
+            return FALSE;
+        }
 
-                if ( entryID )
-                {
-                    map = CFDictionaryCreateMutable( kCFAllocatorDefault, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks );
+        if ( time == NULL || CFGetTypeID( time ) != CFNumberGetTypeID( ) )
+        {
+            return FALSE;
+        }
 
-                    if ( map )
-                    {
-                        CFMutableStringRef options;
+        if ( CFStringGetFileSystemRepresentation( pathAsString, path, sizeof( path ) ) == FALSE )
+        {
+            return FALSE;
+        }
 
-                        options = CFStringCreateMutable( kCFAllocatorDefault, 0 );
+        CFNumberGetValue( time, kCFNumberSInt64Type, &timeAsInteger );
 
-                        if ( options )
-                        {
-                            char *       argument  = NULL;
-                            char *       arguments = fs->fs_mntops;
-                            CFBooleanRef automatic = NULL;
+        if ( __DAFileSystemCacheGetTime( path ) != timeAsInteger )
+        {
+            return FALSE;
+        }
 
-                            while ( ( argument = strsep( &arguments, "," ) ) )
-                            {
-                                if ( strcmp( argument, "auto" ) == 0 )
-                                {
-                                    automatic = kCFBooleanTrue;
-                                }
-                                else if ( strcmp( argument, "noauto" ) == 0 )
-                                {
-                                    automatic = kCFBooleanFalse;
-                                }
-                                else
-                                {
-                                    CFStringAppendCString( options, argument, kCFStringEncodingUTF8 );    
-                                    CFStringAppendCString( options, ",", kCFStringEncodingUTF8 );
-                                }
-                            }
+        url = CFURLCreateFromFileSystemRepresentation( kCFAllocatorDefault, ( void * ) path, strlen( path ), TRUE );
 
-                            if ( automatic )
-                            {
-                                CFDictionarySetValue( map, kDAMountMapMountAutomaticKey, automatic );
-                            }
+        if ( url == NULL )
+        {
+            return FALSE;
+        }
 
-                            if ( CFStringGetLength( options ) )
-                            {
-                                CFStringTrim( options, CFSTR( "," ) );
+        filesystem = DAFileSystemCreateWithProperties( kCFAllocatorDefault, url, properties );
 
-                                CFDictionarySetValue( map, kDAMountMapMountOptionsKey, options );
-                            }
+        CFRelease( url );
 
-                            CFRelease( options );
-                        }
+        if ( filesystem == NULL )
+        {
+            return FALSE;
+        }
 
-                        if ( strcmp( fs->fs_file, "none" ) )
-                        {
-                            CFURLRef path;
+        DALogDebug( "  created filesystem, id = %@.", filesystem );
 
-                            path = CFURLCreateFromFileSystemRepresentation( kCFAllocatorDefault, ( void * ) fs->fs_file, strlen( fs->fs_file ), TRUE );
+        CFArrayAppendValue( list, filesystem );
 
-                            if ( path )
-                            {
-                                CFDictionarySetValue( map, kDAMountMapMountPathKey, path );
+        CFRelease( filesystem );
+    }
 
-                                CFRelease( path );
-                            }
-                        }
+    /*
+     * Restore the probe list, which was saved in order.
+     */
 
-                        if ( strcmp( fs->fs_vfstype, "auto" ) )
-                        {
-                            CFStringRef kind;
+    count = CFArrayGetCount( probes );
 
-                            kind = CFStringCreateWithCString( kCFAllocatorDefault, fs->fs_vfstype, kCFStringEncodingUTF8 );
+    for ( index = 0; index < count; index++ )
+    {
+        __DAFileSystemProbeListContext probeContext;
+        CFDictionaryRef                probe;
+        CFNumberRef                    position;
+        CFIndex                        positionAsInteger;
+        CFStringRef                    key;
+        CFDictionaryRef                value;
 
-                            if ( kind )
-                            {
-                                CFDictionarySetValue( map, kDAMountMapProbeKindKey, kind );
+        probe = CFArrayGetValueAtIndex( probes, index );
 
-                                CFRelease( kind );
-                            }
-                        }
+        if ( CFGetTypeID( probe ) != CFDictionaryGetTypeID( ) )
+        {
+            return FALSE;
+        }
 
-                        CFDictionarySetValue( map, kDAMountMapProbeIDKey, entryID );
-                    }
+        position = CFDictionaryGetValue( probe, __kDAFileSystemCacheIndexKey );
+        key      = CFDictionaryGetValue( probe, __kDAFileSystemCacheKeyKey   );
 
-                    CFRelease( entryID );
-                }
+        if ( position == NULL || CFGetTypeID( position ) != CFNumberGetTypeID( ) )
+        {
+            return FALSE;
+        }
 
-                CFRelease( idAsString );
-            }
+        if ( key == NULL )
+        {
+            return FALSE;
         }
-#if TARGET_OS_OSX
-        if ( map != NULL )
+
+        CFNumberGetValue( position, kCFNumberCFIndexType, &positionAsInteger );
+
+        if ( positionAsInteger < 0 || positionAsInteger >= CFArrayGetCount( list ) )
         {
-            /* mount map entries are considered automounted, not external volumes, and use the kext path */
-            BOOL automounted = TRUE;
-            BOOL externalVolume = FALSE;
-            
-            if ( __DAShouldAddMountMapEntry( ) )
-            {
-                if ( !fstabEntryAdded )
-                {
-                    // Post telemetry event for the first entry added
-                    fstabEntryAdded = YES;
-                    DATelemetrySendMountEvent( DA_STATUS_FSTAB_MOUNT_ADDED ,
-                                              CFDictionaryGetValue( map , kDAMountMapProbeKindKey ) ,
-                                              DATelemetryFSImplementationKext ,
-                                              automounted ,
-                                              externalVolume ,
-                                              0 );
+            return FALSE;
+        }
+
+        probeContext.filesystem = ( void * ) CFArrayGetValueAtIndex( list, positionAsInteger );
+        probeContext.list       = probeList;
+
+        value = DAFileSystemGetProbeList( probeContext.filesystem ) ? CFDictionaryGetValue( DAFileSystemGetProbeList( probeContext.filesystem ), key ) : NULL;
+
+        if ( value == NULL )
+        {
+            return FALSE;
+        }
+
+        __DAFileSystemProbeListAppendValue( key, value, &probeContext );
+    }
+
+    return TRUE;
+}
+
+static Boolean __DAFileSystemCacheLoad( CFMutableArrayRef list, CFMutableArrayRef probeList )
+{
+    int     file;
+    Boolean loaded = FALSE;
+
+    /*
+     * Load the file system list from the cache with a single mapping of the file.  The cache is
+     * keyed on the modification times of the file system folders and of each bundle within.
+     */
+
+    file = open( __kDAFileSystemCachePath, O_RDONLY );
+
+    if ( file != -1 )
+    {
+        struct stat status;
+
+        if ( fstat( file, &status ) == 0 && status.st_size > ( off_t ) sizeof( __DAFileSystemCacheHeader ) )
+        {
+            void * data;
+
+            data = mmap( NULL, status.st_size, PROT_READ, MAP_PRIVATE, file, 0 );
+
+            if ( data != MAP_FAILED )
+            {
+                const __DAFileSystemCacheHeader * header = data;
+
+                if ( header->magic      == __kDAFileSystemCacheMagic                                &&
+                     header->version    == __kDAFileSystemCacheVersion                              &&
+                     header->exclusions == __DAFileSystemCacheGetExclusions( )                      &&
+                     header->size       == status.st_size - sizeof( __DAFileSystemCacheHeader )    &&
+                     header->time1      == __DAFileSystemCacheGetListTime( __gDAFileSystemListTime1 ) &&
+                     header->time2      == __DAFileSystemCacheGetListTime( __gDAFileSystemListTime2 ) )
+                {
+                    CFDataRef body;
+
+                    body = CFDataCreateWithBytesNoCopy( kCFAllocatorDefault, ( void * ) ( header + 1 ), header->size, kCFAllocatorNull );
+
+                    if ( body )
+                    {
+                        CFDictionaryRef cache;
+
+                        cache = CFPropertyListCreateWithData( kCFAllocatorDefault, body, kCFPropertyListImmutable, NULL, NULL );
+
+                        if ( cache )
+                        {
+                            if ( CFGetTypeID( cache ) == CFDictionaryGetTypeID( ) )
+                            {
+                                DALogDebugHeader( "filesystems have been loaded from cache." );
+
+                                loaded = __DAFileSystemCacheRestore( cache, list, probeList );
+                            }
+
+                            CFRelease( cache );
+                        }
+
+                        CFRelease( body );
+                    }
+                }
+
+                munmap( data, status.st_size );
+            }
+        }
+
+        close( file );
+    }
+
+    if ( loaded == FALSE )
+    {
+        CFArrayRemoveAllValues( list );
+        CFArrayRemoveAllValues( probeList );
+    }
+
+    return loaded;
+}
+
+static void __DAFileSystemCacheRemoveInvalidValue( const void * key, const void * value, void * context )
+{
+    if ( CFPropertyListIsValid( value, kCFPropertyListBinaryFormat_v1_0 ) == FALSE )
+    {
+        CFArrayAppendValue( context, key );
+    }
+}
+
+static CFDictionaryRef __DAFileSystemCacheCreateBundle( DAFileSystemRef filesystem )
+{
+    CFMutableDictionaryRef bundle;
+    char                   path[MAXPATHLEN];
+
+    if ( CFURLGetFileSystemRepresentation( DAFileSystemGetID( filesystem ), TRUE, ( void * ) path, sizeof( path ) ) == FALSE )
+    {
+        return NULL;
+    }
+
+    bundle = CFDictionaryCreateMutable( kCFAllocatorDefault, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks );
+
+    if ( bundle )
+    {
+        CFMutableArrayRef      invalid;
+        CFStringRef            pathAsString;
+        CFMutableDictionaryRef properties;
+        int64_t                time;
+        CFNumberRef            timeAsNumber;
+
+        /*
+         * Drop the values that cannot be serialized, such as the URL of the property list that
+         * CFBundle adds to the properties.
+         */
+
+        invalid    = CFArrayCreateMutable( kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks );
+        properties = CFDictionaryCreateMutableCopy( kCFAllocatorDefault, 0, DAFileSystemGetProperties( filesystem ) );
+
+        if ( invalid && properties )
+        {
+            CFIndex count;
+            CFIndex index;
+
+            CFDictionaryApplyFunction( properties, __DAFileSystemCacheRemoveInvalidValue, invalid );
+
+            count = CFArrayGetCount( invalid );
+
+            for ( index = 0; index < count; index++ )
+            {
+                CFDictionaryRemoveValue( properties, CFArrayGetValueAtIndex( invalid, index ) );
+            }
+
+            CFDictionarySetValue( bundle, __kDAFileSystemCachePropertiesKey, properties );
+        }
+
+        if ( invalid    )  CFRelease( invalid    );
+        if ( properties )  CFRelease( properties );
+
+        pathAsString = CFStringCreateWithFileSystemRepresentation( kCFAllocatorDefault, path );
+
+        if ( pathAsString )
+        {
+            CFDictionarySetValue( bundle, __kDAFileSystemCachePathKey, pathAsString );
+
+            CFRelease( pathAsString );
+        }
+
+        time = __DAFileSystemCacheGetTime( path );
+
+        timeAsNumber = CFNumberCreate( kCFAllocatorDefault, kCFNumberSInt64Type, &time );
+
+        if ( timeAsNumber )
+        {
+            CFDictionarySetValue( bundle, __kDAFileSystemCacheTimeKey, timeAsNumber );
+
+            CFRelease( timeAsNumber );
+        }
+
+        if ( CFDictionaryGetCount( bundle ) < 3 )
+        {
+            CFRelease( bundle );
+
+            bundle = NULL;
+        }
+    }
+
+    return bundle;
+}
+
+static CFDictionaryRef __DAFileSystemCacheCreateProbe( CFArrayRef list, CFDictionaryRef probe )
+{
+    DAFileSystemRef        filesystem;
+    CFDictionaryRef        probeList;
+    CFIndex                position;
+    CFMutableDictionaryRef value;
+    CFDictionaryRef        entry = NULL;
+
+    filesystem = ( void * ) CFDictionaryGetValue( probe, kDAFileSystemKey );
+    probeList  = DAFileSystemGetProbeList( filesystem );
+    position   = CFArrayGetFirstIndexOfValue( list, CFRangeMake( 0, CFArrayGetCount( list ) ), filesystem );
+
+    if ( probeList == NULL || position == kCFNotFound )
+    {
+        return NULL;
+    }
+
+    /*
+     * Record the probe by its file system and media type, so that the probe list can be put back
+     * together in order from the properties of each file system.
+     */
+
+    value = CFDictionaryCreateMutableCopy( kCFAllocatorDefault, 0, probe );
+
+    if ( value )
+    {
+        CFIndex       count;
+        CFIndex       index;
+        const void ** keys;
+        const void ** values;
+
+        CFDictionaryRemoveValue( value, kDAFileSystemKey );
+
+        count = CFDictionaryGetCount( probeList );
+
+        keys   = malloc( count * sizeof( void * ) );
+        values = malloc( count * sizeof( void * ) );
+
+        if ( keys && values )
+        {
+            CFDictionaryGetKeysAndValues( probeList, keys, values );
+
+            for ( index = 0; index < count; index++ )
+            {
+                if ( CFEqual( values[index], value ) )
+                {
+                    CFNumberRef number;
+
+                    number = CFNumberCreate( kCFAllocatorDefault, kCFNumberCFIndexType, &position );
+
+                    if ( number )
+                    {
+                        const void * entryKeys[]   = { __kDAFileSystemCacheIndexKey, __kDAFileSystemCacheKeyKey };
+                        const void * entryValues[] = { number, keys[index] };
+
+                        entry = CFDictionaryCreate( kCFAllocatorDefault, entryKeys, entryValues, 2, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks );
+
+                        CFRelease( number );
+                    }
+
+                    break;
+                }
+            }
+        }
+
+        if ( keys   )  free( keys   );
+        if ( values )  free( values );
+
+        CFRelease( value );
+    }
+
+    return entry;
+}
+
+static void __DAFileSystemCacheSave( CFArrayRef list, CFArrayRef probeList )
+{
+    CFMutableArrayRef bundles;
+    CFMutableArrayRef probes;
+    Boolean           valid = TRUE;
+
+    bundles = CFArrayCreateMutable( kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks );
+    probes  = CFArrayCreateMutable( kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks );
+
+    if ( bundles && probes )
+    {
+        CFIndex count;
+        CFIndex index;
+
+        count = CFArrayGetCount( list );
+
+        for ( index = 0; index < count && valid; index++ )
+        {
+            CFDictionaryRef bundle;
+
+            bundle = __DAFileSystemCacheCreateBundle( ( void * ) CFArrayGetValueAtIndex( list, index ) );
+
+            if ( bundle )
+            {
+                CFArrayAppendValue( bundles, bundle );
+
+                CFRelease( bundle );
+            }
+            else
+            {
+                valid = FALSE;
+            }
+        }
+
+        count = CFArrayGetCount( probeList );
+
+        for ( index = 0; index < count && valid; index++ )
+        {
+            CFDictionaryRef probe;
+
+            probe = __DAFileSystemCacheCreateProbe( list, CFArrayGetValueAtIndex( probeList, index ) );
+
+            if ( probe )
+            {
+                CFArrayAppendValue( probes, probe );
+
+                CFRelease( probe );
+            }
+            else
+            {
+                valid = FALSE;
+            }
+        }
+
+        if ( valid )
+        {
+            CFDictionaryRef cache;
+            const void *    keys[]   = { __kDAFileSystemCacheBundlesKey, __kDAFileSystemCacheProbesKey };
+            const void *    values[] = { bundles, probes };
+
+            cache = CFDictionaryCreate( kCFAllocatorDefault, keys, values, 2, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks );
+
+            if ( cache )
+            {
+                CFDataRef body;
+
+                body = CFPropertyListCreateData( kCFAllocatorDefault, cache, kCFPropertyListBinaryFormat_v1_0, 0, NULL );
+
+                if ( body )
+                {
+                    __DAFileSystemCacheHeader header;
+                    int                       file;
+
+                    header.magic      = __kDAFileSystemCacheMagic;
+                    header.version    = __kDAFileSystemCacheVersion;
+                    header.exclusions = __DAFileSystemCacheGetExclusions( );
+                    header.size       = ( uint32_t ) CFDataGetLength( body );
+                    header.time1      = __DAFileSystemCacheGetListTime( __gDAFileSystemListTime1 );
+                    header.time2      = __DAFileSystemCacheGetListTime( __gDAFileSystemListTime2 );
+
+                    /*
+                     * Write the cache aside and rename it into place, so that it is never seen
+                     * half written.
+                     */
+
+                    file = open( __kDAFileSystemCachePath ".new", O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+
+                    if ( file != -1 )
+                    {
+                        Boolean written;
+
+                        written = ( write( file, &header, sizeof( header ) ) == sizeof( header ) &&
+                                    write( file, CFDataGetBytePtr( body ), header.size ) == header.size );
+
+                        close( file );
+
+                        if ( written == FALSE || rename( __kDAFileSystemCachePath ".new", __kDAFileSystemCachePath ) )
+                        {
+                            unlink( __kDAFileSystemCachePath ".new" );
+                        }
+                    }
+
+                    CFRelease( body );
+                }
+
+                CFRelease( cache );
+            }
+        }
+    }
+
+    if ( bundles )  CFRelease( bundles );
+    if ( probes  )  CFRelease( probes  );
+}
+
+static Boolean __DAFileSystemListBuild( CFMutableArrayRef list, CFMutableArrayRef probeList )
+{
+    struct stat status1;
+    struct stat status2;
+
+    /*
+     * Determine whether the file system list is up-to-date.
+     */
+
+    if ( stat( FS_DIR_LOCATION, &status1 ) )
+    {
+        __gDAFileSystemListTime1.tv_sec  = 0;
+        __gDAFileSystemListTime1.tv_nsec = 0;
+    }
+
+    if ( stat( ___FS_DEFAULT_DIR, &status2 ) )
+    {
+        __gDAFileSystemListTime2.tv_sec  = 0;
+        __gDAFileSystemListTime2.tv_nsec = 0;
+    }
+
+    if ( __gDAFileSystemListTime1.tv_sec  != status1.st_mtimespec.tv_sec  ||
+         __gDAFileSystemListTime1.tv_nsec != status1.st_mtimespec.tv_nsec ||
+         __gDAFileSystemListTime2.tv_sec  != status2.st_mtimespec.tv_sec  ||
+         __gDAFileSystemListTime2.tv_nsec != status2.st_mtimespec.tv_nsec )
+    {
+        __gDAFileSystemListTime1.tv_sec  = status1.st_mtimespec.tv_sec;
+        __gDAFileSystemListTime1.tv_nsec = status1.st_mtimespec.tv_nsec;
+        __gDAFileSystemListTime2.tv_sec  = status2.st_mtimespec.tv_sec;
+        __gDAFileSystemListTime2.tv_nsec = status2.st_mtimespec.tv_nsec;
+
+        /*
+         * Load the file system list from the cache, or build it from the bundles.
+         */
+
+        if ( __DAFileSystemCacheLoad( list, probeList ) )
+        {
+            return TRUE;
+        }
+
+        __DAFileSystemListRefresh( FS_DIR_LOCATION, list, probeList );
+        __DAFileSystemListRefresh( ___FS_DEFAULT_DIR, list, probeList );
+
+        /*
+         * Order the probe list.
+         */
+
+        CFArraySortValues( probeList,
+                           CFRangeMake( 0, CFArrayGetCount( probeList ) ),
+                           __DAFileSystemProbeListCompare,
+                           NULL );
+
+        __DAFileSystemCacheSave( list, probeList );
+
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+static void __DAFileSystemListUpdate( void )
+{
+    CFMutableArrayRef list;
+    CFMutableArrayRef probeList;
+
+    list      = CFArrayCreateMutable( kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks );
+    probeList = CFArrayCreateMutable( kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks );
+
+    if ( list && probeList )
+    {
+        if ( __DAFileSystemListBuild( list, probeList ) )
+        {
+            CFArrayRef snapshot;
+
+            snapshot = CFArrayCreateCopy( kCFAllocatorDefault, probeList );
+
+            if ( snapshot )
+            {
+                __DAConfigurationPublish( &__gDAFileSystemProbeList, snapshot );
+
+                CFRelease( snapshot );
+            }
+        }
+    }
+
+    if ( list      )  CFRelease( list      );
+    if ( probeList )  CFRelease( probeList );
+}
+
+void DAFileSystemListRefresh( void )
+{
+    dispatch_sync( __DAConfigurationGetQueue( ), ^
+    {
+        __DAFileSystemListUpdate( );
+    } );
+}
+
+CFArrayRef DAFileSystemProbeListCopy( void )
+{
+    CFArrayRef probeList;
+
+    /*
+     * The probe list must be copied on the workloop, as __DAConfigurationCopy requires.
+     */
+
+    probeList = __DAConfigurationCopy( &__gDAFileSystemProbeList );
+
+    return probeList ? probeList : CFArrayCreate( kCFAllocatorDefault, NULL, 0, &kCFTypeArrayCallBacks );
+}
+
+static struct timespec __gDAMountMapListTime1 = { 0, 0 };
+static struct timespec __gDAMountMapListTime2 = { 0, 0 };
+
+static CFTypeRef _Atomic       __gDAMountMapList1     = NULL;
+static CFTypeRef _Atomic       __gDAMountMapList2     = NULL;
+static CFMutableDictionaryRef __gDAMountMapLineList1 = NULL;
+static CFMutableDictionaryRef __gDAMountMapLineList2 = NULL;
+
+static const CFStringRef __kDAMountMapIndexDeviceKey = CFSTR( "Device" );
+static const CFStringRef __kDAMountMapIndexNameKey   = CFSTR( "Name"   );
+static const CFStringRef __kDAMountMapIndexUUIDKey   = CFSTR( "UUID"   );
+static const CFStringRef __kDAMountMapListKey        = CFSTR( "List"   );
+
+typedef CFDictionaryRef ( *__DAMountMapCreateCallback )( char * line );
+
+const CFStringRef kDAMountMapMountAutomaticKey = CFSTR( "DAMountAutomatic" );
+const CFStringRef kDAMountMapMountOptionsKey   = CFSTR( "DAMountOptions"   );
+const CFStringRef kDAMountMapMountPathKey      = CFSTR( "DAMountPath"      );
+const CFStringRef kDAMountMapProbeIDKey        = CFSTR( "DAProbeID"        );
+const CFStringRef kDAMountMapProbeKindKey      = CFSTR( "DAProbeKind"      );
+
+// TODO: Figure out security policy for rdar://143332014
+static BOOL __DAShouldAddMountMapEntry( )
+{
+    return YES;
+}
+
+static void __DAMountMapIndexAdd( CFMutableDictionaryRef index, CFTypeRef key, CFIndex position )
+{
+    CFMutableArrayRef positions;
+
+    /*
+     * Record the position of a mount map entry under its key.  The positions are kept in the
+     * order of the mount map list, so that the first entry in the file still wins.
+     */
+
+    positions = ( void * ) CFDictionaryGetValue( index, key );
+
+    if ( positions == NULL )
+    {
+        positions = CFArrayCreateMutable( kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks );
+
+        if ( positions )
+        {
+            CFDictionarySetValue( index, key, positions );
+
+            CFRelease( positions );
+        }
+    }
+
+    if ( positions )
+    {
+        CFNumberRef number;
+
+        number = CFNumberCreate( kCFAllocatorDefault, kCFNumberCFIndexType, &position );
+
+        if ( number )
+        {
+            CFArrayAppendValue( positions, number );
+
+            CFRelease( number );
+        }
+    }
+}
+
+static Boolean __DAMountMapMatchKind( CFDictionaryRef map, DAFileSystemRef filesystem )
+{
+    CFStringRef kind;
+
+    kind = CFDictionaryGetValue( map, kDAMountMapProbeKindKey );
+
+    if ( kind && filesystem )
+    {
+        if ( CFEqual( kind, DAFileSystemGetKind( filesystem ) ) == FALSE )
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+static CFIndex __DAMountMapIndexFind( CFArrayRef list, CFArrayRef positions, DAFileSystemRef filesystem )
+{
+    if ( positions )
+    {
+        CFIndex count;
+        CFIndex index;
+
+        count = CFArrayGetCount( positions );
+
+        for ( index = 0; index < count; index++ )
+        {
+            CFIndex position;
+
+            CFNumberGetValue( CFArrayGetValueAtIndex( positions, index ), kCFNumberCFIndexType, &position );
+
+            if ( __DAMountMapMatchKind( CFArrayGetValueAtIndex( list, position ), filesystem ) )
+            {
+                return position;
+            }
+        }
+    }
+
+    return kCFNotFound;
+}
+
+static void __DAMountMapListBuild( const char * path, CFMutableArrayRef list, CFMutableDictionaryRef * lines, __DAMountMapCreateCallback create )
+{
+    CFMutableDictionaryRef cache;
+    int                    file;
+
+    /*
+     * Build the mount map list from the file at the specified path.  The file is mapped
+     * privately, so that each line can be terminated in place rather than copied, and each
+     * line is looked up by its bytes, so that only those lines not seen in the previous build
+     * are parsed.
+     */
+
+    CFArrayRemoveAllValues( list );
+
+    cache = CFDictionaryCreateMutable( kCFAllocatorDefault, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks );
+
+    if ( cache == NULL )
+    {
+        return;
+    }
+
+    file = open( path, O_RDONLY );
+
+    if ( file != -1 )
+    {
+        struct stat status;
+
+        if ( fstat( file, &status ) == 0 && status.st_size > 0 )
+        {
+            char * data;
+
+            data = mmap( NULL, status.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0 );
+
+            if ( data != MAP_FAILED )
+            {
+                char * end;
+                char * line;
+
+                end = data + status.st_size;
+
+                for ( line = data; line < end; )
+                {
+                    CFDataRef key;
+                    char *    next;
+
+                    next = memchr( line, '\n', end - line );
+
+                    if ( next == NULL )
+                    {
+                        next = end;
+                    }
+
+                    key = CFDataCreate( kCFAllocatorDefault, ( void * ) line, next - line );
+
+                    if ( key )
+                    {
+                        CFTypeRef map;
+
+                        map = CFDictionaryGetValue( cache, key );
+
+                        if ( map == NULL && *lines )
+                        {
+                            map = CFDictionaryGetValue( *lines, key );
+                        }
+
+                        if ( map )
+                        {
+                            CFRetain( map );
+                        }
+                        else
+                        {
+                            if ( next < end )
+                            {
+                                *next = '\0';
+
+                                map = create( line );
+                            }
+                            else
+                            {
+                                char * copy;
+
+                                /*
+                                 * The last line lacks a newline and cannot be terminated in place.
+                                 */
+
+                                copy = strndup( line, next - line );
+
+                                if ( copy )
+                                {
+                                    map = create( copy );
+
+                                    free( copy );
+                                }
+                            }
+
+                            if ( map == NULL )
+                            {
+                                map = CFRetain( kCFNull );
+                            }
+                        }
+
+                        CFDictionarySetValue( cache, key, map );
+
+                        if ( map != kCFNull )
+                        {
+                            CFArrayAppendValue( list, map );
+                        }
+
+                        CFRelease( map );
+
+                        CFRelease( key );
+                    }
+
+                    line = next + 1;
+                }
+
+                munmap( data, status.st_size );
+            }
+        }
+
+        close( file );
+    }
+
+    if ( *lines )
+    {
+        CFRelease( *lines );
+    }
+
+    *lines = cache;
+}
+
+static CFDictionaryRef __DAMountMapCreate1( CFAllocatorRef allocator, struct fstab * fs )
+{
+    CFMutableDictionaryRef map = NULL;
+    static BOOL fstabEntryAdded = NO; // Don't post the event again during subsequent refreshes
+    
+    if ( strcmp( fs->fs_type, FSTAB_SW ) )
+    {
+        char * idAsCString = fs->fs_spec;
+
+        strsep( &idAsCString, "=" );
+
+        if ( idAsCString )
+        {
+            CFStringRef idAsString;
+
+            idAsString = CFStringCreateWithCString( kCFAllocatorDefault, idAsCString, kCFStringEncodingUTF8 );
+
+            if ( idAsString )
+            {
+                CFTypeRef entryID = NULL;
+
+                if ( strcmp( fs->fs_spec, "UUID" ) == 0 )
+                {
+                    entryID = ___CFUUIDCreateFromString( kCFAllocatorDefault, idAsString );
+                }
+                else if ( strcmp( fs->fs_spec, "LABEL" ) == 0 )
+                {
+                    entryID = CFRetain( idAsString );
+                }
+                else if ( strcmp( fs->fs_spec, "DEVICE" ) == 0 )
+                {
+                    entryID = ___CFDictionaryCreateFromXMLString( kCFAllocatorDefault, idAsString );
+                }
+
+                if ( entryID )
+                {
+                    map = CFDictionaryCreateMutable( kCFAllocatorDefault, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks );
+
+                    if ( map )
+                    {
+                        CFMutableStringRef options;
+
+                        options = CFStringCreateMutable( kCFAllocatorDefault, 0 );
+
+                        if ( options )
+                        {
+                            char *       argument  = NULL;
+                            char *       arguments = fs->fs_mntops;
+                            CFBooleanRef automatic = NULL;
+
+                            while ( ( argument = strsep( &arguments, "," ) ) )
+                            {
+                                if ( strcmp( argument, "auto" ) == 0 )
+                                {
+                                    automatic = kCFBooleanTrue;
+                                }
+                                else if ( strcmp( argument, "noauto" ) == 0 )
+                                {
+                                    automatic = kCFBooleanFalse;
+                                }
+                                else
+                                {
+                                    CFStringAppendCString( options, argument, kCFStringEncodingUTF8 );    
+                                    CFStringAppendCString( options, ",", kCFStringEncodingUTF8 );
+                                }
+                            }
+
+                            if ( automatic )
+                            {
+                                CFDictionarySetValue( map, kDAMountMapMountAutomaticKey, automatic );
+                            }
+
+                            if ( CFStringGetLength( options ) )
+                            {
+                                CFStringTrim( options, CFSTR( "," ) );
+
+                                CFDictionarySetValue( map, kDAMountMapMountOptionsKey, options );
+                            }
+
+                            CFRelease( options );
+                        }
+
+                        if ( strcmp( fs->fs_file, "none" ) )
+                        {
+                            CFURLRef path;
+
+                            path = CFURLCreateFromFileSystemRepresentation( kCFAllocatorDefault, ( void * ) fs->fs_file, strlen( fs->fs_file ), TRUE );
+
+                            if ( path )
+                            {
+                                CFDictionarySetValue( map, kDAMountMapMountPathKey, path );
+
+                                CFRelease( path );
+                            }
+                        }
+
+                        if ( strcmp( fs->fs_vfstype, "auto" ) )
+                        {
+                            CFStringRef kind;
+
+                            kind = CFStringCreateWithCString( kCFAllocatorDefault, fs->fs_vfstype, kCFStringEncodingUTF8 );
+
+                            if ( kind )
+                            {
+                                CFDictionarySetValue( map, kDAMountMapProbeKindKey, kind );
+
+                                CFRelease( kind );
+                            }
+                        }
+
+                        CFDictionarySetValue( map, kDAMountMapProbeIDKey, entryID );
+                    }
+
+                    CFRelease( entryID );
+                }
+
+                CFRelease( idAsString );
+            }
+        }
+#if TARGET_OS_OSX
+        if ( map != NULL )
+        {
+            /* mount map entries are considered automounted, not external volumes, and use the kext path */
+            BOOL automounted = TRUE;
+            BOOL externalVolume = FALSE;
+            
+            if ( __DAShouldAddMountMapEntry( ) )
+            {
+                if ( !fstabEntryAdded )
+                {
+                    // Post telemetry event for the first entry added
+                    fstabEntryAdded = YES;
+                    DATelemetrySendMountEvent( DA_STATUS_FSTAB_MOUNT_ADDED ,
+                                              CFDictionaryGetValue( map , kDAMountMapProbeKindKey ) ,
+                                              DATelemetryFSImplementationKext ,
+                                              automounted ,
+                                              externalVolume ,
+                                              0 );
                 }
             }
             else
@@ -1544,7 +2480,22 @@ static CFDictionaryRef __DAMountMapCreate1( CFAllocatorRef allocator, struct fst
     return map;
 }
 
-void DAMountMapListRefresh1( void )
+static CFDictionaryRef __DAMountMapCreateFromLine1( char * line )
+{
+    struct fstab fs;
+    int          status;
+
+    status = fstabparse_r( line, &fs );
+
+    if ( status < 0 )
+    {
+        DALogInfo( "unable to parse %s entry.", _PATH_FSTAB );
+    }
+
+    return ( status > 0 ) ? __DAMountMapCreate1( kCFAllocatorDefault, &fs ) : NULL;
+}
+
+static Boolean __DAMountMapListBuild1( CFMutableArrayRef list, CFMutableArrayRef device, CFMutableDictionaryRef name, CFMutableDictionaryRef uuid )
 {
     struct stat status;
 
@@ -1561,40 +2512,108 @@ void DAMountMapListRefresh1( void )
     if ( __gDAMountMapListTime1.tv_sec  != status.st_mtimespec.tv_sec  ||
          __gDAMountMapListTime1.tv_nsec != status.st_mtimespec.tv_nsec )
     {
+        CFIndex count;
+        CFIndex position;
+
         __gDAMountMapListTime1.tv_sec  = status.st_mtimespec.tv_sec;
         __gDAMountMapListTime1.tv_nsec = status.st_mtimespec.tv_nsec;
 
         /*
-         * Clear the mount map list.
+         * Build the mount map list.
          */
 
-        CFArrayRemoveAllValues( gDAMountMapList1 );
+        __DAMountMapListBuild( _PATH_FSTAB, list, &__gDAMountMapLineList1, __DAMountMapCreateFromLine1 );
 
         /*
-         * Build the mount map list.
+         * Index the entries by volume UUID or by volume name.  The device entries require I/O
+         * Kit matching, so they are kept aside in a list of their own.
          */
 
-        if ( setfsent( ) )
+        count = CFArrayGetCount( list );
+
+        for ( position = 0; position < count; position++ )
         {
-            struct fstab * item;
+            CFTypeRef id;
 
-            while ( ( item = getfsent( ) ) )
+            id = CFDictionaryGetValue( CFArrayGetValueAtIndex( list, position ), kDAMountMapProbeIDKey );
+
+            if ( CFGetTypeID( id ) == CFUUIDGetTypeID( ) )
+            {
+                __DAMountMapIndexAdd( uuid, id, position );
+            }
+            else if ( CFGetTypeID( id ) == CFStringGetTypeID( ) )
+            {
+                __DAMountMapIndexAdd( name, id, position );
+            }
+            else if ( CFGetTypeID( id ) == CFDictionaryGetTypeID( ) )
             {
-                CFDictionaryRef map;
+                CFNumberRef number;
 
-                map = __DAMountMapCreate1( kCFAllocatorDefault, item );
+                number = CFNumberCreate( kCFAllocatorDefault, kCFNumberCFIndexType, &position );
 
-                if ( map )
+                if ( number )
                 {
-                    CFArrayAppendValue( gDAMountMapList1, map );
+                    CFArrayAppendValue( device, number );
 
-                    CFRelease( map );
+                    CFRelease( number );
                 }
             }
+        }
+
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+static void __DAMountMapListUpdate1( void )
+{
+    CFMutableArrayRef      device;
+    CFMutableArrayRef      list;
+    CFMutableDictionaryRef name;
+    CFMutableDictionaryRef uuid;
+
+    device = CFArrayCreateMutable( kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks );
+    list   = CFArrayCreateMutable( kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks );
+    name   = CFDictionaryCreateMutable( kCFAllocatorDefault, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks );
+    uuid   = CFDictionaryCreateMutable( kCFAllocatorDefault, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks );
+
+    if ( device && list && name && uuid )
+    {
+        if ( __DAMountMapListBuild1( list, device, name, uuid ) )
+        {
+            CFDictionaryRef snapshot;
+            const void *    keys[]   = { __kDAMountMapListKey, __kDAMountMapIndexDeviceKey, __kDAMountMapIndexNameKey, __kDAMountMapIndexUUIDKey };
+            const void *    values[] = { list, device, name, uuid };
+
+            /*
+             * The mount map list is published together with its index, so that a reader never
+             * sees the index of one list against the entries of another.
+             */
+
+            snapshot = CFDictionaryCreate( kCFAllocatorDefault, keys, values, 4, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks );
+
+            if ( snapshot )
+            {
+                __DAConfigurationPublish( &__gDAMountMapList1, snapshot );
 
-            endfsent( );
+                CFRelease( snapshot );
+            }
         }
     }
+
+    if ( device )  CFRelease( device );
+    if ( list   )  CFRelease( list   );
+    if ( name   )  CFRelease( name   );
+    if ( uuid   )  CFRelease( uuid   );
+}
+
+void DAMountMapListRefresh1( void )
+{
+    dispatch_sync( __DAConfigurationGetQueue( ), ^
+    {
+        __DAMountMapListUpdate1( );
+    } );
 }
 
 static CFDictionaryRef __DAMountMapCreate2( CFAllocatorRef allocator, struct vsdb * vs )
@@ -1606,108 +2625,277 @@ static CFDictionaryRef __DAMountMapCreate2( CFAllocatorRef allocator, struct vsd
 
     if ( idAsString )
     {
-        CFTypeRef id;
+        CFTypeRef id;
+
+        id = _DAFileSystemCreateUUIDFromString( kCFAllocatorDefault, idAsString );
+
+        if ( id )
+        {
+            map = CFDictionaryCreateMutable( kCFAllocatorDefault, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks );
+
+            if ( map )
+            {
+                CFMutableStringRef options;
+
+                options = CFStringCreateMutable( kCFAllocatorDefault, 0 );
+
+                if ( options )
+                {
+                    if ( ( vs->vs_ops & VSDB_PERM ) )
+                    {
+                        CFStringAppend( options, CFSTR( "owners" ) );
+                        CFStringAppend( options, CFSTR( "," ) );
+                    }
+                    else
+                    {
+                        CFStringAppend( options, CFSTR( "noowners" ) );
+                        CFStringAppend( options, CFSTR( "," ) );
+                    }
+
+                    if ( CFStringGetLength( options ) )
+                    {
+                        CFStringTrim( options, CFSTR( "," ) );
+
+                        CFDictionarySetValue( map, kDAMountMapMountOptionsKey, options );
+                    }
+
+                    CFRelease( options );
+                }
+
+                CFDictionarySetValue( map, kDAMountMapProbeIDKey, id );
+            }
+
+            CFRelease( id );
+        }
+
+        CFRelease( idAsString );
+    }
+
+    return map;
+}
+
+static CFDictionaryRef __DAMountMapCreateFromLine2( char * line )
+{
+    struct vsdb vs;
+
+    return vsdbparse_r( line, &vs ) ? __DAMountMapCreate2( kCFAllocatorDefault, &vs ) : NULL;
+}
+
+static Boolean __DAMountMapListBuild2( CFMutableArrayRef list, CFMutableDictionaryRef uuid )
+{
+    struct stat status;
+
+    /*
+     * Determine whether the mount map list is up-to-date.
+     */
+
+    if ( stat( _PATH_VSDB, &status ) )
+    {
+        __gDAMountMapListTime2.tv_sec  = 0;
+        __gDAMountMapListTime2.tv_nsec = 0;
+    }
+
+    if ( __gDAMountMapListTime2.tv_sec  != status.st_mtimespec.tv_sec  ||
+         __gDAMountMapListTime2.tv_nsec != status.st_mtimespec.tv_nsec )
+    {
+        CFIndex count;
+        CFIndex position;
+
+        __gDAMountMapListTime2.tv_sec  = status.st_mtimespec.tv_sec;
+        __gDAMountMapListTime2.tv_nsec = status.st_mtimespec.tv_nsec;
+
+        /*
+         * Build the mount map list.
+         */
+
+        __DAMountMapListBuild( _PATH_VSDB, list, &__gDAMountMapLineList2, __DAMountMapCreateFromLine2 );
+
+        count = CFArrayGetCount( list );
+
+        for ( position = 0; position < count; position++ )
+        {
+            __DAMountMapIndexAdd( uuid, CFDictionaryGetValue( CFArrayGetValueAtIndex( list, position ), kDAMountMapProbeIDKey ), position );
+        }
+
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+static void __DAMountMapListUpdate2( void )
+{
+    CFMutableArrayRef      list;
+    CFMutableDictionaryRef uuid;
+
+    list = CFArrayCreateMutable( kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks );
+    uuid = CFDictionaryCreateMutable( kCFAllocatorDefault, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks );
+
+    if ( list && uuid )
+    {
+        if ( __DAMountMapListBuild2( list, uuid ) )
+        {
+            CFDictionaryRef snapshot;
+            const void *    keys[]   = { __kDAMountMapListKey, __kDAMountMapIndexUUIDKey };
+            const void *    values[] = { list, uuid };
+
+            snapshot = CFDictionaryCreate( kCFAllocatorDefault, keys, values, 2, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks );
+
+            if ( snapshot )
+            {
+                __DAConfigurationPublish( &__gDAMountMapList2, snapshot );
+
+                CFRelease( snapshot );
+            }
+        }
+    }
+
+    if ( list )  CFRelease( list );
+    if ( uuid )  CFRelease( uuid );
+}
+
+void DAMountMapListRefresh2( void )
+{
+    dispatch_sync( __DAConfigurationGetQueue( ), ^
+    {
+        __DAMountMapListUpdate2( );
+    } );
+}
+
+CFDictionaryRef DAMountMapListGetMatch1( DADiskRef disk, DAFileSystemRef filesystem )
+{
+    CFIndex         count;
+    CFArrayRef      device;
+    CFIndex         index;
+    CFTypeRef       key;
+    CFArrayRef      list;
+    CFDictionaryRef map = NULL;
+    CFIndex         match = kCFNotFound;
+    CFDictionaryRef snapshot;
+
+    /*
+     * Match on the workloop only, where the snapshot cannot be retired out from under the lookup.
+     */
+
+    snapshot = __DAConfigurationCopy( &__gDAMountMapList1 );
+
+    if ( snapshot == NULL )
+    {
+        return NULL;
+    }
+
+    device = CFDictionaryGetValue( snapshot, __kDAMountMapIndexDeviceKey );
+    list   = CFDictionaryGetValue( snapshot, __kDAMountMapListKey        );
+
+    /*
+     * Find the first entry in the mount map list that matches the volume, whether by volume
+     * UUID, by volume name or by device description.
+     */
+
+    key = DADiskGetDescription( disk, kDADiskDescriptionVolumeUUIDKey );
+
+    if ( key )
+    {
+        match = __DAMountMapIndexFind( list, CFDictionaryGetValue( CFDictionaryGetValue( snapshot, __kDAMountMapIndexUUIDKey ), key ), filesystem );
+    }
+
+    key = DADiskGetDescription( disk, kDADiskDescriptionVolumeNameKey );
+
+    if ( key )
+    {
+        CFIndex position;
 
-        id = _DAFileSystemCreateUUIDFromString( kCFAllocatorDefault, idAsString );
+        position = __DAMountMapIndexFind( list, CFDictionaryGetValue( CFDictionaryGetValue( snapshot, __kDAMountMapIndexNameKey ), key ), filesystem );
 
-        if ( id )
+        if ( position != kCFNotFound )
         {
-            map = CFDictionaryCreateMutable( kCFAllocatorDefault, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks );
-
-            if ( map )
+            if ( match == kCFNotFound || position < match )
             {
-                CFMutableStringRef options;
+                match = position;
+            }
+        }
+    }
 
-                options = CFStringCreateMutable( kCFAllocatorDefault, 0 );
+    count = CFArrayGetCount( device );
 
-                if ( options )
-                {
-                    if ( ( vs->vs_ops & VSDB_PERM ) )
-                    {
-                        CFStringAppend( options, CFSTR( "owners" ) );
-                        CFStringAppend( options, CFSTR( "," ) );
-                    }
-                    else
-                    {
-                        CFStringAppend( options, CFSTR( "noowners" ) );
-                        CFStringAppend( options, CFSTR( "," ) );
-                    }
+    for ( index = 0; index < count; index++ )
+    {
+        CFIndex position;
 
-                    if ( CFStringGetLength( options ) )
-                    {
-                        CFStringTrim( options, CFSTR( "," ) );
+        CFNumberGetValue( CFArrayGetValueAtIndex( device, index ), kCFNumberCFIndexType, &position );
 
-                        CFDictionarySetValue( map, kDAMountMapMountOptionsKey, options );
-                    }
+        if ( match != kCFNotFound && match < position )
+        {
+            break;
+        }
 
-                    CFRelease( options );
-                }
+        map = CFArrayGetValueAtIndex( list, position );
 
-                CFDictionarySetValue( map, kDAMountMapProbeIDKey, id );
-            }
+        if ( __DAMountMapMatchKind( map, filesystem ) )
+        {
+            boolean_t matched = FALSE;
 
-            CFRelease( id );
-        }
+            IOServiceMatchPropertyTable( DADiskGetIOMedia( disk ), CFDictionaryGetValue( map, kDAMountMapProbeIDKey ), &matched );
 
-        CFRelease( idAsString );
+            if ( matched )
+            {
+                match = position;
+
+                break;
+            }
+        }
     }
 
+    map = ( match == kCFNotFound ) ? NULL : CFArrayGetValueAtIndex( list, match );
+
+    /*
+     * The entry outlives our reference on the snapshot, since the snapshot is retired on the
+     * workloop only after the caller is done.
+     */
+
+    CFRelease( snapshot );
+
     return map;
 }
 
-void DAMountMapListRefresh2( void )
+CFDictionaryRef DAMountMapListGetMatch2( DADiskRef disk )
 {
-    struct stat status;
+    CFTypeRef       key;
+    CFArrayRef      list;
+    CFDictionaryRef map = NULL;
+    CFDictionaryRef snapshot;
 
     /*
-     * Determine whether the mount map list is up-to-date.
+     * As with DAMountMapListGetMatch1( ), this must be called on the workloop.
      */
 
-    if ( stat( _PATH_VSDB, &status ) )
-    {
-        __gDAMountMapListTime2.tv_sec  = 0;
-        __gDAMountMapListTime2.tv_nsec = 0;
-    }
+    snapshot = __DAConfigurationCopy( &__gDAMountMapList2 );
 
-    if ( __gDAMountMapListTime2.tv_sec  != status.st_mtimespec.tv_sec  ||
-         __gDAMountMapListTime2.tv_nsec != status.st_mtimespec.tv_nsec )
+    if ( snapshot == NULL )
     {
-        __gDAMountMapListTime2.tv_sec  = status.st_mtimespec.tv_sec;
-        __gDAMountMapListTime2.tv_nsec = status.st_mtimespec.tv_nsec;
-
-        /*
-         * Clear the mount map list.
-         */
-
-        CFArrayRemoveAllValues( gDAMountMapList2 );
+        return NULL;
+    }
 
-        /*
-         * Build the mount map list.
-         */
+    list = CFDictionaryGetValue( snapshot, __kDAMountMapListKey );
 
-        if ( setvsent( ) )
-        {
-            struct vsdb * item;
+    key = DADiskGetDescription( disk, kDADiskDescriptionVolumeUUIDKey );
 
-            while ( ( item = getvsent( ) ) )
-            {
-                CFDictionaryRef map;
+    if ( key )
+    {
+        CFIndex match;
 
-                map = __DAMountMapCreate2( kCFAllocatorDefault, item );
+        match = __DAMountMapIndexFind( list, CFDictionaryGetValue( CFDictionaryGetValue( snapshot, __kDAMountMapIndexUUIDKey ), key ), NULL );
 
-                if ( map )
-                {
-                    CFArrayAppendValue( gDAMountMapList2, map );
+        map = ( match == kCFNotFound ) ? NULL : CFArrayGetValueAtIndex( list, match );
+    }
 
-                    CFRelease( map );
-                }
-            }
+    CFRelease( snapshot );
 
-            endvsent( );
-        }
-    }
+    return map;
 }
 
+static CFTypeRef _Atomic __gDAPreferenceList = NULL;
+
 static struct timespec __gDAPreferenceListTime1 = { 0, 0 };
 static struct timespec __gDAPreferenceListTime2 = { 0, 0 };
 
@@ -1727,7 +2915,7 @@ const CFStringRef kDAPreferenceDisableUnreadableNotificationKey   = CFSTR( "DADi
 const CFStringRef kDAPreferenceDisableUnrepairableNotificationKey = CFSTR( "DADisableUnrepairableNotification" );
 const CFStringRef kDAPreferenceMountAlwaysRepairKey               = CFSTR( "DAMountAlwaysRepair"   );
 
-void DAPreferenceListRefresh( void )
+static Boolean __DAPreferenceListBuild( CFMutableDictionaryRef list )
 {
     struct stat status1;
     struct stat status2;
@@ -1738,33 +2926,27 @@ void DAPreferenceListRefresh( void )
 
     if ( stat( ___PREFS_DEFAULT_DIR "/" "autodiskmount.plist", &status1 ) )
     {
-        __gDAPreferenceListTime1.tv_sec  = 0;
-        __gDAPreferenceListTime1.tv_nsec = 0;
+        __listTime1.tv_sec  = 0;
+        __listTime1.tv_nsec = 0;
     }
 
     if ( stat( ___PREFS_DEFAULT_DIR "/" _kDADaemonName ".plist", &status2 ) )
     {
-        __gDAPreferenceListTime2.tv_sec  = 0;
-        __gDAPreferenceListTime2.tv_nsec = 0;
+        __listTime2.tv_sec  = 0;
+        __listTime2.tv_nsec = 0;
     }
 
-    if ( __gDAPreferenceListTime1.tv_sec  != status1.st_mtimespec.tv_sec  ||
-         __gDAPreferenceListTime1.tv_nsec != status1.st_mtimespec.tv_nsec ||
-         __gDAPreferenceListTime2.tv_sec  != status2.st_mtimespec.tv_sec  ||
-         __gDAPreferenceListTime2.tv_nsec != status2.st_mtimespec.tv_nsec )
+    if ( __listTime1.tv_sec  != status1.st_mtimespec.tv_sec  ||
+         __listTime1.tv_nsec != status1.st_mtimespec.tv_nsec ||
+         __listTime2.tv_sec  != status2.st_mtimespec.tv_sec  ||
+         __listTime2.tv_nsec != status2.st_mtimespec.tv_nsec )
     {
         SCPreferencesRef preferences;
 
-        __gDAPreferenceListTime1.tv_sec  = status1.st_mtimespec.tv_sec;
-        __gDAPreferenceListTime1.tv_nsec = status1.st_mtimespec.tv_nsec;
-        __gDAPreferenceListTime2.tv_sec  = status2.st_mtimespec.tv_sec;
-        __gDAPreferenceListTime2.tv_nsec = status2.st_mtimespec.tv_nsec;
-
-        /*
-         * Clear the preference list.
-         */
-
-        CFDictionaryRemoveAllValues( gDAPreferenceList );
+        __listTime1.tv_sec  = status1.st_mtimespec.tv_sec;
+        __listTime1.tv_nsec = status1.st_mtimespec.tv_nsec;
+        __listTime2.tv_sec  = status2.st_mtimespec.tv_sec;
+        __listTime2.tv_nsec = status2.st_mtimespec.tv_nsec;
 
         /*
          * Build the preference list.
@@ -1780,15 +2962,15 @@ void DAPreferenceListRefresh( void )
 
             if ( value == kCFBooleanTrue )
             {
-                CFDictionarySetValue( gDAPreferenceList, kDAPreferenceMountDeferExternalKey,  kCFBooleanFalse );
-                CFDictionarySetValue( gDAPreferenceList, kDAPreferenceMountDeferRemovableKey, kCFBooleanFalse );
-                CFDictionarySetValue( gDAPreferenceList, kDAPreferenceMountTrustExternalKey,  kCFBooleanTrue  );
+                CFDictionarySetValue( list, kDAPreferenceMountDeferExternalKey,  kCFBooleanFalse );
+                CFDictionarySetValue( list, kDAPreferenceMountDeferRemovableKey, kCFBooleanFalse );
+                CFDictionarySetValue( list, kDAPreferenceMountTrustExternalKey,  kCFBooleanTrue  );
             }
             else if ( value == kCFBooleanFalse )
             {
-                CFDictionarySetValue( gDAPreferenceList, kDAPreferenceMountDeferExternalKey,  kCFBooleanFalse );
-                CFDictionarySetValue( gDAPreferenceList, kDAPreferenceMountDeferRemovableKey, kCFBooleanTrue  );
-                CFDictionarySetValue( gDAPreferenceList, kDAPreferenceMountTrustExternalKey,  kCFBooleanTrue  );
+                CFDictionarySetValue( list, kDAPreferenceMountDeferExternalKey,  kCFBooleanFalse );
+                CFDictionarySetValue( list, kDAPreferenceMountDeferRemovableKey, kCFBooleanTrue  );
+                CFDictionarySetValue( list, kDAPreferenceMountTrustExternalKey,  kCFBooleanTrue  );
             }
 
             CFRelease( preferences );
@@ -1806,7 +2988,7 @@ void DAPreferenceListRefresh( void )
             {
                 if ( CFGetTypeID( value ) == CFBooleanGetTypeID( ) )
                 {
-                    CFDictionarySetValue( gDAPreferenceList, kDAPreferenceMountDeferExternalKey, value );
+                    CFDictionarySetValue( list, kDAPreferenceMountDeferExternalKey, value );
                 }
             }
 
@@ -1816,7 +2998,7 @@ void DAPreferenceListRefresh( void )
             {
                 if ( CFGetTypeID( value ) == CFBooleanGetTypeID( ) )
                 {
-                    CFDictionarySetValue( gDAPreferenceList, kDAPreferenceMountDeferInternalKey, value );
+                    CFDictionarySetValue( list, kDAPreferenceMountDeferInternalKey, value );
                 }
             }
 
@@ -1826,7 +3008,7 @@ void DAPreferenceListRefresh( void )
             {
                 if ( CFGetTypeID( value ) == CFBooleanGetTypeID( ) )
                 {
-                    CFDictionarySetValue( gDAPreferenceList, kDAPreferenceMountDeferRemovableKey, value );
+                    CFDictionarySetValue( list, kDAPreferenceMountDeferRemovableKey, value );
                 }
             }
 
@@ -1836,7 +3018,7 @@ void DAPreferenceListRefresh( void )
             {
                 if ( CFGetTypeID( value ) == CFBooleanGetTypeID( ) )
                 {
-                    CFDictionarySetValue( gDAPreferenceList, kDAPreferenceMountTrustExternalKey, value );
+                    CFDictionarySetValue( list, kDAPreferenceMountTrustExternalKey, value );
                 }
             }
 
@@ -1846,7 +3028,7 @@ void DAPreferenceListRefresh( void )
             {
                 if ( CFGetTypeID( value ) == CFBooleanGetTypeID( ) )
                 {
-                    CFDictionarySetValue( gDAPreferenceList, kDAPreferenceMountTrustInternalKey, value );
+                    CFDictionarySetValue( list, kDAPreferenceMountTrustInternalKey, value );
                 }
             }
 
@@ -1856,7 +3038,7 @@ void DAPreferenceListRefresh( void )
             {
                 if ( CFGetTypeID( value ) == CFBooleanGetTypeID( ) )
                 {
-                    CFDictionarySetValue( gDAPreferenceList, kDAPreferenceMountTrustRemovableKey, value );
+                    CFDictionarySetValue( list, kDAPreferenceMountTrustRemovableKey, value );
                 }
             }
 
@@ -1866,7 +3048,7 @@ void DAPreferenceListRefresh( void )
             {
                 if ( CFGetTypeID( value ) == CFBooleanGetTypeID( ) )
                 {
-                    CFDictionarySetValue( gDAPreferenceList, kDAPreferenceAutoMountDisableKey, value );
+                    CFDictionarySetValue( list, kDAPreferenceAutoMountDisableKey, value );
                 }
             }
             
@@ -1876,7 +3058,7 @@ void DAPreferenceListRefresh( void )
             {
                 if ( CFGetTypeID( value ) == CFBooleanGetTypeID( ) )
                 {
-                    CFDictionarySetValue( gDAPreferenceList, kDAPreferenceEnableUserFSMountExternalKey, value );
+                    CFDictionarySetValue( list, kDAPreferenceEnableUserFSMountExternalKey, value );
                 }
             }
             
@@ -1886,7 +3068,7 @@ void DAPreferenceListRefresh( void )
             {
                 if ( CFGetTypeID( value ) == CFBooleanGetTypeID( ) )
                 {
-                    CFDictionarySetValue( gDAPreferenceList, kDAPreferenceEnableUserFSMountInternalKey, value );
+                    CFDictionarySetValue( list, kDAPreferenceEnableUserFSMountInternalKey, value );
                 }
             }
             
@@ -1896,7 +3078,7 @@ void DAPreferenceListRefresh( void )
             {
                 if ( CFGetTypeID( value ) == CFBooleanGetTypeID( ) )
                 {
-                    CFDictionarySetValue( gDAPreferenceList, kDAPreferenceEnableUserFSMountRemovableKey, value );
+                    CFDictionarySetValue( list, kDAPreferenceEnableUserFSMountRemovableKey, value );
                 }
             }
             
@@ -1906,7 +3088,7 @@ void DAPreferenceListRefresh( void )
             {
                 if ( CFGetTypeID( value ) == CFStringGetTypeID( ) )
                 {
-                    CFDictionarySetValue( gDAPreferenceList, kDAPreferenceMountMethodkey, value );
+                    CFDictionarySetValue( list, kDAPreferenceMountMethodkey, value );
                 }
             }
             
@@ -1916,7 +3098,7 @@ void DAPreferenceListRefresh( void )
             {
                 if ( CFGetTypeID( value ) == CFBooleanGetTypeID( ) )
                 {
-                    CFDictionarySetValue( gDAPreferenceList, kDAPreferenceDisableEjectNotificationKey, value );
+                    CFDictionarySetValue( list, kDAPreferenceDisableEjectNotificationKey, value );
                 }
             }
             
@@ -1926,7 +3108,7 @@ void DAPreferenceListRefresh( void )
             {
                 if ( CFGetTypeID( value ) == CFBooleanGetTypeID( ) )
                 {
-                    CFDictionarySetValue( gDAPreferenceList, kDAPreferenceDisableUnreadableNotificationKey, value );
+                    CFDictionarySetValue( list, kDAPreferenceDisableUnreadableNotificationKey, value );
                 }
             }
             
@@ -1936,7 +3118,7 @@ void DAPreferenceListRefresh( void )
             {
                 if ( CFGetTypeID( value ) == CFBooleanGetTypeID( ) )
                 {
-                    CFDictionarySetValue( gDAPreferenceList, kDAPreferenceDisableUnrepairableNotificationKey, value );
+                    CFDictionarySetValue( list, kDAPreferenceDisableUnrepairableNotificationKey, value );
                 }
             }
             
@@ -1946,13 +3128,351 @@ void DAPreferenceListRefresh( void )
             {
                 if ( CFGetTypeID( value ) == CFBooleanGetTypeID( ) )
                 {
-                    CFDictionarySetValue( gDAPreferenceList, kDAPreferenceMountAlwaysRepairKey, value );
+                    CFDictionarySetValue( list, kDAPreferenceMountAlwaysRepairKey, value );
                 }
             }
             
             CFRelease( preferences );
         }
+
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+static void __DAPreferenceListUpdate( void )
+{
+    CFMutableDictionaryRef list;
+
+    list = CFDictionaryCreateMutable( kCFAllocatorDefault, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks );
+
+    if ( list )
+    {
+        if ( __DAPreferenceListBuild( list ) )
+        {
+            CFDictionaryRef snapshot;
+
+            snapshot = CFDictionaryCreateCopy( kCFAllocatorDefault, list );
+
+            if ( snapshot )
+            {
+                __DAConfigurationPublish( &__gDAPreferenceList, snapshot );
+
+                CFRelease( snapshot );
+            }        }
+
+        CFRelease( list );
+    }
+}
+
+void DAPreferenceListRefresh( void )
+{
+    dispatch_sync( __DAConfigurationGetQueue( ), ^
+    {
+        __DAPreferenceListUpdate( );
+    } );
+}
+
+CFDictionaryRef DAPreferenceListCopy( void )
+{
+    CFDictionaryRef list;
+
+    /*
+     * The preferences must be copied on the workloop, as __DAConfigurationCopy requires.
+     */
+
+    list = __DAConfigurationCopy( &__gDAPreferenceList );
+
+    return list ? list : CFDictionaryCreate( kCFAllocatorDefault, NULL, NULL, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks );
+}
+
+struct __DAConfigurationWatch
+{
+    const char *      path;
+    void              ( *update )( void );
+    dispatch_source_t source;
+};
+
+typedef struct __DAConfigurationWatch __DAConfigurationWatch;
+
+static __DAConfigurationWatch __gDAConfigurationWatchList[] =
+{
+    { _PATH_FSTAB,                                       __DAMountMapListUpdate1,  NULL },
+    { _PATH_VSDB,                                        __DAMountMapListUpdate2,  NULL },
+    { ___PREFS_DEFAULT_DIR "/" "autodiskmount.plist",    __DAPreferenceListUpdate, NULL },
+    { ___PREFS_DEFAULT_DIR "/" _kDADaemonName ".plist", __DAPreferenceListUpdate, NULL },
+    { FS_DIR_LOCATION,                                   __DAFileSystemListUpdate, NULL },
+    { ___FS_DEFAULT_DIR,                                 __DAFileSystemListUpdate, NULL },
+    { "/etc",                                            NULL,                     NULL },
+    { "/var/db",                                         NULL,                     NULL },
+    { "/Library",                                        NULL,                     NULL },
+    { ___PREFS_DEFAULT_DIR,                              NULL,                     NULL }
+};
+
+static void __DAConfigurationWatchEvent( __DAConfigurationWatch * watch );
+
+static void __DAConfigurationWatchArm( __DAConfigurationWatch * watch )
+{
+    if ( watch->source == NULL )
+    {
+        int file;
+
+        file = open( watch->path, O_EVTONLY );
+
+        if ( file != -1 )
+        {
+            watch->source = dispatch_source_create( DISPATCH_SOURCE_TYPE_VNODE,
+                                                    file,
+                                                    DISPATCH_VNODE_ATTRIB |
+                                                    DISPATCH_VNODE_DELETE |
+                                                    DISPATCH_VNODE_EXTEND |
+                                                    DISPATCH_VNODE_RENAME |
+                                                    DISPATCH_VNODE_REVOKE |
+                                                    DISPATCH_VNODE_WRITE,
+                                                    __DAConfigurationGetQueue( ) );
+
+            if ( watch->source )
+            {
+                dispatch_source_set_event_handler( watch->source, ^
+                {
+                    __DAConfigurationWatchEvent( watch );
+                } );
+
+                dispatch_source_set_cancel_handler( watch->source, ^
+                {
+                    close( file );
+                } );
+
+                dispatch_resume( watch->source );
+            }
+            else
+            {
+                close( file );
+            }
+        }
+    }
+}
+
+static void __DAConfigurationWatchEvent( __DAConfigurationWatch * watch )
+{
+    unsigned long flags;
+
+    flags = dispatch_source_get_data( watch->source );
+
+    /*
+     * A file that is deleted or replaced by a rename is no longer the one being watched, so the
+     * watch is dropped and armed again on whatever is now at the path.
+     */
+
+    if ( ( flags & ( DISPATCH_VNODE_DELETE | DISPATCH_VNODE_RENAME | DISPATCH_VNODE_REVOKE ) ) )
+    {
+        dispatch_source_cancel( watch->source );
+        dispatch_release( watch->source );
+
+        watch->source = NULL;
+    }
+
+    if ( watch->update )
+    {
+        watch->update( );
+
+        __DAConfigurationWatchArm( watch );
+    }
+    else
+    {
+        size_t index;
+
+        /*
+         * A change to a parent folder may have created or replaced any of the files within, so
+         * every watch is armed again and every list is brought up-to-date.  The lists that have
+         * not changed are left alone.
+         */
+
+        for ( index = 0; index < sizeof( __gDAConfigurationWatchList ) / sizeof( __gDAConfigurationWatchList[0] ); index++ )
+        {
+            __DAConfigurationWatch * item = &__gDAConfigurationWatchList[index];
+
+            __DAConfigurationWatchArm( item );
+
+            if ( item->update )
+            {
+                item->update( );
+            }
+        }
+    }
+}
+
+void DAConfigurationListWatch( void )
+{
+    /*
+     * Watch the files and folders behind the file system, mount map and preference lists, so
+     * that the lists are rebuilt as they change rather than checked for change as disks come
+     * and go.
+     */
+
+    dispatch_async( __DAConfigurationGetQueue( ), ^
+    {
+        size_t index;
+
+        for ( index = 0; index < sizeof( __gDAConfigurationWatchList ) / sizeof( __gDAConfigurationWatchList[0] ); index++ )
+        {
+            __DAConfigurationWatchArm( &__gDAConfigurationWatchList[index] );
+        }
+
+        /*
+         * Catch any change made between the initial refresh and the watch.
+         */
+
+        __DAFileSystemListUpdate( );
+        __DAMountMapListUpdate1( );
+        __DAMountMapListUpdate2( );
+        __DAPreferenceListUpdate( );
+    } );
+}
+
+#define __kDAVolumeIDListSize 32
+
+struct __DAVolumeID
+{
+    fsid_t fsid;
+    uid_t  owner;
+    char   name[MAXPATHLEN];
+    char   id[MAXPATHLEN + sizeof( "?owner=4294967295" )];
+};
+
+typedef struct __DAVolumeID __DAVolumeID;
+
+static __DAVolumeID    __gDAVolumeIDList[__kDAVolumeIDListSize];
+static CFDictionaryRef __gDAVolumeList           = NULL;
+static UInt64          __gDAVolumeListGeneration = 1;
+static UInt64          __gDAVolumeListSnapshot   = 0;
+
+const char * DAVolumeGetID( const struct statfs * fs )
+{
+    __DAVolumeID * entry;
+
+    /*
+     * Look the volume ID up by file system ID, owner and mount point, which together identify
+     * a mount for as long as it lasts, and derive it on a miss only.  The table is direct-mapped
+     * on the file system ID and is compared in place, so a lookup never allocates.  It is used
+     * on the workloop only, and the ID returned is valid until the next call.
+     */
+
+    entry = &__gDAVolumeIDList[ ( ( UInt32 ) fs->f_fsid.val[0] ^ ( UInt32 ) fs->f_fsid.val[1] ) % __kDAVolumeIDListSize ];
+
+    if ( entry->id[0]       == 0                  ||
+         entry->fsid.val[0] != fs->f_fsid.val[0]  ||
+         entry->fsid.val[1] != fs->f_fsid.val[1]  ||
+         entry->owner       != fs->f_owner        ||
+         strcmp( entry->name, fs->f_mntonname ) )
+    {
+        entry->fsid  = fs->f_fsid;
+        entry->owner = fs->f_owner;
+
+        strlcpy( entry->name, fs->f_mntonname,      sizeof( entry->name ) );
+        strlcpy( entry->id,   _DAVolumeGetID( fs ), sizeof( entry->id   ) );
+    }
+
+    return entry->id;
+}
+
+CFDictionaryRef DAVolumeListCopy( void )
+{
+    /*
+     * Take a snapshot of the mount table, indexed by volume ID.  A snapshot is reused for as
+     * long as its generation is current, so a wave of refreshes in one dispatch pass fetches
+     * the mount table once.
+     */
+
+    if ( __gDAVolumeList == NULL || __gDAVolumeListSnapshot != __gDAVolumeListGeneration )
+    {
+        CFMutableDictionaryRef list;
+
+        list = CFDictionaryCreateMutable( kCFAllocatorDefault, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks );
+
+        if ( list )
+        {
+            struct statfs * mountList;
+            int             mountListCount;
+            int             mountListIndex;
+
+            mountListCount = getmntinfo( &mountList, MNT_NOWAIT );
+
+            for ( mountListIndex = 0; mountListIndex < mountListCount; mountListIndex++ )
+            {
+                CFStringRef id;
+
+                id = CFStringCreateWithCString( kCFAllocatorDefault, DAVolumeGetID( mountList + mountListIndex ), kCFStringEncodingUTF8 );
+
+                if ( id )
+                {
+                    CFDataRef volume;
+
+                    volume = CFDataCreate( kCFAllocatorDefault, ( void * ) ( mountList + mountListIndex ), sizeof( struct statfs ) );
+
+                    if ( volume )
+                    {
+                        /*
+                         * The first entry for a volume ID wins, as it would in a scan of the
+                         * mount table.
+                         */
+
+                        CFDictionaryAddValue( list, id, volume );
+
+                        CFRelease( volume );
+                    }
+
+                    CFRelease( id );
+                }
+            }
+
+            if ( __gDAVolumeList )
+            {
+                CFRelease( __gDAVolumeList );
+            }
+
+            __gDAVolumeList         = CFRetain( list );
+            __gDAVolumeListSnapshot = __gDAVolumeListGeneration;
+        }
+
+        if ( list )  CFRelease( list );
+    }
+
+    return __gDAVolumeList ? CFRetain( __gDAVolumeList ) : NULL;
+}
+
+const struct statfs * DAVolumeListGetVolume( CFDictionaryRef list, const char * id )
+{
+    const struct statfs * volume = NULL;
+
+    if ( list )
+    {
+        CFStringRef key;
+
+        key = CFStringCreateWithCStringNoCopy( kCFAllocatorDefault, id, kCFStringEncodingUTF8, kCFAllocatorNull );
+
+        if ( key )
+        {
+            CFDataRef value;
+
+            value = CFDictionaryGetValue( list, key );
+
+            if ( value )
+            {
+                volume = ( void * ) CFDataGetBytePtr( value );
+            }
+
+            CFRelease( key );
+        }
     }
+
+    return volume;
+}
+
+void DAVolumeListInvalidate( void )
+{
+    __gDAVolumeListGeneration++;
 }
 
 struct __DAUnit
@@ -53,6 +53,8 @@
  * SUCH DAMAGE.
  */
 
+#include "fstabparse.h"
+
 #include <errno.h>
 #include <fstab.h>
 #include <paths.h>
@@ -89,84 +91,95 @@ fixspace(s)
 	*cp = '\0';
 }
 
-static int
-fstabscan()
+/*
+ * Parse a single line in place.  The fields of the entry point into the line, which
+ * may be of any length.  Returns 1 for an entry, 0 for a line to be skipped and -1
+ * for a malformed line.
+ */
+int
+fstabparse_r(line, fs)
+	char *line;
+	struct fstab *fs;
 {
 	char *cp, *p;
-#define	MAXLINELENGTH	1024
-	static char line[MAXLINELENGTH];
-	char subline[MAXLINELENGTH];
-	int typexx;
-
-	for (;;) {
+	size_t len;
 
-		if (!(p = fgets(line, sizeof(line), _fs_fp)))
-			return(0);
-		++LineNo;
-		while ((cp = strsep(&p, " \t\n")) != NULL && *cp == '\0')
-			;
-		_fs_fstab.fs_spec = cp;
-		if (!_fs_fstab.fs_spec || *_fs_fstab.fs_spec == '#')
-			continue;
-		while ((cp = strsep(&p, " \t\n")) != NULL && *cp == '\0')
-			;
-		_fs_fstab.fs_file = cp;
-		while ((cp = strsep(&p, " \t\n")) != NULL && *cp == '\0')
-			;
-		_fs_fstab.fs_vfstype = cp;
-		while ((cp = strsep(&p, " \t\n")) != NULL && *cp == '\0')
-			;
-		_fs_fstab.fs_mntops = cp;
-		if (_fs_fstab.fs_mntops == NULL)
-			goto bad;
-		fixspace(_fs_fstab.fs_spec);
-		fixspace(_fs_fstab.fs_file);
-		_fs_fstab.fs_freq = 0;
-		_fs_fstab.fs_passno = 0;
+	p = line;
+	while ((cp = strsep(&p, " \t\n")) != NULL && *cp == '\0')
+		;
+	fs->fs_spec = cp;
+	if (!fs->fs_spec || *fs->fs_spec == '#')
+		return(0);
+	while ((cp = strsep(&p, " \t\n")) != NULL && *cp == '\0')
+		;
+	fs->fs_file = cp;
+	while ((cp = strsep(&p, " \t\n")) != NULL && *cp == '\0')
+		;
+	fs->fs_vfstype = cp;
+	while ((cp = strsep(&p, " \t\n")) != NULL && *cp == '\0')
+		;
+	fs->fs_mntops = cp;
+	if (fs->fs_mntops == NULL)
+		return(-1);
+	fixspace(fs->fs_spec);
+	fixspace(fs->fs_file);
+	fs->fs_freq = 0;
+	fs->fs_passno = 0;
+	while ((cp = strsep(&p, " \t\n")) != NULL && *cp == '\0')
+		;
+	if (cp != NULL) {
+		fs->fs_freq = atoi(cp);
 		while ((cp = strsep(&p, " \t\n")) != NULL && *cp == '\0')
 			;
-		if (cp != NULL) {
-			_fs_fstab.fs_freq = atoi(cp);
-			while ((cp = strsep(&p, " \t\n")) != NULL && *cp == '\0')
-				;
-			if (cp != NULL)
-				_fs_fstab.fs_passno = atoi(cp);
-		}
-		_fs_fstab.fs_type = "??";
-		strlcpy(subline, _fs_fstab.fs_mntops, sizeof(subline));
-		p = subline;
-		for (typexx = 0, cp = strsep(&p, ","); cp;
-		     cp = strsep(&p, ",")) {
-			if (strlen(cp) != 2)
-				continue;
-			if (!strcmp(cp, FSTAB_RW)) {
-				_fs_fstab.fs_type = FSTAB_RW;
-				break;
-			}
-			if (!strcmp(cp, FSTAB_RQ)) {
-				_fs_fstab.fs_type = FSTAB_RQ;
+		if (cp != NULL)
+			fs->fs_passno = atoi(cp);
+	}
+	fs->fs_type = "??";
+	for (cp = fs->fs_mntops; ; cp += len + 1) {
+		len = strcspn(cp, ",");
+		if (len == 2) {
+			if (!strncmp(cp, FSTAB_RW, 2)) {
+				fs->fs_type = FSTAB_RW;
 				break;
 			}
-			if (!strcmp(cp, FSTAB_RO)) {
-				_fs_fstab.fs_type = FSTAB_RO;
+			if (!strncmp(cp, FSTAB_RQ, 2)) {
+				fs->fs_type = FSTAB_RQ;
 				break;
 			}
-			if (!strcmp(cp, FSTAB_SW)) {
-				_fs_fstab.fs_type = FSTAB_SW;
+			if (!strncmp(cp, FSTAB_RO, 2)) {
+				fs->fs_type = FSTAB_RO;
 				break;
 			}
-			if (!strcmp(cp, FSTAB_XX)) {
-				_fs_fstab.fs_type = FSTAB_XX;
-				typexx++;
+			if (!strncmp(cp, FSTAB_SW, 2)) {
+				fs->fs_type = FSTAB_SW;
 				break;
 			}
+			if (!strncmp(cp, FSTAB_XX, 2))
+				return(0);
 		}
-		if (typexx)
-			continue;
-		return(1);
+		if (cp[len] == '\0')
+			break;
+	}
+	return(1);
+}
 
-bad:		/* no way to distinguish between EOF and syntax error */
-		error(EFTYPE);
+static int
+fstabscan()
+{
+	static char *line;
+	static size_t size;
+	int status;
+
+	for (;;) {
+
+		if (getline(&line, &size, _fs_fp) < 0)
+			return(0);
+		++LineNo;
+		status = fstabparse_r(line, &_fs_fstab);
+		if (status > 0)
+			return(1);
+		if (status < 0)	/* no way to distinguish between EOF and syntax error */
+			error(EFTYPE);
 	}
 	/* NOTREACHED */
 }
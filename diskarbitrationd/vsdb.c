@@ -31,24 +31,40 @@
 static FILE *_vs_fp;
 static struct vsdb _vs_vsdb;
 
+/*
+ * Parse a single line in place.  The fields of the entry point into the line, which
+ * may be of any length.  Returns 1 for an entry and 0 for a line to be skipped.
+ */
+int
+vsdbparse_r(line, vs)
+	char *line;
+	struct vsdb *vs;
+{
+	char *cp, *p;
+
+	p = line;
+	if (!(cp = strsep(&p, ":")) || *cp == '\0')
+		return(0);
+	vs->vs_spec = cp;
+	if (!(cp = strsep(&p, "\n")) || *cp == '\0')
+		return(0);
+	vs->vs_ops = strtol(cp, &p, 16);
+	if (*p == '\0')
+		return(1);
+	return(0);
+}
+
 static int
 vsdbscan()
 {
-	char *cp, *p;
-#define	MAXLINELENGTH	1024
-	static char line[MAXLINELENGTH];
+	static char *line;
+	static size_t size;
 
 	for (;;) {
 
-		if (!(p = fgets(line, sizeof(line), _vs_fp)))
+		if (getline(&line, &size, _vs_fp) < 0)
 			return(0);
-		if (!(cp = strsep(&p, ":")) || *cp == '\0')
-			continue;
-		_vs_vsdb.vs_spec = cp;
-		if (!(cp = strsep(&p, "\n")) || *cp == '\0')
-			continue;
-		_vs_vsdb.vs_ops = strtol(cp, &p, 16);
-		if (*p == '\0')
+		if (vsdbparse_r(line, &_vs_vsdb))
 			return(1);
 	}
 	/* NOTREACHED */
@@ -40,6 +40,7 @@ struct vsdb *getvsent __P((void));
 struct vsdb *getvsspec __P((const char *));
 int setvsent __P((void));
 void endvsent __P((void));
+int vsdbparse_r __P((char *, struct vsdb *));
 __END_DECLS
 
 #endif /* !_VSDB_H_ */